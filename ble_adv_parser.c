@@ -0,0 +1,139 @@
+/*
+ * ble_adv_parser.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Allocation-free parser for advertising reports and scan responses.
+ *
+ * Data is a sequence of AD structures: [length][type][value; length - 1 bytes].
+ * A zero length terminates the significant part of the data. Structures which
+ * would run past the end of the report are treated as malformed and parsing
+ * stops, so no byte outside the report is ever read.
+ */
+
+#include <string.h>
+
+#include "ble_adv_parser.h"
+
+static uint16_t get_le16(const uint8_t *p)
+{
+        return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+bool adv_ad_next(const uint8_t *data, uint8_t length, uint8_t *pos, uint8_t *type,
+                                                        const uint8_t **value, uint8_t *value_len)
+{
+        uint8_t ad_len;
+
+        if (*pos >= length) {
+                return false;
+        }
+
+        ad_len = data[*pos];
+        // early termination of the significant part
+        if (ad_len == 0) {
+                *pos = length;
+                return false;
+        }
+        // [length] byte + structure must fit in the report, leave pos on malformed data
+        if (ad_len > length - *pos - 1) {
+                return false;
+        }
+
+        *type = data[*pos + 1];
+        *value = &data[*pos + 2];
+        *value_len = ad_len - 1;
+        *pos += ad_len + 1;
+
+        return true;
+}
+
+static bool uuid128_list_has(const uint8_t *list, uint8_t len, const uint8_t *uuid)
+{
+        uint8_t i;
+
+        for (i = 0; i + ADV_UUID128_LEN <= len; i += ADV_UUID128_LEN) {
+                if (!memcmp(&list[i], uuid, ADV_UUID128_LEN)) {
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+bool adv_has_uuid128(const uint8_t *data, uint8_t length, const uint8_t *uuid)
+{
+        uint8_t pos = 0;
+        uint8_t type, len;
+        const uint8_t *value;
+
+        while (adv_ad_next(data, length, &pos, &type, &value, &len)) {
+                if ((type == ADV_AD_TYPE_UUID128_LIST || type == ADV_AD_TYPE_UUID128_LIST_INC) &&
+                                                        uuid128_list_has(value, len, uuid)) {
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+static void parse_manufacturer_data(const uint8_t *value, uint8_t len, struct adv_report_info *info)
+{
+        if (len < BLUETANIST_MFR_RECORD_LEN || get_le16(value) != BLUETANIST_COMPANY_ID ||
+                                                        value[2] != BLUETANIST_MFR_FORMAT_RECORD) {
+                return;
+        }
+
+        sensor_record_unpack(&value[3], &info->record);
+        info->has_record = true;
+}
+
+void adv_encode_sensor_record(const struct sensor_record *rec, uint8_t *buf)
+{
+        buf[0] = BLUETANIST_COMPANY_ID & 0xFF;
+        buf[1] = BLUETANIST_COMPANY_ID >> 8;
+        buf[2] = BLUETANIST_MFR_FORMAT_RECORD;
+        sensor_record_pack(rec, &buf[3]);
+}
+
+bool adv_parse_report(const uint8_t *data, uint8_t length, const uint8_t *uuid,
+                                                                struct adv_report_info *info)
+{
+        uint8_t pos = 0;
+        uint8_t type, len;
+        const uint8_t *value;
+
+        memset(info, 0, sizeof(*info));
+
+        while (adv_ad_next(data, length, &pos, &type, &value, &len)) {
+                switch (type) {
+                case ADV_AD_TYPE_UUID128_LIST_INC:
+                case ADV_AD_TYPE_UUID128_LIST:
+                        if (!info->uuid_match) {
+                                info->uuid_match = uuid128_list_has(value, len, uuid);
+                        }
+                        break;
+                case ADV_AD_TYPE_LOCAL_NAME:
+                case ADV_AD_TYPE_SHORT_NAME:
+                        info->name = value;
+                        info->name_len = len;
+                        info->name_complete = (type == ADV_AD_TYPE_LOCAL_NAME);
+                        break;
+                case ADV_AD_TYPE_TX_POWER_LEVEL:
+                        if (len == 1) {
+                                info->tx_power = (int8_t)value[0];
+                                info->has_tx_power = true;
+                        }
+                        break;
+                case ADV_AD_TYPE_MANUFACTURER_DATA:
+                        parse_manufacturer_data(value, len, info);
+                        break;
+                default:
+                        break;
+                }
+        }
+
+        // the parser consumes all data unless a structure was malformed
+        return pos >= length;
+}
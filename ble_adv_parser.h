@@ -0,0 +1,104 @@
+/*
+ * ble_adv_parser.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef BLE_ADV_PARSER_H_
+#define BLE_ADV_PARSER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sensor_record.h"
+
+/*
+ * AD types used by BlueTanist nodes (Core Specification Supplement, Part A)
+ */
+#define ADV_AD_TYPE_FLAGS               (0x01)
+#define ADV_AD_TYPE_UUID128_LIST_INC    (0x06)
+#define ADV_AD_TYPE_UUID128_LIST        (0x07)
+#define ADV_AD_TYPE_SHORT_NAME          (0x08)
+#define ADV_AD_TYPE_LOCAL_NAME          (0x09)
+#define ADV_AD_TYPE_TX_POWER_LEVEL      (0x0A)
+#define ADV_AD_TYPE_MANUFACTURER_DATA   (0xFF)
+
+#define ADV_UUID128_LEN                 (16)
+
+/*
+ * Company identifier used in BlueTanist manufacturer specific data.
+ * 0xFFFF is reserved by the Bluetooth SIG for internal use and testing.
+ */
+#define BLUETANIST_COMPANY_ID           (0xFFFF)
+
+/*
+ * Manufacturer specific data format: [company id][format][sensor record]
+ * company id little endian, see sensor_record.h for the record.
+ */
+#define BLUETANIST_MFR_FORMAT_RECORD    (0x01)
+#define BLUETANIST_MFR_RECORD_LEN       (2 + 1 + SENSOR_RECORD_LEN)
+
+/*
+ * Information extracted from a single advertising report or scan response.
+ * Strings point into the report data, nothing is copied or allocated.
+ */
+struct adv_report_info {
+        bool uuid_match;                /* the service UUID was found in a UUID128 list */
+
+        const uint8_t *name;            /* local name, not '\0' terminated */
+        uint8_t name_len;
+        bool name_complete;
+
+        bool has_tx_power;
+        int8_t tx_power;
+
+        bool has_record;                /* sensor record broadcast by the node */
+        struct sensor_record record;
+};
+
+/**
+ * \brief Iterate over the AD structures of an advertising report
+ *
+ * \param [in] data: report data
+ * \param [in] length: report data length
+ * \param [in,out] pos: parser position, start with 0
+ * \param [out] type: AD type
+ * \param [out] value: AD value, points into \p data
+ * \param [out] value_len: AD value length
+ *
+ * \return true if an AD structure was returned, false at the end of the data or on
+ *         a malformed structure. On a malformed structure \p pos is left before it.
+ */
+bool adv_ad_next(const uint8_t *data, uint8_t length, uint8_t *pos, uint8_t *type,
+                                                        const uint8_t **value, uint8_t *value_len);
+
+/**
+ * \brief Check whether a report lists the given 128-bit service UUID
+ *
+ * Stops at the first match; any position and any number of UUIDs per list are handled.
+ */
+bool adv_has_uuid128(const uint8_t *data, uint8_t length, const uint8_t *uuid);
+
+/**
+ * \brief Parse an advertising report or scan response
+ *
+ * \param [in] data: report data
+ * \param [in] length: report data length
+ * \param [in] uuid: 128-bit service UUID to match (little endian, as advertised)
+ * \param [out] info: extracted information
+ *
+ * \return false if the report is malformed, \p info holds everything parsed up to that point
+ */
+bool adv_parse_report(const uint8_t *data, uint8_t length, const uint8_t *uuid,
+                                                                struct adv_report_info *info);
+
+/**
+ * \brief Encode a sensor record as BlueTanist manufacturer specific data
+ *
+ * \param [in] rec: sensor record
+ * \param [out] buf: BLUETANIST_MFR_RECORD_LEN bytes, the AD structure value
+ */
+void adv_encode_sensor_record(const struct sensor_record *rec, uint8_t *buf);
+
+#endif /* BLE_ADV_PARSER_H_ */
@@ -13,8 +13,15 @@
  */
 
 #include <stdbool.h>
-#include "stdio.h"
 #include "ble_bluetanist_common.h"
+#include "ble_scan_scheduler.h"
+#include "ble_central_functions.h"
+#include "ble_conn_table.h"
+#include "ble_conn_params.h"
+#include "ble_link.h"
+#include "collect_sched.h"
+#include "time_sync.h"
+#include "deferred_log.h"
 
 /*
  * @brief Notification event callback
@@ -43,17 +50,62 @@
 void event_sent_cb(uint16_t conn_idx, bool status, gatt_event_t type)
 {
         /*
-         * This is just for debugging/demonstration purposes. UART is a slow interface
-         * and will add significant delay compared to the BLE speeds.
+         * This is just for debugging/demonstration purposes, the deferred log keeps
+         * the UART out of the BLE task.
          */
-#if (DBG_SERIAL_CONSOLE_ENABLE == 1)
-        printf("\nNotify callback - Connection idx: %d, Status: %d, Type: %d\n\r",
+        LOG_DBG("Notify callback - Connection idx: %d, Status: %d, Type: %d\r\n",
                                                                 conn_idx, status, type);
-#endif
 }
 
 
 
+/*
+ * Fleet clock, synced by the BLE task and read by the sampling task
+ */
+__RETAINED static struct time_sync fleet_clock;
+
+static uint32_t local_time_now(void)
+{
+        return OS_TICKS_2_MS(OS_GET_TICK_COUNT());
+}
+
+uint32_t fleet_time_now(void)
+{
+        uint32_t now;
+
+        taskENTER_CRITICAL();
+        now = time_sync_now(&fleet_clock, local_time_now());
+        taskEXIT_CRITICAL();
+
+        return now;
+}
+
+void fleet_time_sync(uint32_t fleet_ms)
+{
+        taskENTER_CRITICAL();
+        time_sync_update(&fleet_clock, local_time_now(), fleet_ms);
+        taskEXIT_CRITICAL();
+
+        LOG_DBG("Fleet time synced, error: %ld ms, drift: %ld ppm\r\n",
+                                (long) fleet_clock.last_error, (long) fleet_clock.drift_ppm);
+}
+
+int32_t fleet_time_drift(void)
+{
+        return fleet_clock.drift_ppm;
+}
+
+uint32_t fleet_time_epoch_delay(uint32_t period_ms, uint32_t offset_ms)
+{
+        uint32_t delay;
+
+        taskENTER_CRITICAL();
+        delay = time_sync_epoch_delay(&fleet_clock, local_time_now(), period_ms, offset_ms);
+        taskEXIT_CRITICAL();
+
+        return delay;
+}
+
 /*
  * Main code
  */
@@ -61,7 +113,39 @@ void event_sent_cb(uint16_t conn_idx, bool status, gatt_event_t type)
 
 void handle_evt_gap_connected(ble_evt_gap_connected_t *evt)
 {
-        printf("GAP connected callback - Connection idx: %d, Remote address: %s", evt->conn_idx, ble_address_to_string(&evt->peer_address));
+        LOG_INF("GAP connected callback - Connection idx: %d, Remote address: " LOG_ADDR_FMT "\r\n", evt->conn_idx,
+                                                                                LOG_ADDR(&evt->peer_address));
+
+        // connections initiated by this master are nodes, others a phone or a parent master
+        bool outgoing = conn_table_take_outgoing(&evt->peer_address);
+
+        /*
+         * Two masters connecting each other at the same time get two links, and the
+         * first one may have taken the mark of the other. Both see the same link second
+         * and drop it, the first one serves either way.
+         */
+        if (conn_table_find_addr(&evt->peer_address) != NULL) {
+                LOG_WRN("Second connection %d to " LOG_ADDR_FMT ", disconnecting\r\n", evt->conn_idx,
+                                                                                LOG_ADDR(&evt->peer_address));
+                ble_gap_disconnect(evt->conn_idx, BLE_HCI_ERROR_REMOTE_USER_TERM_CON);
+                return;
+        }
+
+        if (outgoing) {
+                scan_sched_node_connected(&evt->peer_address, evt->conn_idx);
+        }
+        if (conn_table_add(evt, outgoing ? CONN_ROLE_NODE : CONN_ROLE_PEER) == NULL) {
+                LOG_WRN("Connection table full, connection %d not tracked\r\n", evt->conn_idx);
+        }
+        // discovery follows a new connection, the idle check takes over from there
+        conn_params_activity(evt->conn_idx);
+        // upgrade the link for bulk transfers
+        link_setup(evt->conn_idx);
+#if (CFG_COLLECT_WINDOWS == 1)
+        if (outgoing) {
+                collect_sched_node_connected(&evt->peer_address, evt->conn_idx);
+        }
+#endif
 }
 
 void handle_evt_gap_disconnected(ble_evt_gap_disconnected_t *evt)
@@ -69,6 +153,12 @@ void handle_evt_gap_disconnected(ble_evt_gap_disconnected_t *evt)
         /*
          * Manage disconnection information
          */
+        scan_sched_node_disconnected(evt->conn_idx);
+        node_disconnected(evt->conn_idx);
+        conn_table_remove(evt->conn_idx);
+#if (CFG_COLLECT_WINDOWS == 1)
+        collect_sched_node_disconnected(evt->conn_idx);
+#endif
 }
 
 void handle_evt_gap_adv_completed(ble_evt_gap_adv_completed_t *evt)
@@ -82,5 +172,9 @@ void handle_evt_gap_adv_completed(ble_evt_gap_adv_completed_t *evt)
  */
 void handle_ble_evt_gap_connection_completed(const ble_evt_gap_connection_completed_t *info)
 {
-        printf("GAP connection completed - Status: 0x%02x\r\n", info->status);
+        LOG_DBG("GAP connection completed - Status: 0x%02x\r\n", info->status);
+        conn_table_connect_completed();
+#if (CFG_COLLECT_WINDOWS == 1)
+        collect_sched_connection_completed(info);
+#endif
 }
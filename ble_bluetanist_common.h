@@ -8,9 +8,13 @@
 #ifndef BLE_BLUETANIST_COMMON_H_
 #define BLE_BLUETANIST_COMMON_H_
 
+#include "osal.h"
 #include "ble_gap.h"
 #include "ble_gatt.h"
 
+#include "sensor_record.h"
+#include "node_aggregate.h"
+
 /*
  * The maximum length of name in scan response
  */
@@ -21,6 +25,23 @@
  */
 #define DEVICE_NAME     "BlueTanist Node"
 
+/*
+ * The device's advertised short name, used when the complete name does not fit
+ */
+#define DEVICE_SHORT_NAME       "BlueTanist"
+
+/*
+ * Enable/disable broadcasting the latest sensor record in the advertising data.
+ * The service UUID moves to the scan response so the record fits.
+ *
+ * A master takes a broadcasting device for a broadcast-only leaf and never connects
+ * it, so neither its relayed aggregate nor its alarms reach the master. Enable only
+ * in builds for leaf nodes which are read from their broadcasts alone.
+ */
+#ifndef CFG_BROADCAST_SENSOR_DATA
+#define CFG_BROADCAST_SENSOR_DATA       (0)
+#endif
+
 /* Enable/disable changing the default Maximum Protocol Unit (MTU). */
 #define CHANGE_MTU_SIZE_ENABLE        (0)
 
@@ -34,16 +55,42 @@
 #define NODE_MASTER_SVC_UUID    "11111111-0000-0000-0000-111111111111"
 #define NODE_MASTER_ATTR_SET    "11111111-0000-0000-0000-000000000001"
 #define NODE_MASTER_ATTR_DATA   "11111111-0000-0000-0000-000000000010"
+#define NODE_MASTER_ATTR_TIME   "11111111-0000-0000-0000-000000000020"
 
 #define NODE_DATA_SVC_UUID      "22222222-0000-0000-0000-222222222222"
 #define NODE_DATA_ATTR_TEMP     "22222222-0000-0000-0000-000000000001"
 #define NODE_DATA_ATTR_HUMID    "22222222-0000-0000-0000-000000000002"
 #define NODE_DATA_ATTR_WATER    "22222222-0000-0000-0000-000000000003"
 
+#define NODE_ALARM_SVC_UUID     "44444444-0000-0000-0000-444444444444"
+#define NODE_ALARM_ATTR_RULES   "44444444-0000-0000-0000-000000000001"
+#define NODE_ALARM_ATTR_STATE   "44444444-0000-0000-0000-000000000002"
+
+/* Index of NODE_ALARM_ATTR_STATE in the alarm service declaration */
+#define NODE_ALARM_STATE_IDX    (1)
+
+/* Index of NODE_MASTER_ATTR_DATA in the master service declaration */
+#define NODE_MASTER_DATA_IDX    (1)
+
+#define DIAG_SVC_UUID           "33333333-0000-0000-0000-333333333333"
+#define DIAG_ATTR_TRACE         "33333333-0000-0000-0000-000000000001"
+#define DIAG_ATTR_LATENCY       "33333333-0000-0000-0000-000000000002"
+#define DIAG_ATTR_MEMORY        "33333333-0000-0000-0000-000000000003"
+#define DIAG_ATTR_LINK          "33333333-0000-0000-0000-000000000004"
+
+/* Maximum number of bytes returned per read of a diagnostics attribute (default MTU) */
+#define DIAG_READ_CHUNK         (20)
+
+/* Number of sensor attributes read from each node per collection cycle */
+#define NODE_DATA_ATTR_COUNT    (3)
+
 att_uuid_t node_data_svc_uuid;
 att_uuid_t node_data_attr_temp;
 att_uuid_t node_data_attr_humid;
 att_uuid_t node_data_attr_water;
+att_uuid_t node_master_svc_uuid;
+att_uuid_t node_master_attr_data;
+att_uuid_t node_master_attr_time;
 
 /*
  * Macro used for setting the maximum length, expressed in bytes,
@@ -65,6 +112,106 @@ att_uuid_t node_data_attr_water;
 #define CFG_SCAN_FILT_WLIST     (false)
 #define CFG_SCAN_FILT_DUPLT     (false)
 
+/*
+ * BLE background scan (fleet known): passive, low duty cycle, runs until stopped.
+ * Only whitelisted (known) nodes are accepted in this mode.
+ */
+#define CFG_BG_SCAN_TYPE        (GAP_SCAN_PASSIVE)
+#define CFG_BG_SCAN_MODE        (GAP_SCAN_OBSERVER_MODE)
+#define CFG_BG_SCAN_INTERVAL    BLE_SCAN_INTERVAL_FROM_MS(1280)
+#define CFG_BG_SCAN_WINDOW      BLE_SCAN_WINDOW_FROM_MS(30)
+#define CFG_BG_SCAN_FILT_DUPLT  (false)
+
+/*
+ * BLE scan scheduling
+ */
+/* Period of discovery windows while the fleet is not yet known */
+#define CFG_SCAN_DISCOVERY_PERIOD_MS    (30000)
+/* Consecutive discovery windows without new nodes before the fleet is considered known */
+#define CFG_SCAN_FLEET_KNOWN_WINDOWS    (2)
+/* Period of discovery windows once the fleet is known */
+#define CFG_SCAN_REDISCOVERY_PERIOD_MS  (600000)
+
+/*
+ * Scheduled collection windows: instead of keeping a connection to every node, the
+ * master connects the known nodes in batches every period, reads their records with
+ * the cached attribute handles and disconnects them again
+ */
+#ifndef CFG_COLLECT_WINDOWS
+#define CFG_COLLECT_WINDOWS             (0)
+#endif
+/* Period of the collection windows */
+#define CFG_COLLECT_PERIOD_MS           (60000)
+/* Number of nodes connected at the same time */
+#define CFG_COLLECT_BATCH_SIZE          (4)
+/* Time after which the nodes of a batch which did not deliver are given up */
+#define CFG_COLLECT_BATCH_TIMEOUT_MS    (5000)
+
+/*
+ * Fleet time: masters write their fleet time to the nodes they collect, nodes sample
+ * on the epochs of the fleet clock so the samples of one collection are coherent
+ */
+/* Sampling period, epochs are the multiples of the period in fleet time */
+#define CFG_SAMPLE_PERIOD_MS            (1000)
+/*
+ * Delay of a collection window after its epoch, covers the oversampled readings.
+ * CFG_COLLECT_PERIOD_MS should be a multiple of CFG_SAMPLE_PERIOD_MS.
+ */
+#define CFG_COLLECT_EPOCH_OFFSET_MS     (250)
+
+/*
+ * BLE event loop: events handled per wakeup of the BLE task and the time budget of a
+ * wakeup, after which the task yields to the other notifications. A batch of 1 handles
+ * one event per wakeup. Measured under scan storms on the host (test/ble_replay -t):
+ * a batch of 8 reports takes about 0.5 ms, larger batches do not sustain more events
+ * per second; the budget only cuts wakeups of slow events.
+ */
+#ifndef CFG_BLE_EVT_BATCH
+#define CFG_BLE_EVT_BATCH               (8)
+#endif
+#ifndef CFG_BLE_EVT_BUDGET_MS
+#define CFG_BLE_EVT_BUDGET_MS           (2)
+#endif
+
+/*
+ * Aggregate node data
+ */
+/* Maximum number of generations a delta frame may span, older bases get a full frame */
+#define CFG_AGGREGATE_DELTA_WINDOW      (1024)
+/* Minimum time between two notifications of the aggregate, changes in between are coalesced */
+#define CFG_AGGREGATE_NOTIFY_MIN_MS     (1000)
+/* Change of a sensor value (0.01 units) since it was sent last which triggers a notification */
+#define CFG_AGGREGATE_NOTIFY_DELTA      (10)
+
+/*
+ * Node lifecycle
+ */
+/* Maximum number of disconnected nodes whose state is kept for a reconnection */
+#define CFG_NODE_PARK_MAX               (8)
+
+/*
+ * Relaying masters
+ */
+/* Maximum hops of a relayed node, entries further away are dropped (loop protection) */
+#define CFG_RELAY_MAX_HOPS              (4)
+/*
+ * Initial buffer for the aggregate frame read from a relaying master; it grows to the
+ * entry count of the frame header when the frame is longer, up to AGGREGATE_MAX_LEN
+ */
+#define CFG_RELAY_FRAME_LEN             (AGGREGATE_HDR_LEN + 16 * AGGREGATE_ENTRY_LEN)
+
+/*
+ * BLE task notification bits (BLE_APP_NOTIFY_MASK is bit 0)
+ */
+#define BLE_SCAN_SCHED_NOTIF    (1 << 1)
+#define BLE_SENSOR_UPDATE_NOTIF (1 << 2)
+#define BLE_CONN_PARAMS_NOTIF   (1 << 3)
+#define BLE_COLLECT_SCHED_NOTIF (1 << 4)
+#define BLE_AGGREGATE_NOTIF     (1 << 5)
+#define BLE_ALARM_NOTIF         (1 << 6)
+#define BLE_LINK_NOTIF          (1 << 7)
+#define BLE_SENSOR_SAMPLE_NOTIF (1 << 8)
+
 
 /*
  * BLE peripheral advertising data
@@ -77,25 +224,41 @@ static const gap_adv_ad_struct_t adv_data[] = {
 };
 
 /**
- * Default connection parameters
+ * Connection parameters during discovery and bulk transfer; 15-30 ms, no slave latency.
+ * New connections to nodes start with these.
  */
-#define CFG_CONN_PARAMS                                         \
+#define CFG_CONN_PARAMS_FAST                                    \
         {                                                       \
-                .interval_min = 0x28,                           \
-                .interval_max = 0x38,                           \
+                .interval_min = 0x0C,                           \
+                .interval_max = 0x18,                           \
                 .slave_latency = 0,                             \
-                .sup_timeout = 0x2a,                            \
+                .sup_timeout = 0x64,                            \
+        }
+
+/**
+ * Connection parameters in steady state (notifications only); 400-500 ms, the slave
+ * may skip 4 connection events, 6 s supervision timeout
+ */
+#define CFG_CONN_PARAMS_IDLE                                    \
+        {                                                       \
+                .interval_min = 0x140,                          \
+                .interval_max = 0x190,                          \
+                .slave_latency = 4,                             \
+                .sup_timeout = 0x258,                           \
         }
 
+/* Time without GATT activity after which a connection switches to the idle parameters */
+#define CFG_CONN_IDLE_MS                (2000)
+
 /*
  * sensor attribute
- * holds handles and converted sensor data
+ * holds the handle and the sensor channel (enum sensor_channel) the attribute maps to,
+ * mapped once from the UUID at discovery
  */
 struct sensor_attr_list_elem {
         struct sensor_attr_list_elem *next;
-        att_uuid_t uuid;
         uint16_t handle;
-        uint8_t value[2];
+        uint8_t channel;
 };
 
 /*
@@ -106,11 +269,75 @@ struct node_list_elem {
         bd_address_t addr;
         uint16_t conn_idx;
         void *attr_list;
+        /* nodes broadcasting their sensor record are not connected */
+        bool broadcast;
+        /* nodes collected in scheduled windows stay in the list while disconnected */
+        bool scheduled;
+        /* nodes merged from the aggregate of a relaying master are not connected */
+        bool relayed;
+        /* relayed nodes: number of relaying masters in between and the connection to the first */
+        uint8_t hops;
+        uint16_t via_conn_idx;
+        /* connected nodes: relay state and aggregate characteristic value handle */
+        uint8_t relay_state;
+        uint16_t relay_data_h;
+        /* connected nodes: fleet time characteristic value handle */
+        uint16_t time_h;
+        /* connected relaying masters: aggregate frame being read */
+        uint8_t *relay_buf;
+        uint16_t relay_size;
+        uint16_t relay_len;
+        bool relay_reading;
+        struct sensor_record record;
+        /* AGGREGATE_VALID_xxx bits of the fields of record and rssi which hold data */
+        uint8_t valid;
+        int8_t rssi;
+        /* time of the last data update, for freshness */
+        OS_TICK_TIME updated;
+        /* attributes read in the current collection cycle, and whether a value changed */
+        uint8_t cycle_reads;
+        bool cycle_changed;
+        /* aggregate generation in which the node data changed last */
+        uint16_t changed_gen;
+        /* entry sent last in an aggregate frame and its generation, base of delta frames */
+        uint16_t sent_gen;
+        struct aggregate_entry sent;
 };
 
-#define NODE_SENSOR_DATA_TRANSFER_SIZE       8
+/*
+ * Relay state of a connected node
+ */
+enum node_relay_state {
+        NODE_RELAY_UNKNOWN = 0,         /* aggregate not read yet */
+        NODE_RELAY_NO,                  /* leaf, returned an empty aggregate */
+        NODE_RELAY_YES,                 /* relaying master */
+};
+
+/* Flag whether this node acts as a Master node */
+extern bool _is_master_node;
+
+/**
+ * \brief Current fleet time in ms, the local clock until synced by a master
+ */
+uint32_t fleet_time_now(void);
+
+/**
+ * \brief Sync the fleet clock with the fleet time written by a master
+ */
+void fleet_time_sync(uint32_t fleet_ms);
+
+/**
+ * \brief Estimated drift of the local clock against the fleet clock, ppm
+ */
+int32_t fleet_time_drift(void);
+
+/**
+ * \brief Time in ms until the next epoch of \p period_ms of the fleet clock, plus \p offset_ms
+ */
+uint32_t fleet_time_epoch_delay(uint32_t period_ms, uint32_t offset_ms);
 
 void event_sent_cb(uint16_t conn_idx, bool status, gatt_event_t type);
+void ble_peripheral_notify(uint32_t mask);
 void handle_evt_gap_connected(ble_evt_gap_connected_t *evt);
 void handle_evt_gap_disconnected(ble_evt_gap_disconnected_t *evt);
 void handle_evt_gap_adv_completed(ble_evt_gap_adv_completed_t *evt);
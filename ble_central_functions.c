@@ -14,13 +14,13 @@
 
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
 
 #include "osal.h"
 #include "time.h"
 #include "sys_watchdog.h"
 #include "sdk_list.h"
 #include "ble_att.h"
+#include "ble_bufops.h"
 #include "ble_gap.h"
 #include "ble_gattc.h"
 #include "ble_gatts.h"
@@ -33,15 +33,46 @@
 #include "ble_central_functions.h"
 #include "ble_bluetanist_common.h"
 #include "ble_custom_service.h"
+#include "ble_scan_scheduler.h"
+#include "ble_conn_table.h"
+#include "ble_conn_params.h"
+#include "collect_sched.h"
+#include "ble_adv_parser.h"
+#include "deferred_log.h"
+#include "mem_stats.h"
+#include "i2c_sensors.h"
+#include "node_aggregate.h"
 
 
-/* List of devices waiting for connection */
-// TODO: use a queue for this
-__RETAINED static void *node_devices_scanned;
 /* List of devices connected */
 __RETAINED static void *node_devices_connected;
 /* Retained return data array for slave sensor data */
 __RETAINED static uint8_t *node_data;
+__RETAINED static uint16_t node_data_size;
+/* Generation of the last aggregate frame, 0 is never used */
+__RETAINED static uint16_t aggregate_generation;
+/* Nodes of closed connections, newest first, kept for a reconnection */
+__RETAINED static void *node_devices_parked;
+__RETAINED static uint8_t node_parked_count;
+/* Generation in which a node was removed last, 0 if none */
+__RETAINED static uint16_t aggregate_removed_gen;
+
+/*
+ * Aggregate notifications to subscribed clients (the phone)
+ */
+__RETAINED static ble_service_t *aggregate_svc;
+__RETAINED static OS_TASK aggregate_task;
+__RETAINED static uint32_t aggregate_notif_mask;
+__RETAINED static OS_TIMER aggregate_timer;
+__RETAINED static OS_TICK_TIME aggregate_notify_last;
+__RETAINED static bool aggregate_notify_pending;
+/* Generation the subscribers have in full, base of the next notification; 0 for a full frame */
+__RETAINED static uint16_t aggregate_notify_gen;
+#if (CFG_COLLECT_WINDOWS == 0)
+/* Periodic collection while subscribed, replaces polling */
+__RETAINED static OS_TIMER collect_timer;
+__RETAINED static bool collect_due;
+#endif
 
 /*
  * helper function for finding a node by connection id in a linked list
@@ -57,6 +88,20 @@ void *list_find_node_by_connid(void *head, const uint8_t idx)
         return e;
 }
 
+/*
+ * helper function for finding a node by BD address in a linked list
+ */
+void *list_find_node_by_addr(void *head, const bd_address_t *addr)
+{
+        struct node_list_elem *e = head;
+
+        while (e && memcmp(e->addr.addr, addr->addr, sizeof(addr->addr))) {
+                e = e->next;
+        }
+
+        return e;
+}
+
 /*
  * helper function for finding an attribute list item by handle
  */
@@ -81,54 +126,801 @@ void list_foreach_nonconst(void *head, void (* cb) (const void *, void *), void
         }
 }
 
+static void collect_node_check(struct node_list_elem *node);
+static void node_data_changed(struct node_list_elem *node);
+static bool node_make_room(uint8_t hops);
+
+/*
+ * Start reading the aggregate frame of a connected node
+ */
+static void read_relay_aggregate(struct node_list_elem *node)
+{
+        if (node->relay_buf == NULL) {
+                node->relay_buf = APP_MALLOC(MEM_SUBSYS_NODES, CFG_RELAY_FRAME_LEN);
+                if (node->relay_buf == NULL) {
+                        return;
+                }
+                node->relay_size = CFG_RELAY_FRAME_LEN;
+        }
+        node->relay_len = 0;
+
+        if (ble_gattc_read(node->conn_idx, node->relay_data_h, 0) == BLE_STATUS_OK) {
+                node->relay_reading = true;
+        }
+}
+
+/*
+ * Merge an entry of a relaying master's aggregate into the node list
+ */
+static void merge_relay_entry(struct node_list_elem *relay, const struct aggregate_entry *entry,
+                                                        const bd_address_t *own_addr, OS_TICK_TIME now)
+{
+        struct node_list_elem *node;
+        bd_address_t addr;
+
+        // loop protection: this master itself, or too far away
+        if (!memcmp(entry->addr, own_addr->addr, sizeof(entry->addr)) || entry->hops + 1 > CFG_RELAY_MAX_HOPS) {
+                return;
+        }
+
+        memcpy(&addr, &relay->addr, sizeof(addr));
+        memcpy(addr.addr, entry->addr, sizeof(addr.addr));
+        node = list_find_node_by_addr(node_devices_connected, &addr);
+
+        if (node == NULL) {
+                if (!node_make_room(entry->hops + 1)) {
+                        return;
+                }
+                node = APP_MALLOC(MEM_SUBSYS_NODES, sizeof(*node));
+                if (node == NULL) {
+                        return;
+                }
+                memset((void *)node, 0x00, sizeof(*node));
+                memcpy(&node->addr, &addr, sizeof(node->addr));
+                node->conn_idx = BLE_CONN_IDX_INVALID;
+                node->relayed = true;
+                node->hops = entry->hops + 1;
+                list_add(&node_devices_connected, node);
+        }
+
+        // nodes read by this master win, then the shortest path
+        if (!node->relayed || (node->via_conn_idx != relay->conn_idx && entry->hops + 1 > node->hops)) {
+                return;
+        }
+
+        if (node->record.sequence != entry->sequence || node->record.temperature != entry->temperature ||
+                        node->record.humidity != entry->humidity || node->record.water != entry->water ||
+                        node->hops != entry->hops + 1) {
+                node_data_changed(node);
+        }
+
+        node->hops = entry->hops + 1;
+        node->via_conn_idx = relay->conn_idx;
+        node->record.temperature = entry->temperature;
+        node->record.humidity = entry->humidity;
+        node->record.water = entry->water;
+        node->record.sequence = entry->sequence;
+        node->record.battery = entry->battery;
+        node->rssi = entry->rssi;
+        node->valid = entry->valid;
+        if (entry->age != AGGREGATE_AGE_UNKNOWN) {
+                node->updated = now - OS_MS_2_TICKS((uint32_t) entry->age * 1000);
+        }
+}
+
+/*
+ * Merge the aggregate frame read from a connected node
+ */
+static void merge_relay_aggregate(struct node_list_elem *relay)
+{
+        struct aggregate_entry entry;
+        own_address_t own_addr;
+        uint16_t generation;
+        uint32_t timestamp;
+        OS_TICK_TIME now;
+        uint8_t count, i;
+
+        // a frame cut short (the buffer could not grow) merges the entries which were read
+        if (relay->relay_len >= AGGREGATE_HDR_LEN &&
+                        relay->relay_len < AGGREGATE_HDR_LEN + relay->relay_buf[1] * AGGREGATE_ENTRY_LEN) {
+                LOG_WRN("Aggregate from %d cut at %d bytes\r\n", relay->conn_idx, relay->relay_len);
+                relay->relay_buf[1] = (relay->relay_len - AGGREGATE_HDR_LEN) / AGGREGATE_ENTRY_LEN;
+        }
+
+        if (!aggregate_decode_header(relay->relay_buf, relay->relay_len, &count, &generation, &timestamp)) {
+                LOG_WRN("Invalid aggregate from %d, %d bytes\r\n", relay->conn_idx, relay->relay_len);
+                return;
+        }
+
+        // a leaf returns an empty aggregate of generation 0 (masters skip it), do not read it again
+        if (generation == 0) {
+                relay->relay_state = NODE_RELAY_NO;
+                APP_FREE(MEM_SUBSYS_NODES, relay->relay_buf);
+                relay->relay_buf = NULL;
+                return;
+        }
+        relay->relay_state = NODE_RELAY_YES;
+
+        ble_gap_address_get(&own_addr);
+        now = OS_GET_TICK_COUNT();
+
+        for (i = 0; i < count; i++) {
+                aggregate_decode_entry(relay->relay_buf + AGGREGATE_HDR_LEN + i * AGGREGATE_ENTRY_LEN, &entry);
+                merge_relay_entry(relay, &entry, (const bd_address_t *) &own_addr, now);
+        }
+
+        LOG_INF("Merged %d nodes from relay %d, generation %u\r\n", count, relay->conn_idx, generation);
+        if (count) {
+                aggregate_notify_request();
+        }
+}
+
+/*
+ * Grow the aggregate buffer of a relaying master to the frame length announced in
+ * the header, keeping what was read. Fails if it cannot be allocated.
+ */
+static bool relay_buf_fit(struct node_list_elem *node)
+{
+        uint16_t size;
+        uint8_t *buf;
+
+        if (node->relay_len < AGGREGATE_HDR_LEN) {
+                return true;
+        }
+        // a longer frame is not valid, the entries which fit are merged
+        size = AGGREGATE_HDR_LEN + node->relay_buf[1] * AGGREGATE_ENTRY_LEN;
+        if (size > AGGREGATE_MAX_LEN) {
+                size = AGGREGATE_MAX_LEN;
+        }
+        if (size <= node->relay_size) {
+                return true;
+        }
+
+        buf = APP_MALLOC(MEM_SUBSYS_NODES, size);
+        if (buf == NULL) {
+                return false;
+        }
+        memcpy(buf, node->relay_buf, node->relay_len);
+        APP_FREE(MEM_SUBSYS_NODES, node->relay_buf);
+        node->relay_buf = buf;
+        node->relay_size = size;
+
+        return true;
+}
+
+/*
+ * Handle a (partial) read of a relaying master's aggregate, long values are read in parts
+ */
+static void handle_relay_read_completed(struct node_list_elem *node, const ble_evt_gattc_read_completed_t *info)
+{
+        uint16_t mtu = 0;
+        uint16_t len = info->length;
+
+        if (node->relay_buf == NULL) {
+                return;
+        }
+        if (len > node->relay_size - node->relay_len) {
+                len = node->relay_size - node->relay_len;
+        }
+        memcpy(node->relay_buf + node->relay_len, info->value, len);
+        node->relay_len += len;
+
+        // a full PDU means the value may continue; the rest is read if it fits the buffer
+        ble_gattc_get_mtu(info->conn_idx, &mtu);
+        if (info->length == mtu - 1 && relay_buf_fit(node) && node->relay_len < node->relay_size) {
+                ble_gattc_read(info->conn_idx, node->relay_data_h, node->relay_len);
+                return;
+        }
+
+        merge_relay_aggregate(node);
+        node->relay_reading = false;
+        collect_node_check(node);
+}
+
 void discover_node_service(const void *elem, const void *ud)
 {
         ble_error_t status;
         const struct node_list_elem *node = elem;
         const att_uuid_t *svc_uuid = ud;
 
-        printf("Starting service discovery for connection: %d\r\n", node->conn_idx);
+        // broadcasting and relayed nodes are not connected
+        if (node->broadcast || node->relayed) {
+                return;
+        }
+
+        LOG_INF("Starting service discovery for connection: %d\r\n", node->conn_idx);
+        conn_params_activity(node->conn_idx);
         status = ble_gattc_discover_svc(node->conn_idx, svc_uuid);
+
+        // read the aggregate of relaying masters, leaves return an empty one
+        if (node->relay_state == NODE_RELAY_YES && node->relay_data_h) {
+                read_relay_aggregate((struct node_list_elem *) node);
+        } else if (node->relay_state == NODE_RELAY_UNKNOWN) {
+                status = ble_gattc_discover_svc(node->conn_idx, &node_master_svc_uuid);
+        }
 }
 
-void copy_attribute_value(const void *elem, void *ud)
+/*
+ * Write the fleet time to a connected node, it aligns its sampling epochs to it
+ */
+static void sync_node_time(const struct node_list_elem *node)
 {
-        const struct sensor_attr_list_elem *attr = elem;
-        uint8_t *target = ud;
-        uint16_t offset = 0;
+        uint8_t value[sizeof(uint32_t)];
 
-        // compare this attribute's UUID to make sure data ordering is identical between nodes and read cycles
-        // the data frame: [connid][temp][humid][water]
-        // TODO: make some something better for this
-        if(ble_uuid_equal(&attr->uuid, &node_data_attr_temp)) {
-                offset = sizeof(attr->value);
-        } else if(ble_uuid_equal(&attr->uuid, &node_data_attr_humid)) {
-                offset = sizeof(attr->value)*2;
-        } else if(ble_uuid_equal(&attr->uuid, &node_data_attr_water)) {
-                offset = sizeof(attr->value)*3;
-        } else {
-                printf("copy_attribute_value(): unknown attribute uuid: %s\r\n", ble_uuid_to_string(&attr->uuid));
+        put_u32(value, fleet_time_now());
+        ble_gattc_write(node->conn_idx, node->time_h, 0, sizeof(value), value);
+}
+
+/*
+ * Start a new collection cycle
+ */
+void collect_cycle_start(const void *elem, void *ud)
+{
+        struct node_list_elem *node = (struct node_list_elem *) elem;
+
+        node->cycle_reads = 0;
+        node->cycle_changed = false;
+        if (!node->broadcast && !node->relayed) {
+                if (ble_gap_conn_rssi_get(node->conn_idx, &node->rssi) == BLE_STATUS_OK) {
+                        node->valid |= AGGREGATE_VALID_RSSI;
+                }
+                if (node->time_h) {
+                        sync_node_time(node);
+                }
+        }
+}
+
+/*
+ * Disconnect a node collected in a scheduled window once it delivered its attributes
+ * and, if it is a relaying master, its aggregate
+ */
+static void collect_node_check(struct node_list_elem *node)
+{
+#if (CFG_COLLECT_WINDOWS == 1)
+        if (node->scheduled && node->cycle_reads >= NODE_DATA_ATTR_COUNT &&
+                        node->relay_state != NODE_RELAY_UNKNOWN && !node->relay_reading) {
+                collect_sched_node_done(node->conn_idx);
+        }
+#endif
+}
+
+/*
+ * Finish the collection of a node once it delivered all its attributes
+ */
+static void collect_node_done(struct node_list_elem *node)
+{
+        if (++node->cycle_reads != NODE_DATA_ATTR_COUNT) {
+                return;
+        }
+        // connected nodes do not send a sequence number, count the complete reads with a new value instead
+        if (node->cycle_changed) {
+                node->record.sequence++;
+                node->valid |= AGGREGATE_VALID_SEQUENCE;
+                node_data_changed(node);
+                aggregate_notify_request();
+        }
+        collect_node_check(node);
+}
+
+/*
+ * Map a sensor data service attribute UUID to its sensor channel, SENSOR_CH_COUNT if unknown
+ */
+static uint8_t attr_channel_from_uuid(const att_uuid_t *uuid)
+{
+        if (ble_uuid_equal(uuid, &node_data_attr_temp)) {
+                return SENSOR_CH_TEMPERATURE;
+        } else if (ble_uuid_equal(uuid, &node_data_attr_humid)) {
+                return SENSOR_CH_HUMIDITY;
+        } else if (ble_uuid_equal(uuid, &node_data_attr_water)) {
+                return SENSOR_CH_WATER;
+        }
+
+        return SENSOR_CH_COUNT;
+}
+
+static uint16_t entry_channel(const struct aggregate_entry *entry, uint8_t channel)
+{
+        switch (channel) {
+        case SENSOR_CH_TEMPERATURE:
+                return entry->temperature;
+        case SENSOR_CH_HUMIDITY:
+                return entry->humidity;
+        case SENSOR_CH_WATER:
+                return entry->water;
+        default:
+                return 0;
+        }
+}
+
+/*
+ * Check whether a new value differs enough from the one the client got last to notify it
+ */
+static bool value_changed(const struct node_list_elem *node, uint8_t channel, uint16_t value)
+{
+        int16_t diff = (int16_t)(value - entry_channel(&node->sent, channel));
+
+        if (node->sent_gen == 0 || !(node->sent.valid & (1 << channel))) {
+                return true;
+        }
+
+        return diff >= CFG_AGGREGATE_NOTIFY_DELTA || diff <= -CFG_AGGREGATE_NOTIFY_DELTA;
+}
+
+static uint16_t record_channel(const struct sensor_record *rec, uint8_t channel)
+{
+        switch (channel) {
+        case SENSOR_CH_TEMPERATURE:
+                return rec->temperature;
+        case SENSOR_CH_HUMIDITY:
+                return rec->humidity;
+        case SENSOR_CH_WATER:
+                return rec->water;
+        default:
+                return 0;
+        }
+}
+
+static void record_set_channel(struct sensor_record *rec, uint8_t channel, uint16_t value)
+{
+        switch (channel) {
+        case SENSOR_CH_TEMPERATURE:
+                rec->temperature = value;
+                break;
+        case SENSOR_CH_HUMIDITY:
+                rec->humidity = value;
+                break;
+        case SENSOR_CH_WATER:
+                rec->water = value;
+                break;
+        default:
+                break;
+        }
+}
+
+/*
+ * Generation following \p gen, 0 is skipped on wrap around
+ */
+static uint16_t next_generation(uint16_t gen)
+{
+        return (gen == 0xFFFF) ? 1 : gen + 1;
+}
+
+/*
+ * Check whether generation \p to follows \p from within the delta window (wrapping)
+ */
+static bool generation_in_window(uint16_t from, uint16_t to)
+{
+        return (uint16_t)(to - from) <= CFG_AGGREGATE_DELTA_WINDOW;
+}
+
+/*
+ * Mark the node data changed, it goes in the next delta frame
+ */
+static void node_data_changed(struct node_list_elem *node)
+{
+        node->changed_gen = next_generation(aggregate_generation);
+}
+
+/*
+ * Match the node of a connection and the nodes relayed through it
+ */
+static bool node_match_conn(const void *elem, const void *ud)
+{
+        const struct node_list_elem *node = elem;
+        uint16_t conn_idx = *(const uint16_t *) ud;
+
+        return node->conn_idx == conn_idx || (node->relayed && node->via_conn_idx == conn_idx);
+}
+
+static void node_free(struct node_list_elem *node)
+{
+        void *attr;
+
+        while ((attr = list_pop_back(&node->attr_list)) != NULL) {
+                APP_FREE(MEM_SUBSYS_NODES, attr);
+        }
+        if (node->relay_buf) {
+                APP_FREE(MEM_SUBSYS_NODES, node->relay_buf);
+        }
+        APP_FREE(MEM_SUBSYS_NODES, node);
+}
+
+static bool node_match_addr(const void *elem, const void *ud)
+{
+        const struct node_list_elem *node = elem;
+        const bd_address_t *addr = ud;
+
+        return !memcmp(node->addr.addr, addr->addr, sizeof(addr->addr));
+}
+
+/*
+ * Make room for one more node in the list, the aggregate frame holds at most
+ * AGGREGATE_MAX_ENTRIES nodes. When the list is full the relayed node farthest away
+ * gives up its place, if it is farther than \p hops.
+ *
+ * \return false if the list is full of nodes \p hops or less away
+ */
+static bool node_make_room(uint8_t hops)
+{
+        struct node_list_elem *e, *far = NULL;
+
+        if (list_size(node_devices_connected) < AGGREGATE_MAX_ENTRIES) {
+                return true;
+        }
+
+        for (e = node_devices_connected; e; e = e->next) {
+                if (e->relayed && e->hops > hops && (far == NULL || e->hops > far->hops)) {
+                        far = e;
+                }
+        }
+        if (far == NULL) {
+                LOG_WRN("Node list full, %d nodes\r\n", AGGREGATE_MAX_ENTRIES);
+                return false;
+        }
+
+        list_unlink(&node_devices_connected, node_match_addr, &far->addr);
+        node_free(far);
+        aggregate_removed_gen = next_generation(aggregate_generation);
+
+        return true;
+}
+
+/*
+ * Park the node of a closed connection; its record, sequence, attribute handles and
+ * delta state are kept for a reconnection, the oldest parked node is released first
+ */
+static void node_park(struct node_list_elem *node)
+{
+        if (node->relay_buf) {
+                APP_FREE(MEM_SUBSYS_NODES, node->relay_buf);
+                node->relay_buf = NULL;
+        }
+        node->conn_idx = BLE_CONN_IDX_INVALID;
+        node->cycle_reads = 0;
+        node->valid &= ~AGGREGATE_VALID_RSSI;
+        // clients dropped the node with its removal, send it absolute again
+        node->sent_gen = 0;
+
+        list_add(&node_devices_parked, node);
+        if (++node_parked_count > CFG_NODE_PARK_MAX) {
+                node_free(list_pop_back(&node_devices_parked));
+                node_parked_count--;
+        }
+}
+
+/*
+ * Take a parked node back for a new connection to the same BD address
+ */
+static struct node_list_elem *node_rebind(const bd_address_t *addr, uint16_t conn_idx)
+{
+        struct node_list_elem *node = list_unlink(&node_devices_parked, node_match_addr, addr);
+
+        if (node) {
+                node_parked_count--;
+                node->conn_idx = conn_idx;
+                LOG_INF("Node rebound, connection %d\r\n", conn_idx);
+        }
+
+        return node;
+}
+
+static void relay_detach(const void *elem, void *ud)
+{
+        struct node_list_elem *node = (struct node_list_elem *) elem;
+
+        if (node->relayed && node->via_conn_idx == *(uint16_t *) ud) {
+                node->via_conn_idx = BLE_CONN_IDX_INVALID;
+        }
+}
+
+/*
+ * Remove the node of a closed connection from aggregation, and the nodes relayed through it
+ */
+void node_disconnected(uint16_t conn_idx)
+{
+        struct node_list_elem *node = list_find_node_by_connid(node_devices_connected, conn_idx);
+
+        // collected in windows: keeps its place in the aggregate, and so do the nodes it relays
+        if (node && node->scheduled) {
+                node->conn_idx = BLE_CONN_IDX_INVALID;
+                node->relay_reading = false;
+                list_foreach_nonconst(node_devices_connected, relay_detach, &conn_idx);
+                return;
+        }
+
+        while ((node = list_unlink(&node_devices_connected, node_match_conn, &conn_idx)) != NULL) {
+                if (node->relayed) {
+                        // relayed nodes are learned again from the relay's aggregate
+                        node_free(node);
+                } else {
+                        LOG_INF("Node parked, connection %d\r\n", conn_idx);
+                        node_park(node);
+                }
+                aggregate_removed_gen = next_generation(aggregate_generation);
+        }
+}
+
+/*
+ * Collect a node connected by a scheduled collection window; a node collected before
+ * is read with its cached attribute handles, without service discovery
+ */
+void collect_node(uint16_t conn_idx, const bd_address_t *addr)
+{
+        struct node_list_elem *node = list_find_node_by_addr(node_devices_connected, addr);
+        struct sensor_attr_list_elem *attr;
+
+        if (node == NULL) {
+                if (!node_make_room(0)) {
+                        return;
+                }
+                node = node_rebind(addr, conn_idx);
+                if (node == NULL) {
+                        node = APP_MALLOC(MEM_SUBSYS_NODES, sizeof(*node));
+                        if (node == NULL) {
+                                return;
+                        }
+                        memset((void *)node, 0x00, sizeof(*node));
+                        memcpy(&node->addr, addr, sizeof(node->addr));
+                        node->record.battery = SENSOR_BATTERY_UNKNOWN;
+                }
+                node_data_changed(node);
+                list_add(&node_devices_connected, node);
+        }
+
+        // a node read directly replaces a relayed copy of it
+        node->relayed = false;
+        node->hops = 0;
+        node->scheduled = true;
+        node->conn_idx = conn_idx;
+        collect_cycle_start(node, NULL);
+
+        if (list_size(node->attr_list) < NODE_DATA_ATTR_COUNT) {
+                discover_node_service(node, &node_data_svc_uuid);
                 return;
         }
 
-        memcpy(target+offset, &attr->value, sizeof(attr->value));
+        for (attr = node->attr_list; attr; attr = attr->next) {
+                // the value follows the characteristic declaration
+                ble_gattc_read(conn_idx, attr->handle + 1, 0);
+        }
+        if (node->relay_state == NODE_RELAY_YES && node->relay_data_h) {
+                read_relay_aggregate(node);
+        }
+}
+
+/*
+ * Aggregate frame encoder state
+ */
+struct aggregate_ctx {
+        uint8_t *pos;
+        OS_TICK_TIME now;
+        uint16_t generation;
+        uint16_t base;                  /* delta base, 0 for a full frame */
+        uint8_t count;
+};
+
+/*
+ * Check whether a node goes in the frame; a delta frame only holds the nodes which
+ * changed after the base
+ */
+static bool node_in_frame(const struct node_list_elem *node, const struct aggregate_ctx *ctx)
+{
+        return !ctx->base || (node->changed_gen != ctx->base && generation_in_window(ctx->base, node->changed_gen));
 }
 
-void copy_node_sensor_data(const void *elem, void *ud)
+/*
+ * Aggregate frame entry of a node
+ */
+static void node_entry(const struct node_list_elem *node, const struct aggregate_ctx *ctx,
+                                                                        struct aggregate_entry *entry)
+{
+        uint32_t age;
+
+        memcpy(entry->addr, node->addr.addr, sizeof(entry->addr));
+        entry->sequence = node->record.sequence;
+        entry->rssi = node->rssi;
+        entry->valid = node->valid;
+        entry->battery = node->record.battery;
+        entry->flags = node->relayed ? AGGREGATE_FLAG_RELAYED :
+                        (node->broadcast ? AGGREGATE_FLAG_BROADCAST : AGGREGATE_FLAG_CONNECTED);
+        entry->hops = node->hops;
+        entry->temperature = node->record.temperature;
+        entry->humidity = node->record.humidity;
+        entry->water = node->record.water;
+
+        if (node->valid & (AGGREGATE_VALID_TEMPERATURE | AGGREGATE_VALID_HUMIDITY | AGGREGATE_VALID_WATER)) {
+                age = OS_TICKS_2_MS(ctx->now - node->updated) / 1000;
+                entry->age = (age < AGGREGATE_AGE_UNKNOWN) ? age : AGGREGATE_AGE_UNKNOWN - 1;
+        } else {
+                entry->age = AGGREGATE_AGE_UNKNOWN;
+        }
+}
+
+/*
+ * Encode the aggregate frame entry of a node
+ */
+void encode_node_entry(const void *elem, void *ud)
 {
         const struct node_list_elem *node = elem;
-        uint16_t *offset = ud;
-        uint8_t attribute_data[NODE_SENSOR_DATA_TRANSFER_SIZE] = { 0 };
+        struct aggregate_ctx *ctx = ud;
+        struct aggregate_entry entry;
+        const struct aggregate_entry *prev = NULL;
+
+        if (!node_in_frame(node, ctx)) {
+                return;
+        }
+        node_entry(node, ctx, &entry);
+
+        if (ctx->base) {
+                // the client has the entry sent last if it was sent no later than the base
+                if (node->sent_gen && generation_in_window(node->sent_gen, ctx->base)) {
+                        prev = &node->sent;
+                }
+                ctx->pos += aggregate_encode_delta_entry(ctx->pos, &entry, prev);
+        } else {
+                aggregate_encode_entry(ctx->pos, &entry);
+                ctx->pos += AGGREGATE_ENTRY_LEN;
+        }
+        ctx->count++;
+}
+
+/*
+ * Record the entry of a node in a frame which was sent, the base of later delta entries
+ */
+static void commit_node_entry(const void *elem, void *ud)
+{
+        struct node_list_elem *node = (struct node_list_elem *) elem;
+        const struct aggregate_ctx *ctx = ud;
+
+        if (!node_in_frame(node, ctx)) {
+                return;
+        }
+        node_entry(node, ctx, &node->sent);
+        node->sent_gen = ctx->generation;
+}
+
+/*
+ * Write request callback: the client writes the last aggregate generation it has seen
+ * to get delta frames, anything else than a generation selects full frames.
+ */
+void set_node_data_base_cb(const uint8_t *value, uint16_t length)
+{
+        struct conn_entry *conn = conn_table_find(mcs_request_conn_idx());
+
+        if (conn) {
+                conn->delta_base = (length == sizeof(uint16_t)) ? get_u16(value) : 0;
+        }
+}
+
+#if (CFG_COLLECT_WINDOWS == 0)
+/*
+ * Start a collection cycle of the connected nodes
+ */
+static void collect_cycle_run(void)
+{
+        int i;
+
+        /*
+         * 1: push all connected nodes in the connected node list
+         */
+        LOG_INF("Requesting data from %d nodes\r\n", conn_table_count(CONN_ROLE_NODE));
+        for (i = 0; i < CONN_TABLE_SIZE; i++) {
+                const struct conn_entry *conn = &conn_table[i];
+
+                // skip the phone or a parent master, skip if connected device already in list
+                if (conn->role != CONN_ROLE_NODE ||
+                                list_find_node_by_connid(node_devices_connected, conn->conn_idx) != NULL) {
+                        continue;
+                }
+                if (!node_make_room(0)) {
+                        break;
+                }
+                // a reconnected node gets its parked state back
+                struct node_list_elem *node = node_rebind(&conn->addr, conn->conn_idx);
+
+                if (node == NULL) {
+                        // append the node to the linked list for later connection
+                        node = APP_MALLOC(MEM_SUBSYS_NODES, sizeof(*node));
+                        if (node == NULL) {
+                                break;
+                        }
+
+                        // initial zero values
+                        /* zero the struct */
+                        memset((void *)node, 0x00, sizeof(*node));
+
+                        node->conn_idx = conn->conn_idx;
+                        memcpy(&node->addr, &conn->addr, sizeof(node->addr));
+                        node->record.battery = SENSOR_BATTERY_UNKNOWN;
+                }
+                node_data_changed(node);
+                list_add(&node_devices_connected, node);
+        }
+
+        /*
+         * 2: request new node data
+         * Initiate a service scan for the node data service, this will trigger
+         * a chain of async calls with eventually new sensor data.
+         * Runs on every read and, while the aggregate is subscribed, periodically.
+         */
+        att_uuid_t data_svc_uuid;
+        ble_uuid_from_string(NODE_DATA_SVC_UUID, &data_svc_uuid);
+
+        list_foreach_nonconst(node_devices_connected, collect_cycle_start, NULL);
+
+        list_foreach(node_devices_connected, discover_node_service, &data_svc_uuid);
+}
+#endif /* CFG_COLLECT_WINDOWS */
+
+/*
+ * Encode the aggregate frame in a single pass into node_data; a delta frame against
+ * \p base if it is recent enough, a full frame otherwise. node_data is a scratch buffer,
+ * the frame only takes effect with commit_aggregate() once it is sent.
+ *
+ * \return frame length, \p ctx holds the generation, the base used and the entry count;
+ *         0 without a frame if the buffer cannot grow
+ */
+static uint16_t build_aggregate(struct aggregate_ctx *ctx, uint16_t base)
+{
+        uint16_t size = AGGREGATE_DELTA_HDR_LEN + list_size(node_devices_connected) * AGGREGATE_DELTA_ENTRY_MAX_LEN;
+        uint8_t *buf;
+
+        ctx->count = 0;
 
-        // copy the connection id for identification
-        // TODO: send the device MAC address as well
-        memcpy(attribute_data, &node->conn_idx, sizeof(node->conn_idx));
-        // index += 2 effectively; for each attribute as all attributes are 2 bytes
-        list_foreach_nonconst(node->attr_list, copy_attribute_value, &attribute_data);
+        /*
+         * The buffer only grows. Nothing refers to it between frames: a read response,
+         * the continuations of a long read (a copy kept by the custom service) and a
+         * notification are all copied out before the next frame is built.
+         */
+        if (size > node_data_size) {
+                buf = APP_MALLOC(MEM_SUBSYS_COLLECT, size);
+                if (buf == NULL) {
+                        LOG_WRN("No memory for a %d byte aggregate\r\n", size);
+                        return 0;
+                }
+                APP_FREE(MEM_SUBSYS_COLLECT, node_data);
+                node_data = buf;
+                node_data_size = size;
+        }
 
-        memcpy(node_data+*offset, attribute_data, sizeof(attribute_data));
+        ctx->now = OS_GET_TICK_COUNT();
+        ctx->generation = next_generation(aggregate_generation);
+        ctx->base = 0;
+        // nodes removed after the base cannot be expressed in a delta frame
+        if (base && generation_in_window(base, aggregate_generation) &&
+                        !(aggregate_removed_gen && aggregate_removed_gen != base &&
+                                generation_in_window(base, aggregate_removed_gen))) {
+                ctx->base = base;
+        }
+        ctx->pos = node_data + (ctx->base ? AGGREGATE_DELTA_HDR_LEN : AGGREGATE_HDR_LEN);
+        list_foreach_nonconst(node_devices_connected, encode_node_entry, ctx);
+
+        // a delta frame longer than a full one does not fit an attribute value, send the full one
+        if (ctx->base && ctx->pos - node_data > AGGREGATE_MAX_LEN) {
+                ctx->base = 0;
+                ctx->count = 0;
+                ctx->pos = node_data + AGGREGATE_HDR_LEN;
+                list_foreach_nonconst(node_devices_connected, encode_node_entry, ctx);
+        }
 
-        *offset += sizeof(attribute_data);
+        if (ctx->base) {
+                aggregate_encode_delta_header(node_data, ctx->count, ctx->generation, ctx->base,
+                                                                        fleet_time_now());
+        } else {
+                aggregate_encode_header(node_data, ctx->count, ctx->generation, fleet_time_now());
+        }
+
+        return ctx->pos - node_data;
+}
+
+/*
+ * Take the frame built by build_aggregate() as sent: its generation becomes the last one
+ * and its entries the base of the next delta entries
+ */
+static void commit_aggregate(const struct aggregate_ctx *ctx)
+{
+        list_foreach_nonconst(node_devices_connected, commit_node_entry, (void *) ctx);
+        aggregate_generation = ctx->generation;
 }
 
 /*
@@ -150,62 +942,175 @@ void copy_node_sensor_data(const void *elem, void *ud)
  */
 void get_node_data_cb(uint8_t **value, uint16_t *length)
 {
-        ble_error_t status;
-        uint8_t conn_count;
-        uint16_t *conn_idx;
-        int i;
+        struct aggregate_ctx ctx;
+        struct conn_entry *conn;
+        uint16_t base;
 
         /*
-         * 1: push all connected nodes in the connected node list
+         * 0: a leaf has no nodes; return an empty aggregate of generation 0 so a master
+         * reading it knows it is not a relaying master
          */
-        taskENTER_CRITICAL();
-        status = ble_gap_get_connected(&conn_count, &conn_idx);
-        taskEXIT_CRITICAL();
-        if(status == BLE_STATUS_OK) {
-                printf("Requesting data from %d nodes\r\n", conn_count);
-        }
-        for (i = 0; i < conn_count; i++) {
-                // skip if connected device already in list
-                if(list_find_node_by_connid(node_devices_connected, conn_idx[i]) != NULL) {
-                        continue;
-                }
-                // append the node to the linked list for later connection
-                struct node_list_elem *node = OS_MALLOC(sizeof(*node));
-
-                // initial zero values
-                /* zero the struct */
-                memset((void *)node, 0x00, sizeof(*node));
+        if (!_is_master_node) {
+                static uint8_t empty_aggregate[AGGREGATE_HDR_LEN];
 
-                memcpy(&node->conn_idx, &conn_idx[i], sizeof(node->conn_idx));
-                list_add(&node_devices_connected, node);
+                aggregate_encode_header(empty_aggregate, 0, 0, fleet_time_now());
+                *value = empty_aggregate;
+                *length = sizeof(empty_aggregate);
+                return;
         }
-        OS_FREE(conn_idx);
 
+#if (CFG_COLLECT_WINDOWS == 0)
         /*
-         * 2: request new node data
-         * Initiate a service scan for the node data service, this will trigger
-         * a chain of async calls with eventually new sensor data.
-         * TODO: this should be done periodically
+         * 1, 2: collect new node data
          */
-        att_uuid_t data_svc_uuid;
-        ble_uuid_from_string(NODE_DATA_SVC_UUID, &data_svc_uuid);
-
-        list_foreach(node_devices_connected, discover_node_service, &data_svc_uuid);
+        collect_cycle_run();
+#endif
 
         /*
-         * 3: return (old) node data
+         * 3: return (old) node data as an aggregate frame,
+         * a delta frame if the client's base generation is recent enough
          */
-        uint16_t offset = 0;
-        if(node_data != NULL) {
-                OS_FREE(node_data);
+        // the base only applies to the next read of the connection which wrote it, others get full frames
+        conn = conn_table_find(mcs_request_conn_idx());
+        base = conn ? conn->delta_base : 0;
+        if (conn) {
+                conn->delta_base = 0;
         }
-        node_data = OS_MALLOC(list_size(node_devices_connected) * NODE_SENSOR_DATA_TRANSFER_SIZE);
-        list_foreach_nonconst(node_devices_connected, copy_node_sensor_data, &offset);
-
+        *length = build_aggregate(&ctx, base);
         *value = node_data;
-        *length = offset;
+        if (*length == 0) {
+                return;
+        }
+        commit_aggregate(&ctx);
+
+        // a subscriber caught up with a read, notifications continue from this frame
+        if (ctx.base && ctx.base == aggregate_notify_gen) {
+                aggregate_notify_gen = ctx.generation;
+        }
+}
+
+/*
+ * Largest notification all peers (the phone, a parent master) can receive
+ */
+static uint16_t aggregate_notify_max_len(void)
+{
+        uint16_t mtu = 0xFFFF;
+        int i;
+
+        for (i = 0; i < CONN_TABLE_SIZE; i++) {
+                if (conn_table[i].role == CONN_ROLE_PEER && conn_table[i].mtu < mtu) {
+                        mtu = conn_table[i].mtu;
+                }
+        }
+
+        return ((mtu == 0xFFFF) ? CONN_DEFAULT_MTU : mtu) - 3;
+}
+
+/*
+ * Notify the nodes which changed since the last notification as a delta frame. If the
+ * frame does not fit in a notification only its header is sent, without entries; the
+ * subscribers then read the aggregate. The header alone is not committed, the read
+ * gets the frame of the generation it announces.
+ */
+static void notify_aggregate(void)
+{
+        struct aggregate_ctx ctx;
+        uint16_t length;
+
+        if (!mcs_has_subscribers(aggregate_svc, NODE_MASTER_DATA_IDX)) {
+                return;
+        }
+
+        length = build_aggregate(&ctx, aggregate_notify_gen);
+        if (ctx.count == 0) {
+                return;
+        }
+        if (length > aggregate_notify_max_len()) {
+                aggregate_encode_delta_header(node_data, 0, ctx.generation, ctx.base, fleet_time_now());
+                length = AGGREGATE_DELTA_HDR_LEN;
+        } else {
+                commit_aggregate(&ctx);
+                aggregate_notify_gen = ctx.generation;
+        }
+
+        mcs_notify_characteristic(aggregate_svc, NODE_MASTER_DATA_IDX, length, node_data);
 }
 
+static void aggregate_timer_cb(OS_TIMER timer)
+{
+        OS_TASK_NOTIFY(aggregate_task, aggregate_notif_mask, eSetBits);
+}
+
+#if (CFG_COLLECT_WINDOWS == 0)
+static void collect_timer_cb(OS_TIMER timer)
+{
+        collect_due = true;
+        OS_TASK_NOTIFY(aggregate_task, aggregate_notif_mask, eSetBits);
+}
+#endif
+
+void aggregate_notify_init(OS_TASK task, uint32_t notif_mask, ble_service_t *svc)
+{
+        aggregate_task = task;
+        aggregate_notif_mask = notif_mask;
+        aggregate_svc = svc;
+
+        aggregate_timer = OS_TIMER_CREATE("aggr_notify", OS_MS_2_TICKS(CFG_AGGREGATE_NOTIFY_MIN_MS),
+                                                                OS_TIMER_ONCE, NULL, aggregate_timer_cb);
+        OS_ASSERT(aggregate_timer);
+#if (CFG_COLLECT_WINDOWS == 0)
+        collect_timer = OS_TIMER_CREATE("collect", OS_MS_2_TICKS(CFG_COLLECT_PERIOD_MS),
+                                                                OS_TIMER_RELOAD, NULL, collect_timer_cb);
+        OS_ASSERT(collect_timer);
+#endif
+}
+
+void aggregate_notify_start(void)
+{
+#if (CFG_COLLECT_WINDOWS == 0)
+        OS_TIMER_START(collect_timer, OS_TIMER_FOREVER);
+#endif
+}
+
+void aggregate_notify_request(void)
+{
+        if (aggregate_notify_pending || aggregate_svc == NULL) {
+                return;
+        }
+        aggregate_notify_pending = true;
+        OS_TASK_NOTIFY(aggregate_task, aggregate_notif_mask, eSetBits);
+}
+
+void aggregate_notify_process(void)
+{
+        OS_TICK_TIME since = OS_GET_TICK_COUNT() - aggregate_notify_last;
+
+#if (CFG_COLLECT_WINDOWS == 0)
+        // collect periodically while subscribed, nobody polls
+        if (collect_due) {
+                collect_due = false;
+                if (_is_master_node && mcs_has_subscribers(aggregate_svc, NODE_MASTER_DATA_IDX)) {
+                        collect_cycle_run();
+                }
+        }
+#endif
+
+        if (!aggregate_notify_pending) {
+                return;
+        }
+        // coalesce: at most one notification per CFG_AGGREGATE_NOTIFY_MIN_MS
+        if (since < OS_MS_2_TICKS(CFG_AGGREGATE_NOTIFY_MIN_MS)) {
+                if (!OS_TIMER_IS_ACTIVE(aggregate_timer)) {
+                        OS_TIMER_CHANGE_PERIOD(aggregate_timer, OS_MS_2_TICKS(CFG_AGGREGATE_NOTIFY_MIN_MS) - since,
+                                                                                        OS_TIMER_FOREVER);
+                }
+                return;
+        }
+        aggregate_notify_pending = false;
+        aggregate_notify_last = OS_GET_TICK_COUNT();
+
+        notify_aggregate();
+}
 
 /*
  * Main code
@@ -213,29 +1118,21 @@ void get_node_data_cb(uint8_t **value, uint16_t *length)
 
 /*
  * Handler for ble_gap_scan_start call.
- * Initiates a scan procedure.
+ * Initiates a scan procedure with the given type, mode and duty cycle.
  * Prints scan parameters and status returned by call
  */
-bool gap_scan_start()
+bool gap_scan_start(gap_scan_type_t type, gap_scan_mode_t mode, uint16_t interval, uint16_t window,
+                                                                                        bool filt_dup)
 {
         ble_error_t status;
-        gap_scan_params_t scan_params;
-        gap_scan_type_t type = CFG_SCAN_TYPE;
-        gap_scan_mode_t mode = CFG_SCAN_MODE;
-        bool filt_dup = CFG_SCAN_FILT_DUPLT;
         bool wlist = CFG_SCAN_FILT_WLIST;
-        uint16_t interval, window;
-
-        ble_gap_scan_params_get(&scan_params);
-
-        window = scan_params.window;
-        interval = scan_params.interval;
 
         status = ble_gap_scan_start(type, mode, interval, window, wlist, filt_dup);
 
-        printf("BlueTanist node scan started [%d]\r\n", status);
+        LOG_INF("BlueTanist node scan started [%d] mode: %d, interval: %d, window: %d\r\n",
+                                                                status, mode, interval, window);
 
-        return true;
+        return status == BLE_STATUS_OK;
 }
 
 /*
@@ -244,44 +1141,110 @@ bool gap_scan_start()
  */
 bool gap_connect(const bd_address_t *addr)
 {
-        gap_conn_params_t params = CFG_CONN_PARAMS;
+        gap_conn_params_t params = CFG_CONN_PARAMS_FAST;
+        ble_error_t status;
 
-        printf("Initiating connection to: %s\r\n", ble_address_to_string(addr));
+        LOG_INF("Initiating connection to: " LOG_ADDR_FMT "\r\n", LOG_ADDR(addr));
 
         // keep trying if busy connecting other node
-        while(BLE_ERROR_BUSY == ble_gap_connect(addr, &params)) {
+        while(BLE_ERROR_BUSY == (status = ble_gap_connect(addr, &params))) {
                 // Arbitrary delay to not flood the connect
                 OS_DELAY_MS(100);
         }
 
+        if (status != BLE_STATUS_OK) {
+                return false;
+        }
+        // the connected event classifies the connection as a node by this mark
+        conn_table_connecting(addr);
+
         return true;
 }
 
+/*
+ * Store a sensor record broadcast by a node, the node is never connected
+ */
+static void handle_broadcast_record(const bd_address_t *addr, int8_t rssi, const struct sensor_record *rec)
+{
+        struct node_list_elem *node = list_find_node_by_addr(node_devices_connected, addr);
+        uint8_t ch;
+
+        if (node == NULL) {
+                // whitelist the node so background scans keep accepting its reports
+                if (!scan_sched_node_broadcasting(addr) || !node_make_room(0)) {
+                        return;
+                }
+
+                node = APP_MALLOC(MEM_SUBSYS_NODES, sizeof(*node));
+                if (node == NULL) {
+                        return;
+                }
+                memset((void *)node, 0x00, sizeof(*node));
+                memcpy(&node->addr, addr, sizeof(node->addr));
+                node->conn_idx = BLE_CONN_IDX_INVALID;
+                node->broadcast = true;
+                list_add(&node_devices_connected, node);
+
+                LOG_INF("BlueTanist broadcasting node found: [" LOG_ADDR_FMT "]\r\n", LOG_ADDR(addr));
+        }
+
+        node->updated = OS_GET_TICK_COUNT();
+        node->rssi = rssi;
+        // the same record is advertised until the next sample, repeated reports change nothing
+        if ((node->valid & AGGREGATE_VALID_SEQUENCE) && node->record.sequence == rec->sequence &&
+                        node->record.temperature == rec->temperature && node->record.humidity == rec->humidity &&
+                        node->record.water == rec->water && node->record.battery == rec->battery) {
+                return;
+        }
+
+        for (ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+                if (value_changed(node, ch, record_channel(rec, ch))) {
+                        aggregate_notify_request();
+                        break;
+                }
+        }
+
+        memcpy(&node->record, rec, sizeof(node->record));
+        node->valid = AGGREGATE_VALID_TEMPERATURE | AGGREGATE_VALID_HUMIDITY | AGGREGATE_VALID_WATER |
+                                                        AGGREGATE_VALID_SEQUENCE | AGGREGATE_VALID_RSSI;
+        if (rec->battery != SENSOR_BATTERY_UNKNOWN) {
+                node->valid |= AGGREGATE_VALID_BATTERY;
+        }
+        node_data_changed(node);
+}
+
 /*
  * Print GAP advertising report event information
  * Whitelist management API is not present in this SDK release. so we scan for all devices
- * and filter them manually.
+ * and filter them manually. The scan scheduler keeps the whitelist of known nodes.
  */
 void handle_ble_evt_gap_adv_report(ble_evt_gap_adv_report_t *info)
 {
-        int i;
-        int offset;
+        struct adv_report_info adv;
 
-        // the tail of the adv info is AD flags. Get the offset where the actual id starts.
-        offset = info->length - adv_data->len;
+        // cheap address check first, in background mode only known nodes are accepted
+        if (!scan_sched_accepts(&info->address)) {
+                return;
+        }
 
-        // compare the device advertised UUID against our advertised UUID
-        for (i = info->length-1; i >= offset; i--) {
-                if(info->data[i] != adv_data->data[i-offset]) {
-                        return;
-                }
+        // look for our advertised service UUID in any AD structure of the report
+        adv_parse_report(info->data, info->length, adv_data->data, &adv);
+
+        // observer path: take the broadcast sensor record, no connection needed
+        if (adv.has_record) {
+                handle_broadcast_record(&info->address, info->rssi, &adv.record);
+                return;
         }
-        printf("BlueTanist node found: [%s]\r\n", ble_address_to_string(&info->address));
 
-        // append the node to the linked list for later connection
-        struct node_list_elem *node = OS_MALLOC(sizeof(*node));
-        memcpy(&node->addr, &info->address, sizeof(node->addr));
-        list_add(&node_devices_scanned, node);
+        if (!adv.uuid_match) {
+                return;
+        }
+
+        // mark the node for connection if accepted by the scan scheduler
+        if (scan_sched_node_seen(&info->address)) {
+                LOG_INF("BlueTanist node found: [" LOG_ADDR_FMT "] rssi: %d\r\n", LOG_ADDR(&info->address),
+                                                                                        info->rssi);
+        }
 }
 
 /*
@@ -289,16 +1252,19 @@ void handle_ble_evt_gap_adv_report(ble_evt_gap_adv_report_t *info)
  */
 void handle_ble_evt_gap_scan_completed(const ble_evt_gap_scan_completed_t *info)
 {
-        struct node_list_elem *element;
-
-        printf("BlueTanist node scan completed. Found %d nodes\r\n", list_size(node_devices_scanned));
+        bd_address_t addr;
+        int found = 0;
 
         // connect all found nodes
-        while(node_devices_scanned != NULL) {
-                element = (struct node_list_elem *) list_pop_back(&node_devices_scanned);
-                gap_connect(&element->addr);
-                OS_FREE(element);
+        while (scan_sched_pop_pending(&addr)) {
+                gap_connect(&addr);
+                found++;
         }
+
+        LOG_INF("BlueTanist node scan completed. Found %d nodes\r\n", found);
+
+        // schedule the next scan
+        scan_sched_scan_completed();
 }
 
 /*
@@ -309,7 +1275,7 @@ void handle_ble_evt_gattc_discover_svc(const ble_evt_gattc_discover_svc_t *info)
         ble_error_t status;
 
         // sensor data service discovered, scan for attributes
-        printf("Service discovered for %d: %s\r\n", info->conn_idx, ble_uuid_to_string(&info->uuid));
+        LOG_DBG("Service discovered for %d: handles %04x-%04x\r\n", info->conn_idx, info->start_h, info->end_h);
         status = ble_gattc_discover_char(info->conn_idx, info->start_h, info->end_h, NULL);
 }
 
@@ -320,19 +1286,39 @@ void handle_ble_evt_gattc_discover_char(const ble_evt_gattc_discover_char_t *inf
 {
         ble_error_t status;
 
-        printf("Characteristic discovered for %d: %s\r\n", info->conn_idx, ble_uuid_to_string(&info->uuid));
+        LOG_DBG("Characteristic discovered for %d: handle %04x\r\n", info->conn_idx, info->handle);
 
         // add the attribute to the node's attribute list
         struct node_list_elem *node = list_find_node_by_connid(node_devices_connected, info->conn_idx);
         if(node == NULL) {
                 return;
         }
+        // aggregate of a (possibly) relaying master
+        if (ble_uuid_equal(&info->uuid, &node_master_attr_data)) {
+                node->relay_data_h = info->value_handle;
+                read_relay_aggregate(node);
+                return;
+        }
+        if (ble_uuid_equal(&info->uuid, &node_master_attr_time)) {
+                node->time_h = info->value_handle;
+                sync_node_time(node);
+                return;
+        }
+        uint8_t channel = attr_channel_from_uuid(&info->uuid);
+        if (channel >= SENSOR_CH_COUNT) {
+                return;
+        }
         // add the attribute to the attr list if needed (not needed on re-reads)
         struct sensor_attr_list_elem *elem = list_find_attr_by_handle(node->attr_list, info->handle);
         if(elem == NULL) {
-                struct sensor_attr_list_elem *elem = OS_MALLOC(sizeof(*elem));
+                elem = APP_MALLOC(MEM_SUBSYS_NODES, sizeof(*elem));
+                if (elem == NULL) {
+                        // a value without its attribute has no channel, skip it
+                        LOG_WRN("No memory for attribute %04x of %d\r\n", info->handle, info->conn_idx);
+                        return;
+                }
                 memcpy(&elem->handle, &info->handle, sizeof(elem->handle));
-                memcpy(&elem->uuid, &info->uuid, sizeof(elem->uuid));
+                elem->channel = channel;
                 list_add(&node->attr_list, elem);
         }
 
@@ -345,30 +1331,51 @@ void handle_ble_evt_gattc_discover_char(const ble_evt_gattc_discover_char_t *inf
  */
 void handle_ble_evt_gattc_read_completed(ble_evt_gattc_read_completed_t *info)
 {
-        int i;
+        uint16_t value;
 
-        printf("Characteristic read for %d, length: %d, value: ", info->conn_idx, info->length);
         if(info->status == ATT_ERROR_OK)
         {
                 /*
-                 * copy the value to the list element
+                 * store the value in the node record
                  * if node or attribute do not yet exist something has gone wrong; ignore it
                  */
                 struct node_list_elem *node = list_find_node_by_connid(node_devices_connected, info->conn_idx);
                 if(node == NULL) {
                         return;
                 }
+                if (node->relay_data_h && info->handle == node->relay_data_h) {
+                        handle_relay_read_completed(node, info);
+                        return;
+                }
                 // TODO: why is `handle` off by 1?
                 struct sensor_attr_list_elem *elem = list_find_attr_by_handle(node->attr_list, info->handle-1);
-                if(elem == NULL) {
+                if(elem == NULL || elem->channel >= SENSOR_CH_COUNT || info->length < sizeof(uint16_t)) {
                         return;
                 }
-                memcpy(&elem->value, &info->value, sizeof(elem->value));
+                value = get_u16(info->value);
+                if (value_changed(node, elem->channel, value)) {
+                        aggregate_notify_request();
+                }
+                // a value read again unchanged does not go in the next delta frame
+                if (!(node->valid & (1 << elem->channel)) || record_channel(&node->record, elem->channel) != value) {
+                        record_set_channel(&node->record, elem->channel, value);
+                        node->valid |= 1 << elem->channel;
+                        node->cycle_changed = true;
+                        node_data_changed(node);
+                }
+                node->updated = OS_GET_TICK_COUNT();
+                collect_node_done(node);
 
-                for (i = 0; i < info->length; ++i) {
-                        printf("%02x", elem->value[i]);
+                LOG_DBG("Characteristic read for %d, channel: %d, value: %u\r\n",
+                                                        info->conn_idx, elem->channel, value);
+        } else {
+                LOG_WRN("Characteristic read for %d failed: %d\r\n", info->conn_idx, info->status);
+
+                struct node_list_elem *node = list_find_node_by_connid(node_devices_connected, info->conn_idx);
+                if (node && node->relay_data_h && info->handle == node->relay_data_h) {
+                        node->relay_reading = false;
+                        collect_node_check(node);
                 }
-                printf("\r\n");
         }
 }
 
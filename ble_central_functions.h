@@ -9,9 +9,19 @@
 #define BLE_CENTRAL_FUNCTIONS_H_
 
 #include <stdbool.h>
+#include "osal.h"
+#include "ble_service.h"
 
 void get_node_data_cb(uint8_t **value, uint16_t *length);
-bool gap_scan_start();
+void set_node_data_base_cb(const uint8_t *value, uint16_t length);
+void node_disconnected(uint16_t conn_idx);
+void collect_node(uint16_t conn_idx, const bd_address_t *addr);
+void aggregate_notify_init(OS_TASK task, uint32_t notif_mask, ble_service_t *svc);
+void aggregate_notify_start(void);
+void aggregate_notify_request(void);
+void aggregate_notify_process(void);
+bool gap_scan_start(gap_scan_type_t type, gap_scan_mode_t mode, uint16_t interval, uint16_t window,
+                                                                                        bool filt_dup);
 bool gap_connect(const bd_address_t *addr);
 void handle_ble_evt_gap_adv_report(ble_evt_gap_adv_report_t *info);
 void handle_ble_evt_gap_scan_completed(const ble_evt_gap_scan_completed_t *info);
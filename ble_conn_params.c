@@ -0,0 +1,184 @@
+/*
+ * ble_conn_params.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Connection parameter manager.
+ *
+ * A connection with GATT activity (discovery, reads, writes) is switched to the
+ * fast parameters so bursts complete quickly. Once a connection saw no activity
+ * for CFG_CONN_IDLE_MS it is switched to the idle parameters: a long interval and
+ * slave latency, notifications still get through but the radio of the node is off
+ * most of the time. Updates are negotiated with the LL procedure as master and the
+ * L2CAP connection parameter update request as slave, both by ble_gap_conn_param_update().
+ *
+ * The profile of a connection is derived from its negotiated parameters in the
+ * connection table, so both ends of a link asking for the same profile do not
+ * cause extra updates.
+ */
+
+#include <stdbool.h>
+
+#include "osal.h"
+#include "ble_gap.h"
+#include "ble_gattc.h"
+#include "ble_gatts.h"
+
+#include "ble_bluetanist_common.h"
+#include "ble_conn_table.h"
+#include "ble_conn_params.h"
+#include "deferred_log.h"
+
+static const gap_conn_params_t params_fast = CFG_CONN_PARAMS_FAST;
+static const gap_conn_params_t params_idle = CFG_CONN_PARAMS_IDLE;
+
+__RETAINED static OS_TIMER idle_timer;
+__RETAINED static OS_TASK params_task;
+__RETAINED static uint32_t params_notif_mask;
+
+static void idle_timer_cb(OS_TIMER timer)
+{
+        OS_TASK_NOTIFY(params_task, params_notif_mask, eSetBits);
+}
+
+void conn_params_init(OS_TASK task, uint32_t notif_mask)
+{
+        params_task = task;
+        params_notif_mask = notif_mask;
+
+        idle_timer = OS_TIMER_CREATE("conn_params", OS_MS_2_TICKS(CFG_CONN_IDLE_MS),
+                                                                OS_TIMER_RELOAD, NULL, idle_timer_cb);
+        OS_ASSERT(idle_timer);
+}
+
+/*
+ * Profile the negotiated parameters of a connection correspond to
+ */
+static uint8_t current_mode(const struct conn_entry *conn)
+{
+        if (conn->interval <= params_fast.interval_max && conn->latency == 0) {
+                return CONN_PARAMS_FAST;
+        }
+        if (conn->interval >= params_idle.interval_min) {
+                return CONN_PARAMS_IDLE;
+        }
+
+        return CONN_PARAMS_NONE;
+}
+
+static void request_mode(struct conn_entry *conn, uint8_t mode)
+{
+        const gap_conn_params_t *params = (mode == CONN_PARAMS_FAST) ? &params_fast : &params_idle;
+        ble_error_t status;
+
+        if (current_mode(conn) == mode || conn->params_req != CONN_PARAMS_NONE) {
+                return;
+        }
+
+        status = ble_gap_conn_param_update(conn->conn_idx, params);
+        if (status == BLE_STATUS_OK) {
+                conn->params_req = mode;
+        }
+        LOG_DBG("Connection %d parameters %s: %d\r\n", conn->conn_idx,
+                                                (mode == CONN_PARAMS_FAST) ? "fast" : "idle", status);
+}
+
+void conn_params_activity(uint16_t conn_idx)
+{
+        struct conn_entry *conn = conn_table_find(conn_idx);
+
+        if (conn == NULL) {
+                return;
+        }
+
+        conn->last_activity = OS_GET_TICK_COUNT();
+        request_mode(conn, CONN_PARAMS_FAST);
+
+        if (!OS_TIMER_IS_ACTIVE(idle_timer)) {
+                OS_TIMER_START(idle_timer, OS_TIMER_FOREVER);
+        }
+}
+
+/*
+ * Accept parameters requested by the peer within the range of the profiles
+ */
+static void handle_update_req(const ble_evt_gap_conn_param_update_req_t *evt)
+{
+        const gap_conn_params_t *req = &evt->conn_params;
+        bool accept = req->interval_min >= params_fast.interval_min &&
+                        req->interval_max <= params_idle.interval_max &&
+                        req->slave_latency <= params_idle.slave_latency;
+
+        ble_gap_conn_param_update_reply(evt->conn_idx, accept);
+}
+
+bool conn_params_handle_event(const ble_evt_hdr_t *evt)
+{
+        switch (evt->evt_code) {
+        case BLE_EVT_GATTS_READ_REQ:
+                conn_params_activity(((const ble_evt_gatts_read_req_t *) evt)->conn_idx);
+                break;
+        case BLE_EVT_GATTS_WRITE_REQ:
+                conn_params_activity(((const ble_evt_gatts_write_req_t *) evt)->conn_idx);
+                break;
+        case BLE_EVT_GATTS_PREPARE_WRITE_REQ:
+                conn_params_activity(((const ble_evt_gatts_prepare_write_req_t *) evt)->conn_idx);
+                break;
+        case BLE_EVT_GATTC_DISCOVER_SVC:
+                conn_params_activity(((const ble_evt_gattc_discover_svc_t *) evt)->conn_idx);
+                break;
+        case BLE_EVT_GATTC_DISCOVER_CHAR:
+                conn_params_activity(((const ble_evt_gattc_discover_char_t *) evt)->conn_idx);
+                break;
+        case BLE_EVT_GATTC_READ_COMPLETED:
+                conn_params_activity(((const ble_evt_gattc_read_completed_t *) evt)->conn_idx);
+                break;
+        case BLE_EVT_GAP_CONN_PARAM_UPDATE_REQ:
+                handle_update_req((const ble_evt_gap_conn_param_update_req_t *) evt);
+                return true;
+        case BLE_EVT_GAP_CONN_PARAM_UPDATE_COMPLETED:
+        {
+                const ble_evt_gap_conn_param_update_completed_t *info =
+                                                (const ble_evt_gap_conn_param_update_completed_t *) evt;
+                struct conn_entry *conn = conn_table_find(info->conn_idx);
+
+                if (conn) {
+                        conn->params_req = CONN_PARAMS_NONE;
+                }
+                return true;
+        }
+        default:
+                break;
+        }
+
+        return false;
+}
+
+void conn_params_process(void)
+{
+        OS_TICK_TIME now = OS_GET_TICK_COUNT();
+        bool busy = false;
+        int i;
+
+        for (i = 0; i < CONN_TABLE_SIZE; i++) {
+                struct conn_entry *conn = &conn_table[i];
+
+                if (conn->role == CONN_ROLE_FREE) {
+                        continue;
+                }
+                if (now - conn->last_activity < OS_MS_2_TICKS(CFG_CONN_IDLE_MS)) {
+                        busy = true;
+                        continue;
+                }
+                request_mode(conn, CONN_PARAMS_IDLE);
+                // check again until the update went through
+                if (current_mode(conn) != CONN_PARAMS_IDLE) {
+                        busy = true;
+                }
+        }
+
+        if (!busy) {
+                OS_TIMER_STOP(idle_timer, OS_TIMER_FOREVER);
+        }
+}
@@ -0,0 +1,59 @@
+/*
+ * ble_conn_params.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef BLE_CONN_PARAMS_H_
+#define BLE_CONN_PARAMS_H_
+
+#include <stdint.h>
+#include "osal.h"
+#include "ble_common.h"
+
+/*
+ * Connection parameter profiles
+ *
+ * FAST: CFG_CONN_PARAMS_FAST, discovery and bulk transfer
+ * IDLE: CFG_CONN_PARAMS_IDLE, steady state notifications
+ */
+enum conn_params_mode {
+        CONN_PARAMS_NONE = 0,
+        CONN_PARAMS_FAST,
+        CONN_PARAMS_IDLE,
+};
+
+/**
+ * \brief Initialize the connection parameter manager
+ *
+ * \param [in] task: task to notify when idle connections must be checked
+ * \param [in] notif_mask: notification bit(s) to set on \p task
+ */
+void conn_params_init(OS_TASK task, uint32_t notif_mask);
+
+/**
+ * \brief Track link activity and parameter events
+ *
+ * Call for every BLE event before it is dispatched. GATT activity on a connection
+ * switches it to the fast parameters, update requests of the peer are answered.
+ *
+ * \return true if the event was consumed
+ */
+bool conn_params_handle_event(const ble_evt_hdr_t *evt);
+
+/**
+ * \brief Report activity on a connection, switches it to the fast parameters
+ *
+ * Call when a burst starts on the connection (new connection, collection cycle), GATT
+ * events are tracked by conn_params_handle_event().
+ */
+void conn_params_activity(uint16_t conn_idx);
+
+/**
+ * \brief Switch connections without recent activity to the idle parameters,
+ *        call from task context when notified
+ */
+void conn_params_process(void);
+
+#endif /* BLE_CONN_PARAMS_H_ */
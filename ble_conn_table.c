@@ -0,0 +1,170 @@
+/*
+ * ble_conn_table.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Table of the open connections, maintained incrementally from the connected,
+ * disconnected and parameter update events. Replaces ble_gap_get_connected(),
+ * which allocates and copies the connection list on every call; the table is
+ * only accessed from the BLE task, so no locking is needed.
+ */
+
+#include <string.h>
+
+#include "osal.h"
+#include "ble_gap.h"
+
+#include "ble_conn_table.h"
+
+__RETAINED struct conn_entry conn_table[CONN_TABLE_SIZE];
+
+/*
+ * Peers of the outgoing connection procedures, oldest first. The controller runs one
+ * procedure at a time, but ble_gap_connect() succeeds again as soon as the previous one
+ * completed, before its events are handled: a node connected while the next connection
+ * is requested still has its mark.
+ */
+__RETAINED static struct {
+        bd_address_t addr;
+        bool taken;
+} outgoing[CONN_TABLE_SIZE];
+__RETAINED static uint8_t outgoing_count;
+
+struct conn_entry *conn_table_find(uint16_t conn_idx)
+{
+        int i;
+
+        for (i = 0; i < CONN_TABLE_SIZE; i++) {
+                if (conn_table[i].role != CONN_ROLE_FREE && conn_table[i].conn_idx == conn_idx) {
+                        return &conn_table[i];
+                }
+        }
+
+        return NULL;
+}
+
+struct conn_entry *conn_table_find_addr(const bd_address_t *addr)
+{
+        int i;
+
+        for (i = 0; i < CONN_TABLE_SIZE; i++) {
+                if (conn_table[i].role != CONN_ROLE_FREE &&
+                                        !memcmp(conn_table[i].addr.addr, addr->addr, sizeof(addr->addr))) {
+                        return &conn_table[i];
+                }
+        }
+
+        return NULL;
+}
+
+static void set_params(struct conn_entry *conn, const gap_conn_params_t *params)
+{
+        // both interval fields hold the actual interval of an established connection
+        conn->interval = params->interval_min;
+        conn->latency = params->slave_latency;
+        conn->sup_timeout = params->sup_timeout;
+}
+
+struct conn_entry *conn_table_add(const ble_evt_gap_connected_t *evt, uint8_t role)
+{
+        struct conn_entry *conn = conn_table_find(evt->conn_idx);
+        int i;
+
+        for (i = 0; conn == NULL && i < CONN_TABLE_SIZE; i++) {
+                if (conn_table[i].role == CONN_ROLE_FREE) {
+                        conn = &conn_table[i];
+                }
+        }
+        if (conn == NULL) {
+                return NULL;
+        }
+
+        conn->conn_idx = evt->conn_idx;
+        conn->role = role;
+        memcpy(&conn->addr, &evt->peer_address, sizeof(conn->addr));
+        set_params(conn, &evt->conn_params);
+        conn->mtu = CONN_DEFAULT_MTU;
+        conn->params_req = 0;
+        conn->last_activity = OS_GET_TICK_COUNT();
+        conn->tx_phy = BLE_GAP_PHY_1M;
+        conn->rx_phy = BLE_GAP_PHY_1M;
+        conn->tx_octets = CONN_DEFAULT_OCTETS;
+        conn->rx_octets = CONN_DEFAULT_OCTETS;
+        conn->link_flags = 0;
+        conn->rx_bytes = 0;
+        conn->tx_bytes = 0;
+        conn->active_ms = 0;
+        conn->last_transfer = conn->last_activity;
+        conn->delta_base = 0;
+
+        return conn;
+}
+
+void conn_table_connecting(const bd_address_t *addr)
+{
+        // more procedures than connections cannot be pending, drop the oldest mark
+        if (outgoing_count == CONN_TABLE_SIZE) {
+                conn_table_connect_completed();
+        }
+        memcpy(&outgoing[outgoing_count].addr, addr, sizeof(outgoing[outgoing_count].addr));
+        outgoing[outgoing_count].taken = false;
+        outgoing_count++;
+}
+
+bool conn_table_take_outgoing(const bd_address_t *addr)
+{
+        int i;
+
+        for (i = 0; i < outgoing_count; i++) {
+                if (!outgoing[i].taken && !memcmp(outgoing[i].addr.addr, addr->addr, sizeof(addr->addr))) {
+                        outgoing[i].taken = true;
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+void conn_table_connect_completed(void)
+{
+        // procedures complete in the order they were started
+        if (outgoing_count == 0) {
+                return;
+        }
+        outgoing_count--;
+        memmove(&outgoing[0], &outgoing[1], outgoing_count * sizeof(outgoing[0]));
+}
+
+void conn_table_remove(uint16_t conn_idx)
+{
+        struct conn_entry *conn = conn_table_find(conn_idx);
+
+        if (conn) {
+                conn->role = CONN_ROLE_FREE;
+                conn->conn_idx = BLE_CONN_IDX_INVALID;
+        }
+}
+
+void conn_table_params_updated(uint16_t conn_idx, const gap_conn_params_t *params)
+{
+        struct conn_entry *conn = conn_table_find(conn_idx);
+
+        if (conn) {
+                set_params(conn, params);
+        }
+}
+
+uint8_t conn_table_count(uint8_t role)
+{
+        uint8_t count = 0;
+        int i;
+
+        for (i = 0; i < CONN_TABLE_SIZE; i++) {
+                if (conn_table[i].role == role) {
+                        count++;
+                }
+        }
+
+        return count;
+}
@@ -0,0 +1,137 @@
+/*
+ * ble_conn_table.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef BLE_CONN_TABLE_H_
+#define BLE_CONN_TABLE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osal.h"
+#include "ble_gap.h"
+
+/*
+ * Maximum number of simultaneous connections tracked
+ */
+#define CONN_TABLE_SIZE                 (8)
+
+/*
+ * ATT MTU of a new connection, until an exchange changed it
+ */
+#define CONN_DEFAULT_MTU                (23)
+
+/*
+ * Link layer payload of a new connection, until a data length update changed it
+ */
+#define CONN_DEFAULT_OCTETS             (27)
+
+/*
+ * Role of the peer of a connection
+ */
+enum conn_role {
+        CONN_ROLE_FREE = 0,             /* entry not in use */
+        CONN_ROLE_NODE,                 /* node connected by this master */
+        CONN_ROLE_PEER,                 /* phone or parent master connected to this node */
+};
+
+/*
+ * Connection table entry
+ */
+struct conn_entry {
+        uint16_t conn_idx;
+        uint8_t role;                   /* enum conn_role */
+        bd_address_t addr;
+        /* negotiated parameters */
+        uint16_t interval;              /* connection interval, 1.25 ms units */
+        uint16_t latency;
+        uint16_t sup_timeout;           /* supervision timeout, 10 ms units */
+        uint16_t mtu;
+        /* connection parameter manager */
+        uint8_t params_req;             /* enum conn_params_mode requested, CONN_PARAMS_NONE if none pending */
+        OS_TICK_TIME last_activity;
+        /* link layer, see ble_link.h */
+        uint8_t tx_phy;
+        uint8_t rx_phy;
+        uint16_t tx_octets;             /* maximum link layer payload */
+        uint16_t rx_octets;
+        uint8_t link_flags;             /* LINK_FLAG_xxx */
+        OS_TICK_TIME setup_start;       /* data length update requested */
+        /* ATT payload transferred and the time spent transferring it */
+        uint32_t rx_bytes;
+        uint32_t tx_bytes;
+        uint32_t active_ms;
+        OS_TICK_TIME last_transfer;
+        /* aggregate generation the peer wrote for a delta frame on its next read, 0 if none */
+        uint16_t delta_base;
+};
+
+/*
+ * Connection table, maintained from the BLE task event loop. Iterate it directly,
+ * entries with role CONN_ROLE_FREE are not in use.
+ */
+extern struct conn_entry conn_table[CONN_TABLE_SIZE];
+
+/**
+ * \brief Add a connection
+ *
+ * \param [in] evt: connected event
+ * \param [in] role: enum conn_role of the peer
+ *
+ * \return the entry, NULL if the table is full
+ */
+struct conn_entry *conn_table_add(const ble_evt_gap_connected_t *evt, uint8_t role);
+
+/**
+ * \brief Mark the outgoing connection procedure started by ble_gap_connect()
+ *
+ * Call when ble_gap_connect() succeeded. The controller runs one procedure at a time,
+ * the marks of procedures whose events are not handled yet are kept in order.
+ */
+void conn_table_connecting(const bd_address_t *addr);
+
+/**
+ * \brief Check whether a connection was initiated by this device
+ *
+ * Takes the mark of the outgoing procedure if the connected peer is its peer, other
+ * connections were initiated by the peer (a phone or a parent master).
+ */
+bool conn_table_take_outgoing(const bd_address_t *addr);
+
+/**
+ * \brief Clear the mark of the oldest outgoing procedure when it completed
+ */
+void conn_table_connect_completed(void);
+
+/**
+ * \brief Remove a connection
+ */
+void conn_table_remove(uint16_t conn_idx);
+
+/**
+ * \brief Find the entry of a connection
+ *
+ * \return the entry, NULL if the connection is not in the table
+ */
+struct conn_entry *conn_table_find(uint16_t conn_idx);
+
+/**
+ * \brief Find the connection to a peer
+ *
+ * \return the entry, NULL if not connected to the peer
+ */
+struct conn_entry *conn_table_find_addr(const bd_address_t *addr);
+
+/**
+ * \brief Update the parameters of a connection
+ */
+void conn_table_params_updated(uint16_t conn_idx, const gap_conn_params_t *params);
+
+/**
+ * \brief Number of connections with the given role
+ */
+uint8_t conn_table_count(uint8_t role);
+
+#endif /* BLE_CONN_TABLE_H_ */
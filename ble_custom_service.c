@@ -35,12 +35,16 @@
 #include "ble_att.h"
 #include "ble_bufops.h"
 #include "ble_common.h"
+#include "ble_gap.h"
 #include "ble_gatt.h"
 #include "ble_gatts.h"
 #include "ble_storage.h"
 #include "ble_uuid.h"
 
 #include "ble_custom_service.h"
+#include "mem_stats.h"
+#include "ble_conn_table.h"
+#include "ble_link.h"
 
 
 #define UUID_GATT_CLIENT_CHAR_CONFIGURATION (0x2902)
@@ -49,17 +53,95 @@
 mcs_characteristic_structure_t* mcs_characteristic_list_select_element(mcs_characteristic_list_element_t *head,
                                                                         uint8_t list_item);
 
-void mcs_notify_char_value_all(ble_service_t *svc, uint16_t size, const uint8_t *value,
+void mcs_notify_char_value_all(ble_service_t *svc, uint8_t char_idx, uint16_t size, const uint8_t *value,
                                                       mcs_characteristic_structure_t *attr);
 
-void mcs_notify_char_value(ble_service_t *svc, uint16_t conn_idx, uint16_t size, const uint8_t *value,
-                                                      mcs_characteristic_structure_t *attr);
+/* Registered services, for pairing events which are not dispatched to services */
+__RETAINED static mcs_service_structure_t *mcs_services;
+
+/* Connection of the request served by a read or write callback */
+__RETAINED static uint16_t mcs_request_conn;
+
+
+/*
+ * Find the CCC state of a connection, NULL if it has no subscriptions.
+ */
+static mcs_ccc_state_t *ccc_state_find(mcs_service_structure_t *hdr, uint16_t conn_idx)
+{
+        for (int i = 0; i < MCS_MAX_SUBSCRIBERS; i++) {
+                if (hdr->ccc[i].conn_idx == conn_idx) {
+                        return &hdr->ccc[i];
+                }
+        }
+
+        return NULL;
+}
+
+
+/*
+ * Find or allocate the CCC state of a connection, NULL if all entries are in use.
+ */
+static mcs_ccc_state_t *ccc_state_get(mcs_service_structure_t *hdr, uint16_t conn_idx)
+{
+        mcs_ccc_state_t *state = ccc_state_find(hdr, conn_idx);
+        gap_device_t dev;
+
+        if (state) {
+                return state;
+        }
+
+        state = ccc_state_find(hdr, BLE_CONN_IDX_INVALID);
+        if (state) {
+                state->conn_idx = conn_idx;
+                state->notify = 0;
+                state->indicate = 0;
+                state->bonded = (ble_gap_get_device_by_conn_idx(conn_idx, &dev) == BLE_STATUS_OK) && dev.bonded;
+        }
+
+        return state;
+}
+
+
+/*
+ * CCC value of a characteristic from the cached state.
+ */
+static uint16_t ccc_state_value(const mcs_ccc_state_t *state, uint8_t char_idx)
+{
+        uint16_t ccc = GATT_CCC_NONE;
+
+        if (state) {
+                if (state->notify & (1UL << char_idx)) {
+                        ccc |= GATT_CCC_NOTIFICATIONS;
+                }
+                if (state->indicate & (1UL << char_idx)) {
+                        ccc |= GATT_CCC_INDICATIONS;
+                }
+        }
+
+        return ccc;
+}
+
+
+/*
+ * Write the CCC state of a bonded peer back to BLE storage.
+ */
+static void ccc_state_store(mcs_service_structure_t *hdr, const mcs_ccc_state_t *state)
+{
+        for (int idx = 0; idx < hdr->num_of_characteristics; idx++) {
+                mcs_characteristic_structure_t *attr = mcs_characteristic_list_select_element(hdr->p, idx);
+
+                if (attr->characteristic_ccc_h) {
+                        ble_storage_put_u32(state->conn_idx, attr->characteristic_ccc_h,
+                                                (uint32_t)ccc_state_value(state, idx), true);
+                }
+        }
+}
 
 
 /*
  * Write handler intended for servicing write requests to characteristic attribute value.
  */
-static att_error_t do_char_value_write(ble_service_t *svc, mcs_characteristic_structure_t *attr,
+static att_error_t do_char_value_write(ble_service_t *svc, uint8_t char_idx, mcs_characteristic_structure_t *attr,
                                                                 const ble_evt_gatts_write_req_t *evt)
 {
 
@@ -84,7 +166,9 @@ static att_error_t do_char_value_write(ble_service_t *svc, mcs_characteristic_st
         /*
          * Switch to application context to update the characteristic value (as requested by the peer device).
          */
+        mcs_request_conn = evt->conn_idx;
         attr->cb->set_characteristic_value(evt->value, evt->length);
+        mcs_request_conn = BLE_CONN_IDX_INVALID;
 
 
         /*
@@ -97,7 +181,7 @@ static att_error_t do_char_value_write(ble_service_t *svc, mcs_characteristic_st
          * Notify all the connected peers, and given that they have their notifications enabled,
          * that characteristic's value has been changed!
          */
-        mcs_notify_char_value_all(svc, evt->length, evt->value, attr);
+        mcs_notify_char_value_all(svc, char_idx, evt->length, evt->value, attr);
 
         return ATT_ERROR_OK;
 
@@ -107,9 +191,13 @@ static att_error_t do_char_value_write(ble_service_t *svc, mcs_characteristic_st
 /*
  * Write handler intended for servicing write requests to "Client Characteristic Configuration" (CCC) attribute value.
  */
-static att_error_t do_char_value_ccc_write(mcs_characteristic_structure_t *attr, const ble_evt_gatts_write_req_t *evt)
+static att_error_t do_char_value_ccc_write(ble_service_t *svc, uint8_t char_idx, mcs_characteristic_structure_t *attr,
+                                                                        const ble_evt_gatts_write_req_t *evt)
 {
+        mcs_service_structure_t *hdr = (mcs_service_structure_t *) svc;
+        mcs_ccc_state_t *state;
         uint16_t ccc = GATT_CCC_NONE;
+        uint32_t bit = 1UL << char_idx;
 
         if (evt->offset) {
                 return ATT_ERROR_ATTRIBUTE_NOT_LONG;
@@ -122,20 +210,106 @@ static att_error_t do_char_value_ccc_write(mcs_characteristic_structure_t *attr,
         ccc = get_u16(evt->value);
 
         /*
-         * Store the envoy CCC value in Flash memory.
+         * Cache the CCC value, a connection without subscriptions needs no entry.
          */
-        ble_storage_put_u32(evt->conn_idx, attr->characteristic_ccc_h, (uint32_t)ccc, true);
+        state = (ccc != GATT_CCC_NONE) ? ccc_state_get(hdr, evt->conn_idx) : ccc_state_find(hdr, evt->conn_idx);
+        if (state == NULL) {
+                return (ccc != GATT_CCC_NONE) ? ATT_ERROR_INSUFFICIENT_RESOURCES : ATT_ERROR_OK;
+        }
+
+        state->notify = (ccc & GATT_CCC_NOTIFICATIONS) ? (state->notify | bit) : (state->notify & ~bit);
+        state->indicate = (ccc & GATT_CCC_INDICATIONS) ? (state->indicate | bit) : (state->indicate & ~bit);
+
+        /*
+         * Store the envoy CCC value in Flash memory, only bonded peers get it back on reconnection.
+         */
+        if (state->bonded) {
+                ble_storage_put_u32(evt->conn_idx, attr->characteristic_ccc_h, (uint32_t)ccc, true);
+        } else if (!state->notify && !state->indicate) {
+                state->conn_idx = BLE_CONN_IDX_INVALID;
+        }
 
         return ATT_ERROR_OK;
 }
 
 
 
+/*
+ * Find the long read of a connection on a characteristic, NULL if none is in progress.
+ */
+static mcs_long_read_t *long_read_find(mcs_service_structure_t *hdr, uint16_t conn_idx, uint16_t handle)
+{
+        for (int i = 0; i < MCS_MAX_LONG_READS; i++) {
+                if (hdr->long_read[i].conn_idx == conn_idx && hdr->long_read[i].handle == handle) {
+                        return &hdr->long_read[i];
+                }
+        }
+
+        return NULL;
+}
+
+
+/*
+ * End a long read, freeing the copy of the value.
+ */
+static void long_read_free(mcs_long_read_t *read)
+{
+        APP_FREE(MEM_SUBSYS_SERVICE, read->value);
+        read->value = NULL;
+        read->length = 0;
+        read->handle = 0;
+        read->conn_idx = BLE_CONN_IDX_INVALID;
+}
+
+
+/*
+ * Start a long read of a connection with a copy of the value.
+ *
+ * \return false if all entries are in use or the copy cannot be allocated
+ */
+static bool long_read_start(mcs_service_structure_t *hdr, uint16_t conn_idx, uint16_t handle,
+                                                        const uint8_t *value, uint16_t length)
+{
+        mcs_long_read_t *read = long_read_find(hdr, BLE_CONN_IDX_INVALID, 0);
+
+        if (read == NULL) {
+                return false;
+        }
+
+        read->value = APP_MALLOC(MEM_SUBSYS_SERVICE, length);
+        if (read->value == NULL) {
+                return false;
+        }
+
+        memcpy(read->value, value, length);
+        read->length = length;
+        read->handle = handle;
+        read->conn_idx = conn_idx;
+
+        return true;
+}
+
+
+/*
+ * Maximum value length in a read response of a connection.
+ */
+static uint16_t read_rsp_max(uint16_t conn_idx)
+{
+        const struct conn_entry *conn = conn_table_find(conn_idx);
+
+        return (conn ? conn->mtu : CONN_DEFAULT_MTU) - 1;
+}
+
+
 /*
  * Read handler intended for servicing read requests to characteristic attribute value.
  */
 static void do_char_value_read(ble_service_t *svc, mcs_characteristic_structure_t *attr, const ble_evt_gatts_read_req_t *evt)
 {
+        mcs_service_structure_t *hdr = (mcs_service_structure_t *) svc;
+        mcs_long_read_t *read = long_read_find(hdr, evt->conn_idx, attr->characteristic_h);
+        uint16_t remaining;
+
         /* Data initialized by the user! */
         uint16_t length  = 0;
         uint8_t  *value  = NULL;
@@ -149,83 +323,135 @@ static void do_char_value_read(ble_service_t *svc, mcs_characteristic_structure_
                 return;
         }
 
+        /*
+         * Continuation of a long read: return the rest of the copy the read started with,
+         * the copy is freed with the last part.
+         */
+        if (evt->offset) {
+                if (read == NULL) {
+                        ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_ATTRIBUTE_NOT_LONG, 0, NULL);
+                        return;
+                }
+                if (evt->offset > read->length) {
+                        ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_INVALID_OFFSET, 0, NULL);
+                        return;
+                }
+                remaining = read->length - evt->offset;
+                ble_gatts_read_cfm(evt->conn_idx, attr->characteristic_h, ATT_ERROR_OK,
+                                                                remaining, read->value + evt->offset);
+                link_count_tx(evt->conn_idx, remaining);
+                if (remaining < read_rsp_max(evt->conn_idx)) {
+                        long_read_free(read);
+                }
+                return;
+        }
+
+        /* A new read restarts, the previous long read on the characteristic was abandoned */
+        if (read) {
+                long_read_free(read);
+        }
+
         /*
          * Switch to application context to get the characteristic value (as requested by the peer device).
          */
+        mcs_request_conn = evt->conn_idx;
         attr->cb->get_characteristic_value(&value, &length);
+        mcs_request_conn = BLE_CONN_IDX_INVALID;
+
+        /*
+         * The value does not fit in one response, the peer continues with long reads;
+         * keep a copy of it for this connection.
+         */
+        if (length >= read_rsp_max(evt->conn_idx) &&
+                        !long_read_start(hdr, evt->conn_idx, attr->characteristic_h, value, length)) {
+                ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_INSUFFICIENT_RESOURCES, 0, NULL);
+                return;
+        }
 
 
         /* Response for a [BLE_EVT_GATTS_READ_REQ] BLE event. */
         ble_gatts_read_cfm(evt->conn_idx, attr->characteristic_h, ATT_ERROR_OK, length, (const void *)value);
+        link_count_tx(evt->conn_idx, length);
 
 }
 
 
 
 /*
- * Notify all the connected peers that characteristic's value has been changed.
+ * Notify all the subscribed peers that characteristic's value has been changed.
  */
-void mcs_notify_char_value_all(ble_service_t *svc, uint16_t size, const uint8_t *value,
+void mcs_notify_char_value_all(ble_service_t *svc, uint8_t char_idx, uint16_t size, const uint8_t *value,
                                                                mcs_characteristic_structure_t *attr)
 {
-        /*
-         * Number of connected devices.
-         */
-        uint8_t num_conn;
-
-        uint16_t *conn_idx;
-
-        ble_gap_get_connected(&num_conn, &conn_idx);
+        mcs_service_structure_t *hdr = (mcs_service_structure_t *) svc;
+        uint32_t bit = 1UL << char_idx;
 
         /*
-         * For all the connected peer devices.
+         * For all the subscribed peer devices, notifications take precedence over indications.
          */
-        while (num_conn--) {
-                mcs_notify_char_value(svc, conn_idx[num_conn], size, value, attr);
-        }
+        for (int i = 0; i < MCS_MAX_SUBSCRIBERS; i++) {
+                const mcs_ccc_state_t *state = &hdr->ccc[i];
 
-        if (conn_idx) {
-                OS_FREE(conn_idx);
+                if (state->notify & bit) {
+                        ble_gatts_send_event(state->conn_idx, attr->characteristic_h, GATT_EVENT_NOTIFICATION,
+                                                                                   size, (const void *)value);
+                } else if (state->indicate & bit) {
+                        ble_gatts_send_event(state->conn_idx, attr->characteristic_h, GATT_EVENT_INDICATION,
+                                                                                   size, (const void *)value);
+                } else {
+                        continue;
+                }
+                link_count_tx(state->conn_idx, size);
         }
 }
 
 
 
-void mcs_notify_char_value(ble_service_t *svc, uint16_t conn_idx, uint16_t size,
-                                const uint8_t *value, mcs_characteristic_structure_t *attr)
+/*
+ * Notify all the connected peers that a characteristic's value has been changed by the application.
+ */
+void mcs_notify_characteristic(ble_service_t *svc, uint8_t char_idx, uint16_t size, const uint8_t *value)
 {
+        mcs_service_structure_t *hdr = (mcs_service_structure_t *) svc;
 
-        uint16_t ccc = GATT_CCC_NONE;
+        if (!hdr || char_idx >= hdr->num_of_characteristics) {
+                return;
+        }
 
-       /*
-        * Get the Client Configuration Characteristic (CCC) value stored in flash memory.
-        */
-        ble_storage_get_u16(conn_idx, attr->characteristic_ccc_h, &ccc);
+        mcs_notify_char_value_all(svc, char_idx, size, value, mcs_characteristic_list_select_element(hdr->p, char_idx));
+}
 
 
-                /*
-                 * Check whether notifications are enabled from the peer device for that specific connection.
-                 */
-                if ( ((!(ccc & GATT_CCC_NOTIFICATIONS)) && (!(ccc & GATT_CCC_INDICATIONS))) ) {
-                        return;
-                }
+
+/*
+ * Connection of the request served by a read or write callback.
+ */
+uint16_t mcs_request_conn_idx(void)
+{
+        return mcs_request_conn;
+}
 
 
-                if (ccc & GATT_CCC_NOTIFICATIONS) {
-                       /*
-                        * Send a notification to the peer device (updated characteristic value)
-                        */
-                        ble_gatts_send_event(conn_idx, attr->characteristic_h, GATT_EVENT_NOTIFICATION,
-                                                                                   size, (const void *)value);
 
-                } else if (ccc & GATT_CCC_INDICATIONS) {
-                        /*
-                         * Send an indication to the peer device  (updated characteristic value)
-                         */
-                        ble_gatts_send_event(conn_idx, attr->characteristic_h, GATT_EVENT_INDICATION,
-                                                                                    size, (const void *)value);
+/*
+ * Check whether any connected peer subscribed to a characteristic.
+ */
+bool mcs_has_subscribers(ble_service_t *svc, uint8_t char_idx)
+{
+        mcs_service_structure_t *hdr = (mcs_service_structure_t *) svc;
+        uint32_t bit = 1UL << char_idx;
+
+        if (!hdr || char_idx >= hdr->num_of_characteristics) {
+                return false;
+        }
+
+        for (int i = 0; i < MCS_MAX_SUBSCRIBERS; i++) {
+                if ((hdr->ccc[i].notify | hdr->ccc[i].indicate) & bit) {
+                        return true;
                 }
+        }
 
+        return false;
 }
 
 
@@ -272,10 +498,8 @@ static void handle_read_req(ble_service_t *svc, const ble_evt_gatts_read_req_t *
                         do_char_value_read(svc, attr, evt);
                         return;
                 } else if (evt->handle == attr->characteristic_ccc_h) {  // A request to read the descriptor of the Characteristic
-                        uint16_t ccc = 0x0000;
-
-                        /* Extract the CCC value from the BLE storage */
-                        ble_storage_get_u16(evt->conn_idx, attr->characteristic_ccc_h, &ccc);
+                        /* Extract the CCC value from the cached state */
+                        uint16_t ccc = ccc_state_value(ccc_state_find(hdr, evt->conn_idx), idx);
 
                         // We're little-endian - OK to write directly from uint16_t
                         ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_OK, sizeof(ccc), (const void *)&ccc);
@@ -306,10 +530,10 @@ static void handle_write_req(ble_service_t *svc, const ble_evt_gatts_write_req_t
 
                 // Check if the requested attribute is a valid attribute that can be handled
                 if (evt->handle == attr->characteristic_h) {
-                        status = do_char_value_write(svc, attr, evt);
+                        status = do_char_value_write(svc, idx, attr, evt);
                         goto done;
                 } else if (evt->handle == attr->characteristic_ccc_h) {
-                        status = do_char_value_ccc_write(attr, evt);
+                        status = do_char_value_ccc_write(svc, idx, attr, evt);
                         goto done;
                 }
 
@@ -350,6 +574,93 @@ static void handle_prepare_write_req(ble_service_t *svc, const ble_evt_gatts_pre
 }
 
 
+/*
+ * Callback function to be called upon [BLE_EVT_GAP_CONNECTED] BLE event.
+ */
+static void handle_connected_evt(ble_service_t *svc, const ble_evt_gap_connected_t *evt)
+{
+        mcs_service_structure_t *hdr = (mcs_service_structure_t *) svc;
+        mcs_ccc_state_t *state = NULL;
+        gap_device_t dev;
+
+        /*
+         * Only bonded peers have CCC values in BLE storage, restore their subscriptions.
+         */
+        if (ble_gap_get_device_by_conn_idx(evt->conn_idx, &dev) != BLE_STATUS_OK || !dev.bonded) {
+                return;
+        }
+
+        for (int idx = 0; idx < hdr->num_of_characteristics; idx++) {
+                mcs_characteristic_structure_t *attr = mcs_characteristic_list_select_element(hdr->p, idx);
+                uint16_t ccc = GATT_CCC_NONE;
+
+                if (!attr->characteristic_ccc_h) {
+                        continue;
+                }
+
+                ble_storage_get_u16(evt->conn_idx, attr->characteristic_ccc_h, &ccc);
+                if (ccc == GATT_CCC_NONE) {
+                        continue;
+                }
+
+                if (state == NULL && (state = ccc_state_get(hdr, evt->conn_idx)) == NULL) {
+                        return;
+                }
+                if (ccc & GATT_CCC_NOTIFICATIONS) {
+                        state->notify |= 1UL << idx;
+                }
+                if (ccc & GATT_CCC_INDICATIONS) {
+                        state->indicate |= 1UL << idx;
+                }
+        }
+}
+
+
+
+/*
+ * Callback function to be called upon [BLE_EVT_GAP_DISCONNECTED] BLE event.
+ */
+static void handle_disconnected_evt(ble_service_t *svc, const ble_evt_gap_disconnected_t *evt)
+{
+        mcs_service_structure_t *hdr = (mcs_service_structure_t *) svc;
+        mcs_ccc_state_t *state = ccc_state_find(hdr, evt->conn_idx);
+
+        if (state) {
+                state->conn_idx = BLE_CONN_IDX_INVALID;
+                state->notify = 0;
+                state->indicate = 0;
+        }
+
+        for (int i = 0; i < MCS_MAX_LONG_READS; i++) {
+                if (hdr->long_read[i].conn_idx == evt->conn_idx) {
+                        long_read_free(&hdr->long_read[i]);
+                }
+        }
+}
+
+
+
+/*
+ * Persist the CCC state of connections which just bonded.
+ */
+void mcs_handle_pair_completed(const ble_evt_gap_pair_completed_t *evt)
+{
+        if (evt->status != BLE_STATUS_OK || !evt->bond) {
+                return;
+        }
+
+        for (mcs_service_structure_t *hdr = mcs_services; hdr; hdr = hdr->next) {
+                mcs_ccc_state_t *state = ccc_state_find(hdr, evt->conn_idx);
+
+                if (state && !state->bonded) {
+                        state->bonded = true;
+                        ccc_state_store(hdr, state);
+                }
+        }
+}
+
+
+
 /*
  * Callback function to be called after a Cleanup BLE event.
  */
@@ -368,10 +679,26 @@ static void cleanup(ble_service_t *svc)
         }
 
 
+        /*
+         * Unregister the service.
+         */
+        for (mcs_service_structure_t **pp = &mcs_services; *pp; pp = &(*pp)->next) {
+                if (*pp == hdr) {
+                        *pp = hdr->next;
+                        break;
+                }
+        }
+
+        for (int i = 0; i < MCS_MAX_LONG_READS; i++) {
+                if (hdr->long_read[i].value) {
+                        long_read_free(&hdr->long_read[i]);
+                }
+        }
+
         /*
          * Remove the previously allocated memory for the Service structure.
          */
-        OS_FREE(hdr);
+        APP_FREE(MEM_SUBSYS_SERVICE, hdr);
 }
 
 
@@ -406,7 +733,7 @@ mcs_characteristic_structure_t* mcs_characteristic_list_select_element(mcs_chara
 mcs_service_structure_t* mcs_service_handle_init(mcs_characteristic_list_element_t *head, uint8_t num_characteristic)
 {
         /* Allocate memory for the service handle */
-        mcs_service_structure_t *hdr = (mcs_service_structure_t *) OS_MALLOC(sizeof(mcs_service_structure_t));
+        mcs_service_structure_t *hdr = (mcs_service_structure_t *) APP_MALLOC(MEM_SUBSYS_SERVICE, sizeof(mcs_service_structure_t));
         OS_ASSERT(hdr);
 
         /* Clear the memory */
@@ -414,6 +741,15 @@ mcs_service_structure_t* mcs_service_handle_init(mcs_characteristic_list_element
 
         hdr->p = head;
         hdr->num_of_characteristics = num_characteristic;
+        OS_ASSERT(num_characteristic <= MCS_MAX_CHARACTERISTICS);
+
+        for (int i = 0; i < MCS_MAX_SUBSCRIBERS; i++) {
+                hdr->ccc[i].conn_idx = BLE_CONN_IDX_INVALID;
+        }
+
+        for (int i = 0; i < MCS_MAX_LONG_READS; i++) {
+                hdr->long_read[i].conn_idx = BLE_CONN_IDX_INVALID;
+        }
 
         /* Set callback functions associated with specific BLE events */
         hdr->svc.write_req          = handle_write_req;
@@ -421,6 +757,12 @@ mcs_service_structure_t* mcs_service_handle_init(mcs_characteristic_list_element
         hdr->svc.cleanup            = cleanup;
         hdr->svc.event_sent         = handle_event_sent_evt;
         hdr->svc.prepare_write_req  = handle_prepare_write_req;
+        hdr->svc.connected_evt      = handle_connected_evt;
+        hdr->svc.disconnected_evt   = handle_disconnected_evt;
+
+        hdr->next = mcs_services;
+        mcs_services = hdr;
+        mcs_request_conn = BLE_CONN_IDX_INVALID;
 
         return hdr;
 }
@@ -437,7 +779,7 @@ mcs_characteristic_list_element_t* mcs_characteristic_list_init()
          * Allocate memory for the first element of the characteristic list
          */
         mcs_characteristic_list_element_t *head = (mcs_characteristic_list_element_t *)
-                                         OS_MALLOC(sizeof(mcs_characteristic_list_element_t));
+                                         APP_MALLOC(MEM_SUBSYS_SERVICE, sizeof(mcs_characteristic_list_element_t));
         OS_ASSERT(head);
 
         /* Clear the allocated memory */
@@ -481,7 +823,7 @@ void mcs_characteristic_list_add_element(mcs_characteristic_list_element_t *head
          |              |             |            / |              |             |
          ------------------------------              ------------------------------
         */
-        current_position->next = (mcs_characteristic_list_element_t *) OS_MALLOC(sizeof(mcs_characteristic_list_element_t));
+        current_position->next = (mcs_characteristic_list_element_t *) APP_MALLOC(MEM_SUBSYS_SERVICE, sizeof(mcs_characteristic_list_element_t));
         OS_ASSERT(current_position->next);
 
         current_position->next->next = NULL;   // The last element should always be NULL!
@@ -585,7 +927,7 @@ uint16_t mcs_compute_num_of_descriptors(const mcs_characteristic_config_t settin
 
         for (int i = 0; i < num_of_characrteristics; i++) {
                 // Check if notifications/indications are enabled...
-                if ((settings[i].notifications == 1) || (settings[i].notifications == 2)) num_of_descriptors++;
+                if (settings[i].notifications != CHAR_NOTIF_NONE) num_of_descriptors++;
                 // Check if a Characteristic User Description has been declared...
                 if (mcs_is_user_descriptor_enabled(settings[i].characteristic_user_descriptor)) num_of_descriptors++;
         }
@@ -648,8 +990,8 @@ ble_service_t* mcs_init(const mcs_characteristic_config_t settings[], const char
 
                 ble_gatts_add_characteristic(&uuid, ((settings[i].characteristic_read_prop) ? GATT_PROP_READ : GATT_PROP_NONE) |
                                 ((settings[i].characteristic_write_prop) ? GATT_PROP_WRITE    : GATT_PROP_NONE)    |
-                                ((settings[i].notifications == 1)        ? GATT_PROP_NOTIFY   : GATT_PROP_NONE)    |
-                                ((settings[i].notifications == 2)        ? GATT_PROP_INDICATE : GATT_PROP_NONE),
+                                ((settings[i].notifications & CHAR_NOTIF_NOTIF_EN) ? GATT_PROP_NOTIFY   : GATT_PROP_NONE)    |
+                                ((settings[i].notifications & CHAR_NOTIF_INDIC_EN) ? GATT_PROP_INDICATE : GATT_PROP_NONE),
                                                  ATT_PERM_RW, (settings[i].characteristic_max_size),
                                 ((settings[i].characteristic_read_prop) ? GATTS_FLAG_CHAR_READ_REQ : 0x00),
                                                                  NULL, &position->characteristic_h);
@@ -670,7 +1012,7 @@ ble_service_t* mcs_init(const mcs_characteristic_config_t settings[], const char
                 /*
                  * "Characteristic Notification Descriptor" declarations.
                  */
-                if ( (settings[i].notifications == 1) || (settings[i].notifications == 2) ) {
+                if (settings[i].notifications != CHAR_NOTIF_NONE) {
                         ble_uuid_create16(UUID_GATT_CLIENT_CHAR_CONFIGURATION, &uuid);
                         ble_gatts_add_descriptor(&uuid, ATT_PERM_RW, 2, 0, &position->characteristic_ccc_h);   // CHECK FOR HANDLER -
                 }
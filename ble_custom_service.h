@@ -31,7 +31,9 @@
 #ifndef SDK_BLE_CUSTOM_SERVICE_MECHANISM_H_
 #define SDK_BLE_CUSTOM_SERVICE_MECHANISM_H_
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <ble_gap.h>
 #include <ble_service.h>
 
 
@@ -179,6 +181,7 @@ typedef enum {
         CHAR_NOTIF_NONE = 0,
         CHAR_NOTIF_NOTIF_EN  = 1,
         CHAR_NOTIF_INDIC_EN  = 2,
+        CHAR_NOTIF_NOTIF_INDIC_EN = 3,  /* the client chooses in the CCC */
 } CHAR_NOTIF;
 
 
@@ -283,6 +286,56 @@ typedef struct mcs_characteristic_list_element {
 
 
 
+/*
+ * Maximum number of connections with subscriptions (CCC state) per service
+ */
+#ifndef MCS_MAX_SUBSCRIBERS
+#define MCS_MAX_SUBSCRIBERS             (4)
+#endif
+
+/*
+ * Maximum number of Characteristic attributes per service, one bit each in the CCC state
+ */
+#define MCS_MAX_CHARACTERISTICS         (32)
+
+/*
+ * CCC state of a connection, cached in RAM. Only connections which enabled notifications
+ * or indications on a characteristic of the service hold an entry.
+ */
+typedef struct mcs_ccc_state {
+
+        uint16_t conn_idx;              // BLE_CONN_IDX_INVALID if the entry is free
+        bool bonded;                    // CCC values are written back to BLE storage
+        uint32_t notify;                // Characteristics with notifications enabled, bit per index
+        uint32_t indicate;              // Characteristics with indications enabled, bit per index
+
+} mcs_ccc_state_t;
+
+
+
+/*
+ * Maximum number of long reads in progress per service
+ */
+#ifndef MCS_MAX_LONG_READS
+#define MCS_MAX_LONG_READS              (MCS_MAX_SUBSCRIBERS)
+#endif
+
+/*
+ * Long read of a connection. The value returned by the read callback is copied when
+ * it does not fit in one read response; the continuations (reads with an offset) are
+ * served from the copy, so the value is not rebuilt or changed halfway through.
+ */
+typedef struct mcs_long_read {
+
+        uint16_t conn_idx;              // BLE_CONN_IDX_INVALID if the entry is free
+        uint16_t handle;                // Handle of the Characteristic Attribute read
+        uint8_t *value;                 // Copy of the value, allocated from the heap
+        uint16_t length;
+
+} mcs_long_read_t;
+
+
+
 /*
  * Structure of a BLE Service handle
  */
@@ -297,6 +350,15 @@ typedef struct mcs_service_structure {
         /* The total number of Characteristic attributes  */
         uint8_t num_of_characteristics;
 
+        /* CCC state of the subscribed connections */
+        mcs_ccc_state_t ccc[MCS_MAX_SUBSCRIBERS];
+
+        /* Long reads in progress */
+        mcs_long_read_t long_read[MCS_MAX_LONG_READS];
+
+        /* Next registered service */
+        struct mcs_service_structure *next;
+
 } mcs_service_structure_t;
 
 
@@ -321,4 +383,57 @@ ble_service_t* mcs_init(const mcs_characteristic_config_t settings[], const char
 
 
 
+/*
+ * @brief Characteristic Attribute value update notification.
+ *
+ * This function notifies all the connected peer devices, which have their notifications/indications
+ * enabled, that a Characteristic Attribute value has been updated from application context.
+ *
+ * \param[in] svc                          The service handle as returned by mcs_init()
+ * \param[in] char_idx                     The index of the Characteristic Attribute, in declaration order
+ * \param[in] size                         The size of the updated value, expressed in bytes
+ * \param[in] value                        The updated value
+ *
+ */
+void mcs_notify_characteristic(ble_service_t *svc, uint8_t char_idx, uint16_t size, const uint8_t *value);
+
+
+/*
+ * @brief Check for subscribers of a Characteristic Attribute
+ *
+ * \param[in] svc                          The service handle as returned by mcs_init()
+ * \param[in] char_idx                     The index of the Characteristic Attribute, in declaration order
+ *
+ * \return true if a connected peer device has its notifications or indications enabled
+ */
+bool mcs_has_subscribers(ble_service_t *svc, uint8_t char_idx);
+
+
+
+/*
+ * @brief Connection of the request being served
+ *
+ * Read and write callbacks do not get the connection of the request; they can get it
+ * from here to keep per-connection state.
+ *
+ * \return the connection index, BLE_CONN_IDX_INVALID outside of read and write callbacks
+ */
+uint16_t mcs_request_conn_idx(void);
+
+
+
+/*
+ * @brief Pairing completed handler.
+ *
+ * The CCC state of a connection is kept in RAM and only written back to BLE storage for
+ * bonded peers. Call this upon [BLE_EVT_GAP_PAIR_COMPLETED] so the CCC values written before
+ * bonding are persisted as well.
+ *
+ * \param[in] evt                          The pairing completed event
+ *
+ */
+void mcs_handle_pair_completed(const ble_evt_gap_pair_completed_t *evt);
+
+
+
 #endif /* SDK_CUSTOM_SERVICE_DEMO_H_ */
@@ -0,0 +1,256 @@
+/*
+ * ble_latency.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Per event code latency histograms of the BLE task event loop, timed with the
+ * DWT cycle counter, a histogram of the number of events drained per burst
+ * as a proxy for the BLE event queue depth, and the event rate of the batched
+ * drains of the event loop.
+ *
+ * Everything is updated and read in the BLE task context, so no locking is needed.
+ */
+
+#include <string.h>
+
+#include "sdk_defs.h"
+#include "osal.h"
+#include "sys_clock_mgr.h"
+
+#include "ble_latency.h"
+
+struct latency_hist {
+        uint16_t evt_code;
+        uint32_t count;
+        uint32_t max;
+        uint16_t buckets[BLE_LATENCY_BUCKETS];
+};
+
+__RETAINED static struct latency_hist hists[BLE_LATENCY_MAX_CODES];
+__RETAINED static uint8_t num_hists;
+
+__RETAINED static uint16_t depth_buckets[BLE_LATENCY_DEPTH_BUCKETS];
+__RETAINED static uint16_t depth_max;
+__RETAINED static uint16_t burst;
+
+/*
+ * Batched drains of the event loop
+ */
+__RETAINED static struct {
+        uint32_t wakeups;
+        uint32_t events;
+        uint32_t busy;                  /* cycles >> BLE_LATENCY_CYCLES_SHIFT */
+        uint16_t max_events;
+        uint32_t limited;
+        uint32_t peak_rate;             /* events/s */
+} drain;
+
+/* dump state */
+__RETAINED static bool stats_paused;
+__RETAINED static uint16_t dump_pos;
+
+/*
+ * Output cursor which writes the part of the stream between dump_pos and dump_pos + max
+ */
+struct stream {
+        uint8_t *buf;
+        uint16_t max;
+        uint16_t skip;
+        uint16_t n;
+};
+
+static void cycle_counter_enable(void)
+{
+        // the debug block may lose its configuration in sleep, re-enable when needed
+        if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+                CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+                DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+        }
+}
+
+static uint8_t log2_bucket(uint32_t value, uint8_t num_buckets)
+{
+        uint8_t b = value ? 32 - __builtin_clz(value) : 0;
+
+        return (b < num_buckets) ? b : num_buckets - 1;
+}
+
+static void inc_sat(uint16_t *count)
+{
+        if (*count < 0xFFFF) {
+                (*count)++;
+        }
+}
+
+static struct latency_hist *find_hist(uint16_t evt_code)
+{
+        uint8_t i;
+
+        for (i = 0; i < num_hists; i++) {
+                if (hists[i].evt_code == evt_code) {
+                        return &hists[i];
+                }
+        }
+
+        // keep the last histogram for the codes which do not fit
+        if (num_hists < BLE_LATENCY_MAX_CODES - 1) {
+                hists[num_hists].evt_code = evt_code;
+        } else if (num_hists == BLE_LATENCY_MAX_CODES - 1) {
+                hists[num_hists].evt_code = BLE_LATENCY_CODE_OTHER;
+        } else {
+                return &hists[BLE_LATENCY_MAX_CODES - 1];
+        }
+
+        return &hists[num_hists++];
+}
+
+uint32_t ble_latency_begin(void)
+{
+        cycle_counter_enable();
+        burst++;
+
+        return DWT->CYCCNT;
+}
+
+void ble_latency_record(uint16_t evt_code, uint32_t start)
+{
+        uint32_t cycles = DWT->CYCCNT - start;
+        struct latency_hist *hist;
+
+        if (stats_paused) {
+                return;
+        }
+
+        hist = find_hist(evt_code);
+        hist->count++;
+        if (cycles > hist->max) {
+                hist->max = cycles;
+        }
+        inc_sat(&hist->buckets[log2_bucket(cycles >> BLE_LATENCY_CYCLES_SHIFT, BLE_LATENCY_BUCKETS)]);
+}
+
+void ble_latency_queue_sample(bool more)
+{
+        if (more || burst == 0) {
+                return;
+        }
+
+        if (!stats_paused) {
+                inc_sat(&depth_buckets[log2_bucket(burst, BLE_LATENCY_DEPTH_BUCKETS + 1) - 1]);
+                if (burst > depth_max) {
+                        depth_max = burst;
+                }
+        }
+        burst = 0;
+}
+
+uint32_t ble_latency_drain_begin(void)
+{
+        cycle_counter_enable();
+
+        return DWT->CYCCNT;
+}
+
+void ble_latency_drain(uint16_t events, uint32_t start, bool limited)
+{
+        uint32_t cycles = DWT->CYCCNT - start;
+        uint32_t rate;
+
+        if (stats_paused || events == 0) {
+                return;
+        }
+
+        drain.wakeups++;
+        drain.events += events;
+        drain.busy += cycles >> BLE_LATENCY_CYCLES_SHIFT;
+        if (events > drain.max_events) {
+                drain.max_events = events;
+        }
+        if (!limited || cycles == 0) {
+                return;
+        }
+
+        // a full batch with events still queued: the rate the loop sustains under load
+        drain.limited++;
+        rate = (uint32_t)(((uint64_t) events * cm_cpu_clk_get_fromISR() * 1000000UL) / cycles);
+        if (rate > drain.peak_rate) {
+                drain.peak_rate = rate;
+        }
+}
+
+static void put(struct stream *s, uint32_t value, uint8_t size)
+{
+        while (size--) {
+                if (s->skip) {
+                        s->skip--;
+                } else if (s->n < s->max) {
+                        s->buf[s->n++] = value & 0xFF;
+                }
+                value >>= 8;
+        }
+}
+
+uint16_t ble_latency_read(uint8_t *buf, uint16_t max)
+{
+        struct stream s = { .buf = buf, .max = max, .skip = 0, .n = 0 };
+        uint8_t i, j;
+
+        // start of a dump, freeze the statistics
+        if (!stats_paused) {
+                stats_paused = true;
+                dump_pos = 0;
+        }
+        s.skip = dump_pos;
+
+        put(&s, 'B', 1);
+        put(&s, 'L', 1);
+        put(&s, BLE_LATENCY_VERSION, 1);
+        put(&s, num_hists, 1);
+        put(&s, cm_cpu_clk_get_fromISR() * 1000000UL, 4);
+        put(&s, BLE_LATENCY_CYCLES_SHIFT, 1);
+        put(&s, BLE_LATENCY_BUCKETS, 1);
+        put(&s, BLE_LATENCY_DEPTH_BUCKETS, 1);
+        put(&s, 0, 1);
+
+        for (i = 0; i < num_hists; i++) {
+                put(&s, hists[i].evt_code, 2);
+                put(&s, hists[i].count, 4);
+                put(&s, hists[i].max, 4);
+                for (j = 0; j < BLE_LATENCY_BUCKETS; j++) {
+                        put(&s, hists[i].buckets[j], 2);
+                }
+        }
+
+        put(&s, depth_max, 2);
+        for (j = 0; j < BLE_LATENCY_DEPTH_BUCKETS; j++) {
+                put(&s, depth_buckets[j], 2);
+        }
+
+        put(&s, drain.wakeups, 4);
+        put(&s, drain.events, 4);
+        put(&s, drain.busy, 4);
+        put(&s, drain.max_events, 2);
+        put(&s, drain.limited, 4);
+        put(&s, drain.peak_rate, 4);
+
+        dump_pos += s.n;
+
+        // end of the dump, resume the statistics
+        if (s.n == 0) {
+                stats_paused = false;
+        }
+
+        return s.n;
+}
+
+void ble_latency_reset(void)
+{
+        memset(hists, 0, sizeof(hists));
+        num_hists = 0;
+        memset(depth_buckets, 0, sizeof(depth_buckets));
+        depth_max = 0;
+        burst = 0;
+        memset(&drain, 0, sizeof(drain));
+        stats_paused = false;
+}
@@ -0,0 +1,110 @@
+/*
+ * ble_latency.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef BLE_LATENCY_H_
+#define BLE_LATENCY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Enable/disable BLE event latency statistics */
+#define BLE_LATENCY_ENABLE              (1)
+
+/* Number of event codes with their own histogram, further codes share the last one */
+#define BLE_LATENCY_MAX_CODES           (16)
+
+/*
+ * Latency histogram: bucket 0 counts handling times below 2^BLE_LATENCY_CYCLES_SHIFT
+ * CPU cycles, bucket n times in [2^(n-1), 2^n) << BLE_LATENCY_CYCLES_SHIFT cycles.
+ * The last bucket also counts everything above it.
+ */
+#define BLE_LATENCY_CYCLES_SHIFT        (6)
+#define BLE_LATENCY_BUCKETS             (20)
+
+/*
+ * Queue depth histogram: number of events drained back to back before the queue
+ * was empty; bucket n counts bursts of [2^n, 2^(n+1)) events.
+ */
+#define BLE_LATENCY_DEPTH_BUCKETS       (8)
+
+/* Evt code of the shared histogram */
+#define BLE_LATENCY_CODE_OTHER          (0xFFFF)
+
+/*
+ * Statistics stream format, all values little endian:
+ *
+ * header: ['B']['L'][version][number of codes][CPU clock in Hz; 4][cycles shift]
+ *         [number of latency buckets][number of depth buckets][reserved]
+ * code:   [evt_code; 2][count; 4][max cycles; 4][latency buckets; 2 each]
+ * depth:  [max burst; 2][depth buckets; 2 each]
+ * drain:  [wakeups; 4][events; 4][busy cycles >> cycles shift; 4][max events per wakeup; 2]
+ *         [limited wakeups; 4][peak events/s; 4]
+ *
+ * Bucket counts saturate at 0xFFFF. Limited wakeups ended on the batch size or the
+ * time budget with events still queued (scan storms); the peak events/s is the
+ * best rate of those, the events handled per busy time.
+ *
+ * Version history:
+ * 1: initial format
+ * 2: drain statistics added
+ */
+#define BLE_LATENCY_VERSION             (2)
+#define BLE_LATENCY_HDR_LEN             (12)
+
+/**
+ * \brief Start timing an event, call right after the event was taken from the queue
+ *
+ * \return start timestamp to pass to ble_latency_record()
+ */
+uint32_t ble_latency_begin(void);
+
+/**
+ * \brief Account the handling time of an event
+ *
+ * \param [in] evt_code: BLE event code
+ * \param [in] start: value returned by ble_latency_begin()
+ */
+void ble_latency_record(uint16_t evt_code, uint32_t start);
+
+/**
+ * \brief Sample the event queue after an event was handled
+ *
+ * \param [in] more: result of ble_has_event()
+ */
+void ble_latency_queue_sample(bool more);
+
+/**
+ * \brief Start timing a wakeup of the event loop
+ *
+ * \return start timestamp to pass to ble_latency_drain()
+ */
+uint32_t ble_latency_drain_begin(void);
+
+/**
+ * \brief Account a wakeup of the event loop which drained a batch of events
+ *
+ * \param [in] events: number of events handled
+ * \param [in] start: value returned by ble_latency_drain_begin()
+ * \param [in] limited: events were left in the queue
+ */
+void ble_latency_drain(uint16_t events, uint32_t start, bool limited);
+
+/**
+ * \brief Read the next chunk of the statistics stream
+ *
+ * The first read starts a dump and pauses the statistics until the dump is complete.
+ *
+ * \return number of bytes written to \p buf, 0 at the end of the dump
+ */
+uint16_t ble_latency_read(uint8_t *buf, uint16_t max);
+
+/**
+ * \brief Clear all statistics
+ */
+void ble_latency_reset(void);
+
+#endif /* BLE_LATENCY_H_ */
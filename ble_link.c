@@ -0,0 +1,348 @@
+/*
+ * ble_link.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Link layer setup and throughput statistics.
+ *
+ * New connections are upgraded for bulk transfers (aggregate reads, diagnostics
+ * dumps) in sequence, one procedure at a time: the LE 2M PHY, then the maximum
+ * link layer payload (data length extension), then as master the ATT MTU. A peer
+ * refusing the PHY or the data length update keeps the default for that part and
+ * the sequence continues; the refusal is flagged in the statistics. A peer which
+ * does not answer the data length update within CFG_LINK_SETUP_TIMEOUT_MS counts as
+ * refusing it.
+ */
+
+#include <string.h>
+
+#include "osal.h"
+#include "ble_gap.h"
+#include "ble_gattc.h"
+#include "ble_gatts.h"
+
+#include "ble_conn_table.h"
+#include "ble_link.h"
+#include "deferred_log.h"
+
+#define LINK_STATS_HDR_LEN              (4)
+#define LINK_STATS_ENTRY_LEN            (37)
+
+#if (LINK_STATS_ENABLE == 1)
+__RETAINED static uint8_t snapshot[LINK_STATS_HDR_LEN + CONN_TABLE_SIZE * LINK_STATS_ENTRY_LEN];
+__RETAINED static uint16_t snapshot_len;
+__RETAINED static uint16_t snapshot_pos;
+__RETAINED static bool snapshot_valid;
+#endif
+
+__RETAINED static OS_TIMER setup_timer;
+__RETAINED static OS_TASK setup_task;
+__RETAINED static uint32_t setup_notif_mask;
+
+static void setup_mtu(struct conn_entry *conn)
+{
+        // the peer exchanges the MTU of connections it initiated
+        if (conn->role == CONN_ROLE_NODE) {
+                ble_gattc_exchange_mtu(conn->conn_idx);
+        }
+}
+
+static void setup_data_length(struct conn_entry *conn)
+{
+        if (ble_gap_data_length_set(conn->conn_idx, CFG_LINK_TX_OCTETS, CFG_LINK_TX_TIME) != BLE_STATUS_OK) {
+                conn->link_flags |= LINK_FLAG_DLE_REFUSED;
+                setup_mtu(conn);
+                return;
+        }
+
+        // the data length changed or set failed event continues the setup
+        conn->link_flags |= LINK_FLAG_DLE_PENDING;
+        conn->setup_start = OS_GET_TICK_COUNT();
+        if (!OS_TIMER_IS_ACTIVE(setup_timer)) {
+                OS_TIMER_START(setup_timer, OS_TIMER_FOREVER);
+        }
+}
+
+/*
+ * Continue the setup after the data length update, once per connection
+ */
+static void data_length_done(struct conn_entry *conn, bool refused)
+{
+        if (!(conn->link_flags & LINK_FLAG_DLE_PENDING)) {
+                return;
+        }
+        conn->link_flags &= ~LINK_FLAG_DLE_PENDING;
+        if (refused) {
+                conn->link_flags |= LINK_FLAG_DLE_REFUSED;
+        }
+        setup_mtu(conn);
+}
+
+static void setup_timer_cb(OS_TIMER timer)
+{
+        OS_TASK_NOTIFY(setup_task, setup_notif_mask, eSetBits);
+}
+
+void link_init(OS_TASK task, uint32_t notif_mask)
+{
+        setup_task = task;
+        setup_notif_mask = notif_mask;
+
+        setup_timer = OS_TIMER_CREATE("link_setup", OS_MS_2_TICKS(CFG_LINK_SETUP_TIMEOUT_MS),
+                                                                OS_TIMER_RELOAD, NULL, setup_timer_cb);
+        OS_ASSERT(setup_timer);
+}
+
+void link_process(void)
+{
+        OS_TICK_TIME now = OS_GET_TICK_COUNT();
+        bool pending = false;
+        int i;
+
+        for (i = 0; i < CONN_TABLE_SIZE; i++) {
+                struct conn_entry *conn = &conn_table[i];
+
+                if (conn->role == CONN_ROLE_FREE || !(conn->link_flags & LINK_FLAG_DLE_PENDING)) {
+                        continue;
+                }
+                if (now - conn->setup_start < OS_MS_2_TICKS(CFG_LINK_SETUP_TIMEOUT_MS)) {
+                        pending = true;
+                        continue;
+                }
+                LOG_WRN("Connection %d data length update not answered\r\n", conn->conn_idx);
+                data_length_done(conn, true);
+        }
+
+        if (!pending) {
+                OS_TIMER_STOP(setup_timer, OS_TIMER_FOREVER);
+        }
+}
+
+void link_setup(uint16_t conn_idx)
+{
+        struct conn_entry *conn = conn_table_find(conn_idx);
+
+        if (conn == NULL) {
+                return;
+        }
+
+#if (CFG_LINK_2M_PHY == 1)
+        // the data length update follows when the PHY update completed
+        if (ble_gap_phy_set(conn_idx, BLE_GAP_PHY_PREF_2M, BLE_GAP_PHY_PREF_2M) == BLE_STATUS_OK) {
+                return;
+        }
+        conn->link_flags |= LINK_FLAG_PHY_REFUSED;
+#endif
+        setup_data_length(conn);
+}
+
+static void count_transfer(struct conn_entry *conn, uint32_t *bytes, uint16_t length)
+{
+        OS_TICK_TIME now = OS_GET_TICK_COUNT();
+        uint32_t gap_ms = OS_TICKS_2_MS(now - conn->last_transfer);
+
+        // time between transfers of the same burst counts as active
+        if (gap_ms < CFG_LINK_BURST_GAP_MS) {
+                conn->active_ms += gap_ms;
+        }
+        conn->last_transfer = now;
+        *bytes += length;
+}
+
+void link_count_tx(uint16_t conn_idx, uint16_t length)
+{
+        struct conn_entry *conn = conn_table_find(conn_idx);
+
+        if (conn) {
+                // a single PDU carries at most MTU - 1 bytes of a value
+                count_transfer(conn, &conn->tx_bytes, (length < conn->mtu - 1) ? length : conn->mtu - 1);
+        }
+}
+
+static void count_rx(uint16_t conn_idx, uint16_t length)
+{
+        struct conn_entry *conn = conn_table_find(conn_idx);
+
+        if (conn) {
+                count_transfer(conn, &conn->rx_bytes, length);
+        }
+}
+
+bool link_handle_event(const ble_evt_hdr_t *evt)
+{
+        struct conn_entry *conn;
+
+        switch (evt->evt_code) {
+        case BLE_EVT_GAP_PHY_SET_COMPLETED:
+        {
+                const ble_evt_gap_phy_set_completed_t *info = (const ble_evt_gap_phy_set_completed_t *) evt;
+
+                conn = conn_table_find(info->conn_idx);
+                if (conn) {
+                        if (info->status != BLE_STATUS_OK) {
+                                conn->link_flags |= LINK_FLAG_PHY_REFUSED;
+                        }
+                        setup_data_length(conn);
+                }
+                return true;
+        }
+        case BLE_EVT_GAP_PHY_CHANGED:
+        {
+                const ble_evt_gap_phy_changed_t *info = (const ble_evt_gap_phy_changed_t *) evt;
+
+                conn = conn_table_find(info->conn_idx);
+                if (conn) {
+                        conn->tx_phy = info->tx_phy;
+                        conn->rx_phy = info->rx_phy;
+                }
+                LOG_INF("Connection %d PHY tx %d rx %d\r\n", info->conn_idx, info->tx_phy, info->rx_phy);
+                return true;
+        }
+        case BLE_EVT_GAP_DATA_LENGTH_CHANGED:
+        {
+                const ble_evt_gap_data_length_changed_t *info = (const ble_evt_gap_data_length_changed_t *) evt;
+
+                conn = conn_table_find(info->conn_idx);
+                if (conn) {
+                        conn->tx_octets = info->max_tx_length;
+                        conn->rx_octets = info->max_rx_length;
+                        // also sent for updates initiated by the peer, the setup only continues once
+                        data_length_done(conn, false);
+                }
+                return true;
+        }
+        case BLE_EVT_GAP_DATA_LENGTH_SET_FAILED:
+        {
+                const ble_evt_gap_data_length_set_failed_t *info = (const ble_evt_gap_data_length_set_failed_t *) evt;
+
+                conn = conn_table_find(info->conn_idx);
+                if (conn) {
+                        data_length_done(conn, true);
+                }
+                return true;
+        }
+        case BLE_EVT_GATTC_MTU_CHANGED:
+        {
+                const ble_evt_gattc_mtu_changed_t *info = (const ble_evt_gattc_mtu_changed_t *) evt;
+
+                conn = conn_table_find(info->conn_idx);
+                if (conn) {
+                        conn->mtu = info->mtu;
+                        conn->link_flags |= LINK_FLAG_MTU_EXCHANGED;
+                }
+                return true;
+        }
+        case BLE_EVT_GATTC_READ_COMPLETED:
+        {
+                const ble_evt_gattc_read_completed_t *info = (const ble_evt_gattc_read_completed_t *) evt;
+
+                count_rx(info->conn_idx, info->length);
+                break;
+        }
+        case BLE_EVT_GATTS_WRITE_REQ:
+        {
+                const ble_evt_gatts_write_req_t *info = (const ble_evt_gatts_write_req_t *) evt;
+
+                count_rx(info->conn_idx, info->length);
+                break;
+        }
+        default:
+                break;
+        }
+
+        return false;
+}
+
+#if (LINK_STATS_ENABLE == 1)
+static uint8_t *put(uint8_t *p, uint32_t value, uint8_t size)
+{
+        while (size--) {
+                *p++ = value & 0xFF;
+                value >>= 8;
+        }
+
+        return p;
+}
+
+static void take_snapshot(void)
+{
+        uint8_t *p = snapshot + LINK_STATS_HDR_LEN;
+        uint8_t count = 0;
+        int i;
+
+        for (i = 0; i < CONN_TABLE_SIZE; i++) {
+                const struct conn_entry *conn = &conn_table[i];
+                uint32_t throughput = 0;
+
+                if (conn->role == CONN_ROLE_FREE) {
+                        continue;
+                }
+                if (conn->active_ms) {
+                        throughput = (uint32_t)(((uint64_t)(conn->rx_bytes + conn->tx_bytes) * 8 * 1000) /
+                                                                                        conn->active_ms);
+                }
+
+                p = put(p, conn->conn_idx, 1);
+                p = put(p, conn->role, 1);
+                memcpy(p, conn->addr.addr, sizeof(conn->addr.addr));
+                p += sizeof(conn->addr.addr);
+                p = put(p, conn->interval, 2);
+                p = put(p, conn->latency, 2);
+                p = put(p, conn->mtu, 2);
+                p = put(p, conn->tx_phy, 1);
+                p = put(p, conn->rx_phy, 1);
+                p = put(p, conn->tx_octets, 2);
+                p = put(p, conn->rx_octets, 2);
+                p = put(p, conn->link_flags, 1);
+                p = put(p, conn->rx_bytes, 4);
+                p = put(p, conn->tx_bytes, 4);
+                p = put(p, conn->active_ms, 4);
+                p = put(p, throughput, 4);
+                count++;
+        }
+
+        snapshot[0] = 'B';
+        snapshot[1] = 'C';
+        snapshot[2] = LINK_STATS_VERSION;
+        snapshot[3] = count;
+
+        snapshot_len = p - snapshot;
+        snapshot_pos = 0;
+        snapshot_valid = true;
+}
+
+uint16_t link_stats_read(uint8_t *buf, uint16_t max)
+{
+        uint16_t n;
+
+        if (!snapshot_valid) {
+                take_snapshot();
+        }
+
+        n = snapshot_len - snapshot_pos;
+        if (n > max) {
+                n = max;
+        }
+        memcpy(buf, &snapshot[snapshot_pos], n);
+        snapshot_pos += n;
+
+        // end of the snapshot, take a new one on the next read
+        if (n == 0) {
+                snapshot_valid = false;
+        }
+
+        return n;
+}
+
+void link_stats_reset(void)
+{
+        int i;
+
+        for (i = 0; i < CONN_TABLE_SIZE; i++) {
+                conn_table[i].rx_bytes = 0;
+                conn_table[i].tx_bytes = 0;
+                conn_table[i].active_ms = 0;
+        }
+}
+#endif /* LINK_STATS_ENABLE */
@@ -0,0 +1,108 @@
+/*
+ * ble_link.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef BLE_LINK_H_
+#define BLE_LINK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osal.h"
+#include "ble_common.h"
+
+/* Enable/disable the link statistics diagnostics attribute */
+#define LINK_STATS_ENABLE               (1)
+
+/* Request the LE 2M PHY on new connections */
+#define CFG_LINK_2M_PHY                 (1)
+
+/* Link layer payload and transmit time requested on new connections (maximum) */
+#define CFG_LINK_TX_OCTETS              (251)
+#define CFG_LINK_TX_TIME                (2120)
+
+/*
+ * Time a peer gets to answer the data length update; a peer which does not answer is
+ * taken as refusing it and the MTU exchange follows
+ */
+#define CFG_LINK_SETUP_TIMEOUT_MS       (5000)
+
+/* Gap between transfers after which the link counts as inactive for throughput */
+#define CFG_LINK_BURST_GAP_MS           (500)
+
+/*
+ * Link flags
+ */
+#define LINK_FLAG_PHY_REFUSED           (1 << 0)        /* peer refused the 2M PHY, stays on 1M */
+#define LINK_FLAG_DLE_REFUSED           (1 << 1)        /* peer refused the data length update */
+#define LINK_FLAG_MTU_EXCHANGED         (1 << 2)
+#define LINK_FLAG_DLE_PENDING           (1 << 3)        /* data length update requested, not answered yet */
+
+/*
+ * Link statistics stream format, all values little endian:
+ *
+ * header: ['B']['C'][version][number of connections]
+ * conn:   [conn_idx][role][BD address; 6][interval; 2][latency; 2][mtu; 2]
+ *         [tx phy][rx phy][tx octets; 2][rx octets; 2][flags]
+ *         [rx bytes; 4][tx bytes; 4][active ms; 4][throughput; 4]
+ *
+ * Bytes are ATT payload. Active time is the time spent in transfers, gaps longer
+ * than CFG_LINK_BURST_GAP_MS excluded; throughput is the effective rate in bits per
+ * second over the active time.
+ */
+#define LINK_STATS_VERSION              (1)
+
+/**
+ * \brief Initialize the link setup timeout
+ *
+ * \param [in] task: task notified when pending setups are checked for timeouts
+ * \param [in] notif_mask: notification bit, call link_process() when notified
+ */
+void link_init(OS_TASK task, uint32_t notif_mask);
+
+/**
+ * \brief Continue the setup of connections whose peer did not answer in time
+ */
+void link_process(void);
+
+/**
+ * \brief Negotiate the PHY, data length and (as master) the MTU of a new connection
+ *
+ * \param [in] conn_idx: connection index, in the connection table
+ */
+void link_setup(uint16_t conn_idx);
+
+/**
+ * \brief Track link layer updates and received ATT payload
+ *
+ * Call for every BLE event before it is dispatched.
+ *
+ * \return true if the event was consumed
+ */
+bool link_handle_event(const ble_evt_hdr_t *evt);
+
+/**
+ * \brief Count ATT payload sent on a connection (read responses, notifications)
+ *
+ * \param [in] conn_idx: connection index
+ * \param [in] length: value length, limited to what fits in a single PDU
+ */
+void link_count_tx(uint16_t conn_idx, uint16_t length);
+
+/**
+ * \brief Read the next chunk of the link statistics
+ *
+ * The first read takes a snapshot of all connections, following reads continue it.
+ *
+ * \return number of bytes written to \p buf, 0 at the end of the snapshot
+ */
+uint16_t link_stats_read(uint8_t *buf, uint16_t max);
+
+/**
+ * \brief Clear the transfer counters of all connections
+ */
+void link_stats_reset(void);
+
+#endif /* BLE_LINK_H_ */
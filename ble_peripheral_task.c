@@ -22,7 +22,9 @@
 #include "sys_watchdog.h"
 #include "sdk_list.h"
 #include "ble_att.h"
+#include "ble_bufops.h"
 #include "ble_gap.h"
+#include "ble_gattc.h"
 #include "ble_gatts.h"
 #include "ble_service.h"
 #include "ble_uuid.h"
@@ -35,24 +37,192 @@
 #include "ble_central_functions.h"
 #include "ble_custom_service.h"
 #include "ble_bluetanist_common.h"
+#include "ble_scan_scheduler.h"
+#include "ble_conn_table.h"
+#include "ble_conn_params.h"
+#include "ble_link.h"
+#include "collect_sched.h"
+#include "ble_adv_parser.h"
+#include "ble_trace.h"
+#include "ble_latency.h"
+#include "mem_stats.h"
+#include "sensor_snapshot.h"
+#include "sensor_rules.h"
+#include "deferred_log.h"
 
 /*
  * Flag whether this node acts as a Master node
  */
 __RETAINED_RW bool _is_master_node = false;
 
+#ifdef USE_DUMMY_DATA
+/*
+ * Retained dummy sensor data which can be pointed to in attribute read requests
+ */
+__RETAINED static uint8_t dummy_node_data[SENSOR_CH_COUNT][2];
+#else
 /*
- * Retained sensor data which can be pointed to in attribute read requests
+ * Retained copy of the sensor values which can be pointed to in attribute read requests
  */
-__RETAINED_RW struct node_data {
-        uint8_t temperature[2];
-        uint8_t humidity[2];
-        uint8_t water[2];
-} ret_node_data;
+__RETAINED static uint8_t sensor_read_value[SENSOR_CH_COUNT][2];
+#endif
 
 /* Task handle */
 __RETAINED_RW static OS_TASK ble_task_handle = NULL;
 
+/* Sensor data service handle */
+__RETAINED static ble_service_t *sensor_svc;
+/* Master node service handle, for aggregate notifications */
+__RETAINED static ble_service_t *master_svc;
+/* Alarm service handle */
+__RETAINED static ble_service_t *alarm_svc;
+
+/*
+ * Notify subscribed peers about the sensor values which changed meaningfully.
+ * Characteristic indexes of the sensor data service follow enum sensor_channel.
+ */
+static void notify_sensor_values(void)
+{
+        const struct sensor_snapshot *snap;
+        uint8_t changed;
+        int ch;
+
+        taskENTER_CRITICAL();
+        changed = sensor_data.changed;
+        sensor_data.changed = 0;
+        taskEXIT_CRITICAL();
+
+        snap = sensor_snapshot_acquire(&sensor_snapshots);
+        for (ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+                if (changed & (1 << ch)) {
+                        mcs_notify_characteristic(sensor_svc, ch, sizeof(snap->value[ch]), snap->value[ch]);
+                }
+        }
+        sensor_snapshot_release(&sensor_snapshots);
+}
+
+/* Retained alarm and rule values which can be pointed to in read requests */
+__RETAINED static uint8_t alarm_value[SENSOR_ALARM_LEN];
+__RETAINED static uint8_t alarm_rules_value[1 + SENSOR_RULES_MAX * SENSOR_RULE_LEN];
+
+/*
+ * Encode the alarm state with the sample it was evaluated on; a report takes the
+ * changed rules, a read leaves them to the next indication
+ */
+static void build_alarm_value(bool report)
+{
+        const struct sensor_snapshot *snap;
+        uint16_t active, changed;
+
+        taskENTER_CRITICAL();
+        active = alarm_rules.active;
+        changed = alarm_rules.changed;
+        if (report) {
+                alarm_rules.changed = 0;
+        }
+        taskEXIT_CRITICAL();
+
+        snap = sensor_snapshot_acquire(&sensor_snapshots);
+        put_u16(&alarm_value[0], active);
+        put_u16(&alarm_value[2], changed);
+        put_u32(&alarm_value[4], snap->timestamp);
+        put_u16(&alarm_value[8], snap->record.temperature);
+        put_u16(&alarm_value[10], snap->record.humidity);
+        put_u16(&alarm_value[12], snap->record.water);
+        sensor_snapshot_release(&sensor_snapshots);
+}
+
+/*
+ * Indicate rules which changed state, outside of the batched sensor notifications
+ */
+static void notify_alarm(void)
+{
+        build_alarm_value(true);
+        mcs_notify_characteristic(alarm_svc, NODE_ALARM_STATE_IDX, sizeof(alarm_value), alarm_value);
+}
+
+void get_alarm_cb(uint8_t **value, uint16_t *length)
+{
+        build_alarm_value(false);
+        *value = alarm_value;
+        *length = sizeof(alarm_value);
+}
+
+/*
+ * Read the rule table, see sensor_rules.h for the format
+ */
+void get_alarm_rules_cb(uint8_t **value, uint16_t *length)
+{
+        taskENTER_CRITICAL();
+        *length = sensor_rules_encode(&alarm_rules, alarm_rules_value, sizeof(alarm_rules_value));
+        taskEXIT_CRITICAL();
+        *value = alarm_rules_value;
+}
+
+/*
+ * Write (a part of) the rule table; compiled into a staged copy, then swapped in
+ */
+void set_alarm_rules_cb(const uint8_t *value, uint16_t length)
+{
+        static struct sensor_rules staged;
+
+        taskENTER_CRITICAL();
+        staged = alarm_rules;
+        taskEXIT_CRITICAL();
+
+        if (!sensor_rules_compile(&staged, value, length)) {
+                LOG_WRN("Invalid alarm rules, %d bytes\r\n", length);
+                return;
+        }
+
+        taskENTER_CRITICAL();
+        alarm_rules = staged;
+        taskEXIT_CRITICAL();
+        LOG_INF("Alarm rules: %d\r\n", staged.count);
+}
+
+#if (CFG_BROADCAST_SENSOR_DATA == 1)
+/* Manufacturer specific data holding the broadcast sensor record */
+__RETAINED static uint8_t adv_sensor_record[BLUETANIST_MFR_RECORD_LEN];
+
+/*
+ * Advertise the latest sensor record. The service UUID and the short name are put
+ * in the scan response, discovery scans are active so the master still finds them.
+ */
+static void set_broadcast_adv_data(void)
+{
+        adv_encode_sensor_record(&sensor_snapshot_acquire(&sensor_snapshots)->record, adv_sensor_record);
+        sensor_snapshot_release(&sensor_snapshots);
+
+        const gap_adv_ad_struct_t bcast_scan_rsp[] = {
+                {
+                        .type = adv_data->type,
+                        .len  = adv_data->len,
+                        .data = adv_data->data,
+                },
+                {
+                        .type = GAP_DATA_TYPE_SHORT_LOCAL_NAME,
+                        .len  = sizeof(DEVICE_SHORT_NAME) - 1,
+                        .data = (const uint8_t *) DEVICE_SHORT_NAME,
+                },
+        };
+
+        ble_gap_adv_ad_struct_set(1, GAP_ADV_AD_STRUCT_DECLARE(GAP_DATA_TYPE_MANUFACTURER_SPEC,
+                                                sizeof(adv_sensor_record), adv_sensor_record),
+                                                ARRAY_LENGTH(bcast_scan_rsp), bcast_scan_rsp);
+}
+#endif /* CFG_BROADCAST_SENSOR_DATA */
+
+/*
+ * Notify the BLE task from another task
+ */
+void ble_peripheral_notify(uint32_t mask)
+{
+        if (ble_task_handle) {
+                OS_TASK_NOTIFY(ble_task_handle, mask, eSetBits);
+        }
+}
+
 
 /*
  * @brief Read request callback
@@ -65,62 +235,296 @@ __RETAINED_RW static OS_TASK ble_task_handle = NULL;
  *
  * \param [in] length: The number of bytes/octets returned
  *
- * \param [in] data: The location of the data to return
+ * \param [in] ch: sensor channel
  *
- * \param [in] retained: retained data storage to use
+ * The value is copied from the published sensor snapshot, which is released before
+ * returning so the other snapshot readers keep their pin.
  *
  * \warning: The callback function should have that specific prototype
  *
  * \warning: The BLE stack will not proceed with the next BLE event until the
  *        callback returns.
  */
-void get_sensor_value(uint8_t **value, uint16_t *length, uint32_t *data, uint8_t *retained)
+static void get_sensor_value(uint8_t **value, uint16_t *length, enum sensor_channel ch)
 {
+#ifdef USE_DUMMY_DATA
         uint16_t sensor_value;
 
-#ifdef USE_DUMMY_DATA
         // random number 0-9
         sensor_value = rand() % 10;
 #ifdef devkitUNIQUE_BYTE
         sensor_value += devkitUNIQUE_BYTE;
 #endif // devkitUNIQUE_BYTE
+        dummy_node_data[ch][0] = sensor_value & 0xFF;
+        dummy_node_data[ch][1] = sensor_value >> 8;
+
+        *value = dummy_node_data[ch];
+        *length = sizeof(dummy_node_data[ch]);
 #else
-        taskENTER_CRITICAL();
-        sensor_value = *data;
-        taskEXIT_CRITICAL();
-#endif // USE_DUMMY_DATA
+        const struct sensor_snapshot *snap = sensor_snapshot_acquire(&sensor_snapshots);
 
-        /* Update the Characteristic Attribute value as requested by the peer device */
-        memcpy((void *)retained, (void *)&sensor_value, sizeof(sensor_value));
-        /* Return the requested data back to the peer device */
-        *value  = retained;       // A pointer that points to the returned data
-        *length = sizeof(sensor_value);  // The size of the returned data, expressed in bytes.
+        memcpy(sensor_read_value[ch], snap->value[ch], sizeof(sensor_read_value[ch]));
+        sensor_snapshot_release(&sensor_snapshots);
+
+        *value = sensor_read_value[ch];
+        *length = sizeof(sensor_read_value[ch]);
+#endif // USE_DUMMY_DATA
 }
 
 void get_temperature_value_cb(uint8_t **value, uint16_t *length)
 {
-        get_sensor_value(value, length, &sensor_data.temperature, ret_node_data.temperature);
+        get_sensor_value(value, length, SENSOR_CH_TEMPERATURE);
 }
 
 void get_humidity_value_cb(uint8_t **value, uint16_t *length)
 {
-        get_sensor_value(value, length, &sensor_data.humidity, ret_node_data.humidity);
+        get_sensor_value(value, length, SENSOR_CH_HUMIDITY);
 }
 
 void get_water_value_cb(uint8_t **value, uint16_t *length)
 {
-        get_sensor_value(value, length, &sensor_data.water, ret_node_data.water);
+        get_sensor_value(value, length, SENSOR_CH_WATER);
+}
+
+#if (BLE_TRACE_ENABLE == 1)
+/* Retained chunk of the trace stream which can be pointed to in read requests */
+__RETAINED static uint8_t trace_chunk[DIAG_READ_CHUNK];
+
+/*
+ * Return the next chunk of the BLE event trace, an empty value ends the dump
+ */
+void get_trace_cb(uint8_t **value, uint16_t *length)
+{
+        *length = ble_trace_read(trace_chunk, sizeof(trace_chunk));
+        *value = trace_chunk;
+}
+
+/*
+ * Print the BLE event trace on the serial console
+ */
+void set_trace_cb(const uint8_t *value, uint16_t length)
+{
+        ble_trace_dump();
+}
+#endif /* BLE_TRACE_ENABLE */
+
+#if (BLE_LATENCY_ENABLE == 1)
+/* Retained chunk of the latency statistics which can be pointed to in read requests */
+__RETAINED static uint8_t latency_chunk[DIAG_READ_CHUNK];
+
+/*
+ * Return the next chunk of the BLE event latency statistics, an empty value ends the dump
+ */
+void get_latency_cb(uint8_t **value, uint16_t *length)
+{
+        *length = ble_latency_read(latency_chunk, sizeof(latency_chunk));
+        *value = latency_chunk;
+}
+
+/*
+ * Clear the BLE event latency statistics
+ */
+void set_latency_cb(const uint8_t *value, uint16_t length)
+{
+        ble_latency_reset();
+}
+#endif /* BLE_LATENCY_ENABLE */
+
+#if (MEM_STATS_ENABLE == 1)
+/* Retained snapshot of the memory telemetry which can be pointed to in read requests */
+__RETAINED static uint8_t mem_stats_snapshot[MEM_STATS_SNAPSHOT_LEN];
+
+/*
+ * Return a snapshot of the heap and stack telemetry, the service continues it with long reads
+ */
+void get_mem_stats_cb(uint8_t **value, uint16_t *length)
+{
+        *length = mem_stats_read(mem_stats_snapshot, sizeof(mem_stats_snapshot));
+        *value = mem_stats_snapshot;
+}
+
+/*
+ * Print the heap and stack telemetry on the serial console
+ */
+void set_mem_stats_cb(const uint8_t *value, uint16_t length)
+{
+        mem_stats_print();
+}
+#endif /* MEM_STATS_ENABLE */
+
+#if (LINK_STATS_ENABLE == 1)
+/* Retained chunk of the link statistics which can be pointed to in read requests */
+__RETAINED static uint8_t link_stats_chunk[DIAG_READ_CHUNK];
+
+/*
+ * Return the next chunk of the per connection link statistics, an empty value ends the snapshot
+ */
+void get_link_stats_cb(uint8_t **value, uint16_t *length)
+{
+        *length = link_stats_read(link_stats_chunk, sizeof(link_stats_chunk));
+        *value = link_stats_chunk;
+}
+
+/*
+ * Clear the transfer counters of the link statistics
+ */
+void set_link_stats_cb(const uint8_t *value, uint16_t length)
+{
+        link_stats_reset();
+}
+#endif /* LINK_STATS_ENABLE */
+
+/* Retained fleet time value which can be pointed to in read requests */
+__RETAINED static uint8_t fleet_time_value[10];
+
+/*
+ * Read the fleet time: [fleet time; 4][fleet time of the last sample; 4][drift ppm; 2]
+ */
+void get_fleet_time_cb(uint8_t **value, uint16_t *length)
+{
+        const struct sensor_snapshot *snap = sensor_snapshot_acquire(&sensor_snapshots);
+
+        put_u32(&fleet_time_value[0], fleet_time_now());
+        put_u32(&fleet_time_value[4], snap->timestamp);
+        put_u16(&fleet_time_value[8], (uint16_t) fleet_time_drift());
+        sensor_snapshot_release(&sensor_snapshots);
+
+        *value = fleet_time_value;
+        *length = sizeof(fleet_time_value);
+}
+
+/*
+ * A master writes its fleet time [4] when it collects this node
+ */
+void set_fleet_time_cb(const uint8_t *value, uint16_t length)
+{
+        if (length < sizeof(uint32_t)) {
+                return;
+        }
+        fleet_time_sync(get_u32(value));
 }
 
 void set_master_node_cb(const uint8_t *value, uint16_t length)
 {
         _is_master_node = (*value >= 0);
         if(_is_master_node) {
-                gap_scan_start();
+                scan_sched_start();
+                aggregate_notify_start();
+#if (CFG_COLLECT_WINDOWS == 1)
+                collect_sched_start();
+#endif
         }
 }
 
 
+/*
+ * Dispatch a BLE event, frees it
+ */
+static void handle_ble_event(ble_evt_hdr_t *hdr)
+{
+#if (BLE_LATENCY_ENABLE == 1)
+        uint32_t evt_start = ble_latency_begin();
+#endif
+
+#if (BLE_TRACE_ENABLE == 1)
+        ble_trace_record(hdr);
+#endif
+
+        if (conn_params_handle_event(hdr)) {
+                goto handled;
+        }
+
+        if (link_handle_event(hdr)) {
+                goto handled;
+        }
+
+        if (pmp_ble_handle_event(hdr)) {
+                goto handled;
+        }
+
+        if (ble_service_handle_event(hdr)) {
+                goto handled;
+        }
+
+        switch (hdr->evt_code) {
+        case BLE_EVT_GAP_CONNECTED:
+                handle_evt_gap_connected((ble_evt_gap_connected_t *) hdr);
+                break;
+        case BLE_EVT_GAP_ADV_COMPLETED:
+                handle_evt_gap_adv_completed((ble_evt_gap_adv_completed_t *) hdr);
+                break;
+        case BLE_EVT_GAP_DISCONNECTED:
+                handle_evt_gap_disconnected((ble_evt_gap_disconnected_t *) hdr);
+                break;
+        case BLE_EVT_GAP_PAIR_REQ:
+        {
+                ble_evt_gap_pair_req_t *evt = (ble_evt_gap_pair_req_t *) hdr;
+                ble_gap_pair_reply(evt->conn_idx, true, evt->bond);
+                break;
+        }
+        case BLE_EVT_GAP_CONN_PARAM_UPDATED:
+        {
+                ble_evt_gap_conn_param_updated_t *evt = (ble_evt_gap_conn_param_updated_t *) hdr;
+                conn_table_params_updated(evt->conn_idx, &evt->conn_params);
+                break;
+        }
+        case BLE_EVT_GAP_PAIR_COMPLETED:
+                mcs_handle_pair_completed((ble_evt_gap_pair_completed_t *) hdr);
+                break;
+        default:
+                ble_handle_event_default(hdr);
+                break;
+        }
+
+handled:
+#if (BLE_LATENCY_ENABLE == 1)
+        ble_latency_record(hdr->evt_code, evt_start);
+#endif
+        OS_FREE(hdr);
+}
+
+/*
+ * Handle the queued BLE events, up to CFG_BLE_EVT_BATCH per wakeup and for at most
+ * CFG_BLE_EVT_BUDGET_MS, so the other notifications and the watchdog are still
+ * served during scan storms. The task notifies itself if events are left.
+ */
+static void drain_ble_events(void)
+{
+        OS_TICK_TIME start = OS_GET_TICK_COUNT();
+        ble_evt_hdr_t *hdr;
+        uint16_t events = 0;
+        bool more = false;
+#if (BLE_LATENCY_ENABLE == 1)
+        uint32_t drain_start = ble_latency_drain_begin();
+#endif
+
+        while (events < CFG_BLE_EVT_BATCH) {
+                hdr = ble_get_event(false);
+                if (!hdr) {
+                        more = false;
+                        break;
+                }
+                handle_ble_event(hdr);
+                events++;
+
+                more = ble_has_event();
+#if (BLE_LATENCY_ENABLE == 1)
+                ble_latency_queue_sample(more);
+#endif
+                if (!more || OS_GET_TICK_COUNT() - start >= OS_MS_2_TICKS(CFG_BLE_EVT_BUDGET_MS)) {
+                        break;
+                }
+        }
+
+#if (BLE_LATENCY_ENABLE == 1)
+        ble_latency_drain(events, drain_start, more);
+#endif
+        // notify again if there are more events to process in queue
+        if (more) {
+                OS_TASK_NOTIFY(OS_GET_CURRENT_TASK(), BLE_APP_NOTIFY_MASK, eSetBits);
+        }
+}
+
 /*
  * Main code
  */
@@ -178,7 +582,11 @@ void ble_peripheral_task(void *params)
         scan_rsp = GAP_ADV_AD_STRUCT_DECLARE(GAP_DATA_TYPE_LOCAL_NAME, name_len, name_buf);
 
         /* Set advertising data and start advertising */
+#if (CFG_BROADCAST_SENSOR_DATA == 1)
+        set_broadcast_adv_data();
+#else
         ble_gap_adv_ad_struct_set(ARRAY_LENGTH(adv_data), adv_data, 1 , scan_rsp);
+#endif
         ble_gap_adv_start(GAP_CONN_MODE_UNDIRECTED);
 
 
@@ -219,42 +627,109 @@ void ble_peripheral_task(void *params)
                         CHAR_WRITE_PROP_EN, CHAR_READ_PROP_DIS, CHAR_NOTIF_NONE, Set Master,
                                                         NULL, set_master_node_cb, NULL),
 
-                /* Get connected node data Attribute */
-                CHARACTERISTIC_DECLARATION(NODE_MASTER_ATTR_DATA, 0,
-                        CHAR_WRITE_PROP_DIS, CHAR_READ_PROP_EN, CHAR_NOTIF_NONE, Get node data,
-                                                                                 get_node_data_cb, NULL, NULL),
+                /*
+                 * Get connected node data Attribute, write the last seen generation for delta frames;
+                 * subscribers get the changed nodes notified
+                 */
+                CHARACTERISTIC_DECLARATION(NODE_MASTER_ATTR_DATA, sizeof(uint16_t),
+                        CHAR_WRITE_PROP_EN, CHAR_READ_PROP_EN, CHAR_NOTIF_NOTIF_INDIC_EN, Get node data,
+                                                                get_node_data_cb, set_node_data_base_cb, NULL),
+
+                /* Fleet time Attribute: written by the collecting master, sampling follows its epochs */
+                CHARACTERISTIC_DECLARATION(NODE_MASTER_ATTR_TIME, sizeof(fleet_time_value),
+                        CHAR_WRITE_PROP_EN, CHAR_READ_PROP_EN, CHAR_NOTIF_NONE, Fleet time,
+                                                                get_fleet_time_cb, set_fleet_time_cb, NULL),
 
         };
         // ***************** Register the Bluetooth Service in Dialog BLE framework *****************
-        SERVICE_DECLARATION(master_node_service, NODE_MASTER_SVC_UUID)
+        master_svc = SERVICE_DECLARATION(master_node_service, NODE_MASTER_SVC_UUID)
 
         //************ Characteristic declarations for the sensor_data BLE Service *************
         const mcs_characteristic_config_t sensor_data_service[] = {
 
                 /* Temperature Characteristic Attribute */
                 CHARACTERISTIC_DECLARATION(NODE_DATA_ATTR_TEMP, 0,
-                          CHAR_WRITE_PROP_DIS, CHAR_READ_PROP_EN, CHAR_NOTIF_NONE, Temperature,
+                          CHAR_WRITE_PROP_DIS, CHAR_READ_PROP_EN, CHAR_NOTIF_NOTIF_EN, Temperature,
                                                                                    get_temperature_value_cb, NULL,NULL),
 
 
                 /* Humidity Characteristic Attribute */
                 CHARACTERISTIC_DECLARATION(NODE_DATA_ATTR_HUMID, 0,
-                          CHAR_WRITE_PROP_DIS, CHAR_READ_PROP_EN, CHAR_NOTIF_NONE, Humidity,
+                          CHAR_WRITE_PROP_DIS, CHAR_READ_PROP_EN, CHAR_NOTIF_NOTIF_EN, Humidity,
                                                                                      get_humidity_value_cb, NULL, NULL),
 
 
                /* Water Characteristic Attribute */
                CHARACTERISTIC_DECLARATION(NODE_DATA_ATTR_WATER, 0,
-                          CHAR_WRITE_PROP_DIS, CHAR_READ_PROP_EN, CHAR_NOTIF_NONE, Water,
+                          CHAR_WRITE_PROP_DIS, CHAR_READ_PROP_EN, CHAR_NOTIF_NOTIF_EN, Water,
                                                                                     get_water_value_cb, NULL, NULL),
 
 
        };
        // ****************** Register the Bluetooth Service in Dialog BLE framework *****************
-        SERVICE_DECLARATION(sensor_data_service, NODE_DATA_SVC_UUID)
+        sensor_svc = SERVICE_DECLARATION(sensor_data_service, NODE_DATA_SVC_UUID)
+
+        //************ Characteristic declarations for the alarm Service *************
+        const mcs_characteristic_config_t alarm_service[] = {
+
+                /* Alarm rules Attribute: per channel min/max and rate of change rules */
+                CHARACTERISTIC_DECLARATION(NODE_ALARM_ATTR_RULES, sizeof(alarm_rules_value),
+                          CHAR_WRITE_PROP_EN, CHAR_READ_PROP_EN, CHAR_NOTIF_NONE, Alarm rules,
+                                                        get_alarm_rules_cb, set_alarm_rules_cb, NULL),
+
+                /* Alarm state Attribute: indicated when a rule changes state */
+                CHARACTERISTIC_DECLARATION(NODE_ALARM_ATTR_STATE, 0,
+                          CHAR_WRITE_PROP_DIS, CHAR_READ_PROP_EN, CHAR_NOTIF_INDIC_EN, Alarm state,
+                                                                        get_alarm_cb, NULL, NULL),
+
+        };
+        // ****************** Register the Bluetooth Service in Dialog BLE framework *****************
+        alarm_svc = SERVICE_DECLARATION(alarm_service, NODE_ALARM_SVC_UUID)
+
+#if (BLE_TRACE_ENABLE == 1) || (BLE_LATENCY_ENABLE == 1) || (MEM_STATS_ENABLE == 1) || \
+    (LINK_STATS_ENABLE == 1)
+        //************ Characteristic declarations for the diagnostics Service *************
+        const mcs_characteristic_config_t diag_service[] = {
+
+#if (BLE_TRACE_ENABLE == 1)
+                /* BLE event trace Attribute: read to dump, write to print on the console */
+                CHARACTERISTIC_DECLARATION(DIAG_ATTR_TRACE, CHARACTERISTIC_ATTR_VALUE_MAX_BYTES,
+                          CHAR_WRITE_PROP_EN, CHAR_READ_PROP_EN, CHAR_NOTIF_NONE, BLE trace,
+                                                                        get_trace_cb, set_trace_cb, NULL),
+#endif
+
+#if (BLE_LATENCY_ENABLE == 1)
+                /* BLE event latency Attribute: read to dump, write to clear */
+                CHARACTERISTIC_DECLARATION(DIAG_ATTR_LATENCY, CHARACTERISTIC_ATTR_VALUE_MAX_BYTES,
+                          CHAR_WRITE_PROP_EN, CHAR_READ_PROP_EN, CHAR_NOTIF_NONE, BLE latency,
+                                                                        get_latency_cb, set_latency_cb, NULL),
+#endif
+
+#if (MEM_STATS_ENABLE == 1)
+                /* Heap and stack telemetry Attribute: read to get a snapshot, write to print on the console */
+                CHARACTERISTIC_DECLARATION(DIAG_ATTR_MEMORY, CHARACTERISTIC_ATTR_VALUE_MAX_BYTES,
+                          CHAR_WRITE_PROP_EN, CHAR_READ_PROP_EN, CHAR_NOTIF_NONE, Memory usage,
+                                                                        get_mem_stats_cb, set_mem_stats_cb, NULL),
+#endif
+
+#if (LINK_STATS_ENABLE == 1)
+                /* Link statistics Attribute: read to get a snapshot, write to clear the transfer counters */
+                CHARACTERISTIC_DECLARATION(DIAG_ATTR_LINK, CHARACTERISTIC_ATTR_VALUE_MAX_BYTES,
+                          CHAR_WRITE_PROP_EN, CHAR_READ_PROP_EN, CHAR_NOTIF_NONE, Link statistics,
+                                                                        get_link_stats_cb, set_link_stats_cb, NULL),
+#endif
+
+        };
+        // ****************** Register the Bluetooth Service in Dialog BLE framework *****************
+        SERVICE_DECLARATION(diag_service, DIAG_SVC_UUID)
+#endif /* BLE_TRACE_ENABLE || BLE_LATENCY_ENABLE || MEM_STATS_ENABLE || LINK_STATS_ENABLE */
 
         /* Set advertising data and start advertising */
+#if (CFG_BROADCAST_SENSOR_DATA == 1)
+        set_broadcast_adv_data();
+#else
         ble_gap_adv_ad_struct_set(ARRAY_LENGTH(adv_data), adv_data, 1 , scan_rsp);
+#endif
         ble_gap_adv_start(GAP_CONN_MODE_UNDIRECTED);
 
         /* Initialize attributes for use in scanning (central) */
@@ -262,6 +737,24 @@ void ble_peripheral_task(void *params)
         ble_uuid_from_string(NODE_DATA_ATTR_TEMP, &node_data_attr_temp);
         ble_uuid_from_string(NODE_DATA_ATTR_HUMID, &node_data_attr_humid);
         ble_uuid_from_string(NODE_DATA_ATTR_WATER, &node_data_attr_water);
+        ble_uuid_from_string(NODE_MASTER_SVC_UUID, &node_master_svc_uuid);
+        ble_uuid_from_string(NODE_MASTER_ATTR_DATA, &node_master_attr_data);
+        ble_uuid_from_string(NODE_MASTER_ATTR_TIME, &node_master_attr_time);
+
+        /* Initialize the master node scan scheduler */
+        scan_sched_init(ble_task_handle, BLE_SCAN_SCHED_NOTIF);
+
+        /* Initialize the connection parameter manager */
+        conn_params_init(ble_task_handle, BLE_CONN_PARAMS_NOTIF);
+
+        /* Initialize the link setup timeout */
+        link_init(ble_task_handle, BLE_LINK_NOTIF);
+
+        /* Initialize the scheduled collection windows */
+        collect_sched_init(ble_task_handle, BLE_COLLECT_SCHED_NOTIF);
+
+        /* Initialize the aggregate notifications */
+        aggregate_notify_init(ble_task_handle, BLE_AGGREGATE_NOTIF, master_svc);
 
         for (;;) {
                 OS_BASE_TYPE ret;
@@ -283,53 +776,51 @@ void ble_peripheral_task(void *params)
                 /* resume watchdog */
                 sys_watchdog_notify_and_resume(wdog_id);
 
-                /* notified from BLE manager, can get event */
-                if (notif & BLE_APP_NOTIFY_MASK) {
-                        ble_evt_hdr_t *hdr;
-
-                        hdr = ble_get_event(false);
-                        if (!hdr) {
-                                goto no_event;
-                        }
-
-                        if (pmp_ble_handle_event(hdr)) {
-                                goto handled;
-                        }
-
-                        if (ble_service_handle_event(hdr)) {
-                                goto handled;
-                        }
-
-                        switch (hdr->evt_code) {
-                        case BLE_EVT_GAP_CONNECTED:
-                                handle_evt_gap_connected((ble_evt_gap_connected_t *) hdr);
-                                break;
-                        case BLE_EVT_GAP_ADV_COMPLETED:
-                                handle_evt_gap_adv_completed((ble_evt_gap_adv_completed_t *) hdr);
-                                break;
-                        case BLE_EVT_GAP_DISCONNECTED:
-                                handle_evt_gap_disconnected((ble_evt_gap_disconnected_t *) hdr);
-                                break;
-                        case BLE_EVT_GAP_PAIR_REQ:
-                        {
-                                ble_evt_gap_pair_req_t *evt = (ble_evt_gap_pair_req_t *) hdr;
-                                ble_gap_pair_reply(evt->conn_idx, true, evt->bond);
-                                break;
-                        }
-                        default:
-                                ble_handle_event_default(hdr);
-                                break;
-                        }
+                /* scan scheduler timer expired */
+                if (notif & BLE_SCAN_SCHED_NOTIF) {
+                        scan_sched_process();
+                }
 
-handled:
-                        OS_FREE(hdr);
+                /* check for idle connections */
+                if (notif & BLE_CONN_PARAMS_NOTIF) {
+                        conn_params_process();
+                }
 
-no_event:
-                        // notify again if there are more events to process in queue
-                        if (ble_has_event()) {
-                                OS_TASK_NOTIFY(OS_GET_CURRENT_TASK(), BLE_APP_NOTIFY_MASK, eSetBits);
-                        }
+                /* check for link setups the peer did not answer */
+                if (notif & BLE_LINK_NOTIF) {
+                        link_process();
+                }
+
+                /* collection window or batch timer expired */
+                if (notif & BLE_COLLECT_SCHED_NOTIF) {
+                        collect_sched_process();
+                }
+
+                /* an alarm rule changed state */
+                if (notif & BLE_ALARM_NOTIF) {
+                        notify_alarm();
+                }
+
+                /* aggregate changed or periodic collection due */
+                if (notif & BLE_AGGREGATE_NOTIF) {
+                        aggregate_notify_process();
+                }
 
+                /* sensor values changed meaningfully, notify them */
+                if (notif & BLE_SENSOR_UPDATE_NOTIF) {
+                        notify_sensor_values();
+                }
+
+#if (CFG_BROADCAST_SENSOR_DATA == 1)
+                /* new sample, advertise it */
+                if (notif & BLE_SENSOR_SAMPLE_NOTIF) {
+                        set_broadcast_adv_data();
+                }
+#endif
+
+                /* notified from BLE manager, can get events */
+                if (notif & BLE_APP_NOTIFY_MASK) {
+                        drain_ble_events();
                 }
 
         }
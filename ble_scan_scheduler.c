@@ -0,0 +1,330 @@
+/*
+ * ble_scan_scheduler.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Background scan scheduler for the master node.
+ *
+ * Until the fleet is known the master runs active discovery windows every
+ * CFG_SCAN_DISCOVERY_PERIOD_MS. Once CFG_SCAN_FLEET_KNOWN_WINDOWS consecutive
+ * windows did not reveal new nodes, the master switches to a passive, low duty
+ * cycle background scan which only accepts known (whitelisted) nodes, e.g. nodes
+ * which rebooted or dropped their connection. A discovery window is still run
+ * every CFG_SCAN_REDISCOVERY_PERIOD_MS to pick up new nodes.
+ *
+ * The controller whitelist API is not present in this SDK release, so the
+ * whitelist is kept here and checked on the address before anything else.
+ */
+
+#include <string.h>
+
+#include "osal.h"
+#include "ble_gap.h"
+
+#include "ble_bluetanist_common.h"
+#include "ble_central_functions.h"
+#include "ble_scan_scheduler.h"
+#include "deferred_log.h"
+
+/*
+ * Known node (whitelist) entry
+ */
+struct known_node {
+        bd_address_t addr;
+        uint16_t conn_idx;
+        known_node_state_t state;
+};
+
+__RETAINED static struct known_node known_nodes[SCAN_SCHED_MAX_KNOWN];
+
+__RETAINED static scan_sched_state_t sched_state;
+__RETAINED static bool scan_running;
+__RETAINED static bool discovery_due;
+__RETAINED static bool found_new;
+/* Number of consecutive discovery windows which did not reveal a new node */
+__RETAINED static uint8_t quiet_windows;
+
+__RETAINED static OS_TIMER sched_timer;
+__RETAINED static OS_TASK sched_task;
+__RETAINED static uint32_t sched_notif_mask;
+
+static struct known_node *find_known_by_addr(const bd_address_t *addr)
+{
+        int i;
+
+        for (i = 0; i < SCAN_SCHED_MAX_KNOWN; i++) {
+                if (known_nodes[i].state != KNOWN_NODE_FREE &&
+                                !memcmp(known_nodes[i].addr.addr, addr->addr, sizeof(addr->addr))) {
+                        return &known_nodes[i];
+                }
+        }
+
+        return NULL;
+}
+
+static struct known_node *find_known_by_connid(uint16_t conn_idx)
+{
+        int i;
+
+        for (i = 0; i < SCAN_SCHED_MAX_KNOWN; i++) {
+                if (known_nodes[i].state == KNOWN_NODE_CONNECTED && known_nodes[i].conn_idx == conn_idx) {
+                        return &known_nodes[i];
+                }
+        }
+
+        return NULL;
+}
+
+static struct known_node *add_known(const bd_address_t *addr)
+{
+        int i;
+
+        for (i = 0; i < SCAN_SCHED_MAX_KNOWN; i++) {
+                if (known_nodes[i].state == KNOWN_NODE_FREE) {
+                        memcpy(&known_nodes[i].addr, addr, sizeof(*addr));
+                        known_nodes[i].conn_idx = BLE_CONN_IDX_INVALID;
+                        known_nodes[i].state = KNOWN_NODE_IDLE;
+                        return &known_nodes[i];
+                }
+        }
+
+        return NULL;
+}
+
+static uint8_t known_count(void)
+{
+        uint8_t count = 0;
+        int i;
+
+        for (i = 0; i < SCAN_SCHED_MAX_KNOWN; i++) {
+                if (known_nodes[i].state != KNOWN_NODE_FREE) {
+                        count++;
+                }
+        }
+
+        return count;
+}
+
+static void sched_timer_cb(OS_TIMER timer)
+{
+        OS_TASK_NOTIFY(sched_task, sched_notif_mask, eSetBits);
+}
+
+static void arm_timer(uint32_t ms)
+{
+        OS_TIMER_CHANGE_PERIOD(sched_timer, OS_MS_2_TICKS(ms), OS_TIMER_FOREVER);
+}
+
+static void start_scan(void)
+{
+        if (sched_state == SCAN_SCHED_DISCOVERY) {
+                scan_running = gap_scan_start(CFG_SCAN_TYPE, CFG_SCAN_MODE,
+                                                CFG_SCAN_INTERVAL, CFG_SCAN_WINDOW, CFG_SCAN_FILT_DUPLT);
+        } else if (sched_state == SCAN_SCHED_BACKGROUND) {
+                scan_running = gap_scan_start(CFG_BG_SCAN_TYPE, CFG_BG_SCAN_MODE,
+                                                CFG_BG_SCAN_INTERVAL, CFG_BG_SCAN_WINDOW, CFG_BG_SCAN_FILT_DUPLT);
+        }
+}
+
+void scan_sched_init(OS_TASK task, uint32_t notif_mask)
+{
+        sched_task = task;
+        sched_notif_mask = notif_mask;
+        sched_state = SCAN_SCHED_IDLE;
+        scan_running = false;
+
+        sched_timer = OS_TIMER_CREATE("scan_sched", OS_MS_2_TICKS(CFG_SCAN_DISCOVERY_PERIOD_MS),
+                                                                OS_TIMER_ONCE, NULL, sched_timer_cb);
+        OS_ASSERT(sched_timer);
+}
+
+void scan_sched_start(void)
+{
+        if (sched_state != SCAN_SCHED_IDLE) {
+                return;
+        }
+
+        sched_state = SCAN_SCHED_DISCOVERY;
+        quiet_windows = 0;
+        found_new = false;
+        start_scan();
+}
+
+scan_sched_state_t scan_sched_get_state(void)
+{
+        return sched_state;
+}
+
+void scan_sched_process(void)
+{
+        switch (sched_state) {
+        case SCAN_SCHED_DISCOVERY:
+                if (!scan_running) {
+                        start_scan();
+                }
+                break;
+        case SCAN_SCHED_BACKGROUND:
+                // time for a discovery window; switch over once the background scan stopped
+                discovery_due = true;
+                if (scan_running) {
+                        ble_gap_scan_stop();
+                } else {
+                        scan_sched_scan_completed();
+                }
+                break;
+        default:
+                break;
+        }
+}
+
+bool scan_sched_accepts(const bd_address_t *addr)
+{
+        struct known_node *node;
+
+        if (sched_state == SCAN_SCHED_DISCOVERY) {
+                return true;
+        }
+
+        node = find_known_by_addr(addr);
+
+        return node != NULL && (node->state == KNOWN_NODE_IDLE || node->state == KNOWN_NODE_BROADCAST);
+}
+
+bool scan_sched_node_seen(const bd_address_t *addr)
+{
+        struct known_node *node = find_known_by_addr(addr);
+
+        if (node == NULL) {
+                // whitelist only in background mode
+                if (sched_state != SCAN_SCHED_DISCOVERY) {
+                        return false;
+                }
+                node = add_known(addr);
+                if (node == NULL) {
+                        LOG_WRN("Known node table full, ignoring: [" LOG_ADDR_FMT "]\r\n", LOG_ADDR(addr));
+                        return false;
+                }
+                found_new = true;
+        }
+
+        if (node->state != KNOWN_NODE_IDLE) {
+                return false;
+        }
+#if (CFG_COLLECT_WINDOWS == 1)
+        // known nodes are connected by the collection windows
+        return false;
+#else
+        node->state = KNOWN_NODE_PENDING;
+
+        // a background scan runs until stopped, stop it so the node can be connected
+        if (sched_state == SCAN_SCHED_BACKGROUND && scan_running) {
+                ble_gap_scan_stop();
+        }
+
+        return true;
+#endif
+}
+
+bool scan_sched_node_broadcasting(const bd_address_t *addr)
+{
+        struct known_node *node = find_known_by_addr(addr);
+
+        if (node == NULL) {
+                if (sched_state != SCAN_SCHED_DISCOVERY) {
+                        return false;
+                }
+                node = add_known(addr);
+                if (node == NULL) {
+                        return false;
+                }
+                found_new = true;
+        }
+        node->state = KNOWN_NODE_BROADCAST;
+
+        return true;
+}
+
+bool scan_sched_pop_pending(bd_address_t *addr)
+{
+        int i;
+
+        for (i = 0; i < SCAN_SCHED_MAX_KNOWN; i++) {
+                if (known_nodes[i].state == KNOWN_NODE_PENDING) {
+                        memcpy(addr, &known_nodes[i].addr, sizeof(*addr));
+                        // back to idle; the connected event moves it forward
+                        known_nodes[i].state = KNOWN_NODE_IDLE;
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+void scan_sched_scan_completed(void)
+{
+        scan_running = false;
+
+        switch (sched_state) {
+        case SCAN_SCHED_DISCOVERY:
+                quiet_windows = found_new ? 0 : quiet_windows + 1;
+                found_new = false;
+
+                if (quiet_windows >= CFG_SCAN_FLEET_KNOWN_WINDOWS && known_count() > 0) {
+                        LOG_INF("BlueTanist fleet known (%d nodes), background scanning\r\n", known_count());
+                        sched_state = SCAN_SCHED_BACKGROUND;
+                        discovery_due = false;
+                        arm_timer(CFG_SCAN_REDISCOVERY_PERIOD_MS);
+                        start_scan();
+                } else {
+                        arm_timer(CFG_SCAN_DISCOVERY_PERIOD_MS);
+                }
+                break;
+        case SCAN_SCHED_BACKGROUND:
+                if (discovery_due) {
+                        discovery_due = false;
+                        quiet_windows = 0;
+                        sched_state = SCAN_SCHED_DISCOVERY;
+                }
+                start_scan();
+                break;
+        default:
+                break;
+        }
+}
+
+void scan_sched_node_connected(const bd_address_t *addr, uint16_t conn_idx)
+{
+        struct known_node *node = find_known_by_addr(addr);
+
+        if (node == NULL) {
+                return;
+        }
+        node->conn_idx = conn_idx;
+        node->state = KNOWN_NODE_CONNECTED;
+}
+
+void scan_sched_node_disconnected(uint16_t conn_idx)
+{
+        struct known_node *node = find_known_by_connid(conn_idx);
+
+        if (node == NULL) {
+                return;
+        }
+        node->conn_idx = BLE_CONN_IDX_INVALID;
+        node->state = KNOWN_NODE_IDLE;
+}
+
+bool scan_sched_next_known(uint8_t *idx, bd_address_t *addr)
+{
+        while (*idx < SCAN_SCHED_MAX_KNOWN) {
+                struct known_node *node = &known_nodes[(*idx)++];
+
+                if (node->state == KNOWN_NODE_IDLE) {
+                        memcpy(addr, &node->addr, sizeof(*addr));
+                        return true;
+                }
+        }
+
+        return false;
+}
@@ -0,0 +1,120 @@
+/*
+ * ble_scan_scheduler.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef BLE_SCAN_SCHEDULER_H_
+#define BLE_SCAN_SCHEDULER_H_
+
+#include <stdbool.h>
+#include "osal.h"
+#include "ble_gap.h"
+
+/*
+ * Maximum number of nodes remembered by the scan scheduler (software whitelist)
+ */
+#define SCAN_SCHED_MAX_KNOWN            (16)
+
+/*
+ * Scan scheduler states
+ *
+ * DISCOVERY:  active general-discovery scan, every BlueTanist node is accepted
+ * BACKGROUND: passive low duty cycle scan, only whitelisted nodes are accepted
+ */
+typedef enum {
+        SCAN_SCHED_IDLE = 0,
+        SCAN_SCHED_DISCOVERY,
+        SCAN_SCHED_BACKGROUND,
+} scan_sched_state_t;
+
+/*
+ * State of a known node
+ */
+typedef enum {
+        KNOWN_NODE_FREE = 0,
+        KNOWN_NODE_IDLE,                /* known, not connected */
+        KNOWN_NODE_PENDING,             /* seen while scanning, waiting for connection */
+        KNOWN_NODE_CONNECTED,
+        KNOWN_NODE_BROADCAST,           /* broadcasts its sensor record, never connected */
+} known_node_state_t;
+
+/**
+ * \brief Initialize the scan scheduler
+ *
+ * \param [in] task: task to notify when the scheduler needs to run
+ * \param [in] notif_mask: notification bit(s) to set on \p task
+ */
+void scan_sched_init(OS_TASK task, uint32_t notif_mask);
+
+/**
+ * \brief Start scheduled scanning (master node), begins with a discovery window
+ */
+void scan_sched_start(void);
+
+/**
+ * \brief Run the scheduler, call from task context when notified
+ */
+void scan_sched_process(void);
+
+/**
+ * \brief Current scheduler state
+ */
+scan_sched_state_t scan_sched_get_state(void);
+
+/**
+ * \brief Whitelist check on the advertiser address
+ *
+ * \return false if reports from \p addr are of no interest in the current state
+ */
+bool scan_sched_accepts(const bd_address_t *addr);
+
+/**
+ * \brief Filter an advertising report
+ *
+ * Called for every BlueTanist advertising report. Marks the node pending for
+ * connection when it is accepted in the current scheduler state.
+ *
+ * \return true if the node should be connected
+ */
+bool scan_sched_node_seen(const bd_address_t *addr);
+
+/**
+ * \brief Whitelist a node which broadcasts its sensor record
+ *
+ * The node is accepted by background scans but never marked for connection.
+ *
+ * \return false if the node is not known and cannot be added in the current state
+ */
+bool scan_sched_node_broadcasting(const bd_address_t *addr);
+
+/**
+ * \brief Pop the next node waiting for connection
+ *
+ * \return true if \p addr was filled
+ */
+bool scan_sched_pop_pending(bd_address_t *addr);
+
+/**
+ * \brief Notify the scheduler that the running scan completed
+ */
+void scan_sched_scan_completed(void);
+
+/**
+ * \brief Track connection state of known nodes
+ */
+void scan_sched_node_connected(const bd_address_t *addr, uint16_t conn_idx);
+void scan_sched_node_disconnected(uint16_t conn_idx);
+
+/**
+ * \brief Iterate over the known nodes which are not connected and do not broadcast
+ *
+ * \param [in,out] idx: iterator, start with 0
+ * \param [out] addr: address of the node
+ *
+ * \return true if \p addr was filled
+ */
+bool scan_sched_next_known(uint8_t *idx, bd_address_t *addr);
+
+#endif /* BLE_SCAN_SCHEDULER_H_ */
@@ -0,0 +1,146 @@
+/*
+ * ble_trace.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Compact binary trace of the BLE events handled by the BLE task, kept in a RAM
+ * ring buffer. Recording and reading both happen in the BLE task context, so no
+ * locking is needed.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "osal.h"
+
+#include "ble_trace.h"
+
+__RETAINED static uint8_t trace_buf[BLE_TRACE_BUF_SIZE];
+__RETAINED static uint16_t trace_tail;          /* oldest record */
+__RETAINED static uint16_t trace_used;
+
+/* dump state */
+__RETAINED static bool trace_paused;
+__RETAINED static uint8_t dump_hdr[BLE_TRACE_DUMP_HDR_LEN];
+__RETAINED static uint8_t dump_hdr_pos;
+__RETAINED static uint16_t dump_pos;
+__RETAINED static uint16_t dump_left;
+
+static uint16_t ring_pos(uint16_t pos, uint16_t offset)
+{
+        return (pos + offset) % BLE_TRACE_BUF_SIZE;
+}
+
+static void ring_put(const uint8_t *src, uint16_t len)
+{
+        uint16_t pos = ring_pos(trace_tail, trace_used);
+        uint16_t i;
+
+        for (i = 0; i < len; i++) {
+                trace_buf[pos] = src[i];
+                pos = ring_pos(pos, 1);
+        }
+        trace_used += len;
+}
+
+static void drop_oldest(void)
+{
+        uint16_t size = BLE_TRACE_REC_HDR_LEN + trace_buf[trace_tail];
+
+        trace_tail = ring_pos(trace_tail, size);
+        trace_used -= size;
+}
+
+void ble_trace_record(const ble_evt_hdr_t *hdr)
+{
+        uint8_t rec[BLE_TRACE_REC_HDR_LEN];
+        OS_TICK_TIME now;
+        uint8_t len;
+
+        if (trace_paused) {
+                return;
+        }
+
+        len = (hdr->length < BLE_TRACE_MAX_PAYLOAD) ? hdr->length : BLE_TRACE_MAX_PAYLOAD;
+        while (BLE_TRACE_BUF_SIZE - trace_used < BLE_TRACE_REC_HDR_LEN + len) {
+                drop_oldest();
+        }
+
+        now = OS_GET_TICK_COUNT();
+        rec[0] = len;
+        rec[1] = hdr->evt_code & 0xFF;
+        rec[2] = hdr->evt_code >> 8;
+        rec[3] = hdr->length & 0xFF;
+        rec[4] = hdr->length >> 8;
+        rec[5] = now & 0xFF;
+        rec[6] = (now >> 8) & 0xFF;
+        rec[7] = (now >> 16) & 0xFF;
+        rec[8] = (now >> 24) & 0xFF;
+
+        ring_put(rec, sizeof(rec));
+        ring_put((const uint8_t *)(hdr + 1), len);
+}
+
+uint16_t ble_trace_read(uint8_t *buf, uint16_t max)
+{
+        uint16_t n = 0;
+
+        // start of a dump, freeze the trace
+        if (!trace_paused) {
+                trace_paused = true;
+                dump_hdr[0] = 'B';
+                dump_hdr[1] = 'T';
+                dump_hdr[2] = BLE_TRACE_VERSION;
+                dump_hdr[3] = 0;
+                dump_hdr[4] = configTICK_RATE_HZ & 0xFF;
+                dump_hdr[5] = (configTICK_RATE_HZ >> 8) & 0xFF;
+                dump_hdr[6] = (configTICK_RATE_HZ >> 16) & 0xFF;
+                dump_hdr[7] = (configTICK_RATE_HZ >> 24) & 0xFF;
+                dump_hdr_pos = 0;
+                dump_pos = trace_tail;
+                dump_left = trace_used;
+        }
+
+        while (n < max && dump_hdr_pos < sizeof(dump_hdr)) {
+                buf[n++] = dump_hdr[dump_hdr_pos++];
+        }
+        while (n < max && dump_left) {
+                buf[n++] = trace_buf[dump_pos];
+                dump_pos = ring_pos(dump_pos, 1);
+                dump_left--;
+        }
+
+        // end of the dump, resume recording
+        if (n == 0) {
+                trace_paused = false;
+        }
+
+        return n;
+}
+
+void ble_trace_dump(void)
+{
+        uint16_t pos = trace_tail;
+        uint16_t left = trace_used;
+        uint8_t i;
+
+        printf("BLE trace: %u bytes, tick rate %u Hz\r\n", trace_used, (unsigned int) configTICK_RATE_HZ);
+
+        while (left) {
+                uint8_t len = trace_buf[pos];
+                uint16_t code = trace_buf[ring_pos(pos, 1)] | (trace_buf[ring_pos(pos, 2)] << 8);
+                uint16_t length = trace_buf[ring_pos(pos, 3)] | (trace_buf[ring_pos(pos, 4)] << 8);
+                uint32_t ts = (uint32_t)trace_buf[ring_pos(pos, 5)] | ((uint32_t)trace_buf[ring_pos(pos, 6)] << 8) |
+                        ((uint32_t)trace_buf[ring_pos(pos, 7)] << 16) | ((uint32_t)trace_buf[ring_pos(pos, 8)] << 24);
+
+                printf("%08lx %04x %3u:", (unsigned long) ts, code, length);
+                for (i = 0; i < len; i++) {
+                        printf("%02x", trace_buf[ring_pos(pos, BLE_TRACE_REC_HDR_LEN + i)]);
+                }
+                printf("\r\n");
+
+                pos = ring_pos(pos, BLE_TRACE_REC_HDR_LEN + len);
+                left -= BLE_TRACE_REC_HDR_LEN + len;
+        }
+}
@@ -0,0 +1,57 @@
+/*
+ * ble_trace.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef BLE_TRACE_H_
+#define BLE_TRACE_H_
+
+#include <stdint.h>
+#include "ble_common.h"
+
+/* Enable/disable BLE event tracing */
+#define BLE_TRACE_ENABLE                (1)
+
+/* Size of the trace ring buffer in bytes, the oldest records are overwritten */
+#define BLE_TRACE_BUF_SIZE              (4096)
+
+/*
+ * Maximum number of event bytes (after the event header) kept per record. An
+ * advertising report with its data fits, so a scan storm can be replayed
+ * (test/ble_replay.c); longer events, GATT values mostly, are cut.
+ */
+#define BLE_TRACE_MAX_PAYLOAD           (56)
+
+/*
+ * Trace stream format, all values little endian:
+ *
+ * dump header: ['B']['T'][version][reserved][tick rate in Hz; 4]
+ * record:      [payload length; 1][evt_code; 2][evt length; 2][tick count; 4][payload]
+ */
+#define BLE_TRACE_VERSION               (1)
+#define BLE_TRACE_DUMP_HDR_LEN          (8)
+#define BLE_TRACE_REC_HDR_LEN           (9)
+
+/**
+ * \brief Record a BLE event in the trace, call for every event before it is handled
+ */
+void ble_trace_record(const ble_evt_hdr_t *hdr);
+
+/**
+ * \brief Read the next chunk of the trace stream
+ *
+ * The first read starts a dump and pauses recording until the dump is complete.
+ * The stream starts with the dump header, followed by all records oldest first.
+ *
+ * \return number of bytes written to \p buf, 0 at the end of the dump
+ */
+uint16_t ble_trace_read(uint8_t *buf, uint16_t max);
+
+/**
+ * \brief Print the trace on the serial console, one record per line
+ */
+void ble_trace_dump(void);
+
+#endif /* BLE_TRACE_H_ */
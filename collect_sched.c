@@ -0,0 +1,333 @@
+/*
+ * collect_sched.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Scheduled collection windows for the master node.
+ *
+ * Every CFG_COLLECT_PERIOD_MS the known nodes of the scan scheduler are collected in
+ * batches of CFG_COLLECT_BATCH_SIZE: the nodes of a batch are connected one after the
+ * other (a single connection procedure at a time) and collected in parallel, each
+ * node is disconnected as soon as it delivered its records. The next batch starts
+ * when all nodes of the batch are disconnected, or CFG_COLLECT_BATCH_TIMEOUT_MS after
+ * the batch started. A master can so serve more nodes than the controller can hold
+ * connections for.
+ *
+ * Windows start CFG_COLLECT_EPOCH_OFFSET_MS after the epochs of the fleet clock, right
+ * after the nodes took their aligned samples.
+ */
+
+#include <string.h>
+
+#include "osal.h"
+#include "ble_gap.h"
+
+#include "ble_bluetanist_common.h"
+#include "ble_central_functions.h"
+#include "ble_conn_table.h"
+#include "ble_scan_scheduler.h"
+#include "collect_sched.h"
+#include "deferred_log.h"
+
+/*
+ * State of a node of the running batch
+ */
+typedef enum {
+        BATCH_NODE_WAIT = 0,            /* to be connected */
+        BATCH_NODE_CONNECTING,
+        BATCH_NODE_CONNECTED,           /* collecting */
+        BATCH_NODE_DISCONNECTING,
+        BATCH_NODE_DONE,                /* disconnected or failed */
+} batch_node_state_t;
+
+struct batch_node {
+        bd_address_t addr;
+        uint16_t conn_idx;
+        batch_node_state_t state;
+};
+
+__RETAINED static struct batch_node batch[CFG_COLLECT_BATCH_SIZE];
+__RETAINED static uint8_t batch_count;
+__RETAINED static bool connecting;
+/* Next known node index of the window */
+__RETAINED static uint8_t cursor;
+
+/*
+ * Statistics of the running window
+ */
+__RETAINED static struct {
+        OS_TICK_TIME start;
+        uint8_t batches;
+        uint8_t nodes;                  /* nodes tried */
+        uint8_t collected;              /* nodes which delivered their records */
+} window;
+
+__RETAINED static collect_sched_state_t sched_state;
+__RETAINED static bool sched_started;
+__RETAINED static OS_TIMER sched_timer;
+__RETAINED static OS_TASK sched_task;
+__RETAINED static uint32_t sched_notif_mask;
+
+static void next_batch(void);
+
+static void sched_timer_cb(OS_TIMER timer)
+{
+        OS_TASK_NOTIFY(sched_task, sched_notif_mask, eSetBits);
+}
+
+static void arm_timer(uint32_t ms)
+{
+        OS_TIMER_CHANGE_PERIOD(sched_timer, OS_MS_2_TICKS(ms), OS_TIMER_FOREVER);
+}
+
+static struct batch_node *find_by_conn(uint16_t conn_idx)
+{
+        int i;
+
+        for (i = 0; i < batch_count; i++) {
+                if ((batch[i].state == BATCH_NODE_CONNECTED || batch[i].state == BATCH_NODE_DISCONNECTING) &&
+                                                                        batch[i].conn_idx == conn_idx) {
+                        return &batch[i];
+                }
+        }
+
+        return NULL;
+}
+
+static struct batch_node *find_by_state(batch_node_state_t state)
+{
+        int i;
+
+        for (i = 0; i < batch_count; i++) {
+                if (batch[i].state == state) {
+                        return &batch[i];
+                }
+        }
+
+        return NULL;
+}
+
+/*
+ * Connect the next node of the batch, one connection procedure at a time
+ */
+static void connect_next(void)
+{
+        gap_conn_params_t params = CFG_CONN_PARAMS_FAST;
+        struct batch_node *node;
+        ble_error_t status;
+
+        while (!connecting && (node = find_by_state(BATCH_NODE_WAIT)) != NULL) {
+                status = ble_gap_connect(&node->addr, &params);
+                if (status == BLE_ERROR_BUSY) {
+                        // retried when the next connection event of the batch comes in
+                        return;
+                }
+                if (status == BLE_STATUS_OK) {
+                        conn_table_connecting(&node->addr);
+                        node->state = BATCH_NODE_CONNECTING;
+                        connecting = true;
+                } else {
+                        node->state = BATCH_NODE_DONE;
+                }
+        }
+}
+
+static void end_window(void)
+{
+        uint32_t duration = OS_TICKS_2_MS(OS_GET_TICK_COUNT() - window.start);
+
+        LOG_INF("Collection window done: %d of %d nodes in %lu ms, %d batches\r\n", window.collected,
+                                                window.nodes, (unsigned long) duration, window.batches);
+
+        aggregate_notify_request();
+
+        // collect right after the sampling epoch of the next window
+        sched_state = COLLECT_SCHED_IDLE;
+        arm_timer(fleet_time_epoch_delay(CFG_COLLECT_PERIOD_MS, CFG_COLLECT_EPOCH_OFFSET_MS));
+}
+
+static void check_batch_done(void)
+{
+        int i;
+
+        for (i = 0; i < batch_count; i++) {
+                if (batch[i].state != BATCH_NODE_DONE) {
+                        return;
+                }
+        }
+
+        next_batch();
+}
+
+static void next_batch(void)
+{
+        batch_count = 0;
+        connecting = false;
+
+        while (batch_count < CFG_COLLECT_BATCH_SIZE && scan_sched_next_known(&cursor, &batch[batch_count].addr)) {
+                batch[batch_count].conn_idx = BLE_CONN_IDX_INVALID;
+                batch[batch_count].state = BATCH_NODE_WAIT;
+                batch_count++;
+        }
+
+        if (batch_count == 0) {
+                end_window();
+                return;
+        }
+
+        window.batches++;
+        window.nodes += batch_count;
+        sched_state = COLLECT_SCHED_BATCH;
+        arm_timer(CFG_COLLECT_BATCH_TIMEOUT_MS);
+        connect_next();
+}
+
+static void start_window(void)
+{
+        window.start = OS_GET_TICK_COUNT();
+        window.batches = 0;
+        window.nodes = 0;
+        window.collected = 0;
+        cursor = 0;
+
+        next_batch();
+}
+
+/*
+ * Give up on the nodes of the batch which did not deliver in time
+ */
+static void batch_timeout(void)
+{
+        struct batch_node *node;
+        int i;
+
+        if (connecting) {
+                ble_gap_connect_cancel();
+                connecting = false;
+        }
+
+        for (i = 0; i < batch_count; i++) {
+                node = &batch[i];
+
+                if (node->state == BATCH_NODE_CONNECTED) {
+                        // done once the disconnection completed
+                        node->state = BATCH_NODE_DISCONNECTING;
+                        ble_gap_disconnect(node->conn_idx, BLE_HCI_ERROR_REMOTE_USER_TERM_CON);
+                } else if (node->state != BATCH_NODE_DISCONNECTING) {
+                        node->state = BATCH_NODE_DONE;
+                }
+        }
+
+        check_batch_done();
+}
+
+void collect_sched_init(OS_TASK task, uint32_t notif_mask)
+{
+        sched_task = task;
+        sched_notif_mask = notif_mask;
+        sched_state = COLLECT_SCHED_IDLE;
+        sched_started = false;
+
+        sched_timer = OS_TIMER_CREATE("collect_sched", OS_MS_2_TICKS(CFG_COLLECT_PERIOD_MS),
+                                                                OS_TIMER_ONCE, NULL, sched_timer_cb);
+        OS_ASSERT(sched_timer);
+}
+
+void collect_sched_start(void)
+{
+        if (sched_started) {
+                return;
+        }
+        sched_started = true;
+
+        start_window();
+}
+
+void collect_sched_process(void)
+{
+        switch (sched_state) {
+        case COLLECT_SCHED_IDLE:
+                start_window();
+                break;
+        case COLLECT_SCHED_BATCH:
+                batch_timeout();
+                break;
+        default:
+                break;
+        }
+}
+
+bool collect_sched_is_batch_conn(uint16_t conn_idx)
+{
+        return sched_state == COLLECT_SCHED_BATCH && find_by_conn(conn_idx) != NULL;
+}
+
+void collect_sched_connection_completed(const ble_evt_gap_connection_completed_t *info)
+{
+        struct batch_node *node;
+
+        if (sched_state != COLLECT_SCHED_BATCH) {
+                return;
+        }
+
+        /*
+         * Successful connections were taken over by the connected event already, the
+         * next connection procedure may be running by now. A failed procedure did not
+         * connect, so the node connecting is the one which failed.
+         */
+        if (info->status != BLE_STATUS_OK && connecting) {
+                connecting = false;
+                node = find_by_state(BATCH_NODE_CONNECTING);
+                if (node) {
+                        node->state = BATCH_NODE_DONE;
+                }
+        }
+
+        // a procedure completed, retry the nodes a busy controller turned down
+        connect_next();
+        check_batch_done();
+}
+
+void collect_sched_node_connected(const bd_address_t *addr, uint16_t conn_idx)
+{
+        struct batch_node *node = find_by_state(BATCH_NODE_CONNECTING);
+
+        if (sched_state != COLLECT_SCHED_BATCH || node == NULL ||
+                                        memcmp(node->addr.addr, addr->addr, sizeof(addr->addr))) {
+                return;
+        }
+
+        node->state = BATCH_NODE_CONNECTED;
+        node->conn_idx = conn_idx;
+        connecting = false;
+
+        collect_node(conn_idx, addr);
+        connect_next();
+}
+
+void collect_sched_node_done(uint16_t conn_idx)
+{
+        struct batch_node *node = find_by_conn(conn_idx);
+
+        if (sched_state != COLLECT_SCHED_BATCH || node == NULL || node->state != BATCH_NODE_CONNECTED) {
+                return;
+        }
+
+        node->state = BATCH_NODE_DISCONNECTING;
+        window.collected++;
+        ble_gap_disconnect(conn_idx, BLE_HCI_ERROR_REMOTE_USER_TERM_CON);
+}
+
+void collect_sched_node_disconnected(uint16_t conn_idx)
+{
+        struct batch_node *node = find_by_conn(conn_idx);
+
+        if (sched_state != COLLECT_SCHED_BATCH || node == NULL) {
+                return;
+        }
+
+        node->state = BATCH_NODE_DONE;
+        connect_next();
+        check_batch_done();
+}
@@ -0,0 +1,62 @@
+/*
+ * collect_sched.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef COLLECT_SCHED_H_
+#define COLLECT_SCHED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "osal.h"
+#include "ble_gap.h"
+
+/*
+ * Collection scheduler states
+ *
+ * IDLE:   waiting for the next window
+ * BATCH:  connecting and collecting a batch of nodes
+ */
+typedef enum {
+        COLLECT_SCHED_IDLE = 0,
+        COLLECT_SCHED_BATCH,
+} collect_sched_state_t;
+
+/**
+ * \brief Initialize the collection scheduler
+ *
+ * \param [in] task: task to notify when the scheduler needs to run
+ * \param [in] notif_mask: notification bit(s) to set on \p task
+ */
+void collect_sched_init(OS_TASK task, uint32_t notif_mask);
+
+/**
+ * \brief Start scheduled collection windows (master node), the first one starts right away
+ */
+void collect_sched_start(void);
+
+/**
+ * \brief Run the scheduler, call from task context when notified
+ */
+void collect_sched_process(void);
+
+/**
+ * \brief Check whether a connection belongs to the running batch
+ */
+bool collect_sched_is_batch_conn(uint16_t conn_idx);
+
+/**
+ * \brief Track the connections of the running batch
+ */
+void collect_sched_connection_completed(const ble_evt_gap_connection_completed_t *info);
+void collect_sched_node_connected(const bd_address_t *addr, uint16_t conn_idx);
+void collect_sched_node_disconnected(uint16_t conn_idx);
+
+/**
+ * \brief A node of the batch delivered its records, it is disconnected
+ */
+void collect_sched_node_done(uint16_t conn_idx);
+
+#endif /* COLLECT_SCHED_H_ */
@@ -114,7 +114,7 @@
 #define dg_configBLE_L2CAP_COC                  ( 1 )
 
 #define defaultBLE_ATT_DB_CONFIGURATION         ( 0x30 )
-#define CFG_AUTO_CONN_PARAM_REPLY               ( 1 )
+#define CFG_AUTO_CONN_PARAM_REPLY               ( 0 )    /* replied by ble_conn_params.c */
 #define CFG_AUTO_PAIR_REPLY                     ( 1 )
 
 /* Include bsp default values */
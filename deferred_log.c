@@ -0,0 +1,140 @@
+/*
+ * deferred_log.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Deferred binary logger.
+ *
+ * Producers store the format string address (format ID) and the raw arguments
+ * in a bounded lock-free ring buffer; a low priority task renders the messages
+ * with printf. Producers therefore never wait on the UART.
+ *
+ * The ring buffer is a multi-producer, single-consumer queue: every slot
+ * carries a sequence number telling whether it is free for position pos
+ * (seq == pos) or holds the message of position pos (seq == pos + 1).
+ * Producers claim a position with a compare-and-swap.
+ */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "osal.h"
+
+#include "deferred_log.h"
+
+struct log_slot {
+        uint32_t seq;
+        const char *fmt;
+        OS_TICK_TIME time;
+        uint32_t args[LOG_MAX_ARGS];
+        uint8_t level;
+};
+
+__RETAINED static struct log_slot log_slots[LOG_SLOTS];
+__RETAINED static uint32_t enqueue_pos;
+__RETAINED static uint32_t dequeue_pos;
+__RETAINED static uint32_t dropped;
+
+static const char level_tag[] = "-EWID";
+
+void log_write(uint8_t level, uint8_t nargs, const char *fmt, ...)
+{
+        struct log_slot *slot;
+        uint32_t pos, seq;
+        int32_t dif;
+        va_list ap;
+        uint8_t i;
+
+        pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+        for (;;) {
+                slot = &log_slots[pos % LOG_SLOTS];
+                seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+                dif = (int32_t)(seq - pos);
+
+                if (dif == 0) {
+                        // slot is free for this position, try to claim it
+                        if (__atomic_compare_exchange_n(&enqueue_pos, &pos, pos + 1, true,
+                                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                                break;
+                        }
+                } else if (dif < 0) {
+                        // ring buffer full
+                        __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+                        return;
+                } else {
+                        pos = __atomic_load_n(&enqueue_pos, __ATOMIC_RELAXED);
+                }
+        }
+
+        slot->fmt = fmt;
+        slot->level = level;
+        slot->time = OS_GET_TICK_COUNT();
+
+        va_start(ap, fmt);
+        for (i = 0; i < LOG_MAX_ARGS; i++) {
+                slot->args[i] = (i < nargs) ? va_arg(ap, uint32_t) : 0;
+        }
+        va_end(ap);
+
+        // publish the message
+        __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t log_dropped(void)
+{
+        return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
+
+/*
+ * Take the next message from the ring buffer (single consumer)
+ */
+static bool log_read(struct log_slot *msg)
+{
+        struct log_slot *slot = &log_slots[dequeue_pos % LOG_SLOTS];
+
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != dequeue_pos + 1) {
+                return false;
+        }
+
+        *msg = *slot;
+
+        // release the slot for the position one lap ahead
+        __atomic_store_n(&slot->seq, dequeue_pos + LOG_SLOTS, __ATOMIC_RELEASE);
+        dequeue_pos++;
+
+        return true;
+}
+
+void log_init(void)
+{
+        uint32_t i;
+
+        for (i = 0; i < LOG_SLOTS; i++) {
+                log_slots[i].seq = i;
+        }
+        enqueue_pos = 0;
+        dequeue_pos = 0;
+        dropped = 0;
+}
+
+void log_task(void *params)
+{
+        struct log_slot msg;
+        uint32_t reported_drops = 0;
+
+        for (;;) {
+                OS_DELAY_MS(LOG_FLUSH_PERIOD_MS);
+
+                while (log_read(&msg)) {
+                        printf("[%lu %c] ", (unsigned long) OS_TICKS_2_MS(msg.time), level_tag[msg.level]);
+                        printf(msg.fmt, msg.args[0], msg.args[1], msg.args[2], msg.args[3]);
+                }
+
+                if (log_dropped() != reported_drops) {
+                        reported_drops = log_dropped();
+                        printf("[log] %lu messages dropped\r\n", (unsigned long) reported_drops);
+                }
+        }
+}
@@ -0,0 +1,117 @@
+/*
+ * deferred_log.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef DEFERRED_LOG_H_
+#define DEFERRED_LOG_H_
+
+#include <stdint.h>
+
+/*
+ * Log levels
+ */
+#define LOG_LEVEL_NONE          (0)
+#define LOG_LEVEL_ERR           (1)
+#define LOG_LEVEL_WRN           (2)
+#define LOG_LEVEL_INF           (3)
+#define LOG_LEVEL_DBG           (4)
+
+/*
+ * Compile-time log level, messages above this level are not compiled in
+ */
+#ifndef LOG_LEVEL
+#define LOG_LEVEL               LOG_LEVEL_INF
+#endif
+
+/* Number of log slots in the ring buffer, must be a power of 2 */
+#define LOG_SLOTS               (32)
+
+/* Maximum number of arguments per message */
+#define LOG_MAX_ARGS            (4)
+
+/* Period at which the log task renders pending messages */
+#define LOG_FLUSH_PERIOD_MS     (100)
+
+/*
+ * Count the arguments following the format string (up to LOG_MAX_ARGS). A message
+ * with 5 to 12 arguments expands to the undeclared log_too_many_arguments and fails
+ * to compile instead of silently dropping arguments.
+ */
+#define LOG_NARGS(...)          LOG_NARGS_(__VA_ARGS__, LOG_NARGS_ERR, LOG_NARGS_ERR, LOG_NARGS_ERR, \
+                                        LOG_NARGS_ERR, LOG_NARGS_ERR, LOG_NARGS_ERR, LOG_NARGS_ERR, \
+                                        LOG_NARGS_ERR, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_fmt, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, N, ...) N
+#define LOG_NARGS_ERR           log_too_many_arguments
+
+/*
+ * Bluetooth device address as two integer arguments, most significant byte first:
+ *
+ *   LOG_INF("Node " LOG_ADDR_FMT "\r\n", LOG_ADDR(&addr));
+ */
+#define LOG_ADDR_FMT            "%04x%08lx"
+#define LOG_ADDR(_a)            (unsigned int) ((_a)->addr[5] << 8 | (_a)->addr[4]), \
+                                (unsigned long) ((uint32_t) (_a)->addr[3] << 24 | (uint32_t) (_a)->addr[2] << 16 | \
+                                                 (uint32_t) (_a)->addr[1] << 8 | (_a)->addr[0])
+
+#define LOG_WRITE(_level, ...)  log_write(_level, LOG_NARGS(__VA_ARGS__), __VA_ARGS__)
+
+/*
+ * Logging macros
+ *
+ * The format string must be a literal; its address is the format ID stored in the
+ * ring buffer, the message is rendered later by the log task. Arguments are stored
+ * as 32-bit words: integers and pointers to data which outlives the message (e.g.
+ * string literals). Strings from static conversion buffers such as
+ * ble_address_to_string() must not be passed, use LOG_ADDR() for addresses.
+ */
+#if (LOG_LEVEL >= LOG_LEVEL_ERR)
+#define LOG_ERR(...)            LOG_WRITE(LOG_LEVEL_ERR, __VA_ARGS__)
+#else
+#define LOG_ERR(...)            do { } while (0)
+#endif
+
+#if (LOG_LEVEL >= LOG_LEVEL_WRN)
+#define LOG_WRN(...)            LOG_WRITE(LOG_LEVEL_WRN, __VA_ARGS__)
+#else
+#define LOG_WRN(...)            do { } while (0)
+#endif
+
+#if (LOG_LEVEL >= LOG_LEVEL_INF)
+#define LOG_INF(...)            LOG_WRITE(LOG_LEVEL_INF, __VA_ARGS__)
+#else
+#define LOG_INF(...)            do { } while (0)
+#endif
+
+#if (LOG_LEVEL >= LOG_LEVEL_DBG)
+#define LOG_DBG(...)            LOG_WRITE(LOG_LEVEL_DBG, __VA_ARGS__)
+#else
+#define LOG_DBG(...)            do { } while (0)
+#endif
+
+/**
+ * \brief Initialize the log ring buffer, call before any task logs
+ */
+void log_init(void);
+
+/**
+ * \brief Queue a log message, never blocks
+ *
+ * Safe to call from any task. The message is dropped if the ring buffer is full.
+ * Use the LOG_xxx macros instead of calling this directly.
+ */
+void log_write(uint8_t level, uint8_t nargs, const char *fmt, ...);
+
+/**
+ * \brief Number of messages dropped because the ring buffer was full
+ */
+uint32_t log_dropped(void);
+
+/**
+ * \brief Log task, renders queued messages on the serial console
+ */
+void log_task(void *params);
+
+#endif /* DEFERRED_LOG_H_ */
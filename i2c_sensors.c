@@ -13,6 +13,9 @@
 #include "peripheral_setup.h"
 #include "platform_devices.h"
 #include "i2c_sensors.h"
+#include "sensor_conversion.h"
+#include "sensor_calib_tables.h"
+#include "deferred_log.h"
 
 /*
  * Drivers
@@ -47,11 +50,10 @@ static int8_t i2c_write_reg(i2c_device dev, uint8_t reg, uint8_t *val, uint8_t l
          */
         I2C_error_code = ad_i2c_write(dev_hdr, data, len+1, HW_I2C_F_ADD_STOP);
         if (HW_I2C_ABORT_NONE != I2C_error_code) {
-                printf("I2C write failure: %u\n", I2C_error_code);
-                return I2C_error_code;
+                LOG_ERR("I2C write failure: %u\r\n", I2C_error_code);
         }
 
-        /* Close the device */
+        /* Close the device, also on a failure or the next open waits for ever */
         ad_i2c_close(dev_hdr, false);
 
         return I2C_error_code;
@@ -70,8 +72,8 @@ static int8_t i2c_read_reg(i2c_device dev, uint8_t reg, uint8_t *val, uint8_t le
          */
         I2C_error_code = ad_i2c_write(dev_hdr, &reg, 1, HW_I2C_F_ADD_STOP);
         if (HW_I2C_ABORT_NONE != I2C_error_code) {
-                printf("I2C write failure: %u\n", I2C_error_code);
-                return I2C_error_code;
+                LOG_ERR("I2C write failure: %u\r\n", I2C_error_code);
+                goto close;
         }
 
         /*
@@ -79,11 +81,11 @@ static int8_t i2c_read_reg(i2c_device dev, uint8_t reg, uint8_t *val, uint8_t le
          */
         I2C_error_code = ad_i2c_read(dev_hdr, val, len, HW_I2C_F_ADD_STOP);
         if (HW_I2C_ABORT_NONE != I2C_error_code) {
-                printf("I2C read failure: %u\n", I2C_error_code);
-                return I2C_error_code;
+                LOG_ERR("I2C read failure: %u\r\n", I2C_error_code);
         }
 
-        /* Close the device */
+close:
+        /* Close the device, also on a failure or the next open waits for ever */
         ad_i2c_close(dev_hdr, false);
 
         return I2C_error_code;
@@ -136,14 +138,12 @@ int read_bmp_sensor(struct sensor_data_t *data)
         v_uncomp_temp_u16 = bmp180_get_uncomp_temperature();
         v_uncomp_press_u32 = bmp180_get_uncomp_pressure();
 
-        com_rslt += bmp180_get_temperature(v_uncomp_temp_u16);
-
-        com_rslt += bmp180_get_pressure(v_uncomp_press_u32);
+        // run the (costly) Bosch integer compensation once per value
         uint32_t temp = bmp180_get_temperature(v_uncomp_temp_u16);
         uint32_t pres = bmp180_get_pressure(v_uncomp_press_u32);
 
         data->temperature = temp * 10;
-        printf("BMP: Temp: %lu, Pressure: %lu\r\n", temp, pres);
+        LOG_DBG("BMP: Temp: %lu, Pressure: %lu\r\n", temp, pres);
 
         return 0;
 }
@@ -157,7 +157,7 @@ int read_hih_sensor(struct sensor_data_t *data)
 {
         uint8_t raw_data[4];
         uint16_t raw_humidity, raw_temperature;
-        uint32_t rel_humidity, amb_temperature;
+        int32_t rel_humidity, amb_temperature;
 
         /*
          * Send a measurement request.
@@ -175,7 +175,7 @@ int read_hih_sensor(struct sensor_data_t *data)
          * Read 4 bytes from the sensor
          */
         if (0 != i2c_read_reg(HIH6130, 0x0, raw_data, 4)) {
-                printf("HIH6130 sensor read failed.");
+                LOG_ERR("HIH6130 sensor read failed.\r\n");
                 return 1;
         }
 
@@ -186,12 +186,12 @@ int read_hih_sensor(struct sensor_data_t *data)
          */
         raw_humidity = ((((uint16_t)raw_data[0] & 0x3F) << 8) | (uint16_t)raw_data[1]);
         raw_temperature = ((uint16_t)raw_data[2] << 6) | ((uint16_t)raw_data[3] >> 2);
-        rel_humidity = ((uint32_t)raw_humidity * 10000) / 16382;
-        amb_temperature = (((uint32_t)raw_temperature * 16500) / 16382) - 4000;
+        rel_humidity = calib_apply(&calib_hih_humidity, conv_hih_humidity(raw_humidity));
+        amb_temperature = calib_apply(&calib_hih_temperature, conv_hih_temperature(raw_temperature));
 
         data->temperature = amb_temperature;
         data->humidity = rel_humidity;
-        printf("HIH6130: Temp: %lu, Humidity: %lu\r\n", amb_temperature, rel_humidity);
+        LOG_DBG("HIH6130: Temp: %ld, Humidity: %ld\r\n", amb_temperature, rel_humidity);
 
         return 0;
 }
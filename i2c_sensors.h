@@ -8,10 +8,23 @@
 #ifndef I2C_SENSORS_H_
 #define I2C_SENSORS_H_
 
+/*
+ * Sensor channels, in the order of the sensor data service characteristics
+ */
+enum sensor_channel {
+        SENSOR_CH_TEMPERATURE = 0,
+        SENSOR_CH_HUMIDITY,
+        SENSOR_CH_WATER,
+        SENSOR_CH_COUNT,
+};
+
 struct sensor_data_t {
         uint32_t temperature;
         uint32_t humidity;
         uint32_t water;
+        uint16_t sequence;
+        uint8_t battery;
+        uint8_t changed;        /* bitmask of channels which changed meaningfully, (1 << channel) */
 } sensor_data;
 
 #if dg_configI2C_ADAPTER || dg_configUSE_HW_I2C
@@ -18,42 +18,170 @@
 
 /* Required libraries for the target application */
 #include "i2c_sensors.h"
+#include "sensor_filter.h"
+#include "sensor_snapshot.h"
+#include "sensor_rules.h"
+#include "ble_bluetanist_common.h"
 
 
 /* Enable/disable debugging aid. Valid values */
 #define DBG_SERIAL_CONSOLE_ENABLE      (1)
 
+/* Number of readings averaged into one sample */
+#define SENSOR_OVERSAMPLING             (4)
+
+/*
+ * Filter configuration per channel, values in 0.01 units. The traces of test/traces/
+ * are replayed with the temperature and humidity configurations.
+ */
+static const struct sensor_filter_config filter_config[SENSOR_CH_COUNT] = {
+        [SENSOR_CH_TEMPERATURE] = {
+                .ema_shift = 2, .median = true, .outlier_limit = 500, .max_rejects = 3, .change_delta = 10,
+        },
+        [SENSOR_CH_HUMIDITY] = {
+                .ema_shift = 2, .median = true, .outlier_limit = 1000, .max_rejects = 3, .change_delta = 50,
+        },
+        [SENSOR_CH_WATER] = {
+                .ema_shift = 3, .median = true, .outlier_limit = 1000, .max_rejects = 3, .change_delta = 50,
+        },
+};
+
+/* Filter state per channel */
+__RETAINED static struct sensor_filter filters[SENSOR_CH_COUNT];
+
+/* Published sensor snapshot, read by the BLE task */
+__RETAINED struct sensor_snapshot_buf sensor_snapshots;
+
+/* Alarm rules, configured by the BLE task */
+__RETAINED struct sensor_rules alarm_rules;
+
 /* Task handle */
 __RETAINED_RW static OS_TASK i2c_task_handle = NULL;
 
+/*
+ * Take one reading from all enabled sensors
+ */
+static int acquire(struct sensor_data_t *data)
+{
+        int err = 0;
+
+#if dg_configSENSOR_BMP180
+        err |= read_bmp_sensor(data);
+#endif /* dg_configSENSOR_BMP180 */
+#if dg_configSENSOR_HIH6130
+        err |= read_hih_sensor(data);
+#endif /* dg_configSENSOR_HIH6130 */
+
+        return err;
+}
+
 
 void I2C_task(void *params)
 {
+        int ch;
+
         /* Get task's handler */
         i2c_task_handle = OS_GET_CURRENT_TASK();
 
         printf("\n\r*** I2C task started ***\n\n\r");
 
+        for (ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+                sensor_filter_reset(&filters[ch]);
+        }
 
         for (;;) {
-                struct sensor_data_t new_sensor_data = { 0 };
+                int32_t sum[SENSOR_CH_COUNT] = { 0 };
+                int32_t value[SENSOR_CH_COUNT];
+                uint16_t alarms = 0;
+                struct sensor_snapshot *snap;
+                uint8_t changed = 0;
+                int n, valid = 0;
+                uint32_t epoch = fleet_time_now();
 
-#if dg_configSENSOR_BMP180
-                read_bmp_sensor(&new_sensor_data);
-#endif /* dg_configSENSOR_BMP180 */
-#if dg_configSENSOR_HIH6130
-                read_hih_sensor(&new_sensor_data);
-#endif /* dg_configSENSOR_HIH6130 */
+                /*
+                 * Oversample: average a number of readings into one sample
+                 */
+                for (n = 0; n < SENSOR_OVERSAMPLING; n++) {
+                        struct sensor_data_t reading = { 0 };
+
+                        if (acquire(&reading) != 0) {
+                                continue;
+                        }
+                        sum[SENSOR_CH_TEMPERATURE] += (int32_t)reading.temperature;
+                        sum[SENSOR_CH_HUMIDITY] += (int32_t)reading.humidity;
+                        sum[SENSOR_CH_WATER] += (int32_t)reading.water;
+                        valid++;
+                }
+
+                /*
+                 * No reading succeeded: nothing new to publish, the last sample and its
+                 * sequence number stay
+                 */
+                if (valid == 0) {
+                        OS_DELAY_MS(fleet_time_epoch_delay(CFG_SAMPLE_PERIOD_MS, 0));
+                        continue;
+                }
+
+                /*
+                 * Filter the sample, keep track of channels which changed meaningfully
+                 */
+                for (ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+                        if (sensor_filter_update(&filters[ch], &filter_config[ch], sum[ch] / valid)) {
+                                changed |= (1 << ch);
+                        }
+                        value[ch] = sensor_filter_value(&filters[ch]);
+                }
+
+                /*
+                 * Evaluate the alarm rules on the filtered sample; the table is
+                 * replaced by the BLE task, keep it consistent for the pass
+                 */
+                taskENTER_CRITICAL();
+                alarms = sensor_rules_eval(&alarm_rules, value, epoch);
+                taskEXIT_CRITICAL();
 
                 /*
                  * Copy new sensor data to the global data struct
                  */
                 taskENTER_CRITICAL();
-                sensor_data.temperature = new_sensor_data.temperature;
-                sensor_data.humidity = new_sensor_data.humidity;
+                sensor_data.temperature = sensor_filter_value(&filters[SENSOR_CH_TEMPERATURE]);
+                sensor_data.humidity = sensor_filter_value(&filters[SENSOR_CH_HUMIDITY]);
+                sensor_data.water = sensor_filter_value(&filters[SENSOR_CH_WATER]);
+                // the sensor board has no battery measurement, masters leave the battery level unset
+                sensor_data.battery = SENSOR_BATTERY_UNKNOWN;
+                sensor_data.sequence++;
+                sensor_data.changed |= changed;
                 taskEXIT_CRITICAL();
 
-                OS_DELAY_MS(1000);
+                /*
+                 * Publish the sample for the BLE task
+                 */
+                snap = sensor_snapshot_begin(&sensor_snapshots);
+                snap->record.temperature = sensor_filter_value(&filters[SENSOR_CH_TEMPERATURE]);
+                snap->record.humidity = sensor_filter_value(&filters[SENSOR_CH_HUMIDITY]);
+                snap->record.water = sensor_filter_value(&filters[SENSOR_CH_WATER]);
+                snap->record.sequence = sensor_data.sequence;
+                snap->record.battery = SENSOR_BATTERY_UNKNOWN;
+                snap->timestamp = epoch;
+                sensor_snapshot_publish(&sensor_snapshots, snap);
+
+#if (CFG_BROADCAST_SENSOR_DATA == 1)
+                /* the advertised record carries every sample */
+                ble_peripheral_notify(BLE_SENSOR_SAMPLE_NOTIF);
+#endif
+
+                /* let the BLE task notify meaningful changes only */
+                if (changed) {
+                        ble_peripheral_notify(BLE_SENSOR_UPDATE_NOTIF);
+                }
+
+                /* rule violations are indicated right away */
+                if (alarms) {
+                        ble_peripheral_notify(BLE_ALARM_NOTIF);
+                }
+
+                /* sleep until the next sampling epoch of the fleet clock */
+                OS_DELAY_MS(fleet_time_epoch_delay(CFG_SAMPLE_PERIOD_MS, 0));
 
 //                OS_BASE_TYPE ret;
 //                uint32_t notif;
@@ -28,10 +28,20 @@
 #include "hw_sys.h"
 #include "peripheral_setup.h"
 #include "platform_devices.h"
+#include "deferred_log.h"
+#include "mem_stats.h"
 
 /* Task priorities */
 #define mainBLE_PERIPHERAL_TASK_PRIORITY        ( OS_TASK_PRIORITY_NORMAL )
 #define mainI2C_TASK_PRIORITY                   ( OS_TASK_PRIORITY_LOWEST )
+#define mainLOG_TASK_PRIORITY                   ( OS_TASK_PRIORITY_LOWEST )
+
+/* Stack size of the application tasks in bytes */
+#if defined CONFIG_RETARGET
+#define mainTASK_STACK_SIZE                     ( 1024 )
+#else
+#define mainTASK_STACK_SIZE                     ( 200 * OS_STACK_WORD_SIZE )
+#endif
 
 /* The rate at which data is template task counter is incremented. */
 #define mainCOUNTER_FREQUENCY_MS                OS_MS_2_TICKS(200)
@@ -58,6 +68,7 @@ void I2C_task(void *params);
 __RETAINED static OS_TASK prvSysInit_h = NULL;
 __RETAINED static OS_TASK prvBLETask_h = NULL;
 __RETAINED static OS_TASK prvI2CTask_h = NULL;
+__RETAINED static OS_TASK prvLogTask_h = NULL;
 
 /**
  * @brief System Initialization and creation of the BLE task
@@ -112,6 +123,9 @@ static void system_init( void *pvParameters )
         retarget_init();
 #endif
 
+        /* Initialize the deferred logger before any task can log */
+        log_init();
+
         /* Initialize BLE Manager */
         ble_mgr_init();
 
@@ -120,13 +134,8 @@ static void system_init( void *pvParameters )
                                                            debug only; not used by the kernel. */
                        ble_peripheral_task,             /* The function that implements the task. */
                        NULL,                            /* The parameter passed to the task. */
-#if defined CONFIG_RETARGET
-                       1024,                            /* The number of bytes to allocate to the
-                                                           stack of the task. */
-#else
-                       200 * OS_STACK_WORD_SIZE,        /* The number of bytes to allocate to the
+                       mainTASK_STACK_SIZE,             /* The number of bytes to allocate to the
                                                            stack of the task. */
-#endif
                        mainBLE_PERIPHERAL_TASK_PRIORITY,/* The priority assigned to the task. */
                        prvBLETask_h);                         /* The task prvBLETask_h. */
         OS_ASSERT(prvBLETask_h);
@@ -136,17 +145,28 @@ static void system_init( void *pvParameters )
                                                            debug only; not used by the kernel. */
                        I2C_task,             /* The function that implements the task. */
                        NULL,                            /* The parameter passed to the task. */
-#if defined CONFIG_RETARGET
-                       1024,                            /* The number of bytes to allocate to the
-                                                           stack of the task. */
-#else
-                       200 * OS_STACK_WORD_SIZE,        /* The number of bytes to allocate to the
+                       mainTASK_STACK_SIZE,             /* The number of bytes to allocate to the
                                                            stack of the task. */
-#endif
                        mainI2C_TASK_PRIORITY,/* The priority assigned to the task. */
                        prvI2CTask_h);                         /* The task prvBLETask_h. */
         OS_ASSERT(prvI2CTask_h);
 
+        /* Start the log task, renders deferred log messages when nothing else runs. */
+        OS_TASK_CREATE("Log",                /* The text name assigned to the task, for
+                                                           debug only; not used by the kernel. */
+                       log_task,                        /* The function that implements the task. */
+                       NULL,                            /* The parameter passed to the task. */
+                       mainTASK_STACK_SIZE,             /* The number of bytes to allocate to the
+                                                           stack of the task. */
+                       mainLOG_TASK_PRIORITY,           /* The priority assigned to the task. */
+                       prvLogTask_h);                   /* The task handle. */
+        OS_ASSERT(prvLogTask_h);
+
+        /* Monitor the stack usage of the application tasks */
+        mem_stats_register_task(prvBLETask_h, mainTASK_STACK_SIZE);
+        mem_stats_register_task(prvI2CTask_h, mainTASK_STACK_SIZE);
+        mem_stats_register_task(prvLogTask_h, mainTASK_STACK_SIZE);
+
         /* the work of the SysInit task is done */
         OS_TASK_DELETE(OS_GET_CURRENT_TASK());
 }
@@ -0,0 +1,156 @@
+/*
+ * mem_stats.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Heap and stack telemetry: heap usage from the kernel allocator, per task stack
+ * high-water marks and per subsystem allocation counters.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "osal.h"
+
+#include "mem_stats.h"
+
+/* vPortGetHeapStats() is available from FreeRTOS V10.2.1 */
+#if (tskKERNEL_VERSION_MAJOR > 10) || ((tskKERNEL_VERSION_MAJOR == 10) && \
+        ((tskKERNEL_VERSION_MINOR > 2) || ((tskKERNEL_VERSION_MINOR == 2) && (tskKERNEL_VERSION_BUILD >= 1))))
+#define MEM_STATS_HEAP_STATS            (1)
+#else
+#define MEM_STATS_HEAP_STATS            (0)
+#endif
+
+struct task_stack {
+        OS_TASK task;
+        uint16_t size;
+};
+
+__RETAINED static struct task_stack tasks[MEM_STATS_MAX_TASKS];
+__RETAINED static uint8_t num_tasks;
+
+__RETAINED static uint32_t allocs[MEM_SUBSYS_COUNT];
+__RETAINED static uint32_t frees[MEM_SUBSYS_COUNT];
+
+void *mem_stats_malloc(enum mem_subsys subsys, size_t size)
+{
+        void *ptr = OS_MALLOC(size);
+
+        if (ptr) {
+                __atomic_fetch_add(&allocs[subsys], 1, __ATOMIC_RELAXED);
+        }
+
+        return ptr;
+}
+
+void mem_stats_free(enum mem_subsys subsys, void *ptr)
+{
+        if (ptr) {
+                __atomic_fetch_add(&frees[subsys], 1, __ATOMIC_RELAXED);
+        }
+
+        OS_FREE(ptr);
+}
+
+void mem_stats_register_task(OS_TASK task, uint16_t stack_size)
+{
+        if (task == NULL || num_tasks >= MEM_STATS_MAX_TASKS) {
+                return;
+        }
+
+        tasks[num_tasks].task = task;
+        tasks[num_tasks].size = stack_size;
+        num_tasks++;
+}
+
+static uint32_t largest_free_block(void)
+{
+#if (MEM_STATS_HEAP_STATS == 1)
+        HeapStats_t stats;
+
+        vPortGetHeapStats(&stats);
+        return stats.xSizeOfLargestFreeBlockInBytes;
+#else
+        return 0;
+#endif
+}
+
+static uint16_t stack_free(OS_TASK task)
+{
+#if (INCLUDE_uxTaskGetStackHighWaterMark == 1)
+        return uxTaskGetStackHighWaterMark(task) * sizeof(StackType_t);
+#else
+        return 0;
+#endif
+}
+
+static uint8_t *put(uint8_t *p, uint32_t value, uint8_t size)
+{
+        while (size--) {
+                *p++ = value & 0xFF;
+                value >>= 8;
+        }
+
+        return p;
+}
+
+uint16_t mem_stats_read(uint8_t *buf, uint16_t max)
+{
+        uint8_t *p = buf;
+        const char *name;
+        uint8_t i;
+
+        if (max < MEM_STATS_SNAPSHOT_LEN) {
+                return 0;
+        }
+
+        p = put(p, 'B', 1);
+        p = put(p, 'M', 1);
+        p = put(p, MEM_STATS_VERSION, 1);
+        p = put(p, num_tasks, 1);
+        p = put(p, MEM_SUBSYS_COUNT, 1);
+        p = put(p, 0, 1);
+
+        p = put(p, OS_GET_FREE_HEAP_SIZE(), 4);
+        p = put(p, OS_GET_HEAP_WATERMARK(), 4);
+        p = put(p, largest_free_block(), 4);
+        p = put(p, configTOTAL_HEAP_SIZE, 4);
+
+        for (i = 0; i < num_tasks; i++) {
+                name = pcTaskGetName(tasks[i].task);
+                // first 4 characters of the task name, '\0' padded
+                memset(p, 0, 4);
+                strncpy((char *)p, name, 4);
+                p += 4;
+                p = put(p, tasks[i].size, 2);
+                p = put(p, stack_free(tasks[i].task), 2);
+        }
+
+        for (i = 0; i < MEM_SUBSYS_COUNT; i++) {
+                p = put(p, __atomic_load_n(&allocs[i], __ATOMIC_RELAXED), 4);
+                p = put(p, __atomic_load_n(&frees[i], __ATOMIC_RELAXED), 4);
+        }
+
+        return p - buf;
+}
+
+void mem_stats_print(void)
+{
+        uint8_t i;
+
+        printf("Heap: %u free, %u min free, %lu largest block, %u total\r\n",
+                        (unsigned int) OS_GET_FREE_HEAP_SIZE(), (unsigned int) OS_GET_HEAP_WATERMARK(),
+                        (unsigned long) largest_free_block(), (unsigned int) configTOTAL_HEAP_SIZE);
+
+        for (i = 0; i < num_tasks; i++) {
+                printf("Stack %s: %u of %u bytes never used\r\n", pcTaskGetName(tasks[i].task),
+                                                        stack_free(tasks[i].task), tasks[i].size);
+        }
+
+        for (i = 0; i < MEM_SUBSYS_COUNT; i++) {
+                printf("Subsystem %u: %lu allocations, %lu outstanding\r\n", i,
+                                        (unsigned long) allocs[i], (unsigned long) (allocs[i] - frees[i]));
+        }
+}
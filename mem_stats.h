@@ -0,0 +1,87 @@
+/*
+ * mem_stats.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef MEM_STATS_H_
+#define MEM_STATS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "osal.h"
+
+/* Enable/disable heap and stack telemetry */
+#define MEM_STATS_ENABLE                (1)
+
+/* Maximum number of tasks whose stack is monitored */
+#define MEM_STATS_MAX_TASKS             (4)
+
+/*
+ * Application subsystems whose heap allocations are counted
+ */
+enum mem_subsys {
+        MEM_SUBSYS_NODES = 0,           /* master node: node and attribute lists */
+        MEM_SUBSYS_COLLECT,             /* master node: node data collection buffers */
+        MEM_SUBSYS_SERVICE,             /* custom GATT service structures */
+        MEM_SUBSYS_COUNT,
+};
+
+/*
+ * Telemetry stream format, all values little endian:
+ *
+ * header: ['B']['M'][version][number of tasks][number of subsystems][reserved]
+ * heap:   [free; 4][minimum ever free; 4][largest free block; 4][total; 4]
+ * task:   [name; 4][stack size; 2][minimum ever free stack; 2]
+ * subsys: [allocations; 4][frees; 4]
+ *
+ * Sizes in bytes. The largest free block is 0 when the kernel does not report it.
+ */
+#define MEM_STATS_VERSION               (1)
+
+#define MEM_STATS_HDR_LEN               (6)
+#define MEM_STATS_HEAP_LEN              (16)
+#define MEM_STATS_TASK_LEN              (8)
+#define MEM_STATS_SUBSYS_LEN            (8)
+#define MEM_STATS_SNAPSHOT_LEN          (MEM_STATS_HDR_LEN + MEM_STATS_HEAP_LEN + \
+                                         MEM_STATS_MAX_TASKS * MEM_STATS_TASK_LEN + \
+                                         MEM_SUBSYS_COUNT * MEM_STATS_SUBSYS_LEN)
+
+/*
+ * Counted heap allocation, use instead of OS_MALLOC()/OS_FREE() in application code
+ */
+#if (MEM_STATS_ENABLE == 1)
+#define APP_MALLOC(_subsys, _size)      mem_stats_malloc(_subsys, _size)
+#define APP_FREE(_subsys, _ptr)         mem_stats_free(_subsys, _ptr)
+#else
+#define APP_MALLOC(_subsys, _size)      OS_MALLOC(_size)
+#define APP_FREE(_subsys, _ptr)         OS_FREE(_ptr)
+#endif
+
+void *mem_stats_malloc(enum mem_subsys subsys, size_t size);
+void mem_stats_free(enum mem_subsys subsys, void *ptr);
+
+/**
+ * \brief Monitor the stack of a task
+ *
+ * \param [in] task: task handle
+ * \param [in] stack_size: stack size in bytes, as passed to OS_TASK_CREATE()
+ */
+void mem_stats_register_task(OS_TASK task, uint16_t stack_size);
+
+/**
+ * \brief Take a snapshot of the telemetry stream
+ *
+ * Every read returns a whole snapshot, readers keep their own position in it.
+ *
+ * \return number of bytes written to \p buf, 0 if \p max is below MEM_STATS_SNAPSHOT_LEN
+ */
+uint16_t mem_stats_read(uint8_t *buf, uint16_t max);
+
+/**
+ * \brief Print the telemetry on the serial console
+ */
+void mem_stats_print(void);
+
+#endif /* MEM_STATS_H_ */
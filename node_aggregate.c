@@ -0,0 +1,145 @@
+/*
+ * node_aggregate.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Encoder for the master node aggregate frame, see node_aggregate.h.
+ */
+
+#include <string.h>
+
+#include "node_aggregate.h"
+
+static uint8_t *put_le16(uint8_t *p, uint16_t value)
+{
+        p[0] = value & 0xFF;
+        p[1] = value >> 8;
+
+        return p + 2;
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+        return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static uint8_t *put_le32(uint8_t *p, uint32_t value)
+{
+        p = put_le16(p, value & 0xFFFF);
+
+        return put_le16(p, value >> 16);
+}
+
+void aggregate_encode_header(uint8_t *buf, uint8_t count, uint16_t generation, uint32_t timestamp)
+{
+        buf[0] = AGGREGATE_VERSION;
+        buf[1] = count;
+        buf = put_le16(&buf[2], generation);
+        put_le32(buf, timestamp);
+}
+
+void aggregate_encode_entry(uint8_t *buf, const struct aggregate_entry *entry)
+{
+        memcpy(buf, entry->addr, sizeof(entry->addr));
+        buf = put_le16(&buf[6], entry->sequence);
+        buf = put_le16(buf, entry->age);
+        *buf++ = (uint8_t) entry->rssi;
+        *buf++ = entry->valid;
+        *buf++ = entry->battery;
+        *buf++ = entry->flags;
+        *buf++ = entry->hops;
+        buf = put_le16(buf, entry->temperature);
+        buf = put_le16(buf, entry->humidity);
+        put_le16(buf, entry->water);
+}
+
+void aggregate_encode_delta_header(uint8_t *buf, uint8_t count, uint16_t generation, uint16_t base,
+                                                                                uint32_t timestamp)
+{
+        buf[0] = AGGREGATE_DELTA_VERSION;
+        buf[1] = count;
+        buf = put_le16(&buf[2], generation);
+        buf = put_le16(buf, base);
+        put_le32(buf, timestamp);
+}
+
+static uint8_t *put_varint(uint8_t *p, uint32_t value)
+{
+        while (value >= 0x80) {
+                *p++ = (value & 0x7F) | 0x80;
+                value >>= 7;
+        }
+        *p++ = value;
+
+        return p;
+}
+
+static uint8_t *put_svarint(uint8_t *p, int16_t value)
+{
+        // zigzag: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+        return put_varint(p, ((uint32_t) value << 1) ^ (uint32_t)(value >> 15));
+}
+
+uint8_t aggregate_encode_delta_entry(uint8_t *buf, const struct aggregate_entry *entry,
+                                                        const struct aggregate_entry *prev)
+{
+        uint8_t *p = buf;
+
+        memcpy(p, entry->addr, sizeof(entry->addr));
+        p += sizeof(entry->addr);
+        *p++ = entry->flags | (prev ? AGGREGATE_FLAG_DELTA : 0);
+        *p++ = entry->valid;
+        *p++ = entry->hops;
+
+        if (prev) {
+                p = put_varint(p, (uint16_t)(entry->sequence - prev->sequence));
+        } else {
+                p = put_varint(p, entry->sequence);
+        }
+        p = put_varint(p, entry->age);
+        *p++ = (uint8_t) entry->rssi;
+        *p++ = entry->battery;
+
+        if (prev) {
+                p = put_svarint(p, (int16_t)(entry->temperature - prev->temperature));
+                p = put_svarint(p, (int16_t)(entry->humidity - prev->humidity));
+                p = put_svarint(p, (int16_t)(entry->water - prev->water));
+        } else {
+                p = put_svarint(p, (int16_t) entry->temperature);
+                p = put_svarint(p, (int16_t) entry->humidity);
+                p = put_svarint(p, (int16_t) entry->water);
+        }
+
+        return p - buf;
+}
+
+bool aggregate_decode_header(const uint8_t *buf, uint16_t length, uint8_t *count, uint16_t *generation,
+                                                                                uint32_t *timestamp)
+{
+        if (length < AGGREGATE_HDR_LEN || buf[0] != AGGREGATE_VERSION || buf[1] > AGGREGATE_MAX_ENTRIES ||
+                                        length < AGGREGATE_HDR_LEN + buf[1] * AGGREGATE_ENTRY_LEN) {
+                return false;
+        }
+
+        *count = buf[1];
+        *generation = get_le16(&buf[2]);
+        *timestamp = (uint32_t)get_le16(&buf[4]) | ((uint32_t)get_le16(&buf[6]) << 16);
+
+        return true;
+}
+
+void aggregate_decode_entry(const uint8_t *buf, struct aggregate_entry *entry)
+{
+        memcpy(entry->addr, buf, sizeof(entry->addr));
+        entry->sequence = get_le16(&buf[6]);
+        entry->age = get_le16(&buf[8]);
+        entry->rssi = (int8_t) buf[10];
+        entry->valid = buf[11];
+        entry->battery = buf[12];
+        entry->flags = buf[13];
+        entry->hops = buf[14];
+        entry->temperature = get_le16(&buf[15]);
+        entry->humidity = get_le16(&buf[17]);
+        entry->water = get_le16(&buf[19]);
+}
@@ -0,0 +1,151 @@
+/*
+ * node_aggregate.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef NODE_AGGREGATE_H_
+#define NODE_AGGREGATE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Aggregate frame returned by the master node, all values little endian:
+ *
+ * header: [version][count][generation; 2][timestamp; 4]
+ * entry:  [BD address; 6][sequence; 2][age; 2][rssi][valid][battery][flags][hops]
+ *         [temperature; 2][humidity; 2][water; 2]
+ *
+ * generation: incremented for every frame built by the master
+ * timestamp:  fleet time in ms when the frame was built (uptime of the root master)
+ * sequence:   sample sequence number of the node
+ * age:        seconds since the node data was updated, AGGREGATE_AGE_UNKNOWN if never
+ * valid:      AGGREGATE_VALID_xxx bits, fields without their bit set are 0
+ * hops:       number of relaying masters between the node and the frame's master,
+ *             0 for nodes the master reads itself
+ *
+ * Version history:
+ * 1: initial format
+ * 2: hops added to the entries (relaying masters)
+ */
+#define AGGREGATE_VERSION               (2)
+#define AGGREGATE_HDR_LEN               (8)
+#define AGGREGATE_ENTRY_LEN             (21)
+
+/*
+ * A frame fits in one attribute value (the ATT limit of 512 bytes), so it holds at most
+ * AGGREGATE_MAX_ENTRIES (24) nodes and a master keeps no more; a delta frame which would
+ * be longer is sent as a full frame instead
+ */
+#define AGGREGATE_MAX_LEN               (512)
+#define AGGREGATE_MAX_ENTRIES           ((AGGREGATE_MAX_LEN - AGGREGATE_HDR_LEN) / AGGREGATE_ENTRY_LEN)
+
+#define AGGREGATE_AGE_UNKNOWN           (0xFFFF)
+
+/* Validity bits, the sensor bits follow enum sensor_channel */
+#define AGGREGATE_VALID_TEMPERATURE     (1 << 0)
+#define AGGREGATE_VALID_HUMIDITY        (1 << 1)
+#define AGGREGATE_VALID_WATER           (1 << 2)
+#define AGGREGATE_VALID_SEQUENCE        (1 << 3)
+#define AGGREGATE_VALID_RSSI            (1 << 4)
+#define AGGREGATE_VALID_BATTERY         (1 << 5)
+
+/* Entry flags */
+#define AGGREGATE_FLAG_CONNECTED        (1 << 0)
+#define AGGREGATE_FLAG_BROADCAST        (1 << 1)
+#define AGGREGATE_FLAG_DELTA            (1 << 2)        /* delta frame: values relative to the previous entry */
+#define AGGREGATE_FLAG_RELAYED          (1 << 3)        /* read from the aggregate of a relaying master */
+
+/*
+ * Delta frame, returned instead of the full frame when the client wrote the last
+ * generation it has seen (the base) right before the read. It only holds the nodes
+ * whose data changed after the base generation:
+ *
+ * header: [AGGREGATE_DELTA_VERSION][count][generation; 2][base generation; 2][timestamp; 4]
+ * entry:  [BD address; 6][flags][valid][hops][sequence; varint][age; varint][rssi][battery]
+ *         [temperature; svarint][humidity; svarint][water; svarint]
+ *
+ * varint:  unsigned LEB128
+ * svarint: zigzag encoded signed value, then varint
+ *
+ * With AGGREGATE_FLAG_DELTA set, sequence is the increment and the sensor values
+ * are the (16-bit, wrapping) differences to the node's entry the client already
+ * has, otherwise they are absolute values. Sensor values are signed 16-bit.
+ *
+ * The first byte tells the frames apart, delta frames have bit 7 set.
+ *
+ * Notifications of the aggregate are delta frames against the previous notification
+ * (base 0 and absolute values for the first one). A notification without entries
+ * means the changes did not fit in it and the aggregate has to be read.
+ */
+#define AGGREGATE_DELTA_VERSION         (0x80 | AGGREGATE_VERSION)
+#define AGGREGATE_DELTA_HDR_LEN         (10)
+#define AGGREGATE_DELTA_ENTRY_MAX_LEN   (6 + 1 + 1 + 1 + 3 + 3 + 1 + 1 + 3 * 3)
+
+struct aggregate_entry {
+        uint8_t addr[6];
+        uint16_t sequence;
+        uint16_t age;
+        int8_t rssi;
+        uint8_t valid;
+        uint8_t battery;
+        uint8_t flags;
+        uint8_t hops;
+        uint16_t temperature;
+        uint16_t humidity;
+        uint16_t water;
+};
+
+/**
+ * \brief Encode the frame header
+ *
+ * \param [out] buf: AGGREGATE_HDR_LEN bytes
+ */
+void aggregate_encode_header(uint8_t *buf, uint8_t count, uint16_t generation, uint32_t timestamp);
+
+/**
+ * \brief Encode a node entry
+ *
+ * \param [out] buf: AGGREGATE_ENTRY_LEN bytes
+ */
+void aggregate_encode_entry(uint8_t *buf, const struct aggregate_entry *entry);
+
+/**
+ * \brief Encode the delta frame header
+ *
+ * \param [out] buf: AGGREGATE_DELTA_HDR_LEN bytes
+ */
+void aggregate_encode_delta_header(uint8_t *buf, uint8_t count, uint16_t generation, uint16_t base,
+                                                                                uint32_t timestamp);
+
+/**
+ * \brief Encode a delta frame entry
+ *
+ * \param [out] buf: up to AGGREGATE_DELTA_ENTRY_MAX_LEN bytes
+ * \param [in] entry: node entry
+ * \param [in] prev: the node's entry the client already has, NULL to encode absolute values
+ *
+ * \return number of bytes written
+ */
+uint8_t aggregate_encode_delta_entry(uint8_t *buf, const struct aggregate_entry *entry,
+                                                        const struct aggregate_entry *prev);
+
+/**
+ * \brief Decode the header of a full frame
+ *
+ * \return false if \p buf does not hold a full frame of this version with \p count entries,
+ *         or if the frame announces more than AGGREGATE_MAX_ENTRIES entries
+ */
+bool aggregate_decode_header(const uint8_t *buf, uint16_t length, uint8_t *count, uint16_t *generation,
+                                                                                uint32_t *timestamp);
+
+/**
+ * \brief Decode a full frame entry
+ *
+ * \param [in] buf: AGGREGATE_ENTRY_LEN bytes
+ */
+void aggregate_decode_entry(const uint8_t *buf, struct aggregate_entry *entry);
+
+#endif /* NODE_AGGREGATE_H_ */
@@ -0,0 +1,49 @@
+/*
+ * sensor_calib_tables.h
+ *
+ * Generated by tools/gen_calib_tables.py, do not edit.
+ */
+
+#ifndef SENSOR_CALIB_TABLES_H_
+#define SENSOR_CALIB_TABLES_H_
+
+#include "sensor_conversion.h"
+
+static const int16_t calib_hih_humidity_y[11] = {
+             0,   1024,   2048,   3072,   4096,   5120,   6144,   7168,
+          8192,   9216,  10240,
+};
+
+static const struct calib_table calib_hih_humidity = {
+        .x0     = 0,
+        .shift  = 10,
+        .num    = 11,
+        .y      = calib_hih_humidity_y,
+};
+
+static const int16_t calib_hih_temperature_y[18] = {
+         -4000,  -2976,  -1952,   -928,     96,   1120,   2144,   3168,
+          4192,   5216,   6240,   7264,   8288,   9312,  10336,  11360,
+         12384,  13408,
+};
+
+static const struct calib_table calib_hih_temperature = {
+        .x0     = -4000,
+        .shift  = 10,
+        .num    = 18,
+        .y      = calib_hih_temperature_y,
+};
+
+static const int16_t calib_water_y[9] = {
+             0,   1250,   2500,   3750,   5000,   6250,   7500,   8751,
+         10001,
+};
+
+static const struct calib_table calib_water = {
+        .x0     = 0,
+        .shift  = 11,
+        .num    = 9,
+        .y      = calib_water_y,
+};
+
+#endif /* SENSOR_CALIB_TABLES_H_ */
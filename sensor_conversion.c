@@ -0,0 +1,65 @@
+/*
+ * sensor_conversion.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Fixed-point sensor conversion kernels.
+ *
+ * Divisions by a constant are replaced by a multiplication with a scaled
+ * reciprocal and a shift: (raw * M) >> S. M and S were chosen so the result
+ * equals the integer division for every 14-bit input. The product needs more
+ * than 32 bits, which is a single UMULL on the Cortex-M33.
+ */
+
+#include <stddef.h>
+
+#include "sensor_conversion.h"
+
+/* (raw * 10000) / 16382 == (raw * HIH_HUMID_MUL) >> HIH_HUMID_SHIFT for raw < 2^14 */
+#define HIH_HUMID_MUL           (40965001ULL)
+#define HIH_HUMID_SHIFT         (26)
+
+/* (raw * 16500) / 16382 == (raw * HIH_TEMP_MUL) >> HIH_TEMP_SHIFT for raw < 2^14 */
+#define HIH_TEMP_MUL            (135184503ULL)
+#define HIH_TEMP_SHIFT          (27)
+#define HIH_TEMP_OFFSET         (4000)
+
+#define HIH_RAW_MASK            (0x3FFF)
+
+uint16_t conv_hih_humidity(uint16_t raw)
+{
+        return (uint16_t)(((raw & HIH_RAW_MASK) * HIH_HUMID_MUL) >> HIH_HUMID_SHIFT);
+}
+
+int16_t conv_hih_temperature(uint16_t raw)
+{
+        return (int16_t)((int32_t)(((raw & HIH_RAW_MASK) * HIH_TEMP_MUL) >> HIH_TEMP_SHIFT) - HIH_TEMP_OFFSET);
+}
+
+int32_t calib_apply(const struct calib_table *tbl, int32_t x)
+{
+        int32_t dx, y0, y1;
+        uint32_t k;
+
+        if (tbl == NULL) {
+                return x;
+        }
+
+        dx = x - tbl->x0;
+        if (dx <= 0) {
+                return tbl->y[0];
+        }
+
+        k = (uint32_t)dx >> tbl->shift;
+        if (k >= (uint32_t)(tbl->num - 1)) {
+                return tbl->y[tbl->num - 1];
+        }
+
+        // interpolate within segment k, floor division by the power of two segment width
+        y0 = tbl->y[k];
+        y1 = tbl->y[k + 1];
+        dx &= (1 << tbl->shift) - 1;
+
+        return y0 + (((y1 - y0) * dx) >> tbl->shift);
+}
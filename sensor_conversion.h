@@ -0,0 +1,51 @@
+/*
+ * sensor_conversion.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef SENSOR_CONVERSION_H_
+#define SENSOR_CONVERSION_H_
+
+#include <stdint.h>
+
+/*
+ * Piecewise-linear calibration table with uniformly spaced breakpoints.
+ *
+ * Breakpoint k is at x0 + (k << shift), y[k] holds the calibrated value there.
+ * Inputs outside [x0, x0 + ((num - 1) << shift)] are clamped.
+ * Tables are generated offline by tools/gen_calib_tables.py.
+ */
+struct calib_table {
+        int32_t x0;
+        uint8_t shift;
+        uint8_t num;
+        const int16_t *y;
+};
+
+/**
+ * \brief HIH6130 14-bit raw humidity to relative humidity in 0.01 %RH
+ *
+ * Bit-exact with (raw * 10000) / 16382.
+ */
+uint16_t conv_hih_humidity(uint16_t raw);
+
+/**
+ * \brief HIH6130 14-bit raw temperature to ambient temperature in 0.01 degC
+ *
+ * Bit-exact with ((raw * 16500) / 16382) - 4000.
+ */
+int16_t conv_hih_temperature(uint16_t raw);
+
+/**
+ * \brief Apply a piecewise-linear calibration table
+ *
+ * \param [in] tbl: calibration table, NULL applies no calibration
+ * \param [in] x: converted sensor value
+ *
+ * \return calibrated value
+ */
+int32_t calib_apply(const struct calib_table *tbl, int32_t x);
+
+#endif /* SENSOR_CONVERSION_H_ */
@@ -0,0 +1,101 @@
+/*
+ * sensor_filter.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Streaming sensor filters: outlier rejection, median of 3 and an exponential
+ * moving average in fixed point. All state is kept in struct sensor_filter.
+ */
+
+#include <string.h>
+
+#include "sensor_filter.h"
+
+static int32_t median3(int32_t a, int32_t b, int32_t c)
+{
+        if (a > b) {
+                int32_t t = a;
+                a = b;
+                b = t;
+        }
+        if (b > c) {
+                b = c;
+        }
+
+        return (a > b) ? a : b;
+}
+
+static int32_t abs32(int32_t v)
+{
+        return (v < 0) ? -v : v;
+}
+
+static void prime(struct sensor_filter *f, int32_t x)
+{
+        f->hist[0] = x;
+        f->hist_len = 1;
+        f->hist_pos = 1;
+        f->ema = x * (1 << SENSOR_FILTER_FRAC_BITS);
+        f->primed = true;
+        f->rejects = 0;
+}
+
+void sensor_filter_reset(struct sensor_filter *f)
+{
+        memset(f, 0, sizeof(*f));
+}
+
+int32_t sensor_filter_value(const struct sensor_filter *f)
+{
+        // round to nearest
+        return (f->ema + (1 << (SENSOR_FILTER_FRAC_BITS - 1))) >> SENSOR_FILTER_FRAC_BITS;
+}
+
+bool sensor_filter_update(struct sensor_filter *f, const struct sensor_filter_config *cfg, int32_t x)
+{
+        int32_t m, out;
+
+        if (!f->primed) {
+                prime(f, x);
+                f->reported = x;
+                return true;
+        }
+
+        /*
+         * Reject samples too far from the current output. A sustained deviation is
+         * a real step, accept it after max_rejects samples and restart from there.
+         */
+        if (cfg->outlier_limit && abs32(x - sensor_filter_value(f)) > cfg->outlier_limit) {
+                if (++f->rejects <= cfg->max_rejects) {
+                        return false;
+                }
+                prime(f, x);
+                goto report;
+        }
+        f->rejects = 0;
+
+        /* median of the last 3 samples */
+        f->hist[f->hist_pos] = x;
+        f->hist_pos = (f->hist_pos + 1) % 3;
+        if (f->hist_len < 3) {
+                f->hist_len++;
+        }
+        m = (cfg->median && f->hist_len == 3) ? median3(f->hist[0], f->hist[1], f->hist[2]) : x;
+
+        /* EMA: ema += (m - ema) / 2^ema_shift */
+        if (cfg->ema_shift) {
+                f->ema += ((m * (1 << SENSOR_FILTER_FRAC_BITS)) - f->ema) >> cfg->ema_shift;
+        } else {
+                f->ema = m * (1 << SENSOR_FILTER_FRAC_BITS);
+        }
+
+report:
+        out = sensor_filter_value(f);
+        if (abs32(out - f->reported) < cfg->change_delta) {
+                return false;
+        }
+        f->reported = out;
+
+        return true;
+}
@@ -0,0 +1,62 @@
+/*
+ * sensor_filter.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef SENSOR_FILTER_H_
+#define SENSOR_FILTER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Fractional bits kept in the EMA state
+ */
+#define SENSOR_FILTER_FRAC_BITS         (8)
+
+/*
+ * Per-channel filter configuration
+ */
+struct sensor_filter_config {
+        uint8_t ema_shift;              /* EMA weight 1 / 2^ema_shift, 0 disables the EMA */
+        bool median;                    /* median of the last 3 samples */
+        int32_t outlier_limit;          /* max deviation from the filter output, 0 disables */
+        uint8_t max_rejects;            /* consecutive outliers after which the step is accepted */
+        int32_t change_delta;           /* minimum change of the output to report */
+};
+
+/*
+ * Per-channel filter state, O(1) in size
+ */
+struct sensor_filter {
+        int32_t hist[3];                /* last samples for the median */
+        uint8_t hist_len;
+        uint8_t hist_pos;
+        int32_t ema;                    /* EMA output, SENSOR_FILTER_FRAC_BITS fractional bits */
+        bool primed;
+        uint8_t rejects;
+        int32_t reported;               /* last output reported as changed */
+};
+
+/**
+ * \brief Reset a filter, the next sample primes it
+ */
+void sensor_filter_reset(struct sensor_filter *f);
+
+/**
+ * \brief Feed a sample into a filter
+ *
+ * Pipeline: outlier rejection -> median of 3 -> EMA -> change detection
+ *
+ * \return true if the output changed by at least change_delta since it was last reported
+ */
+bool sensor_filter_update(struct sensor_filter *f, const struct sensor_filter_config *cfg, int32_t x);
+
+/**
+ * \brief Current filter output
+ */
+int32_t sensor_filter_value(const struct sensor_filter *f);
+
+#endif /* SENSOR_FILTER_H_ */
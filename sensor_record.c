@@ -0,0 +1,37 @@
+/*
+ * sensor_record.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#include "sensor_record.h"
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+        return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+void sensor_record_pack(const struct sensor_record *rec, uint8_t *buf)
+{
+        put_le16(&buf[0], rec->temperature);
+        put_le16(&buf[2], rec->humidity);
+        put_le16(&buf[4], rec->water);
+        put_le16(&buf[6], rec->sequence);
+        buf[8] = rec->battery;
+}
+
+void sensor_record_unpack(const uint8_t *buf, struct sensor_record *rec)
+{
+        rec->temperature = get_le16(&buf[0]);
+        rec->humidity = get_le16(&buf[2]);
+        rec->water = get_le16(&buf[4]);
+        rec->sequence = get_le16(&buf[6]);
+        rec->battery = buf[8];
+}
@@ -0,0 +1,47 @@
+/*
+ * sensor_record.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef SENSOR_RECORD_H_
+#define SENSOR_RECORD_H_
+
+#include <stdint.h>
+
+/*
+ * Packed sensor record: [temp][humid][water][sequence][battery]
+ * all values little endian
+ */
+#define SENSOR_RECORD_LEN               (2 + 2 + 2 + 2 + 1)
+
+/*
+ * Battery level in percent, or unknown. Nodes without a battery measurement (the
+ * current sensor board) always report unknown; masters then do not mark the battery
+ * level valid in the aggregate.
+ */
+#define SENSOR_BATTERY_UNKNOWN          (0xFF)
+
+/*
+ * A single sensor sample as exchanged between nodes and master
+ */
+struct sensor_record {
+        uint16_t temperature;
+        uint16_t humidity;
+        uint16_t water;
+        uint16_t sequence;              /* incremented on every sample */
+        uint8_t battery;
+};
+
+/**
+ * \brief Pack a sensor record into SENSOR_RECORD_LEN bytes
+ */
+void sensor_record_pack(const struct sensor_record *rec, uint8_t *buf);
+
+/**
+ * \brief Unpack SENSOR_RECORD_LEN bytes into a sensor record
+ */
+void sensor_record_unpack(const uint8_t *buf, struct sensor_record *rec);
+
+#endif /* SENSOR_RECORD_H_ */
@@ -0,0 +1,143 @@
+/*
+ * sensor_rules.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Threshold and alarm rules evaluated on the node. Rules are compiled once from
+ * the configuration written by the client into a fixed table; evaluating a sample
+ * is a single pass over the table, without allocation. A rule changes state only
+ * when crossing its threshold, and back only past its hysteresis, so a value
+ * hovering around a threshold does not toggle the alarm.
+ */
+
+#include <string.h>
+
+#include "sensor_rules.h"
+
+static uint16_t get_le16(const uint8_t *p)
+{
+        return (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+}
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+        p[0] = v & 0xFF;
+        p[1] = v >> 8;
+}
+
+bool sensor_rules_compile(struct sensor_rules *rules, const uint8_t *buf, uint16_t length)
+{
+        struct sensor_rule rule[SENSOR_RULES_MAX];
+        uint8_t first, count, i;
+
+        if (length < 1 || (length - 1) % SENSOR_RULE_LEN) {
+                return false;
+        }
+        first = buf[0];
+        count = (length - 1) / SENSOR_RULE_LEN;
+        // parts are written in order, a part cannot leave a gap
+        if (first > rules->count || first + count > SENSOR_RULES_MAX) {
+                return false;
+        }
+
+        for (i = 0; i < count; i++) {
+                const uint8_t *p = &buf[1 + i * SENSOR_RULE_LEN];
+
+                rule[i].channel = p[0];
+                rule[i].type = p[1];
+                rule[i].threshold = (int16_t) get_le16(&p[2]);
+                rule[i].hysteresis = (int16_t) get_le16(&p[4]);
+
+                if (rule[i].channel >= SENSOR_CH_COUNT || rule[i].type >= SENSOR_RULE_TYPES ||
+                                                                        rule[i].hysteresis < 0) {
+                        return false;
+                }
+        }
+
+        memcpy(&rules->rule[first], rule, count * sizeof(rule[0]));
+        rules->count = first + count;
+        rules->active = 0;
+        rules->changed = 0;
+        rules->primed = false;
+
+        return true;
+}
+
+uint16_t sensor_rules_encode(const struct sensor_rules *rules, uint8_t *buf, uint16_t max)
+{
+        uint16_t n = 1;
+        uint8_t i;
+
+        if (max < 1) {
+                return 0;
+        }
+        buf[0] = 0;
+
+        for (i = 0; i < rules->count && n + SENSOR_RULE_LEN <= max; i++) {
+                buf[n] = rules->rule[i].channel;
+                buf[n + 1] = rules->rule[i].type;
+                put_le16(&buf[n + 2], (uint16_t) rules->rule[i].threshold);
+                put_le16(&buf[n + 4], (uint16_t) rules->rule[i].hysteresis);
+                n += SENSOR_RULE_LEN;
+        }
+
+        return n;
+}
+
+/*
+ * Absolute change of a channel per minute since the previous sample
+ */
+static int32_t rate_per_min(const struct sensor_rules *rules, uint8_t channel, int32_t value, uint32_t dt)
+{
+        int64_t rate = ((int64_t)(value - rules->prev[channel]) * 60000) / dt;
+
+        return (int32_t)((rate < 0) ? -rate : rate);
+}
+
+uint16_t sensor_rules_eval(struct sensor_rules *rules, const int32_t value[SENSOR_CH_COUNT], uint32_t now_ms)
+{
+        uint32_t dt = now_ms - rules->prev_ms;
+        uint16_t changed = 0;
+        uint8_t i;
+
+        for (i = 0; i < rules->count; i++) {
+                const struct sensor_rule *rule = &rules->rule[i];
+                uint16_t bit = 1 << i;
+                int32_t x = value[rule->channel];
+                bool trip, clear;
+
+                switch (rule->type) {
+                case SENSOR_RULE_MIN:
+                        trip = x < rule->threshold;
+                        clear = x >= rule->threshold + rule->hysteresis;
+                        break;
+                case SENSOR_RULE_MAX:
+                        trip = x > rule->threshold;
+                        clear = x <= rule->threshold - rule->hysteresis;
+                        break;
+                case SENSOR_RULE_RATE:
+                        if (!rules->primed || dt == 0) {
+                                continue;
+                        }
+                        x = rate_per_min(rules, rule->channel, x, dt);
+                        trip = x > rule->threshold;
+                        clear = x <= rule->threshold - rule->hysteresis;
+                        break;
+                default:
+                        continue;
+                }
+
+                if ((!(rules->active & bit) && trip) || ((rules->active & bit) && clear)) {
+                        rules->active ^= bit;
+                        changed |= bit;
+                }
+        }
+
+        memcpy(rules->prev, value, sizeof(rules->prev));
+        rules->prev_ms = now_ms;
+        rules->primed = true;
+        rules->changed |= changed;
+
+        return changed;
+}
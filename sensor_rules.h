@@ -0,0 +1,107 @@
+/*
+ * sensor_rules.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef SENSOR_RULES_H_
+#define SENSOR_RULES_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "i2c_sensors.h"
+
+/* Maximum number of rules, one bit each in the alarm state */
+#define SENSOR_RULES_MAX                (16)
+
+/*
+ * Rule types
+ *
+ * MIN:  violated below the threshold, cleared at threshold + hysteresis
+ * MAX:  violated above the threshold, cleared at threshold - hysteresis
+ * RATE: violated when the value changes faster than the threshold per minute (either
+ *       direction), cleared at threshold - hysteresis
+ */
+enum sensor_rule_type {
+        SENSOR_RULE_MIN = 0,
+        SENSOR_RULE_MAX,
+        SENSOR_RULE_RATE,
+        SENSOR_RULE_TYPES,
+};
+
+/*
+ * Rule configuration written by the client, all values little endian:
+ *
+ * write: [first rule index][rule]...
+ * rule:  [channel][type][threshold; 2][hysteresis; 2]
+ *
+ * The rules from the first index on are replaced by the rules of the write and the
+ * table ends after them, so a table longer than one write is written in parts; a
+ * write of only [0] clears all rules. Threshold and hysteresis are signed, in the
+ * units of the channel (0.01 units), the hysteresis is not negative.
+ */
+#define SENSOR_RULE_LEN                 (6)
+
+/*
+ * Alarm value:
+ *
+ * [active rules; 2][rules changed since the last report; 2][fleet time; 4]
+ * [temperature; 2][humidity; 2][water; 2]
+ */
+#define SENSOR_ALARM_LEN                (14)
+
+/*
+ * Compiled rule
+ */
+struct sensor_rule {
+        uint8_t channel;
+        uint8_t type;
+        int16_t threshold;
+        int16_t hysteresis;
+};
+
+/*
+ * Rule table and evaluation state, fixed size
+ */
+struct sensor_rules {
+        struct sensor_rule rule[SENSOR_RULES_MAX];
+        uint8_t count;
+        uint16_t active;                /* violated rules */
+        uint16_t changed;               /* rules which changed state since the last report */
+        bool primed;                    /* previous values valid, for rate rules */
+        int32_t prev[SENSOR_CH_COUNT];
+        uint32_t prev_ms;
+};
+
+/* Alarm rules evaluated by the I2C task */
+extern struct sensor_rules alarm_rules;
+
+/**
+ * \brief Compile a rule configuration write into a table
+ *
+ * The rules are validated before \p rules is modified; the evaluation state restarts.
+ *
+ * \return false if the write is malformed, \p rules is unchanged then
+ */
+bool sensor_rules_compile(struct sensor_rules *rules, const uint8_t *buf, uint16_t length);
+
+/**
+ * \brief Encode the rule table in the configuration format, first rule index 0
+ *
+ * \return number of bytes written, the rules which do not fit in \p max are left out
+ */
+uint16_t sensor_rules_encode(const struct sensor_rules *rules, uint8_t *buf, uint16_t max);
+
+/**
+ * \brief Evaluate all rules on a sample, O(rules)
+ *
+ * \param [in] value: sample per channel, after conversion and filtering
+ * \param [in] now_ms: time of the sample
+ *
+ * \return rules which changed state, also accumulated in rules->changed
+ */
+uint16_t sensor_rules_eval(struct sensor_rules *rules, const int32_t value[SENSOR_CH_COUNT], uint32_t now_ms);
+
+#endif /* SENSOR_RULES_H_ */
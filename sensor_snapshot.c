@@ -0,0 +1,62 @@
+/*
+ * sensor_snapshot.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Triple buffered sensor snapshot. At any time one buffer is published, at most
+ * one is pinned by the reader and the writer fills one which is neither.
+ *
+ * The reader pins the published buffer and checks it is still published
+ * afterwards; if the writer published in between, the writer may already be
+ * filling the buffer which was just pinned, so the reader pins again.
+ */
+
+#include "sensor_snapshot.h"
+
+struct sensor_snapshot *sensor_snapshot_begin(struct sensor_snapshot_buf *buf)
+{
+        uint8_t pub = __atomic_load_n(&buf->published, __ATOMIC_SEQ_CST);
+        uint8_t pin = __atomic_load_n(&buf->pinned, __ATOMIC_SEQ_CST);
+        uint8_t i;
+
+        for (i = 0; i < SENSOR_SNAPSHOT_BUFFERS - 1; i++) {
+                if (i != pub && i + 1 != pin) {
+                        break;
+                }
+        }
+
+        return &buf->snap[i];
+}
+
+static void put_le16(uint8_t *p, uint16_t value)
+{
+        p[0] = value & 0xFF;
+        p[1] = value >> 8;
+}
+
+void sensor_snapshot_publish(struct sensor_snapshot_buf *buf, struct sensor_snapshot *snap)
+{
+        put_le16(snap->value[SENSOR_CH_TEMPERATURE], snap->record.temperature);
+        put_le16(snap->value[SENSOR_CH_HUMIDITY], snap->record.humidity);
+        put_le16(snap->value[SENSOR_CH_WATER], snap->record.water);
+
+        __atomic_store_n(&buf->published, (uint8_t)(snap - buf->snap), __ATOMIC_SEQ_CST);
+}
+
+const struct sensor_snapshot *sensor_snapshot_acquire(struct sensor_snapshot_buf *buf)
+{
+        uint8_t pub;
+
+        do {
+                pub = __atomic_load_n(&buf->published, __ATOMIC_SEQ_CST);
+                __atomic_store_n(&buf->pinned, pub + 1, __ATOMIC_SEQ_CST);
+        } while (pub != __atomic_load_n(&buf->published, __ATOMIC_SEQ_CST));
+
+        return &buf->snap[pub];
+}
+
+void sensor_snapshot_release(struct sensor_snapshot_buf *buf)
+{
+        __atomic_store_n(&buf->pinned, 0, __ATOMIC_SEQ_CST);
+}
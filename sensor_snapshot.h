@@ -0,0 +1,73 @@
+/*
+ * sensor_snapshot.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef SENSOR_SNAPSHOT_H_
+#define SENSOR_SNAPSHOT_H_
+
+#include <stdint.h>
+
+#include "i2c_sensors.h"
+#include "sensor_record.h"
+
+/*
+ * Published sensor sample.
+ *
+ * value[] holds the characteristic values in their on-air format (little endian),
+ * so GATT read responses and notifications are copied straight from the snapshot.
+ */
+struct sensor_snapshot {
+        uint8_t value[SENSOR_CH_COUNT][2];
+        struct sensor_record record;
+        uint32_t timestamp;             /* fleet time of the sampling epoch, ms */
+};
+
+/*
+ * Triple buffered snapshot, a zero initialized instance is valid (all values 0)
+ */
+#define SENSOR_SNAPSHOT_BUFFERS         (3)
+
+struct sensor_snapshot_buf {
+        struct sensor_snapshot snap[SENSOR_SNAPSHOT_BUFFERS];
+        uint8_t published;              /* index of the current snapshot */
+        uint8_t pinned;                 /* index + 1 of the snapshot pinned by the reader, 0 if none */
+};
+
+/* Published sensor snapshot, written by the I2C task */
+extern struct sensor_snapshot_buf sensor_snapshots;
+
+/*
+ * Ownership rules (one writer, one reader):
+ *
+ * - the writer (sampling task) fills the buffer returned by sensor_snapshot_begin()
+ *   and makes it current with sensor_snapshot_publish(); it never touches the
+ *   published or the pinned buffer.
+ * - the reader (BLE task) pins the current snapshot with sensor_snapshot_acquire()
+ *   and may hand out pointers into it until sensor_snapshot_release(). A pinned
+ *   snapshot is never modified, so a concurrent publish cannot tear a response.
+ */
+
+/**
+ * \brief Get a free snapshot buffer to fill (writer)
+ */
+struct sensor_snapshot *sensor_snapshot_begin(struct sensor_snapshot_buf *buf);
+
+/**
+ * \brief Fill the on-air values from the record and make the buffer current (writer)
+ */
+void sensor_snapshot_publish(struct sensor_snapshot_buf *buf, struct sensor_snapshot *snap);
+
+/**
+ * \brief Pin the current snapshot (reader)
+ */
+const struct sensor_snapshot *sensor_snapshot_acquire(struct sensor_snapshot_buf *buf);
+
+/**
+ * \brief Unpin the snapshot (reader)
+ */
+void sensor_snapshot_release(struct sensor_snapshot_buf *buf);
+
+#endif /* SENSOR_SNAPSHOT_H_ */
@@ -0,0 +1,507 @@
+/*
+ * adv_fuzz.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Fuzz loop and throughput benchmark of the advertising report parser
+ * (ble_adv_parser.c).
+ *
+ * The fuzz loop feeds synthetic reports to adv_parse_report() and adv_has_uuid128():
+ * well-formed reports built from the AD structures nodes and other devices send,
+ * the same reports with random bytes changed or cut short, and random bytes. Each
+ * report is placed at the very end of a heap block, so with the sanitizers of the
+ * makefile (adv_fuzz) a read past the report is caught, and the results are
+ * compared with a plain reference walk of the AD structures.
+ *
+ * The benchmark (-b, built without the sanitizers as adv_bench) parses a fixed set
+ * of typical reports: node advertising data and scan responses, beacons and other
+ * devices not matching the service UUID.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ble_adv_parser.h"
+
+#define FUZZ_DEFAULT_REPORTS            (1000000)
+#define BENCH_DEFAULT_REPORTS           (10000000)
+#define BENCH_CORPUS                    (64)
+
+/* legacy advertising data, a longer extended advertising report now and then */
+#define FUZZ_LEGACY_LEN                 (31)
+#define FUZZ_MAX_LEN                    (255)
+
+static const uint8_t service_uuid[ADV_UUID128_LEN] = {
+        0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+        0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
+};
+
+static uint32_t rand_state;
+
+/* xorshift32, all 32 bits are random */
+static uint32_t fuzz_random(void)
+{
+        rand_state ^= rand_state << 13;
+        rand_state ^= rand_state >> 17;
+        rand_state ^= rand_state << 5;
+
+        return rand_state;
+}
+
+static uint32_t fuzz_below(uint32_t n)
+{
+        return fuzz_random() % n;
+}
+
+/* Append an AD structure, false if it does not fit */
+static bool put_ad(uint8_t *buf, uint8_t *len, uint8_t max, uint8_t type, const uint8_t *value,
+                                                                                uint8_t value_len)
+{
+        if (*len + 2 + value_len > max) {
+                return false;
+        }
+
+        buf[(*len)++] = value_len + 1;
+        buf[(*len)++] = type;
+        memcpy(&buf[*len], value, value_len);
+        *len += value_len;
+
+        return true;
+}
+
+static void random_bytes(uint8_t *buf, uint8_t len)
+{
+        uint8_t i;
+
+        for (i = 0; i < len; i++) {
+                buf[i] = fuzz_random();
+        }
+}
+
+/*
+ * A well-formed report: the AD structures in random order, the service UUID
+ * anywhere in a list of UUIDs, manufacturer data of nodes and of other devices
+ */
+static uint8_t gen_report(uint8_t *buf, uint8_t max)
+{
+        uint8_t value[FUZZ_MAX_LEN];
+        struct sensor_record rec;
+        uint8_t len = 0;
+        uint8_t n, k, i;
+        int tries;
+
+        memset(&rec, 0, sizeof(rec));
+
+        for (tries = 0; tries < 8 && len < max; tries++) {
+                switch (fuzz_below(8)) {
+                case 0:
+                        value[0] = 0x06;
+                        put_ad(buf, &len, max, ADV_AD_TYPE_FLAGS, value, 1);
+                        break;
+                case 1:
+                        // a list of UUIDs, the service UUID at a random place or not at all
+                        n = 1 + fuzz_below((max - len) > 2 * (2 + ADV_UUID128_LEN) ? 4 : 1);
+                        k = fuzz_below(n + 1);
+                        for (i = 0; i < n; i++) {
+                                if (i == k) {
+                                        memcpy(&value[i * ADV_UUID128_LEN], service_uuid, ADV_UUID128_LEN);
+                                } else {
+                                        random_bytes(&value[i * ADV_UUID128_LEN], ADV_UUID128_LEN);
+                                }
+                        }
+                        while (n && len + 2 + n * ADV_UUID128_LEN > max) {
+                                n--;
+                        }
+                        if (n) {
+                                put_ad(buf, &len, max, fuzz_below(2) ? ADV_AD_TYPE_UUID128_LIST :
+                                        ADV_AD_TYPE_UUID128_LIST_INC, value, n * ADV_UUID128_LEN);
+                        }
+                        break;
+                case 2:
+                        n = fuzz_below(12);
+                        for (i = 0; i < n; i++) {
+                                value[i] = 'a' + fuzz_below(26);
+                        }
+                        put_ad(buf, &len, max, fuzz_below(2) ? ADV_AD_TYPE_LOCAL_NAME :
+                                                                ADV_AD_TYPE_SHORT_NAME, value, n);
+                        break;
+                case 3:
+                        // a TX power level of the wrong length is ignored
+                        random_bytes(value, 2);
+                        put_ad(buf, &len, max, ADV_AD_TYPE_TX_POWER_LEVEL, value, fuzz_below(4) ? 1 : 2);
+                        break;
+                case 4:
+                        rec.temperature = fuzz_random();
+                        rec.humidity = fuzz_random();
+                        rec.water = fuzz_random();
+                        rec.sequence = fuzz_random();
+                        rec.battery = fuzz_random();
+                        adv_encode_sensor_record(&rec, value);
+                        put_ad(buf, &len, max, ADV_AD_TYPE_MANUFACTURER_DATA, value,
+                                                                        BLUETANIST_MFR_RECORD_LEN);
+                        break;
+                case 5:
+                        // manufacturer data of another company, another format or too short
+                        adv_encode_sensor_record(&rec, value);
+                        n = BLUETANIST_MFR_RECORD_LEN;
+                        switch (fuzz_below(3)) {
+                        case 0:
+                                value[0] = 0x4C;
+                                value[1] = 0x00;
+                                break;
+                        case 1:
+                                value[2]++;
+                                break;
+                        default:
+                                n = fuzz_below(BLUETANIST_MFR_RECORD_LEN);
+                                break;
+                        }
+                        put_ad(buf, &len, max, ADV_AD_TYPE_MANUFACTURER_DATA, value, n);
+                        break;
+                case 6:
+                        n = fuzz_below(8);
+                        random_bytes(value, n);
+                        put_ad(buf, &len, max, fuzz_random(), value, n);
+                        break;
+                default:
+                        // early termination, whatever follows is not significant
+                        if (len < max) {
+                                buf[len++] = 0;
+                                n = fuzz_below(max - len + 1);
+                                random_bytes(&buf[len], n);
+                                len += n;
+                        }
+                        break;
+                }
+        }
+
+        return len;
+}
+
+static uint8_t gen_mutated(uint8_t *buf, uint8_t max)
+{
+        uint8_t len = gen_report(buf, max);
+        int n;
+
+        if (len == 0) {
+                return 0;
+        }
+
+        for (n = 1 + fuzz_below(3); n > 0; n--) {
+                switch (fuzz_below(3)) {
+                case 0:
+                        buf[fuzz_below(len)] ^= 1 << fuzz_below(8);
+                        break;
+                case 1:
+                        buf[fuzz_below(len)] = fuzz_random();
+                        break;
+                default:
+                        len = fuzz_below(len + 1);
+                        if (len == 0) {
+                                return 0;
+                        }
+                        break;
+                }
+        }
+
+        return len;
+}
+
+static uint8_t gen_random(uint8_t *buf, uint8_t max)
+{
+        uint8_t len = fuzz_below(max + 1);
+        uint8_t i;
+
+        // small values are more likely to be taken as a valid AD length
+        for (i = 0; i < len; i++) {
+                buf[i] = fuzz_below(4) ? fuzz_below(max) : fuzz_random();
+        }
+
+        return len;
+}
+
+/* Expected result of a report */
+struct ref_result {
+        bool ok;
+        bool uuid_match;
+        int name_pos;
+        uint8_t name_len;
+        bool name_complete;
+        bool has_tx_power;
+        int8_t tx_power;
+        bool has_record;
+        struct sensor_record record;
+};
+
+static void ref_parse(const uint8_t *data, int length, struct ref_result *ref)
+{
+        int pos = 0;
+        int len, type, i;
+        const uint8_t *v;
+
+        memset(ref, 0, sizeof(*ref));
+        ref->name_pos = -1;
+        ref->ok = true;
+
+        while (pos < length && data[pos] != 0) {
+                len = data[pos] - 1;
+                if (pos + 1 + data[pos] > length) {
+                        ref->ok = false;
+                        break;
+                }
+                type = data[pos + 1];
+                v = &data[pos + 2];
+
+                if (type == ADV_AD_TYPE_UUID128_LIST || type == ADV_AD_TYPE_UUID128_LIST_INC) {
+                        for (i = 0; i + ADV_UUID128_LEN <= len; i += ADV_UUID128_LEN) {
+                                if (memcmp(&v[i], service_uuid, ADV_UUID128_LEN) == 0) {
+                                        ref->uuid_match = true;
+                                }
+                        }
+                } else if (type == ADV_AD_TYPE_LOCAL_NAME || type == ADV_AD_TYPE_SHORT_NAME) {
+                        ref->name_pos = pos + 2;
+                        ref->name_len = len;
+                        ref->name_complete = (type == ADV_AD_TYPE_LOCAL_NAME);
+                } else if (type == ADV_AD_TYPE_TX_POWER_LEVEL && len == 1) {
+                        ref->has_tx_power = true;
+                        ref->tx_power = (int8_t)v[0];
+                } else if (type == ADV_AD_TYPE_MANUFACTURER_DATA && len >= BLUETANIST_MFR_RECORD_LEN &&
+                                v[0] == (BLUETANIST_COMPANY_ID & 0xFF) &&
+                                v[1] == (BLUETANIST_COMPANY_ID >> 8) && v[2] == BLUETANIST_MFR_FORMAT_RECORD) {
+                        ref->has_record = true;
+                        ref->record.temperature = v[3] | (v[4] << 8);
+                        ref->record.humidity = v[5] | (v[6] << 8);
+                        ref->record.water = v[7] | (v[8] << 8);
+                        ref->record.sequence = v[9] | (v[10] << 8);
+                        ref->record.battery = v[11];
+                }
+
+                pos += 1 + data[pos];
+        }
+}
+
+/* Differences between the parser and the reference, 0 if none */
+static int check_report(const uint8_t *data, uint8_t length, struct ref_result *ref)
+{
+        struct adv_report_info info;
+        bool ok;
+        int bad = 0;
+
+        ref_parse(data, length, ref);
+        ok = adv_parse_report(data, length, service_uuid, &info);
+
+        bad += (ok != ref->ok);
+        bad += (info.uuid_match != ref->uuid_match);
+        bad += (adv_has_uuid128(data, length, service_uuid) != ref->uuid_match);
+        if (ref->name_pos < 0) {
+                bad += (info.name != NULL);
+        } else {
+                bad += (info.name != &data[ref->name_pos] || info.name_len != ref->name_len ||
+                                                        info.name_complete != ref->name_complete);
+        }
+        bad += (info.has_tx_power != ref->has_tx_power || info.tx_power != ref->tx_power);
+        bad += (info.has_record != ref->has_record);
+        if (ref->has_record) {
+                bad += (info.record.temperature != ref->record.temperature ||
+                        info.record.humidity != ref->record.humidity ||
+                        info.record.water != ref->record.water ||
+                        info.record.sequence != ref->record.sequence ||
+                        info.record.battery != ref->record.battery);
+        }
+
+        return bad;
+}
+
+static void dump_report(const uint8_t *data, uint8_t length)
+{
+        uint8_t i;
+
+        for (i = 0; i < length; i++) {
+                printf("%02X", data[i]);
+        }
+        printf("\n");
+}
+
+static int run_fuzz(unsigned long reports)
+{
+        uint8_t buf[FUZZ_MAX_LEN];
+        uint8_t *block = malloc(FUZZ_MAX_LEN);
+        struct ref_result ref;
+        unsigned long i, failed = 0;
+        unsigned long matched = 0, records = 0, malformed = 0;
+        uint8_t max, len;
+        uint8_t *data;
+
+        if (block == NULL) {
+                return 1;
+        }
+
+        for (i = 0; i < reports; i++) {
+                max = fuzz_below(16) ? FUZZ_LEGACY_LEN : FUZZ_MAX_LEN;
+                switch (i % 3) {
+                case 0:
+                        len = gen_report(buf, max);
+                        break;
+                case 1:
+                        len = gen_mutated(buf, max);
+                        break;
+                default:
+                        len = gen_random(buf, max);
+                        break;
+                }
+
+                // the last byte of the report is the last byte of the block
+                data = &block[FUZZ_MAX_LEN - len];
+                memcpy(data, buf, len);
+
+                if (check_report(data, len, &ref)) {
+                        if (failed++ < 10) {
+                                printf("report %lu differs from the reference: ", i);
+                                dump_report(data, len);
+                        }
+                        continue;
+                }
+
+                matched += ref.uuid_match;
+                records += ref.has_record;
+                malformed += !ref.ok;
+        }
+
+        free(block);
+
+        printf("%lu reports: %lu matching the service UUID, %lu with a sensor record, %lu malformed\n",
+                                                                reports, matched, records, malformed);
+        printf("%lu reports differ from the reference\n", failed);
+
+        return failed ? 1 : 0;
+}
+
+static double now_s(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int run_bench(unsigned long reports)
+{
+        static uint8_t corpus[BENCH_CORPUS][FUZZ_LEGACY_LEN];
+        static uint8_t corpus_len[BENCH_CORPUS];
+        struct adv_report_info info;
+        struct sensor_record rec = { 2150, 4800, 120, 7, SENSOR_BATTERY_UNKNOWN };
+        uint8_t value[FUZZ_LEGACY_LEN];
+        unsigned long i, hits = 0;
+        double start, elapsed;
+        uint8_t *buf;
+        uint8_t *len;
+        int k;
+
+        /*
+         * A quarter each: node advertising data (flags, service UUID), node scan
+         * responses (name, record), beacons and other devices (flags, manufacturer
+         * data of another company, a 16-bit UUID list, TX power)
+         */
+        for (k = 0; k < BENCH_CORPUS; k++) {
+                buf = corpus[k];
+                len = &corpus_len[k];
+                value[0] = 0x06;
+                switch (k % 4) {
+                case 0:
+                        put_ad(buf, len, FUZZ_LEGACY_LEN, ADV_AD_TYPE_FLAGS, value, 1);
+                        put_ad(buf, len, FUZZ_LEGACY_LEN, ADV_AD_TYPE_UUID128_LIST, service_uuid,
+                                                                                ADV_UUID128_LEN);
+                        break;
+                case 1:
+                        put_ad(buf, len, FUZZ_LEGACY_LEN, ADV_AD_TYPE_SHORT_NAME, (const uint8_t *)"Tank", 4);
+                        rec.sequence = k;
+                        adv_encode_sensor_record(&rec, value);
+                        put_ad(buf, len, FUZZ_LEGACY_LEN, ADV_AD_TYPE_MANUFACTURER_DATA, value,
+                                                                        BLUETANIST_MFR_RECORD_LEN);
+                        break;
+                case 2:
+                        put_ad(buf, len, FUZZ_LEGACY_LEN, ADV_AD_TYPE_FLAGS, value, 1);
+                        value[0] = 0x4C;
+                        value[1] = 0x00;
+                        random_bytes(&value[2], 23);
+                        put_ad(buf, len, FUZZ_LEGACY_LEN, ADV_AD_TYPE_MANUFACTURER_DATA, value, 25);
+                        break;
+                default:
+                        put_ad(buf, len, FUZZ_LEGACY_LEN, ADV_AD_TYPE_FLAGS, value, 1);
+                        value[0] = 0x0F;
+                        value[1] = 0x18;
+                        put_ad(buf, len, FUZZ_LEGACY_LEN, 0x03, value, 2);
+                        value[0] = 0xF4;
+                        put_ad(buf, len, FUZZ_LEGACY_LEN, ADV_AD_TYPE_TX_POWER_LEVEL, value, 1);
+                        random_bytes(value, 8);
+                        put_ad(buf, len, FUZZ_LEGACY_LEN, ADV_AD_TYPE_LOCAL_NAME, value, 8);
+                        break;
+                }
+        }
+
+        start = now_s();
+        for (i = 0; i < reports; i++) {
+                k = i % BENCH_CORPUS;
+                adv_parse_report(corpus[k], corpus_len[k], service_uuid, &info);
+                hits += info.uuid_match + info.has_record;
+        }
+        elapsed = now_s() - start;
+
+        printf("%lu reports in %.3f s: %.1f M reports/s, %.1f ns per report (%lu matches)\n", reports,
+                elapsed, reports / elapsed / 1e6, elapsed * 1e9 / reports, hits);
+
+        return 0;
+}
+
+static void usage(const char *prog)
+{
+        fprintf(stderr,
+                "usage: %s [-n reports] [-s seed] [-b] [-h]\n"
+                "Fuzzes the advertising report parser, -b measures its throughput instead.\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+        unsigned long reports = 0;
+        bool bench = false;
+        int opt;
+
+        rand_state = 1;
+
+        while ((opt = getopt(argc, argv, "n:s:bh")) != -1) {
+                switch (opt) {
+                case 'n':
+                        reports = strtoul(optarg, NULL, 0);
+                        break;
+                case 's':
+                        rand_state = strtoul(optarg, NULL, 0);
+                        break;
+                case 'b':
+                        bench = true;
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return 0;
+                default:
+                        usage(argv[0]);
+                        return 2;
+                }
+        }
+        if (rand_state == 0) {
+                // xorshift never leaves 0
+                rand_state = 1;
+        }
+
+        if (bench) {
+                return run_bench(reports ? reports : BENCH_DEFAULT_REPORTS);
+        }
+
+        return run_fuzz(reports ? reports : FUZZ_DEFAULT_REPORTS);
+}
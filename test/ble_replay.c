@@ -0,0 +1,672 @@
+/*
+ * ble_replay.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Replayer of the BLE event traces of ble_trace.c.
+ *
+ * A trace is the stream read from the BLE trace characteristic of a node, saved
+ * to a file as it is. The replayer loads a fresh copy of the firmware image
+ * (libnode.so), puts its BLE stand-in in replay mode and feeds the events of the
+ * trace to the BLE task at their recorded ticks: they run through the same
+ * handle_ble_event() and the handlers behind it as on the node. The stand-in's own
+ * events are dropped, everything the firmware does besides is simulated as in the
+ * world of fleet_world.c, with no peer in range. Event bytes the trace did not keep
+ * (BLE_TRACE_MAX_PAYLOAD) are zero; the event layouts of test/sdk must match the
+ * SDK for a trace recorded on a node.
+ *
+ * The trace only holds the events of its ring buffer, the state of the node before
+ * them is not known; with -m the replaying node is made a master first, as the
+ * node recording a collection was.
+ *
+ * -o records a trace instead: a master collecting through an advertising storm,
+ * dumped by a phone through the trace characteristic as in the field. -c checks a
+ * replay: the replaying node traced the events itself, its trace must be the one
+ * replayed, tick for tick. -n replays the trace that many times in a row and
+ * reports the events per second of CPU time.
+ *
+ * -t measures the event loop under a scan storm instead: the advertising reports of
+ * the trace keep the queue of a master filled, its CPU time is charged to its clock,
+ * and the events per second the loop sustains, its wakeups and their length are
+ * reported for every batch size and time budget of the sweep (storm_batches,
+ * storm_budgets), on the tuning image libnode_tune.so. Times are node time, with the
+ * host taken STORM_HOST_SPEEDUP times as fast as the node.
+ *
+ *   $ ./ble_replay -o storm.trace
+ *   $ ./ble_replay -m -c storm.trace
+ *   $ ./ble_replay -m -n 100 storm.trace
+ *   $ ./ble_replay -t storm.trace
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "fleet_world.h"
+#include "ble_bluetanist_common.h"
+#include "ble_latency.h"
+#include "ble_trace.h"
+
+#define REPLAY_IMAGE                    "./libnode.so"
+
+/* Time the replaying node runs before the first event */
+#define REPLAY_BOOT_MS                  (1000)
+/* Time it runs after the last one */
+#define REPLAY_TAIL_MS                  (100)
+
+/* Recorded scenario: a master, a phone and advertisers in range */
+#define CAPTURE_CROWD                   (24)
+#define CAPTURE_ADV_INTERVAL_MS         (20)
+#define CAPTURE_MS                      (5000)
+
+/*
+ * Storm sweep: the event loop of the tuning image (CFG_BLE_EVT_BATCH and
+ * CFG_BLE_EVT_BUDGET_MS set at run time) handles the advertising reports of a trace
+ * for STORM_MS of node time per setting, the stack keeping the queue filled up to
+ * its reserve. The CPU time of the node is charged to its clock, the host taken
+ * STORM_HOST_SPEEDUP times as fast as the node.
+ */
+#define STORM_IMAGE                     "./libnode_tune.so"
+#define STORM_MS                        (20000)
+#define STORM_HOST_SPEEDUP              (32)
+#define STORM_FILL                      (HOST_BLE_EVT_QUEUE_LEN - HOST_BLE_EVT_RESERVED)
+
+/* Largest latency stream: the header, every code, the depth and drain statistics */
+#define LATENCY_STREAM_MAX              (2048)
+
+/* Largest trace stream: the dump header and a full ring buffer */
+#define TRACE_STREAM_MAX                (BLE_TRACE_DUMP_HDR_LEN + BLE_TRACE_BUF_SIZE)
+
+struct trace_rec {
+        uint16_t evt_code;
+        uint16_t length;                /* length of the event */
+        uint32_t tick;
+        uint8_t kept;                   /* bytes of the event in the trace */
+        uint8_t data[255];
+};
+
+struct trace {
+        uint32_t tick_rate;
+        int count;
+        int cut;                        /* events not kept whole */
+        struct trace_rec *recs;
+};
+
+/* Drain statistics of the latency stream */
+struct drain_stats {
+        uint32_t wakeups;
+        uint32_t events;
+        uint16_t max_events;
+        uint32_t limited;
+};
+
+static const uint16_t storm_batches[] = { 1, 2, 4, 8, 16, 24 };
+static const uint32_t storm_budgets[] = { 1, 2, 5, 10 };
+
+static const struct host_hih6130 sensor_default = {
+        .raw_humidity = 8191,
+        .raw_temperature = 6454,
+};
+
+static uint32_t get_le32(const uint8_t *p)
+{
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+        return p[0] | (p[1] << 8);
+}
+
+/* Parse a trace stream, false if it is not one */
+static bool trace_parse(const uint8_t *buf, size_t len, struct trace *t)
+{
+        size_t pos = BLE_TRACE_DUMP_HDR_LEN;
+        struct trace_rec *rec;
+
+        memset(t, 0, sizeof(*t));
+        if (len < BLE_TRACE_DUMP_HDR_LEN || buf[0] != 'B' || buf[1] != 'T' || buf[2] != BLE_TRACE_VERSION) {
+                return false;
+        }
+        t->tick_rate = get_le32(&buf[4]);
+        if (t->tick_rate == 0) {
+                return false;
+        }
+        t->recs = calloc(len / BLE_TRACE_REC_HDR_LEN + 1, sizeof(*t->recs));
+        if (!t->recs) {
+                return false;
+        }
+
+        while (pos < len) {
+                if (len - pos < BLE_TRACE_REC_HDR_LEN || len - pos - BLE_TRACE_REC_HDR_LEN < buf[pos]) {
+                        return false;
+                }
+                rec = &t->recs[t->count++];
+                rec->kept = buf[pos];
+                rec->evt_code = get_le16(&buf[pos + 1]);
+                rec->length = get_le16(&buf[pos + 3]);
+                rec->tick = get_le32(&buf[pos + 5]);
+                memcpy(rec->data, &buf[pos + BLE_TRACE_REC_HDR_LEN], rec->kept);
+                if (rec->kept < rec->length) {
+                        t->cut++;
+                }
+                pos += BLE_TRACE_REC_HDR_LEN + rec->kept;
+        }
+
+        return true;
+}
+
+/* Ticks of the trace since event \p base, in ms */
+static uint32_t trace_ms(const struct trace *t, int base, int i)
+{
+        return (uint64_t)(t->recs[i].tick - t->recs[base].tick) * 1000 / t->tick_rate;
+}
+
+static void trace_summary(const struct trace *t, FILE *out)
+{
+        int per_cat[BLE_EVT_CAT_L2CAP + 1] = { 0 };
+        int i, cat;
+
+        for (i = 0; i < t->count; i++) {
+                cat = t->recs[i].evt_code >> 8;
+                per_cat[cat < BLE_EVT_CAT_L2CAP ? cat : BLE_EVT_CAT_L2CAP]++;
+        }
+
+        fprintf(out, "trace: %d events over %u ms, tick rate %u Hz, %d events cut\n", t->count,
+                t->count ? trace_ms(t, 0, t->count - 1) : 0, t->tick_rate, t->cut);
+        fprintf(out, "       %d common, %d GAP, %d GATT client, %d GATT server, %d other\n",
+                per_cat[BLE_EVT_CAT_COMMON], per_cat[BLE_EVT_CAT_GAP], per_cat[BLE_EVT_CAT_GATTC],
+                per_cat[BLE_EVT_CAT_GATTS], per_cat[BLE_EVT_CAT_L2CAP]);
+}
+
+static bd_address_t node_addr(int n)
+{
+        bd_address_t addr = {
+                .addr_type = PUBLIC_ADDRESS,
+                .addr = { n & 0xFF, (n >> 8) & 0xFF, 0x00, 0x90, 0x06, 0x42 },
+        };
+
+        return addr;
+}
+
+static struct world_node *add_phone(void)
+{
+        bd_address_t addr = {
+                .addr_type = PUBLIC_ADDRESS,
+                .addr = { 0x01, 0x00, 0x00, 0xAA, 0xBB, 0xCC },
+        };
+
+        return world_add_phone("phone", &addr);
+}
+
+/* Connect a phone to a node and make the node a master, the phone stays connected */
+static struct world_link *make_master(struct world_node *phone, struct world_node *node)
+{
+        struct world_link *link = world_phone_connect(phone, node, 1000);
+        uint16_t set_h;
+        uint8_t on = 1;
+
+        if (!link || !world_phone_exchange_mtu(phone, link) ||
+                        !(set_h = world_phone_find_char(phone, link, NODE_MASTER_ATTR_SET)) ||
+                        world_phone_write(phone, link, set_h, &on, sizeof(on)) != ATT_ERROR_OK) {
+                return NULL;
+        }
+
+        return link;
+}
+
+/* Record a trace: a master collecting through an advertising storm */
+static int capture(const char *image, const char *path, uint32_t seed, FILE *out)
+{
+        static uint8_t stream[TRACE_STREAM_MAX];
+        uint8_t chunk[HOST_ATT_VALUE_MAX];
+        struct world_node *master, *phone;
+        struct world_link *link;
+        struct trace t;
+        bd_address_t addr;
+        uint16_t trace_h, len;
+        size_t size = 0;
+        FILE *fp;
+        int i;
+
+        world_init(image, seed);
+        addr = node_addr(1);
+        master = world_add_node("master", &addr, &sensor_default);
+        phone = add_phone();
+        for (i = 0; i < CAPTURE_CROWD; i++) {
+                char name[16];
+
+                snprintf(name, sizeof(name), "node%d", 100 + i);
+                addr = node_addr(100 + i);
+                world_add_node(name, &addr, &sensor_default);
+        }
+        world_set_adv_interval(CAPTURE_ADV_INTERVAL_MS);
+        world_run(1000);
+
+        link = make_master(phone, master);
+        if (!link || !(trace_h = world_phone_find_char(phone, link, DIAG_ATTR_TRACE))) {
+                fprintf(out, "capture: the master could not be set up\n");
+                return 1;
+        }
+        world_run(CAPTURE_MS);
+
+        // as a phone dumps the trace: read until the value is empty
+        do {
+                len = 0;
+                if (world_phone_read(phone, link, trace_h, 0, chunk, &len) != ATT_ERROR_OK ||
+                                                                size + len > sizeof(stream)) {
+                        fprintf(out, "capture: reading the trace failed\n");
+                        return 1;
+                }
+                memcpy(&stream[size], chunk, len);
+                size += len;
+        } while (len);
+
+        if (!trace_parse(stream, size, &t)) {
+                fprintf(out, "capture: the trace read is malformed\n");
+                return 1;
+        }
+        trace_summary(&t, out);
+        free(t.recs);
+
+        fp = fopen(path, "wb");
+        if (!fp || fwrite(stream, 1, size, fp) != size || fclose(fp)) {
+                perror(path);
+                return 1;
+        }
+
+        return 0;
+}
+
+static bool load(const char *path, struct trace *t)
+{
+        static uint8_t stream[1 << 20];
+        size_t size;
+        FILE *fp;
+
+        fp = fopen(path, "rb");
+        if (!fp) {
+                perror(path);
+                return false;
+        }
+        size = fread(stream, 1, sizeof(stream), fp);
+        fclose(fp);
+
+        return trace_parse(stream, size, t);
+}
+
+/* The trace a node recorded itself */
+static bool node_trace(const struct world_node *node, struct trace *t)
+{
+        static uint8_t stream[TRACE_STREAM_MAX];
+        uint16_t (*trace_read)(uint8_t *buf, uint16_t max) = world_node_sym(node, "ble_trace_read");
+        size_t size = 0;
+        uint16_t len;
+
+        if (!trace_read) {
+                return false;
+        }
+        // a dump the trace ends with was replayed too, finish it first
+        while (trace_read(stream, sizeof(stream)) != 0) {
+        }
+        while ((len = trace_read(&stream[size], sizeof(stream) - size)) != 0) {
+                size += len;
+        }
+
+        return trace_parse(stream, size, t);
+}
+
+/*
+ * Differences between the replayed trace and the one the replaying node recorded;
+ * the node also traced the events before the replay, the replayed ones come last
+ */
+static int compare(const struct trace *played, const struct trace *traced, FILE *out)
+{
+        int base = traced->count - played->count;
+        const struct trace_rec *a, *b;
+        int bad = 0;
+        int i;
+
+        if (base < 0) {
+                fprintf(out, "check: %d events replayed, %d traced\n", played->count, traced->count);
+                return 1;
+        }
+
+        for (i = 0; i < played->count; i++) {
+                a = &played->recs[i];
+                b = &traced->recs[base + i];
+                if (a->evt_code != b->evt_code || a->length != b->length || a->kept != b->kept ||
+                                memcmp(a->data, b->data, a->kept) ||
+                                trace_ms(played, 0, i) != trace_ms(traced, base, base + i)) {
+                        if (bad++ < 5) {
+                                fprintf(out, "check: event %d: %04x at %u ms replayed, %04x at %u ms traced\n",
+                                        i, a->evt_code, trace_ms(played, 0, i), b->evt_code,
+                                        trace_ms(traced, base, base + i));
+                        }
+                }
+        }
+
+        return bad;
+}
+
+static double cpu_s(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* A fresh node in replay mode, made a master first with \p master */
+static struct world_node *replay_node(const char *image, bool master, FILE *out)
+{
+        void (*set_replay)(bool on);
+        struct world_node *node, *phone;
+        struct world_link *link;
+        bd_address_t addr = node_addr(1);
+
+        world_init(image, 1);
+        node = world_add_node("replay", &addr, &sensor_default);
+        set_replay = world_node_sym(node, "host_ble_replay");
+        if (!set_replay || !world_node_sym(node, "host_ble_inject")) {
+                fprintf(out, "%s: not built with the replay stand-in\n", image);
+                return NULL;
+        }
+        world_run(REPLAY_BOOT_MS);
+        if (master) {
+                phone = add_phone();
+                link = make_master(phone, node);
+                if (!link) {
+                        fprintf(out, "replay: the node could not be made a master\n");
+                        return NULL;
+                }
+                world_phone_disconnect(phone, link);
+                world_run(REPLAY_TAIL_MS);
+        }
+        set_replay(true);
+
+        return node;
+}
+
+static int replay(const char *image, const struct trace *t, int repeat, bool master, bool check, FILE *out)
+{
+        bool (*inject)(uint16_t evt_code, uint16_t length, const uint8_t *data, uint16_t data_len);
+        struct world_node *node;
+        struct trace traced;
+        uint32_t start, span;
+        int r, i, lost = 0;
+        double cpu;
+
+        node = replay_node(image, master, out);
+        if (!node) {
+                return 1;
+        }
+        inject = world_node_sym(node, "host_ble_inject");
+
+        span = t->count ? trace_ms(t, 0, t->count - 1) + 1 : 0;
+        start = world_now();
+        cpu = cpu_s();
+        for (r = 0; r < repeat; r++) {
+                for (i = 0; i < t->count; i++) {
+                        world_run_until(start + r * span + trace_ms(t, 0, i));
+                        if (!inject(t->recs[i].evt_code, t->recs[i].length, t->recs[i].data, t->recs[i].kept)) {
+                                lost++;
+                        }
+                }
+        }
+        world_run(REPLAY_TAIL_MS);
+        cpu = cpu_s() - cpu;
+
+        fprintf(out, "replayed %d times: %d events in %u ms, %d not allocated, %.3f s CPU, %.0f events/s\n",
+                repeat, repeat * t->count, world_now() - start, lost, cpu,
+                cpu > 0 ? repeat * t->count / cpu : 0);
+        if (node->api.wdog_expiries()) {
+                fprintf(out, "replay: %u watchdog expiries\n", node->api.wdog_expiries());
+                return 1;
+        }
+        if (!check) {
+                return lost ? 1 : 0;
+        }
+
+        if (!node_trace(node, &traced)) {
+                fprintf(out, "check: the trace of the replaying node is malformed\n");
+                return 1;
+        }
+        r = compare(t, &traced, out);
+        free(traced.recs);
+        fprintf(out, "check: %s\n", r ? "the replayed trace differs" : "the replayed trace matches");
+
+        return (r || lost) ? 1 : 0;
+}
+
+/* The drain statistics a node recorded, from its latency stream */
+static bool node_drain(const struct world_node *node, struct drain_stats *d)
+{
+        static uint8_t stream[LATENCY_STREAM_MAX];
+        uint16_t (*latency_read)(uint8_t *buf, uint16_t max) = world_node_sym(node, "ble_latency_read");
+        size_t size = 0, pos;
+        uint16_t len;
+
+        if (!latency_read) {
+                return false;
+        }
+        while ((len = latency_read(&stream[size], sizeof(stream) - size)) != 0) {
+                size += len;
+        }
+        if (size < BLE_LATENCY_HDR_LEN || stream[0] != 'B' || stream[1] != 'L' ||
+                                                        stream[2] != BLE_LATENCY_VERSION) {
+                return false;
+        }
+        // the drain statistics follow the codes and the depth histogram
+        pos = BLE_LATENCY_HDR_LEN + stream[3] * (10 + 2 * stream[9]) + 2 + 2 * stream[10];
+        if (size < pos + 22) {
+                return false;
+        }
+        d->wakeups = get_le32(&stream[pos]);
+        d->events = get_le32(&stream[pos + 4]);
+        d->max_events = get_le16(&stream[pos + 12]);
+        d->limited = get_le32(&stream[pos + 14]);
+
+        return true;
+}
+
+/* The event loop of a master with one batch size and budget, a row of the sweep */
+static int storm(const char *image, const struct trace *t, uint16_t batch, uint32_t budget_ms, FILE *out)
+{
+        bool (*inject)(uint16_t evt_code, uint16_t length, const uint8_t *data, uint16_t data_len);
+        uint32_t ns_per_tick = 1000000 / STORM_HOST_SPEEDUP;
+        uint32_t *budget_var;
+        uint16_t *batch_var;
+        void (*latency_reset)(void);
+        struct world_node *node;
+        struct drain_stats d;
+        OS_TICK_TIME start, elapsed;
+        double event_ms;
+        int i = 0, n;
+
+        node = replay_node(image, true, out);
+        if (!node) {
+                return 1;
+        }
+        inject = world_node_sym(node, "host_ble_inject");
+        batch_var = world_node_sym(node, "host_ble_evt_batch");
+        budget_var = world_node_sym(node, "host_ble_evt_budget_ms");
+        latency_reset = world_node_sym(node, "ble_latency_reset");
+        if (!batch_var || !budget_var || !latency_reset) {
+                fprintf(out, "%s: not the tuning image\n", image);
+                return 1;
+        }
+        *batch_var = batch;
+        *budget_var = budget_ms;
+        latency_reset();
+
+        // the node is never idle: each round refills the queue, the world follows the node's clock
+        node->api.set_cpu_scale(ns_per_tick);
+        start = node->api.now();
+        while ((elapsed = node->api.now() - start) < STORM_MS) {
+                for (n = 0; n < STORM_FILL; n++) {
+                        do {
+                                i = (i + 1) % t->count;
+                        } while (t->recs[i].evt_code != BLE_EVT_GAP_ADV_REPORT);
+                        inject(t->recs[i].evt_code, t->recs[i].length, t->recs[i].data, t->recs[i].kept);
+                }
+                world_run_until(node->api.now());
+        }
+        node->api.set_cpu_scale(0);
+
+        if (!node_drain(node, &d) || d.events == 0 || d.wakeups == 0) {
+                fprintf(out, "storm: no drain statistics\n");
+                return 1;
+        }
+        // ticks are ms on the host; the node did nothing but handle the storm
+        event_ms = (double)elapsed / d.events;
+        fprintf(out, "%5u %4u ms %9.0f %9.0f %7.1f %4u %7.1f %% %7.2f %7.2f %5u\n", batch, budget_ms,
+                d.events * 1000.0 / elapsed, d.wakeups * 1000.0 / elapsed, (double)d.events / d.wakeups,
+                d.max_events, d.limited * 100.0 / d.wakeups, event_ms * d.events / d.wakeups,
+                event_ms * d.max_events, node->api.wdog_expiries());
+
+        return node->api.wdog_expiries() ? 1 : 0;
+}
+
+/* Every batch size and budget, each on a fresh world of its own */
+static int storm_sweep(const char *image, const struct trace *t, FILE *out)
+{
+        uint32_t span = t->count ? trace_ms(t, 0, t->count - 1) : 0;
+        int reports = 0, failed = 0;
+        size_t b, g;
+        int i;
+
+        for (i = 0; i < t->count; i++) {
+                reports += (t->recs[i].evt_code == BLE_EVT_GAP_ADV_REPORT);
+        }
+        if (reports == 0) {
+                fprintf(out, "storm: no advertising reports in the trace\n");
+                return 1;
+        }
+        fprintf(out, "storm: the trace has %.0f reports/s, %d queued per round, host %d times the node\n",
+                span ? reports * 1000.0 / span : 0, STORM_FILL, STORM_HOST_SPEEDUP);
+        fprintf(out, "batch budget  events/s wakeups/s per wakeup max limited  wakeup ms  max  wdog\n");
+
+        for (b = 0; b < ARRAY_LENGTH(storm_batches); b++) {
+                for (g = 0; g < ARRAY_LENGTH(storm_budgets); g++) {
+                        int status;
+                        pid_t pid;
+
+                        fflush(out);
+                        pid = fork();
+                        if (pid < 0) {
+                                perror("fork");
+                                return 1;
+                        }
+                        if (pid == 0) {
+                                exit(storm(image, t, storm_batches[b], storm_budgets[g], out));
+                        }
+                        if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+                                failed++;
+                        }
+                }
+        }
+
+        return failed ? 1 : 0;
+}
+
+static void usage(const char *prog)
+{
+        fprintf(stderr,
+                "usage: %s [-i image] [-m] [-c] [-n repeat] [-v] trace\n"
+                "       %s [-i image] [-v] -t trace\n"
+                "       %s [-i image] [-s seed] [-v] -o trace\n"
+                "Replays a BLE event trace through a firmware image, -m makes the node a master\n"
+                "first, -c checks the trace the node recorded, -n replays it that many times.\n"
+                "-t sweeps the event loop batch and budget under a storm of the trace's reports.\n"
+                "-o records a trace of a master collecting through an advertising storm.\n", prog, prog, prog);
+}
+
+int main(int argc, char **argv)
+{
+        const char *image = NULL;
+        const char *record = NULL;
+        bool master = false;
+        bool sweep = false;
+        bool check = false;
+        bool verbose = false;
+        uint32_t seed = 1;
+        int repeat = 1;
+        struct trace t;
+        FILE *out;
+        int opt, ret;
+
+        while ((opt = getopt(argc, argv, "i:o:s:n:mctvh")) != -1) {
+                switch (opt) {
+                case 'i':
+                        image = optarg;
+                        break;
+                case 'o':
+                        record = optarg;
+                        break;
+                case 's':
+                        seed = strtoul(optarg, NULL, 0);
+                        break;
+                case 'n':
+                        repeat = atoi(optarg);
+                        break;
+                case 'm':
+                        master = true;
+                        break;
+                case 'c':
+                        check = true;
+                        break;
+                case 't':
+                        sweep = true;
+                        break;
+                case 'v':
+                        verbose = true;
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return 0;
+                default:
+                        usage(argv[0]);
+                        return 2;
+                }
+        }
+        // the replaying node traces the last ring buffer only, a single pass is checked
+        if ((!record && optind != argc - 1) || repeat < 1 || (check && repeat > 1) || (sweep && record)) {
+                usage(argv[0]);
+                return 2;
+        }
+        if (!image) {
+                image = sweep ? STORM_IMAGE : REPLAY_IMAGE;
+        }
+
+        out = fdopen(dup(STDOUT_FILENO), "w");
+        if (!out || (!verbose && !freopen("/dev/null", "w", stdout))) {
+                perror("stdout");
+                return 2;
+        }
+
+        if (record) {
+                ret = capture(image, record, seed, out);
+                fclose(out);
+                return ret;
+        }
+
+        if (!load(argv[optind], &t)) {
+                fprintf(out, "%s: not a BLE trace\n", argv[optind]);
+                fclose(out);
+                return 1;
+        }
+        trace_summary(&t, out);
+        ret = sweep ? storm_sweep(image, &t, out) : replay(image, &t, repeat, master, check, out);
+        free(t.recs);
+        fclose(out);
+
+        return ret;
+}
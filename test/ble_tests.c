@@ -0,0 +1,891 @@
+/*
+ * ble_tests.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host tests of the firmware on the SDK stand-ins: the BLE task, the custom
+ * services, the central functions, the connection table, parameter and link
+ * managers, the scan and collection schedulers and the I2C task, run as they are
+ * in the images of fleet_world.c and driven through the radio by phones and other
+ * nodes.
+ *
+ * The world keeps its state in statics, so every scenario runs in a child process
+ * of its own; the checks count in memory shared with the parent. The firmware
+ * prints its log on stdout, shown with -v.
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "fleet_world.h"
+#include "ble_bluetanist_common.h"
+#include "ble_conn_table.h"
+#include "ble_link.h"
+#include "i2c_sensors.h"
+#include "node_aggregate.h"
+#include "sensor_calib_tables.h"
+#include "sensor_conversion.h"
+
+#define IMAGE                   "./libnode.so"
+#define IMAGE_WINDOWS           "./libnode_windows.so"
+
+static struct {
+        int checks;
+        int failures;
+} *counters;
+
+#define CHECK(expr)                                                                     \
+        do {                                                                            \
+                counters->checks++;                                                     \
+                if (!(expr)) {                                                          \
+                        counters->failures++;                                           \
+                        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+                }                                                                       \
+        } while (0)
+
+/* HIH6130 reading of the nodes: 25.00 C and 50.00 % */
+static const struct host_hih6130 sensor_default = {
+        .raw_humidity = 8191,
+        .raw_temperature = 6454,
+};
+
+/* Raw HIH6130 temperature of a temperature in 0.01 C */
+static uint16_t raw_temperature(int32_t centi)
+{
+        return (centi + 4000) * 16382 / 16500;
+}
+
+static bd_address_t node_addr(int n)
+{
+        bd_address_t addr = {
+                .addr_type = PUBLIC_ADDRESS,
+                .addr = { n & 0xFF, (n >> 8) & 0xFF, 0x00, 0x90, 0x06, 0x42 },
+        };
+
+        return addr;
+}
+
+static struct world_node *add_node(int n, const struct host_hih6130 *sensor)
+{
+        char name[16];
+        bd_address_t addr = node_addr(n);
+
+        snprintf(name, sizeof(name), "node%d", n);
+
+        return world_add_node(name, &addr, sensor ? sensor : &sensor_default);
+}
+
+static struct world_node *add_phone(void)
+{
+        bd_address_t addr = {
+                .addr_type = PUBLIC_ADDRESS,
+                .addr = { 0x01, 0x00, 0x00, 0xAA, 0xBB, 0xCC },
+        };
+
+        return world_add_phone("phone", &addr);
+}
+
+static uint16_t get_le16(const uint8_t *p)
+{
+        return p[0] | (p[1] << 8);
+}
+
+static uint32_t wdog_expiries(const struct world_node *node)
+{
+        return node->api.wdog_expiries();
+}
+
+/* Connection table entry of a node for a link */
+static const struct conn_entry *node_conn(const struct world_node *node, const struct world_link *link)
+{
+        const struct conn_entry *table = world_node_sym(node, "conn_table");
+        uint16_t conn_idx = (node == link->master) ? link->master_idx : link->slave_idx;
+        int i;
+
+        for (i = 0; i < CONN_TABLE_SIZE; i++) {
+                if (table[i].role != CONN_ROLE_FREE && table[i].conn_idx == conn_idx) {
+                        return &table[i];
+                }
+        }
+
+        return NULL;
+}
+
+static const struct sensor_data_t *node_sensor_data(const struct world_node *node)
+{
+        return world_node_sym(node, "sensor_data");
+}
+
+static struct world_link *connect_phone(struct world_node *phone, struct world_node *node)
+{
+        struct world_link *link = world_phone_connect(phone, node, 1000);
+
+        CHECK(link != NULL);
+        if (link) {
+                world_phone_exchange_mtu(phone, link);
+        }
+
+        return link;
+}
+
+static int16_t read_u16(struct world_node *phone, struct world_link *link, uint16_t handle)
+{
+        uint8_t value[HOST_ATT_VALUE_MAX];
+        uint16_t len = 0;
+
+        CHECK(world_phone_read(phone, link, handle, 0, value, &len) == ATT_ERROR_OK);
+        CHECK(len == 2);
+
+        return (int16_t)get_le16(value);
+}
+
+/* PDUs counted and dropped by the filter */
+static struct {
+        uint8_t count_op;
+        uint32_t count;
+        uint8_t drop_op;
+        uint32_t dropped;
+} pdu_filter;
+
+static bool filter_pdus(const struct world_node *from, const struct world_node *to, const struct host_pdu *pdu)
+{
+        (void)from;
+        (void)to;
+
+        if (pdu->op == pdu_filter.count_op) {
+                pdu_filter.count++;
+        }
+        if (pdu->op == pdu_filter.drop_op) {
+                pdu_filter.dropped++;
+                return true;
+        }
+
+        return false;
+}
+
+static void filter_init(uint8_t count_op, uint8_t drop_op)
+{
+        memset(&pdu_filter, 0, sizeof(pdu_filter));
+        // no PDU has op 0xFF
+        pdu_filter.count_op = count_op;
+        pdu_filter.drop_op = drop_op;
+        world_set_filter(filter_pdus);
+}
+
+/* Make a node a master by writing the master characteristic */
+static void make_master(struct world_node *phone, struct world_link *link)
+{
+        uint16_t set_h = world_phone_find_char(phone, link, NODE_MASTER_ATTR_SET);
+        uint8_t on = 1;
+
+        CHECK(set_h != 0);
+        CHECK(world_phone_write(phone, link, set_h, &on, sizeof(on)) == ATT_ERROR_OK);
+}
+
+/* Read the aggregate of a master, returns the number of entries decoded, -1 on an error */
+static int read_aggregate(struct world_node *phone, struct world_link *link, struct aggregate_entry *entries,
+        int max)
+{
+        static uint8_t frame[HOST_ATT_VALUE_MAX];
+        uint16_t data_h = world_phone_find_char(phone, link, NODE_MASTER_ATTR_DATA);
+        uint16_t len = 0, generation;
+        uint32_t timestamp;
+        uint8_t count;
+        int i;
+
+        if (world_phone_read_long(phone, link, data_h, frame, &len) != ATT_ERROR_OK ||
+                !aggregate_decode_header(frame, len, &count, &generation, &timestamp)) {
+                return -1;
+        }
+        for (i = 0; i < count && i < max; i++) {
+                aggregate_decode_entry(frame + AGGREGATE_HDR_LEN + i * AGGREGATE_ENTRY_LEN, &entries[i]);
+        }
+
+        return i;
+}
+
+static const struct aggregate_entry *find_entry(const struct aggregate_entry *entries, int count,
+        const struct world_node *node)
+{
+        int i;
+
+        for (i = 0; i < count; i++) {
+                if (!memcmp(entries[i].addr, node->addr.addr, sizeof(entries[i].addr))) {
+                        return &entries[i];
+                }
+        }
+
+        return NULL;
+}
+
+/* Value a node publishes for a constant HIH6130 reading, in 0.01 units */
+static int16_t expected_temperature(const struct host_hih6130 *sensor)
+{
+        return calib_apply(&calib_hih_temperature, conv_hih_temperature(sensor->raw_temperature));
+}
+
+static uint16_t expected_humidity(const struct host_hih6130 *sensor)
+{
+        return calib_apply(&calib_hih_humidity, conv_hih_humidity(sensor->raw_humidity));
+}
+
+/*
+ * A node boots, advertises its service and the local name, and a phone finds the
+ * sensor data, master and alarm services on it. The node advertises on while
+ * connected, for more peers.
+ */
+static void test_boot_and_discovery(void)
+{
+        struct world_node *node, *phone;
+        struct world_link *link;
+
+        world_init(IMAGE, 1);
+        node = add_node(1, NULL);
+        phone = add_phone();
+        world_run(1000);
+
+        CHECK(node->advertising);
+        CHECK(node->ad_len > 0);
+        CHECK(node->sd_len > 2 && !memcmp(&node->sd[2], DEVICE_NAME, node->sd_len - 2));
+
+        link = world_phone_connect(phone, node, 1000);
+        CHECK(link != NULL);
+        if (!link) {
+                return;
+        }
+        CHECK(world_node_links(node) == 1);
+        CHECK(node->advertising);
+        // the node keeps the default MTU of the stack, CHANGE_MTU_SIZE_ENABLE is off
+        CHECK(world_phone_exchange_mtu(phone, link) == HOST_GAP_MTU_DEFAULT);
+        CHECK(world_phone_find_char(phone, link, NODE_DATA_ATTR_TEMP) != 0);
+        CHECK(world_phone_find_char(phone, link, NODE_DATA_ATTR_HUMID) != 0);
+        CHECK(world_phone_find_char(phone, link, NODE_DATA_ATTR_WATER) != 0);
+        CHECK(world_phone_find_char(phone, link, NODE_MASTER_ATTR_SET) != 0);
+        CHECK(world_phone_find_char(phone, link, NODE_MASTER_ATTR_DATA) != 0);
+        CHECK(world_phone_find_char(phone, link, NODE_MASTER_ATTR_TIME) != 0);
+        CHECK(world_phone_find_char(phone, link, NODE_ALARM_ATTR_STATE) != 0);
+        CHECK(world_phone_find_char(phone, link, "12345678-0000-0000-0000-000000000000") == 0);
+
+        world_phone_disconnect(phone, link);
+        world_run(1000);
+        CHECK(world_find_link(phone, node) == NULL);
+        CHECK(world_node_links(node) == 0);
+        CHECK(node->advertising);
+        CHECK(wdog_expiries(node) == 0);
+}
+
+/*
+ * The I2C task samples the HIH6130 and a phone reads the filtered values
+ */
+static void test_sensor_read(void)
+{
+        struct world_node *node, *phone;
+        struct world_link *link;
+        uint8_t value[HOST_ATT_VALUE_MAX];
+        uint16_t len = 0, temp_h, humid_h;
+
+        world_init(IMAGE, 2);
+        node = add_node(1, NULL);
+        phone = add_phone();
+        world_run(5000);
+
+        link = world_phone_connect(phone, node, 1000);
+        CHECK(link != NULL);
+        if (!link) {
+                return;
+        }
+        temp_h = world_phone_find_char(phone, link, NODE_DATA_ATTR_TEMP);
+        humid_h = world_phone_find_char(phone, link, NODE_DATA_ATTR_HUMID);
+
+        CHECK(world_phone_read(phone, link, temp_h, 0, value, &len) == ATT_ERROR_OK);
+        CHECK(len == 2);
+        CHECK((int16_t)get_le16(value) == expected_temperature(&sensor_default));
+        CHECK(world_phone_read(phone, link, humid_h, 0, value, &len) == ATT_ERROR_OK);
+        CHECK(len == 2);
+        CHECK(get_le16(value) == expected_humidity(&sensor_default));
+
+        // every reading closes the bus again
+        CHECK(node->api.i2c_open_count() == 0);
+        CHECK(node->api.i2c_transfers() >= 2 * 4 * 4);
+        CHECK(wdog_expiries(node) == 0);
+}
+
+/*
+ * A phone subscribed to the temperature gets a notification when it changes
+ */
+static void test_notifications(void)
+{
+        struct host_hih6130 warmer = sensor_default;
+        const struct world_notification *n;
+        struct world_node *node, *phone;
+        struct world_link *link;
+        uint16_t temp_h, humid_h;
+        uint8_t ccc[2] = { 0x01, 0x00 };
+        uint32_t since;
+
+        world_init(IMAGE, 3);
+        node = add_node(1, NULL);
+        phone = add_phone();
+        world_run(5000);
+        link = connect_phone(phone, node);
+        if (!link) {
+                return;
+        }
+        temp_h = world_phone_find_char(phone, link, NODE_DATA_ATTR_TEMP);
+        humid_h = world_phone_find_char(phone, link, NODE_DATA_ATTR_HUMID);
+
+        // the client characteristic configuration follows the value and the description
+        CHECK(world_phone_write(phone, link, temp_h + 2, ccc, sizeof(ccc)) == ATT_ERROR_OK);
+        since = phone->notify_count;
+        world_run(3000);
+        CHECK(phone->notify_count == since);
+
+        warmer.raw_temperature = raw_temperature(2700);
+        node->api.set_hih6130(&warmer);
+        // the filter settles in about 30 samples
+        world_run(40000);
+        n = world_phone_last_notification(phone, temp_h, since);
+        CHECK(n != NULL);
+        if (n) {
+                int16_t value = (int16_t)get_le16(n->value);
+
+                CHECK(!n->indication);
+                CHECK(n->length == 2);
+                // the last notification is within the change delta of the settled value
+                CHECK(abs(value - expected_temperature(&warmer)) <= 10);
+        }
+        // the humidity did not change and is not subscribed
+        CHECK(world_phone_last_notification(phone, humid_h, since) == NULL);
+        CHECK(read_u16(phone, link, temp_h) == expected_temperature(&warmer));
+        CHECK(wdog_expiries(node) == 0);
+}
+
+/*
+ * A node switches an idle connection to the idle parameters and back to the fast ones
+ * on activity; a phone refusing the update keeps its parameters and the node asks again
+ */
+static void test_conn_params(void)
+{
+        const struct conn_entry *conn;
+        struct world_node *node, *phone;
+        struct world_link *link;
+        uint16_t temp_h;
+
+        world_init(IMAGE, 4);
+        node = add_node(1, NULL);
+        phone = add_phone();
+        filter_init(HOST_PDU_CONN_PARAM_REQ, 0xFF);
+        world_run(1000);
+        link = connect_phone(phone, node);
+        if (!link) {
+                return;
+        }
+        temp_h = world_phone_find_char(phone, link, NODE_DATA_ATTR_TEMP);
+        read_u16(phone, link, temp_h);
+        CHECK(link->interval_ms == 30);
+
+        // the idle check runs every CFG_CONN_IDLE_MS, an idle connection is seen within two periods
+        world_run(2 * CFG_CONN_IDLE_MS + 500);
+        conn = node_conn(node, link);
+        CHECK(pdu_filter.count == 1);
+        CHECK(link->interval_ms == 0x140 * 5 / 4);
+        CHECK(conn && conn->interval == 0x140);
+
+        // a read is activity, the fast parameters come back
+        read_u16(phone, link, temp_h);
+        // the request and the update each wait for a connection event of the idle interval
+        world_run(1000);
+        CHECK(pdu_filter.count == 2);
+        CHECK(link->interval_ms == 0x0C * 5 / 4);
+        CHECK(conn && conn->interval == 0x0C);
+        world_phone_disconnect(phone, link);
+
+        phone->phone_reject_params = true;
+        pdu_filter.count = 0;
+        link = connect_phone(phone, node);
+        if (!link) {
+                return;
+        }
+        read_u16(phone, link, temp_h);
+        world_run(3 * CFG_CONN_IDLE_MS + 500);
+        conn = node_conn(node, link);
+        CHECK(pdu_filter.count >= 2);
+        CHECK(link->interval_ms == 30);
+        CHECK(conn && conn->interval == 0x18 && conn->params_req == 0);
+        CHECK(read_u16(phone, link, temp_h) == expected_temperature(&sensor_default));
+        CHECK(wdog_expiries(node) == 0);
+}
+
+/*
+ * A new connection gets the 2M PHY and the longest data length; a peer which does not
+ * answer the data length update is taken as refusing it after the setup timeout
+ */
+static void test_link_setup(void)
+{
+        const struct conn_entry *conn;
+        struct world_node *node, *phone;
+        struct world_link *link;
+
+        world_init(IMAGE, 5);
+        node = add_node(1, NULL);
+        phone = add_phone();
+        world_run(1000);
+        link = connect_phone(phone, node);
+        if (!link) {
+                return;
+        }
+        world_run(500);
+        conn = node_conn(node, link);
+        CHECK(conn != NULL);
+        if (conn) {
+                CHECK(conn->tx_phy == BLE_GAP_PHY_2M && conn->rx_phy == BLE_GAP_PHY_2M);
+                CHECK(conn->tx_octets == CFG_LINK_TX_OCTETS);
+                CHECK(!(conn->link_flags & (LINK_FLAG_PHY_REFUSED | LINK_FLAG_DLE_REFUSED | LINK_FLAG_DLE_PENDING)));
+        }
+        world_phone_disconnect(phone, link);
+
+        filter_init(0xFF, HOST_PDU_LENGTH_RSP);
+        link = connect_phone(phone, node);
+        if (!link) {
+                return;
+        }
+        world_run(CFG_LINK_SETUP_TIMEOUT_MS / 2);
+        conn = node_conn(node, link);
+        CHECK(pdu_filter.dropped == 1);
+        CHECK(conn && (conn->link_flags & LINK_FLAG_DLE_PENDING));
+        // the timeout check runs every CFG_LINK_SETUP_TIMEOUT_MS, the timeout is seen within two periods
+        world_run(2 * CFG_LINK_SETUP_TIMEOUT_MS);
+        CHECK(conn && !(conn->link_flags & LINK_FLAG_DLE_PENDING));
+        CHECK(conn && (conn->link_flags & LINK_FLAG_DLE_REFUSED));
+        CHECK(conn && conn->tx_octets == CONN_DEFAULT_OCTETS);
+        CHECK(wdog_expiries(node) == 0);
+}
+
+/*
+ * A sensor which does not answer leaves the last sample in place and the bus closed,
+ * sampling resumes when it answers again
+ */
+static void test_i2c_nack(void)
+{
+        struct host_hih6130 sensor = sensor_default;
+        struct world_node *node, *phone;
+        struct world_link *link;
+        uint16_t sequence, temp_h;
+
+        world_init(IMAGE, 6);
+        node = add_node(1, NULL);
+        phone = add_phone();
+        world_run(3000);
+        link = connect_phone(phone, node);
+        if (!link) {
+                return;
+        }
+        temp_h = world_phone_find_char(phone, link, NODE_DATA_ATTR_TEMP);
+        CHECK(node_sensor_data(node)->sequence > 0);
+
+        sensor.nack = true;
+        node->api.set_hih6130(&sensor);
+        world_run(1000);
+        sequence = node_sensor_data(node)->sequence;
+        world_run(5000);
+        CHECK(node_sensor_data(node)->sequence == sequence);
+        CHECK(node->api.i2c_open_count() == 0);
+        CHECK(read_u16(phone, link, temp_h) == expected_temperature(&sensor_default));
+
+        sensor.nack = false;
+        sensor.raw_temperature = raw_temperature(2600);
+        node->api.set_hih6130(&sensor);
+        world_run(40000);
+        CHECK(node_sensor_data(node)->sequence > sequence + 10);
+        CHECK(node->api.i2c_open_count() == 0);
+        CHECK(read_u16(phone, link, temp_h) == expected_temperature(&sensor));
+        CHECK(wdog_expiries(node) == 0);
+}
+
+/*
+ * A node made master scans, connects the nodes it finds, reads them and returns their
+ * values in its aggregate
+ */
+static void test_master(void)
+{
+        struct host_hih6130 sensors[3];
+        struct aggregate_entry entries[8];
+        struct world_node *master, *leaves[3], *phone;
+        struct world_link *link;
+        int i, count;
+
+        world_init(IMAGE, 7);
+        master = add_node(1, NULL);
+        for (i = 0; i < 3; i++) {
+                sensors[i] = sensor_default;
+                sensors[i].raw_temperature = raw_temperature(2000 + 100 * i);
+                leaves[i] = add_node(10 + i, &sensors[i]);
+        }
+        phone = add_phone();
+        world_run(3000);
+        link = connect_phone(phone, master);
+        if (!link) {
+                return;
+        }
+        make_master(phone, link);
+        CHECK(master->scanning);
+
+        // the discovery scan, then one connection after the other
+        world_run(20000);
+        for (i = 0; i < 3; i++) {
+                CHECK(world_find_link(master, leaves[i]) != NULL);
+                CHECK(world_find_link(master, leaves[i]) && world_find_link(master, leaves[i])->master == master);
+        }
+
+        // the first read starts a collection cycle, the next one returns its data
+        count = read_aggregate(phone, link, entries, ARRAY_LENGTH(entries));
+        CHECK(count == 3);
+        world_run(3000);
+        count = read_aggregate(phone, link, entries, ARRAY_LENGTH(entries));
+        CHECK(count == 3);
+        for (i = 0; i < 3; i++) {
+                const struct aggregate_entry *e = find_entry(entries, count, leaves[i]);
+
+                CHECK(e != NULL);
+                if (!e) {
+                        continue;
+                }
+                CHECK(e->flags & AGGREGATE_FLAG_CONNECTED);
+                CHECK(e->hops == 0);
+                CHECK((e->valid & (AGGREGATE_VALID_TEMPERATURE | AGGREGATE_VALID_HUMIDITY)) ==
+                        (AGGREGATE_VALID_TEMPERATURE | AGGREGATE_VALID_HUMIDITY));
+                CHECK((int16_t)e->temperature == expected_temperature(&sensors[i]));
+                CHECK(e->humidity == expected_humidity(&sensors[i]));
+        }
+
+        // a lost node leaves the connected state
+        world_link_loss(world_find_link(master, leaves[0]));
+        world_run(1000);
+        count = read_aggregate(phone, link, entries, ARRAY_LENGTH(entries));
+        CHECK(count >= 2);
+        CHECK(find_entry(entries, count, leaves[0]) == NULL ||
+                !(find_entry(entries, count, leaves[0])->flags & AGGREGATE_FLAG_CONNECTED));
+        CHECK(wdog_expiries(master) == 0);
+        for (i = 0; i < 3; i++) {
+                CHECK(wdog_expiries(leaves[i]) == 0);
+        }
+}
+
+/*
+ * A master collecting in windows (collect_sched.c) connects the known nodes in a
+ * window, reads them and disconnects them again
+ */
+static void test_collect_windows(void)
+{
+        struct host_hih6130 sensors[3];
+        struct aggregate_entry entries[8];
+        struct world_node *master, *leaves[3], *phone;
+        struct world_link *link;
+        int i, count;
+
+        world_init(IMAGE_WINDOWS, 8);
+        master = add_node(1, NULL);
+        for (i = 0; i < 3; i++) {
+                sensors[i] = sensor_default;
+                sensors[i].raw_temperature = raw_temperature(2000 + 100 * i);
+                leaves[i] = add_node(10 + i, &sensors[i]);
+        }
+        phone = add_phone();
+        world_run(3000);
+        link = connect_phone(phone, master);
+        if (!link) {
+                return;
+        }
+        make_master(phone, link);
+
+        // the discovery scan finds the nodes, the first window collects them
+        world_run(CFG_COLLECT_PERIOD_MS + 20000);
+        for (i = 0; i < 3; i++) {
+                CHECK(leaves[i]->links_up >= 1);
+                // released after the window
+                CHECK(world_find_link(master, leaves[i]) == NULL);
+        }
+        count = read_aggregate(phone, link, entries, ARRAY_LENGTH(entries));
+        CHECK(count == 3);
+        for (i = 0; i < 3; i++) {
+                const struct aggregate_entry *e = find_entry(entries, count, leaves[i]);
+
+                CHECK(e != NULL);
+                if (!e) {
+                        continue;
+                }
+                // read over a connection, which is closed again
+                CHECK(e->flags == AGGREGATE_FLAG_CONNECTED);
+                CHECK((int16_t)e->temperature == expected_temperature(&sensors[i]));
+        }
+
+        // the next window reads them again
+        sensors[1].raw_temperature = raw_temperature(3000);
+        leaves[1]->api.set_hih6130(&sensors[1]);
+        world_run(CFG_COLLECT_PERIOD_MS + 5000);
+        count = read_aggregate(phone, link, entries, ARRAY_LENGTH(entries));
+        CHECK(count == 3);
+        CHECK(find_entry(entries, count, leaves[1]) &&
+                (int16_t)find_entry(entries, count, leaves[1])->temperature == expected_temperature(&sensors[1]));
+        CHECK(wdog_expiries(master) == 0);
+}
+
+/*
+ * A master scanning through a crowd of advertisers keeps serving its peers and the
+ * watchdog; a burst of reports beyond the queue reserve is dropped, the other events
+ * still get through
+ */
+static void test_adv_storm(void)
+{
+        struct world_node *master, *phone, *crowd[40];
+        struct host_ble_stats before, stats;
+        struct world_link *link;
+        uint16_t temp_h;
+        int i;
+
+        world_init(IMAGE, 9);
+        master = add_node(1, NULL);
+        phone = add_phone();
+        world_run(1000);
+        link = connect_phone(phone, master);
+        if (!link) {
+                return;
+        }
+        temp_h = world_phone_find_char(phone, link, NODE_DATA_ATTR_TEMP);
+        for (i = 0; i < (int)ARRAY_LENGTH(crowd); i++) {
+                crowd[i] = add_node(100 + i, NULL);
+        }
+        world_set_adv_interval(20);
+        make_master(phone, link);
+        world_run(10000);
+        master->api.get_stats(&stats);
+        CHECK(master->adv_reports > 5000);
+        CHECK(stats.max_held == 0);
+        CHECK(read_u16(phone, link, temp_h) == expected_temperature(&sensor_default));
+        // the connection table holds the phone and the nodes which fit
+        CHECK(world_node_links(master) == CONN_TABLE_SIZE);
+        CHECK(wdog_expiries(master) == 0);
+
+        // a burst while the BLE task does not run: only the reports beyond the reserve are lost
+        for (i = 0; i < 600 && !master->scanning; i++) {
+                world_run(100);
+        }
+        CHECK(master->scanning);
+        master->api.get_stats(&before);
+        for (i = 0; i < 100; i++) {
+                master->api.adv_report(&crowd[i % ARRAY_LENGTH(crowd)]->addr, -70, false, crowd[0]->ad,
+                        crowd[0]->ad_len);
+        }
+        master->api.get_stats(&stats);
+        CHECK(stats.adv_dropped - before.adv_dropped == 100 - (HOST_BLE_EVT_QUEUE_LEN - HOST_BLE_EVT_RESERVED));
+        CHECK(stats.max_queued >= HOST_BLE_EVT_QUEUE_LEN - HOST_BLE_EVT_RESERVED);
+        CHECK(stats.max_queued <= HOST_BLE_EVT_QUEUE_LEN);
+        world_run(1000);
+        CHECK(read_u16(phone, link, temp_h) == expected_temperature(&sensor_default));
+        CHECK(wdog_expiries(master) == 0);
+}
+
+/*
+ * A master whose own nodes and the nodes of a relaying master add up to more than
+ * AGGREGATE_MAX_ENTRIES keeps that many: its own nodes, then relayed ones, and its
+ * frames stay within one attribute value
+ */
+static void test_aggregate_cap(void)
+{
+        static uint8_t frame[HOST_ATT_VALUE_MAX];
+        struct aggregate_entry entries[AGGREGATE_MAX_ENTRIES];
+        struct world_node *top, *relay, *own[10], *far[16], *phone;
+        struct world_link *link;
+        uint16_t data_h, len = 0, generation;
+        uint8_t base[2];
+        int i, j, count;
+
+        world_init(IMAGE_WINDOWS, 10);
+        top = add_node(1, NULL);
+        relay = add_node(2, NULL);
+        for (i = 0; i < (int)ARRAY_LENGTH(own); i++) {
+                own[i] = add_node(10 + i, NULL);
+                world_set_range(own[i], relay, false);
+        }
+        for (i = 0; i < (int)ARRAY_LENGTH(far); i++) {
+                far[i] = add_node(100 + i, NULL);
+                world_set_range(far[i], top, false);
+                for (j = 0; j < (int)ARRAY_LENGTH(own); j++) {
+                        world_set_range(far[i], own[j], false);
+                }
+        }
+        phone = add_phone();
+        world_run(3000);
+
+        link = connect_phone(phone, relay);
+        if (!link) {
+                return;
+        }
+        make_master(phone, link);
+        world_phone_disconnect(phone, link);
+        link = connect_phone(phone, top);
+        if (!link) {
+                return;
+        }
+        make_master(phone, link);
+        data_h = world_phone_find_char(phone, link, NODE_MASTER_ATTR_DATA);
+
+        // the relay's window, then the top's window reading the relay's aggregate
+        world_run(3 * CFG_COLLECT_PERIOD_MS);
+        count = read_aggregate(phone, link, entries, ARRAY_LENGTH(entries));
+        CHECK(count == AGGREGATE_MAX_ENTRIES);
+        // its own nodes keep their place, read directly
+        for (i = 0; i < (int)ARRAY_LENGTH(own); i++) {
+                const struct aggregate_entry *e = find_entry(entries, count, own[i]);
+
+                CHECK(e && e->hops == 0 && e->flags == AGGREGATE_FLAG_CONNECTED);
+        }
+        CHECK(find_entry(entries, count, relay) && find_entry(entries, count, relay)->hops == 0);
+        CHECK(find_entry(entries, count, top) == NULL);
+        for (i = 0; i < count; i++) {
+                CHECK(entries[i].hops == 0 || (entries[i].flags & AGGREGATE_FLAG_RELAYED));
+                for (j = i + 1; j < count; j++) {
+                        CHECK(memcmp(entries[i].addr, entries[j].addr, sizeof(entries[i].addr)));
+                }
+        }
+
+        // a full frame is as long as an attribute value gets, a delta frame no longer
+        CHECK(world_phone_read_long(phone, link, data_h, frame, &len) == ATT_ERROR_OK);
+        CHECK(len == AGGREGATE_HDR_LEN + AGGREGATE_MAX_ENTRIES * AGGREGATE_ENTRY_LEN);
+        CHECK(len <= AGGREGATE_MAX_LEN);
+        generation = get_le16(&frame[2]);
+        world_run(CFG_COLLECT_PERIOD_MS);
+        base[0] = generation & 0xFF;
+        base[1] = generation >> 8;
+        CHECK(world_phone_write(phone, link, data_h, base, sizeof(base)) == ATT_ERROR_OK);
+        CHECK(world_phone_read_long(phone, link, data_h, frame, &len) == ATT_ERROR_OK);
+        CHECK(len > 0 && len <= AGGREGATE_MAX_LEN);
+        CHECK(wdog_expiries(top) == 0);
+        CHECK(wdog_expiries(relay) == 0);
+}
+
+/*
+ * Two masters in range collect each other in their windows, aligned to the same
+ * epochs: they connect each other at the same time now and then, and the link they
+ * get twice must not stay up
+ */
+static void test_mutual_masters(void)
+{
+        struct aggregate_entry entries[AGGREGATE_MAX_ENTRIES];
+        struct world_node *masters[2], *phone;
+        struct world_link *link;
+        int i, count, idle = 0;
+
+        world_init(IMAGE_WINDOWS, 11);
+        masters[0] = add_node(1, NULL);
+        masters[1] = add_node(2, NULL);
+        phone = add_phone();
+        world_run(3000);
+
+        for (i = 0; i < 2; i++) {
+                link = connect_phone(phone, masters[i]);
+                if (!link) {
+                        return;
+                }
+                make_master(phone, link);
+                world_phone_disconnect(phone, link);
+        }
+
+        // windows last well below a second here, the masters are idle most of a period
+        world_run(5 * CFG_COLLECT_PERIOD_MS);
+        for (i = 0; i < CFG_COLLECT_PERIOD_MS / 1000; i++) {
+                world_run(1000);
+                idle += world_node_links(masters[0]) == 0 && world_node_links(masters[1]) == 0;
+        }
+        CHECK(idle > 0);
+        CHECK(world_get_stats()->links_up > 6);
+
+        for (i = 0; i < 2; i++) {
+                link = connect_phone(phone, masters[i]);
+                if (!link) {
+                        return;
+                }
+                count = read_aggregate(phone, link, entries, ARRAY_LENGTH(entries));
+                CHECK(count == 1 && find_entry(entries, count, masters[!i]) != NULL);
+                world_phone_disconnect(phone, link);
+                CHECK(wdog_expiries(masters[i]) == 0);
+        }
+}
+
+struct scenario {
+        const char *name;
+        void (*run)(void);
+};
+
+static const struct scenario scenarios[] = {
+        { "boot and discovery", test_boot_and_discovery },
+        { "sensor read", test_sensor_read },
+        { "notifications", test_notifications },
+        { "connection parameters", test_conn_params },
+        { "link setup", test_link_setup },
+        { "i2c nack", test_i2c_nack },
+        { "master", test_master },
+        { "collection windows", test_collect_windows },
+        { "adv storm", test_adv_storm },
+        { "aggregate cap", test_aggregate_cap },
+        { "mutual masters", test_mutual_masters },
+};
+
+int main(int argc, char **argv)
+{
+        bool verbose = (argc > 1 && !strcmp(argv[1], "-v"));
+        const char *only = NULL;
+        int crashed = 0;
+        size_t i;
+
+        if (argc > 1 + verbose) {
+                only = argv[1 + verbose];
+        }
+
+        counters = mmap(NULL, sizeof(*counters), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (counters == MAP_FAILED) {
+                perror("mmap");
+                return 2;
+        }
+
+        for (i = 0; i < ARRAY_LENGTH(scenarios); i++) {
+                int status;
+                pid_t pid;
+
+                if (only && !strstr(scenarios[i].name, only)) {
+                        continue;
+                }
+                fflush(stdout);
+                pid = fork();
+                if (pid < 0) {
+                        perror("fork");
+                        return 2;
+                }
+                if (pid == 0) {
+                        if (!verbose) {
+                                int null = open("/dev/null", O_WRONLY);
+
+                                dup2(null, STDOUT_FILENO);
+                        }
+                        scenarios[i].run();
+                        fflush(stdout);
+                        _exit(0);
+                }
+                waitpid(pid, &status, 0);
+                if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                        fprintf(stderr, "%s: crashed (status 0x%x)\n", scenarios[i].name, status);
+                        crashed++;
+                }
+        }
+
+        printf("%d checks, %d failed, %d scenarios crashed\n", counters->checks, counters->failures,
+                crashed);
+
+        return (counters->failures || crashed) ? 1 : 0;
+}
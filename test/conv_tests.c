@@ -0,0 +1,290 @@
+/*
+ * conv_tests.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Tests and benchmark of the fixed-point conversion kernels and the calibration
+ * tables (sensor_conversion.c, sensor_calib_tables.h).
+ *
+ * The kernels are checked against the original division for every 14-bit input
+ * of the HIH6130, calib_apply() against a 64-bit reference interpolation over the
+ * whole input range of the generated tables and of a nonlinear table. The makefile
+ * also checks that sensor_calib_tables.h is what tools/gen_calib_tables.py gives.
+ *
+ * With -b the conversions of a sample are timed instead: the kernels, the
+ * original division and the calibration of the converted values.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sensor_calib_tables.h"
+#include "sensor_conversion.h"
+
+#define BENCH_DEFAULT_ROUNDS            (2000)
+#define HIH_RAW_VALUES                  (1 << 14)
+
+static int checks;
+static int failures;
+
+#define CHECK(expr)                                                                     \
+        do {                                                                            \
+                checks++;                                                               \
+                if (!(expr)) {                                                          \
+                        failures++;                                                     \
+                        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+                }                                                                       \
+        } while (0)
+
+/* A probe curve: falling, flat and steep segments, negative values */
+static const int16_t calib_probe_y[12] = {
+        -500, -180, 0, 0, 900, 3100, 6500, 7000, 6900, 8800, 9990, 10000,
+};
+
+static const struct calib_table calib_probe = {
+        .x0     = -1000,
+        .shift  = 9,
+        .num    = 12,
+        .y      = calib_probe_y,
+};
+
+/* The divisor the compiler cannot turn into a multiplication */
+static volatile uint32_t hih_divisor = 16382;
+
+static uint16_t ref_humidity(uint32_t raw)
+{
+        return (uint16_t)((raw * 10000) / 16382);
+}
+
+static int16_t ref_temperature(uint32_t raw)
+{
+        return (int16_t)(((raw * 16500) / 16382) - 4000);
+}
+
+/* Linear interpolation with floor rounding, in 64 bits */
+static int32_t ref_calib(const struct calib_table *tbl, int32_t x)
+{
+        int64_t step = (int64_t)1 << tbl->shift;
+        int64_t dx = (int64_t)x - tbl->x0;
+        int64_t k, num, r;
+
+        if (dx <= 0) {
+                return tbl->y[0];
+        }
+        k = dx / step;
+        if (k >= tbl->num - 1) {
+                return tbl->y[tbl->num - 1];
+        }
+
+        num = (int64_t)(tbl->y[k + 1] - tbl->y[k]) * (dx - k * step);
+        r = num / step;
+        if (num % step != 0 && num < 0) {
+                r--;
+        }
+
+        return tbl->y[k] + r;
+}
+
+/* Inputs where calib_apply() differs from the reference, from below the table to past its end */
+static int calib_mismatches(const struct calib_table *tbl)
+{
+        int32_t end = tbl->x0 + ((tbl->num - 1) << tbl->shift);
+        int32_t x;
+        int bad = 0;
+
+        for (x = tbl->x0 - 1000; x <= end + 1000; x++) {
+                if (calib_apply(tbl, x) != ref_calib(tbl, x)) {
+                        bad++;
+                }
+        }
+
+        return bad;
+}
+
+/*
+ * The fixed-point kernels must give the result of the original division for
+ * every 14-bit input of the HIH6130
+ */
+static void test_kernels(void)
+{
+        uint32_t raw;
+        int bad_humidity = 0;
+        int bad_temperature = 0;
+
+        for (raw = 0; raw < HIH_RAW_VALUES; raw++) {
+                if (conv_hih_humidity(raw) != ref_humidity(raw)) {
+                        bad_humidity++;
+                }
+                if (conv_hih_temperature(raw) != ref_temperature(raw)) {
+                        bad_temperature++;
+                }
+        }
+        CHECK(bad_humidity == 0);
+        CHECK(bad_temperature == 0);
+
+        // the sensor range ends
+        CHECK(conv_hih_humidity(0) == 0);
+        CHECK(conv_hih_humidity(16382) == 10000);
+        CHECK(conv_hih_temperature(0) == -4000);
+        CHECK(conv_hih_temperature(16382) == 12500);
+
+        // the status bits above the 14-bit value are ignored
+        CHECK(conv_hih_humidity(0xC000 | 8191) == conv_hih_humidity(8191));
+        CHECK(conv_hih_temperature(0xC000 | 8191) == conv_hih_temperature(8191));
+}
+
+static void test_calibration(void)
+{
+        int32_t x;
+        int bad_humidity = 0;
+        int bad_temperature = 0;
+
+        // the HIH6130 tables are identities over the sensor range
+        for (x = 0; x <= 10000; x++) {
+                if (calib_apply(&calib_hih_humidity, x) != x) {
+                        bad_humidity++;
+                }
+        }
+        for (x = -4000; x <= 12500; x++) {
+                if (calib_apply(&calib_hih_temperature, x) != x) {
+                        bad_temperature++;
+                }
+        }
+        CHECK(bad_humidity == 0);
+        CHECK(bad_temperature == 0);
+
+        CHECK(calib_mismatches(&calib_hih_humidity) == 0);
+        CHECK(calib_mismatches(&calib_hih_temperature) == 0);
+        CHECK(calib_mismatches(&calib_water) == 0);
+        CHECK(calib_mismatches(&calib_probe) == 0);
+
+        // the breakpoints themselves, the segments rounding down between them
+        CHECK(calib_apply(&calib_probe, -1000 + 4 * 512) == 900);
+        CHECK(calib_apply(&calib_probe, -1000 + 7 * 512 + 256) == 6950);
+        CHECK(calib_apply(&calib_probe, -1000 + 7 * 512 + 1) == 6999);
+
+        // the water table maps the 14-bit raw range onto 0.00-100.00 %
+        CHECK(calib_apply(&calib_water, 0) == 0);
+        CHECK(calib_apply(&calib_water, 16383) == 10000);
+
+        // clamped outside of the table, no table is the identity
+        CHECK(calib_apply(&calib_water, -100) == calib_water_y[0]);
+        CHECK(calib_apply(&calib_water, 100000) == calib_water_y[calib_water.num - 1]);
+        CHECK(calib_apply(&calib_probe, -1000000) == calib_probe_y[0]);
+        CHECK(calib_apply(&calib_probe, 1000000) == calib_probe_y[calib_probe.num - 1]);
+        CHECK(calib_apply(NULL, 12345) == 12345);
+}
+
+static double now_s(void)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_report(const char *name, double elapsed, unsigned long n)
+{
+        printf("%-28s %8.2f ns per value\n", name, elapsed * 1e9 / n);
+}
+
+/* Every 14-bit input, \p rounds times over */
+static int run_bench(unsigned long rounds)
+{
+        unsigned long n = rounds * HIH_RAW_VALUES;
+        volatile uint32_t sink = 0;
+        unsigned long r;
+        uint32_t raw, div;
+        uint32_t acc;
+        double start;
+
+        start = now_s();
+        for (r = 0, acc = 0; r < rounds; r++) {
+                for (raw = 0; raw < HIH_RAW_VALUES; raw++) {
+                        acc += conv_hih_humidity(raw) + conv_hih_temperature(raw);
+                }
+        }
+        sink += acc;
+        bench_report("kernels", now_s() - start, 2 * n);
+
+        start = now_s();
+        for (r = 0, acc = 0; r < rounds; r++) {
+                div = hih_divisor;
+                for (raw = 0; raw < HIH_RAW_VALUES; raw++) {
+                        acc += (raw * 10000) / div + ((raw * 16500) / div) - 4000;
+                }
+        }
+        sink += acc;
+        bench_report("division", now_s() - start, 2 * n);
+
+        start = now_s();
+        for (r = 0, acc = 0; r < rounds; r++) {
+                for (raw = 0; raw < HIH_RAW_VALUES; raw++) {
+                        acc += calib_apply(&calib_hih_humidity, conv_hih_humidity(raw)) +
+                                calib_apply(&calib_hih_temperature, conv_hih_temperature(raw));
+                }
+        }
+        sink += acc;
+        bench_report("kernels and calibration", now_s() - start, 2 * n);
+
+        start = now_s();
+        for (r = 0, acc = 0; r < rounds; r++) {
+                for (raw = 0; raw < HIH_RAW_VALUES; raw++) {
+                        acc += calib_apply(&calib_water, raw);
+                }
+        }
+        sink += acc;
+        bench_report("water calibration", now_s() - start, n);
+
+        return sink == 0xFFFFFFFF;
+}
+
+static void usage(const char *prog)
+{
+        fprintf(stderr,
+                "usage: %s [-b] [-n rounds] [-h]\n"
+                "Checks the conversion kernels and calibration tables, -b times them instead\n"
+                "over every 14-bit input, -n times over.\n", prog);
+}
+
+int main(int argc, char **argv)
+{
+        unsigned long rounds = BENCH_DEFAULT_ROUNDS;
+        bool bench = false;
+        int opt;
+
+        while ((opt = getopt(argc, argv, "bn:h")) != -1) {
+                switch (opt) {
+                case 'b':
+                        bench = true;
+                        break;
+                case 'n':
+                        rounds = strtoul(optarg, NULL, 0);
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return 0;
+                default:
+                        usage(argv[0]);
+                        return 2;
+                }
+        }
+
+        if (bench) {
+                return run_bench(rounds);
+        }
+
+        test_kernels();
+        test_calibration();
+
+        printf("%d checks, %d failed\n", checks, failures);
+
+        return failures ? 1 : 0;
+}
@@ -0,0 +1,818 @@
+/*
+ * fleet_sim.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Fleet simulator: one master collecting a fleet of nodes, every one of them
+ * running the firmware on the SDK stand-ins in the radio world of fleet_world.c.
+ *
+ * The master runs the collection windows of collect_sched.c (libnode_windows.so):
+ * it finds the nodes with its discovery scan, then connects them in batches every
+ * period, reads their records and releases them. Broadcasting nodes run
+ * libnode_broadcast.so and are read from their advertising. A phone connected to
+ * the master makes it a master and, once per period after the window, writes the
+ * generation it got last and reads a delta frame, then reads the full aggregate;
+ * both come from get_node_data_cb() of the master, as over the air.
+ *
+ * With relays (-r) the fleet has three tiers: the nodes are out of range of the
+ * master, each in range of one relaying master, every tenth one of two. The relays
+ * are in range of the master and of each other, so they read each other's
+ * aggregates too and the master gets most nodes on more than one path. The node
+ * lists of the relays and of the master overflow (AGGREGATE_MAX_ENTRIES), their
+ * frames are checked for duplicate nodes, the reader's own address, hop counts
+ * below the shortest path and values the nodes never had.
+ *
+ * Every node reads a temperature of its own from its HIH6130 model, changed each
+ * period; an entry counts as collected when it carries the value of the period.
+ * PDUs are lost at the configured rate per connection event and retransmitted at
+ * the next one, 6 losses in a row are a supervision timeout (fleet_world.c).
+ *
+ * The first window is not counted: the nodes are found by the discovery scan and
+ * synced to the fleet clock in it. Relayed data takes a period per tier more.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "fleet_world.h"
+#include "ble_bluetanist_common.h"
+#include "node_aggregate.h"
+#include "sensor_calib_tables.h"
+#include "sensor_conversion.h"
+
+#define SIM_IMAGE_WINDOWS               "./libnode_windows.so"
+#define SIM_IMAGE_BROADCAST             "./libnode_broadcast.so"
+
+/* Nodes and relays, besides the master and the phone */
+#define SIM_MAX_NODES                   (WORLD_MAX_NODES - 2)
+#define SIM_MAX_RELAYS                  (8)
+
+/* Time after the master is set up in which the first window has to complete */
+#define SIM_FIRST_WINDOW_MS             (3 * CFG_COLLECT_PERIOD_MS)
+
+/* Values of a node, the one of the period first; they repeat every 8 periods, these are all */
+#define SIM_VALUE_HISTORY               (8)
+
+struct sim_config {
+        uint16_t nodes;
+        uint8_t relays;                 /* relaying masters between the master and the nodes */
+        uint8_t loss_pct;               /* per PDU and connection event */
+        uint8_t broadcast_pct;          /* nodes broadcasting their record instead of being read */
+        uint16_t cycles;
+        uint32_t seed;
+        bool quiet;
+        bool verbose;                   /* firmware log on stdout */
+};
+
+struct vnode {
+        struct world_node *node;
+        struct host_hih6130 sensor;
+        int16_t values[SIM_VALUE_HISTORY];
+        uint8_t num_values;
+        bool broadcast;
+        bool relay;
+        bool direct;                    /* in range of the master */
+        /* relays in range of a node behind them, -1 if none */
+        int8_t home;
+        int8_t second;
+        /* state of the current window */
+        bool connected;
+        bool released;
+};
+
+struct node_stats {
+        uint32_t age_sum;
+        uint32_t age_max;
+        uint32_t ages;
+        uint32_t missed;
+};
+
+struct sim_stats {
+        uint32_t windows;
+        uint32_t incomplete;            /* windows in which not every node was read */
+        uint32_t ttfa_min;
+        uint32_t ttfa_max;
+        uint64_t ttfa_sum;
+        uint32_t duration_max;          /* first connection to last release of a window */
+        uint64_t duration_sum;
+        uint32_t pdus;                  /* on the links of the master to the nodes */
+        uint32_t retransmissions;
+        uint32_t links_lost;
+        uint32_t collected;
+        uint32_t expected;
+        uint32_t entries;
+        uint32_t relay_entries;         /* in the aggregates of the relays at the end */
+        uint32_t full_bytes;
+        uint32_t delta_bytes;
+        uint32_t read_errors;
+        uint32_t decode_errors;
+        /* merge checks of the frames */
+        uint32_t hops_shortest;         /* relayed entries on the shortest path */
+        uint32_t hops_longer;
+        uint32_t hops_wrong;            /* below the shortest path, or flagged relayed without hops */
+        uint32_t duplicates;
+        uint32_t own;                   /* the reader's own address */
+        uint32_t unknown;
+        uint32_t stale;                 /* the value of an earlier period */
+        uint32_t wrong_values;
+};
+
+static struct sim_config cfg;
+static struct sim_stats stats;
+static struct node_stats *node_stats;
+static struct vnode *vnodes;
+static int num_vnodes;
+static struct world_node *master;
+/* the firmware prints its log on stdout, the report has a stream of its own */
+static FILE *out;
+
+/* Window in progress, seen from the links of the master */
+static struct {
+        bool counted;
+        bool started;
+        bool complete;
+        uint32_t start;
+        uint32_t end;                   /* last release */
+        uint16_t pending;               /* nodes to read in the window */
+} window;
+
+static uint32_t rng_state;
+
+static uint32_t rng(void)
+{
+        rng_state = rng_state * 1103515245 + 12345;
+
+        return (rng_state >> 16) & 0x7FFF;
+}
+
+static bd_address_t node_addr(int n)
+{
+        bd_address_t addr = {
+                .addr_type = PUBLIC_ADDRESS,
+                .addr = { n & 0xFF, (n >> 8) & 0xFF, 0x00, 0x90, 0x06, 0x42 },
+        };
+
+        return addr;
+}
+
+/* Raw HIH6130 temperature of a temperature in 0.01 C */
+static uint16_t raw_temperature(int32_t centi)
+{
+        return (centi + 4000) * 16382 / 16500;
+}
+
+/* Value a node publishes for its HIH6130 reading, in 0.01 C */
+static int16_t expected_temperature(const struct host_hih6130 *sensor)
+{
+        return calib_apply(&calib_hih_temperature, conv_hih_temperature(sensor->raw_temperature));
+}
+
+static struct vnode *vnode_of(const struct world_node *node)
+{
+        int i;
+
+        for (i = 0; i < num_vnodes; i++) {
+                if (vnodes[i].node == node) {
+                        return &vnodes[i];
+                }
+        }
+
+        return NULL;
+}
+
+static struct vnode *vnode_by_addr(const uint8_t *addr)
+{
+        int i;
+
+        for (i = 0; i < num_vnodes; i++) {
+                if (!memcmp(vnodes[i].node->addr.addr, addr, sizeof(vnodes[i].node->addr.addr))) {
+                        return &vnodes[i];
+                }
+        }
+
+        return NULL;
+}
+
+static void window_reset(void)
+{
+        int i;
+
+        memset(&window, 0, sizeof(window));
+        for (i = 0; i < num_vnodes; i++) {
+                vnodes[i].connected = false;
+                vnodes[i].released = false;
+                window.pending += vnodes[i].direct && !vnodes[i].broadcast;
+        }
+}
+
+/* Links of the master to the nodes mark the progress of the window */
+static void link_hook(const struct world_link *link, bool up)
+{
+        struct vnode *v;
+
+        if (link->master != master || !(v = vnode_of(link->slave))) {
+                return;
+        }
+
+        if (up) {
+                if (!window.started) {
+                        window.started = true;
+                        window.start = world_now();
+                }
+                v->connected = true;
+                return;
+        }
+
+        if (window.counted) {
+                stats.pdus += link->pdus;
+                if (link->losses >= WORLD_SUPERVISION_EVENTS) {
+                        stats.links_lost++;
+                }
+        }
+        if (!v->connected || v->released) {
+                return;
+        }
+        v->released = true;
+        window.end = world_now();
+        if (--window.pending == 0 && !window.complete) {
+                uint32_t ttfa = world_now() - window.start;
+
+                window.complete = true;
+                if (!window.counted) {
+                        return;
+                }
+                if (ttfa < stats.ttfa_min) {
+                        stats.ttfa_min = ttfa;
+                }
+                if (ttfa > stats.ttfa_max) {
+                        stats.ttfa_max = ttfa;
+                }
+                stats.ttfa_sum += ttfa;
+        }
+}
+
+static void set_sensor(struct vnode *v, int32_t centi)
+{
+        memmove(&v->values[1], &v->values[0], (SIM_VALUE_HISTORY - 1) * sizeof(v->values[0]));
+        v->sensor.raw_temperature = raw_temperature(centi);
+        v->values[0] = expected_temperature(&v->sensor);
+        if (v->num_values < SIM_VALUE_HISTORY) {
+                v->num_values++;
+        }
+}
+
+/*
+ * Periods since a node had a value, -1 if it never had it. The sensor filter of the
+ * node moves its output from one value to the next over some samples, a value in
+ * between counts as the older one.
+ */
+static int value_age(const struct vnode *v, int16_t value)
+{
+        int j;
+
+        for (j = 0; j < v->num_values; j++) {
+                if (value == v->values[j]) {
+                        return j;
+                }
+                if (j + 1 < v->num_values && (value - v->values[j]) * (value - v->values[j + 1]) < 0) {
+                        return j + 1;
+                }
+        }
+
+        return -1;
+}
+
+/* Give every node a new temperature for the next window */
+static void change_sensors(uint16_t cycle)
+{
+        int i;
+
+        for (i = 0; i < num_vnodes; i++) {
+                set_sensor(&vnodes[i], 1500 + 10 * i + 100 * (cycle % 8));
+                vnodes[i].node->api.set_hih6130(&vnodes[i].sensor);
+        }
+}
+
+/*
+ * Fewest relays between a reader and a node, NULL for the master: none if the reader
+ * is in range of it. The relays are in range of the master and of each other.
+ */
+static uint8_t shortest_hops(const struct world_node *reader, const struct vnode *v)
+{
+        const struct vnode *r = vnode_of(reader);
+
+        if (!v || v->relay || (v->direct && reader == master)) {
+                return 0;
+        }
+        if (r && (r - vnodes == v->home || r - vnodes == v->second)) {
+                return 0;
+        }
+
+        return 1;
+}
+
+/*
+ * Check the aggregate of a reader: every node once, not the reader itself, on no
+ * path shorter than there is, with a value the node had. A node in range may come on
+ * a longer path, when the reader could not connect it or its scan table is full.
+ */
+static void check_entries(const struct world_node *reader, const struct aggregate_entry *entries, int count)
+{
+        int i, j;
+
+        for (i = 0; i < count; i++) {
+                const struct aggregate_entry *e = &entries[i];
+                const struct vnode *v = vnode_by_addr(e->addr);
+                uint8_t hops;
+                int age;
+
+                for (j = i + 1; j < count; j++) {
+                        stats.duplicates += !memcmp(e->addr, entries[j].addr, sizeof(e->addr));
+                }
+                if (!memcmp(e->addr, reader->addr.addr, sizeof(e->addr))) {
+                        stats.own++;
+                        continue;
+                }
+                // besides the nodes only the master, in the aggregates of the relays
+                if (!v && memcmp(e->addr, master->addr.addr, sizeof(e->addr))) {
+                        stats.unknown++;
+                        continue;
+                }
+
+                hops = shortest_hops(reader, v);
+                if (e->hops < hops || !(e->flags & AGGREGATE_FLAG_RELAYED) != !e->hops) {
+                        stats.hops_wrong++;
+                } else if (e->hops > hops) {
+                        stats.hops_longer++;
+                } else if (e->hops) {
+                        stats.hops_shortest++;
+                }
+
+                if (!v || !(e->valid & AGGREGATE_VALID_TEMPERATURE)) {
+                        continue;
+                }
+                age = value_age(v, (int16_t) e->temperature);
+                if (age < 0) {
+                        stats.wrong_values++;
+                } else if (age) {
+                        stats.stale++;
+                }
+        }
+}
+
+static const struct aggregate_entry *find_entry(const struct aggregate_entry *entries, int count,
+        const struct world_node *node)
+{
+        int i;
+
+        for (i = 0; i < count; i++) {
+                if (!memcmp(entries[i].addr, node->addr.addr, sizeof(entries[i].addr))) {
+                        return &entries[i];
+                }
+        }
+
+        return NULL;
+}
+
+/*
+ * Read and decode the full aggregate of the node a phone is connected to
+ *
+ * \return number of entries, -1 if the frame could not be read or decoded
+ */
+static int read_frame(struct world_node *phone, struct world_link *link, uint16_t data_h,
+        struct aggregate_entry *entries, uint16_t *generation)
+{
+        static uint8_t frame[HOST_ATT_VALUE_MAX];
+        uint16_t len = 0;
+        uint32_t timestamp;
+        uint8_t count;
+        int i;
+
+        if (world_phone_read_long(phone, link, data_h, frame, &len) != ATT_ERROR_OK) {
+                stats.read_errors++;
+                return -1;
+        }
+        if (!aggregate_decode_header(frame, len, &count, generation, &timestamp) ||
+                len != AGGREGATE_HDR_LEN + count * AGGREGATE_ENTRY_LEN) {
+                stats.decode_errors++;
+                return -1;
+        }
+        for (i = 0; i < count; i++) {
+                aggregate_decode_entry(frame + AGGREGATE_HDR_LEN + i * AGGREGATE_ENTRY_LEN, &entries[i]);
+        }
+
+        return count;
+}
+
+/*
+ * Read the delta frame against the generation read last, then the full frame, and
+ * check the full frame against the values of the nodes
+ */
+static void read_aggregate(struct world_node *phone, struct world_link *link, uint16_t data_h,
+        uint16_t *generation)
+{
+        static uint8_t frame[HOST_ATT_VALUE_MAX];
+        static struct aggregate_entry entries[AGGREGATE_MAX_ENTRIES];
+        uint8_t base[2] = { *generation & 0xFF, *generation >> 8 };
+        uint16_t len = 0;
+        int i, count;
+
+        if (*generation && world_phone_write(phone, link, data_h, base, sizeof(base)) == ATT_ERROR_OK &&
+                world_phone_read_long(phone, link, data_h, frame, &len) == ATT_ERROR_OK) {
+                stats.delta_bytes += len;
+        }
+
+        count = read_frame(phone, link, data_h, entries, generation);
+        if (count < 0) {
+                return;
+        }
+        stats.full_bytes += AGGREGATE_HDR_LEN + count * AGGREGATE_ENTRY_LEN;
+        stats.entries += count;
+        check_entries(master, entries, count);
+
+        for (i = 0; i < num_vnodes; i++) {
+                const struct aggregate_entry *e = find_entry(entries, count, vnodes[i].node);
+                struct node_stats *ns = &node_stats[i];
+
+                stats.expected++;
+                if (!e || !(e->valid & AGGREGATE_VALID_TEMPERATURE) || (int16_t)e->temperature != vnodes[i].values[0]) {
+                        ns->missed++;
+                        continue;
+                }
+                stats.collected++;
+                ns->age_sum += e->age;
+                ns->ages++;
+                if (e->age > ns->age_max) {
+                        ns->age_max = e->age;
+                }
+        }
+}
+
+/* Read and check the aggregate of a relay once */
+static void check_relay(struct world_node *phone, const struct vnode *relay)
+{
+        static struct aggregate_entry entries[AGGREGATE_MAX_ENTRIES];
+        // a relay with all connections in use does not advertise, until its window is over
+        struct world_link *link = world_phone_connect(phone, relay->node, CFG_COLLECT_PERIOD_MS);
+        uint16_t data_h, generation;
+        int count;
+
+        if (!link || !world_phone_exchange_mtu(phone, link) ||
+                !(data_h = world_phone_find_char(phone, link, NODE_MASTER_ATTR_DATA))) {
+                stats.read_errors++;
+                return;
+        }
+        count = read_frame(phone, link, data_h, entries, &generation);
+        if (count >= 0) {
+                stats.relay_entries += count;
+                check_entries(relay->node, entries, count);
+        }
+        world_phone_disconnect(phone, link);
+}
+
+static bool merge_errors(void)
+{
+        return stats.duplicates || stats.own || stats.unknown || stats.hops_wrong || stats.wrong_values;
+}
+
+static void report(void)
+{
+        uint32_t n = stats.windows ? stats.windows : 1;
+        uint32_t complete = stats.windows - stats.incomplete;
+        uint16_t i, broadcast = 0;
+
+        for (i = 0; i < num_vnodes; i++) {
+                broadcast += vnodes[i].broadcast;
+        }
+
+        if (cfg.relays) {
+                fprintf(out, "fleet: %u nodes behind %u relays, batches of %u, loss %u%%\n", cfg.nodes,
+                                cfg.relays, CFG_COLLECT_BATCH_SIZE, cfg.loss_pct);
+        } else {
+                fprintf(out, "fleet: %u nodes (%u broadcasting), batches of %u, loss %u%%\n", cfg.nodes,
+                                broadcast, CFG_COLLECT_BATCH_SIZE, cfg.loss_pct);
+        }
+        fprintf(out, "  windows:                  %lu counted, %lu incomplete\n", (unsigned long) stats.windows,
+                                                                        (unsigned long) stats.incomplete);
+        fprintf(out, "  time to full aggregate:   min %lu, avg %lu, max %lu ms\n",
+                        (unsigned long)(complete ? stats.ttfa_min : 0),
+                        (unsigned long)(complete ? stats.ttfa_sum / complete : 0), (unsigned long) stats.ttfa_max);
+        fprintf(out, "  window duration:          avg %lu, max %lu ms\n", (unsigned long)(stats.duration_sum / n),
+                                                                        (unsigned long) stats.duration_max);
+        fprintf(out, "  PDUs per cycle:           %.1f, %.1f retransmissions, %lu links lost\n",
+                        (double) stats.pdus / n, (double) stats.retransmissions / n, (unsigned long) stats.links_lost);
+        fprintf(out, "  nodes collected:          %.1f of %.1f per cycle, %.1f entries\n",
+                        (double) stats.collected / n, (double) stats.expected / n, (double) stats.entries / n);
+        fprintf(out, "  aggregate frame:          %.0f bytes full, %.0f bytes delta\n", (double) stats.full_bytes / n,
+                                                                        (double) stats.delta_bytes / n);
+        if (cfg.relays) {
+                fprintf(out, "  relay aggregates:         %.1f entries\n", (double) stats.relay_entries / cfg.relays);
+                fprintf(out, "  relayed entries:          %lu on the shortest path, %lu longer, %lu stale values\n",
+                                (unsigned long) stats.hops_shortest, (unsigned long) stats.hops_longer,
+                                (unsigned long) stats.stale);
+        }
+        fprintf(out, "  master heap:              %lu bytes in use, %lu bytes minimum ever free\n",
+                        (unsigned long) master->api.heap_used(), (unsigned long) master->api.heap_watermark());
+        if (stats.read_errors || stats.decode_errors) {
+                fprintf(out, "  FRAME ERRORS:             %lu reads failed, %lu not decoded\n",
+                                (unsigned long) stats.read_errors, (unsigned long) stats.decode_errors);
+        }
+        if (merge_errors()) {
+                fprintf(out, "  MERGE ERRORS:             %lu duplicates, %lu own, %lu unknown, %lu hops, %lu values\n",
+                                (unsigned long) stats.duplicates, (unsigned long) stats.own,
+                                (unsigned long) stats.unknown, (unsigned long) stats.hops_wrong,
+                                (unsigned long) stats.wrong_values);
+        }
+        for (i = 0; i <= cfg.relays; i++) {
+                struct world_node *node = i ? vnodes[i - 1].node : master;
+
+                if (node->api.wdog_expiries()) {
+                        fprintf(out, "  WATCHDOG EXPIRIES:        %lu on %s\n", (unsigned long) node->api.wdog_expiries(),
+                                                                                                node->name);
+                }
+        }
+
+        if (cfg.quiet) {
+                return;
+        }
+
+        fprintf(out, "  node               age avg / max s   missed\n");
+        for (i = 0; i < num_vnodes; i++) {
+                const struct node_stats *ns = &node_stats[i];
+                const uint8_t *a = vnodes[i].node->addr.addr;
+
+                fprintf(out, "  %02X:%02X:%02X:%02X:%02X:%02X%c  %7lu / %-7lu %6lu\n", a[5], a[4], a[3], a[2],
+                                a[1], a[0], vnodes[i].relay ? 'r' : (vnodes[i].broadcast ? 'b' : ' '),
+                                (unsigned long)(ns->ages ? ns->age_sum / ns->ages : 0),
+                                (unsigned long) ns->age_max, (unsigned long) ns->missed);
+        }
+}
+
+/* Run the world until the window in progress is complete, at most until \p deadline */
+static bool run_window(uint32_t deadline)
+{
+        while (!window.complete && (int32_t)(deadline - world_now()) > 0) {
+                world_run(100);
+        }
+
+        return window.complete;
+}
+
+/* Nodes behind relays: out of range of the master, in range of their relays only */
+static void place_nodes(void)
+{
+        int i, r;
+
+        for (i = cfg.relays; i < num_vnodes; i++) {
+                struct vnode *v = &vnodes[i];
+                int k = i - cfg.relays;
+
+                v->home = k % cfg.relays;
+                if (k % 10 == 0 && cfg.relays > 1) {
+                        v->second = (v->home + 1) % cfg.relays;
+                }
+                world_set_range(v->node, master, false);
+                for (r = 0; r < cfg.relays; r++) {
+                        if (r != v->home && r != v->second) {
+                                world_set_range(v->node, vnodes[r].node, false);
+                        }
+                }
+        }
+}
+
+/*
+ * Make a node a master from the phone
+ *
+ * \return the link of the phone, disconnected already unless \p keep
+ */
+static struct world_link *make_master(struct world_node *phone, struct world_node *node, uint16_t *data_h,
+        bool keep)
+{
+        struct world_link *link = world_phone_connect(phone, node, 1000);
+        uint16_t set_h;
+        uint8_t on = 1;
+
+        if (!link || !world_phone_exchange_mtu(phone, link) ||
+                !(set_h = world_phone_find_char(phone, link, NODE_MASTER_ATTR_SET)) ||
+                !(*data_h = world_phone_find_char(phone, link, NODE_MASTER_ATTR_DATA)) ||
+                world_phone_write(phone, link, set_h, &on, sizeof(on)) != ATT_ERROR_OK) {
+                fprintf(stderr, "phone cannot set up %s\n", node->name);
+                exit(2);
+        }
+        if (!keep) {
+                world_phone_disconnect(phone, link);
+                return NULL;
+        }
+
+        return link;
+}
+
+static int run(void)
+{
+        struct world_node *phone;
+        struct world_link *link;
+        bd_address_t addr;
+        uint16_t data_h, generation = 0;
+        uint16_t cycle;
+        int i, ret = 0;
+
+        memset(&stats, 0, sizeof(stats));
+        stats.ttfa_min = UINT32_MAX;
+        rng_state = cfg.seed;
+        num_vnodes = cfg.relays + cfg.nodes;
+        vnodes = calloc(num_vnodes, sizeof(*vnodes));
+        node_stats = calloc(num_vnodes, sizeof(*node_stats));
+        if (!vnodes || !node_stats) {
+                fprintf(stderr, "out of memory\n");
+                exit(2);
+        }
+
+        world_init(SIM_IMAGE_WINDOWS, cfg.seed);
+        world_set_link_hook(link_hook);
+        addr = node_addr(0);
+        master = world_add_node("master", &addr, &(struct host_hih6130){ .raw_humidity = 8191,
+                                                                        .raw_temperature = 6454 });
+        for (i = 0; i < num_vnodes; i++) {
+                struct vnode *v = &vnodes[i];
+                char name[16];
+
+                v->relay = i < cfg.relays;
+                v->direct = v->relay || !cfg.relays;
+                v->broadcast = !v->relay && rng() % 100 < cfg.broadcast_pct;
+                v->home = -1;
+                v->second = -1;
+                v->sensor.raw_humidity = 8191;
+                set_sensor(v, 1500 + 10 * i);
+                snprintf(name, sizeof(name), v->relay ? "relay%d" : "node%d", i + 1);
+                world_set_image(v->broadcast ? SIM_IMAGE_BROADCAST : SIM_IMAGE_WINDOWS);
+                addr = node_addr(i + 1);
+                v->node = world_add_node(name, &addr, &v->sensor);
+        }
+        if (cfg.relays) {
+                place_nodes();
+        }
+        addr = (bd_address_t){ .addr_type = PUBLIC_ADDRESS, .addr = { 0x01, 0x00, 0x00, 0xAA, 0xBB, 0xCC } };
+        phone = world_add_phone("phone", &addr);
+        world_run(3000);
+
+        // the relays first, the phone stays connected to the master
+        for (i = 0; i < cfg.relays; i++) {
+                make_master(phone, vnodes[i].node, &data_h, false);
+        }
+        link = make_master(phone, master, &data_h, true);
+        // losses only from here, the phone link is set up
+        world_set_loss(cfg.loss_pct);
+
+        // the discovery scan, then the first window; a fleet the master cannot read whole
+        // never completes one. The nodes behind the relays reach the master a window later.
+        window_reset();
+        run_window(world_now() + SIM_FIRST_WINDOW_MS);
+        world_run(1000);
+        if (cfg.relays) {
+                world_run(CFG_COLLECT_PERIOD_MS);
+        }
+        read_aggregate(phone, link, data_h, &generation);
+        memset(&stats, 0, sizeof(stats));
+        memset(node_stats, 0, num_vnodes * sizeof(*node_stats));
+        stats.ttfa_min = UINT32_MAX;
+
+        for (cycle = 1; cycle <= cfg.cycles; cycle++) {
+                uint32_t end = world_now() + CFG_COLLECT_PERIOD_MS;
+                uint32_t retransmissions = world_get_stats()->retransmissions;
+
+                change_sensors(cycle);
+                window_reset();
+                window.counted = true;
+                run_window(end);
+                world_run_until(end);
+                stats.windows++;
+                stats.incomplete += !window.complete;
+                // a window in which no node was released has no duration
+                if (window.started && (int32_t)(window.end - window.start) >= 0) {
+                        uint32_t duration = window.end - window.start;
+
+                        stats.duration_sum += duration;
+                        if (duration > stats.duration_max) {
+                                stats.duration_max = duration;
+                        }
+                }
+                stats.retransmissions += world_get_stats()->retransmissions - retransmissions;
+                read_aggregate(phone, link, data_h, &generation);
+        }
+
+        // the aggregates of the relays, after the last one of the master
+        if (cfg.relays) {
+                world_phone_disconnect(phone, link);
+                for (i = 0; i < cfg.relays; i++) {
+                        check_relay(phone, &vnodes[i]);
+                }
+        }
+
+        report();
+        fflush(out);
+        if (stats.read_errors || stats.decode_errors || merge_errors()) {
+                ret = 1;
+        }
+        for (i = 0; i <= cfg.relays; i++) {
+                if ((i ? vnodes[i - 1].node : master)->api.wdog_expiries()) {
+                        ret = 1;
+                }
+        }
+        free(vnodes);
+        free(node_stats);
+
+        return ret;
+}
+
+static void usage(const char *prog)
+{
+        fprintf(stderr,
+                "usage: %s [-n nodes] [-r relays] [-p loss_pct] [-b broadcast_pct] [-k cycles] [-s seed]\n"
+                "          [-q] [-v] [-h]\n"
+                "Without -n the fleets of 5, 20 and 50 nodes are simulated, -v shows the firmware log.\n"
+                "With -r the nodes are behind relays, -b is not supported then.\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+        static const uint16_t fleets[] = { 5, 20, 50 };
+        uint16_t nodes = 0;
+        unsigned int i;
+        int opt, status, ret = 0;
+
+        cfg.loss_pct = 2;
+        cfg.cycles = 10;
+        cfg.seed = 1;
+
+        while ((opt = getopt(argc, argv, "n:r:p:b:k:s:qvh")) != -1) {
+                switch (opt) {
+                case 'n':
+                        nodes = atoi(optarg);
+                        break;
+                case 'r':
+                        cfg.relays = atoi(optarg);
+                        break;
+                case 'p':
+                        cfg.loss_pct = atoi(optarg);
+                        break;
+                case 'b':
+                        cfg.broadcast_pct = atoi(optarg);
+                        break;
+                case 'k':
+                        cfg.cycles = atoi(optarg);
+                        break;
+                case 's':
+                        cfg.seed = strtoul(optarg, NULL, 0);
+                        break;
+                case 'q':
+                        cfg.quiet = true;
+                        break;
+                case 'v':
+                        cfg.verbose = true;
+                        break;
+                case 'h':
+                        usage(argv[0]);
+                        return 0;
+                default:
+                        usage(argv[0]);
+                        return 2;
+                }
+        }
+
+        if (cfg.cycles == 0 || cfg.loss_pct >= 100 || cfg.relays > SIM_MAX_RELAYS ||
+                                nodes + cfg.relays > SIM_MAX_NODES || (cfg.relays && cfg.broadcast_pct)) {
+                usage(argv[0]);
+                return 2;
+        }
+
+        out = fdopen(dup(STDOUT_FILENO), "w");
+        if (!out || (!cfg.verbose && !freopen("/dev/null", "w", stdout))) {
+                perror("stdout");
+                return 2;
+        }
+
+        if (nodes) {
+                cfg.nodes = nodes;
+                return run();
+        }
+
+        // the world keeps its state in statics, every fleet runs in a process of its own
+        for (i = 0; i < sizeof(fleets) / sizeof(fleets[0]); i++) {
+                cfg.nodes = fleets[i];
+                fflush(out);
+                if (fork() == 0) {
+                        exit(run());
+                }
+                if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+                        ret = 1;
+                }
+        }
+
+        return ret;
+}
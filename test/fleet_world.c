@@ -0,0 +1,1141 @@
+/*
+ * fleet_world.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Radio world of the host tests and the fleet simulator, see fleet_world.h.
+ *
+ * The world runs in steps: the clock moves to the next thing which happens, every
+ * image runs its tasks and timers up to that time, then the PDUs, link events and
+ * advertising events due are delivered and the images which got something run
+ * again. The images only call into the world from their tasks, while the world
+ * waits in their run call, so the world needs no locking.
+ */
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "fleet_world.h"
+
+/* Signal strength of all advertising reports and connections */
+#define WORLD_RSSI                      (-65)
+
+/* Random delay added to each advertising event, as the link layer does */
+#define WORLD_ADV_DELAY_MS              (10)
+
+/* Connection parameters of a phone */
+#define WORLD_PHONE_INTERVAL            (0x18)
+#define WORLD_PHONE_TIMEOUT             (0x1F4)
+
+/* Time a phone waits for a response */
+#define WORLD_PHONE_RSP_TIMEOUT_MS      (5000)
+
+enum msg_kind {
+        MSG_PDU,
+        MSG_LINK_DOWN,
+};
+
+struct world_msg {
+        struct world_msg *next;
+        uint32_t at;
+        uint8_t kind;
+        struct world_link *link;
+        struct world_node *to;
+        uint8_t reason;                 /* MSG_LINK_DOWN: reason at the receiving side */
+        uint8_t peer_reason;            /* MSG_LINK_DOWN: reason at the other side */
+        struct host_pdu pdu;
+};
+
+static struct {
+        char image[256];
+        char dir[64];
+        uint32_t now;
+        uint32_t rand;
+        uint32_t adv_interval_ms;
+        uint8_t loss_pct;
+        struct world_node *nodes[WORLD_MAX_NODES];
+        int num_nodes;
+        bool far[WORLD_MAX_NODES][WORLD_MAX_NODES];
+        struct world_link links[WORLD_MAX_LINKS];
+        struct world_msg *msgs;
+        bool (*filter)(const struct world_node *from, const struct world_node *to,
+                const struct host_pdu *pdu);
+        void (*link_hook)(const struct world_link *link, bool up);
+        struct world_stats stats;
+} world;
+
+static uint32_t world_random(void)
+{
+        world.rand = world.rand * 1103515245 + 12345;
+
+        return (world.rand >> 16) & 0x7FFF;
+}
+
+static void fail(const char *what, const char *detail)
+{
+        fprintf(stderr, "fleet_world: %s: %s\n", what, detail);
+        exit(2);
+}
+
+static void world_cleanup(void)
+{
+        rmdir(world.dir);
+}
+
+void world_init(const char *image, uint32_t seed)
+{
+        memset(&world, 0, sizeof(world));
+        snprintf(world.image, sizeof(world.image), "%s", image);
+        world.rand = seed;
+        world.adv_interval_ms = 100;
+
+        strcpy(world.dir, "/tmp/fleet_world_XXXXXX");
+        if (!mkdtemp(world.dir)) {
+                fail("mkdtemp", world.dir);
+        }
+        atexit(world_cleanup);
+}
+
+/*
+ * Images
+ */
+
+/* dlopen() loads a file once, every node needs a copy of its own */
+static void *load_image(int id)
+{
+        char path[sizeof(world.dir) + 32];
+        char buf[65536];
+        ssize_t n;
+        int in, out;
+        void *lib;
+
+        snprintf(path, sizeof(path), "%s/node%d.so", world.dir, id);
+        in = open(world.image, O_RDONLY);
+        if (in < 0) {
+                fail("cannot open", world.image);
+        }
+        out = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0700);
+        if (out < 0) {
+                fail("cannot create", path);
+        }
+        while ((n = read(in, buf, sizeof(buf))) > 0) {
+                if (write(out, buf, n) != n) {
+                        fail("cannot write", path);
+                }
+        }
+        close(in);
+        close(out);
+
+        lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+        if (!lib) {
+                fail("dlopen", dlerror());
+        }
+        // the mapping stays, the file is not needed any more
+        unlink(path);
+
+        return lib;
+}
+
+static void *sym(void *lib, const char *name)
+{
+        void *p = dlsym(lib, name);
+
+        if (!p) {
+                fail("missing symbol", name);
+        }
+
+        return p;
+}
+
+static void bind_image(struct world_node *node)
+{
+        struct world_image *api = &node->api;
+        void *lib = node->lib;
+
+        *(void **)&api->boot = sym(lib, "host_os_boot");
+        *(void **)&api->main = sym(lib, "host_main");
+        *(void **)&api->run_until = sym(lib, "host_os_run_until");
+        *(void **)&api->now = sym(lib, "host_os_now");
+        *(void **)&api->next_event = sym(lib, "host_os_next_event");
+        *(void **)&api->set_cpu_scale = sym(lib, "host_os_set_cpu_scale");
+        *(void **)&api->wdog_expiries = sym(lib, "host_os_wdog_expiries");
+        *(void **)&api->heap_used = sym(lib, "host_os_heap_used");
+        *(void **)&api->heap_watermark = sym(lib, "host_os_heap_watermark");
+        *(void **)&api->heap_limit = sym(lib, "host_os_heap_limit");
+        *(void **)&api->heap_fail_hook = sym(lib, "host_os_heap_fail_hook");
+        *(void **)&api->set_address = sym(lib, "host_ble_set_address");
+        *(void **)&api->set_world = sym(lib, "host_ble_set_world");
+        *(void **)&api->link_up = sym(lib, "host_ble_link_up");
+        *(void **)&api->connect_failed = sym(lib, "host_ble_connect_failed");
+        *(void **)&api->link_down = sym(lib, "host_ble_link_down");
+        *(void **)&api->adv_report = sym(lib, "host_ble_adv_report");
+        *(void **)&api->recv = sym(lib, "host_ble_recv");
+        *(void **)&api->pair = sym(lib, "host_ble_pair");
+        *(void **)&api->set_rssi = sym(lib, "host_ble_set_rssi");
+        *(void **)&api->get_stats = sym(lib, "host_ble_get_stats");
+        *(void **)&api->set_hih6130 = sym(lib, "host_i2c_set_hih6130");
+        *(void **)&api->i2c_open_count = sym(lib, "host_i2c_open_count");
+        *(void **)&api->i2c_transfers = sym(lib, "host_i2c_transfers");
+}
+
+void *world_node_sym(const struct world_node *node, const char *name)
+{
+        return node->lib ? dlsym(node->lib, name) : NULL;
+}
+
+/*
+ * Radio callbacks of the images, called from their tasks
+ */
+static void radio_adv(void *ctx, bool on, const uint8_t *ad, uint8_t ad_len, const uint8_t *sd,
+        uint8_t sd_len)
+{
+        struct world_node *node = ctx;
+
+        if (on && !node->advertising) {
+                node->next_adv = world.now + 1 + world_random() % WORLD_ADV_DELAY_MS;
+        }
+        node->advertising = on;
+        memcpy(node->ad, ad, ad_len);
+        node->ad_len = ad_len;
+        memcpy(node->sd, sd, sd_len);
+        node->sd_len = sd_len;
+}
+
+static void radio_scan(void *ctx, bool on, bool active, uint16_t interval, uint16_t window)
+{
+        struct world_node *node = ctx;
+
+        node->scanning = on;
+        node->scan_active = active;
+        node->scan_start = world.now;
+        node->scan_interval_ms = interval * 5 / 8;
+        node->scan_window_ms = window * 5 / 8;
+        if (node->scan_interval_ms == 0) {
+                node->scan_interval_ms = 1;
+        }
+}
+
+static void radio_connect(void *ctx, const bd_address_t *peer, const gap_conn_params_t *params)
+{
+        struct world_node *node = ctx;
+
+        node->connecting = true;
+        node->connect_addr = *peer;
+        node->connect_params = *params;
+}
+
+static void radio_connect_cancel(void *ctx)
+{
+        struct world_node *node = ctx;
+
+        node->connecting = false;
+}
+
+static struct world_link *link_by_idx(const struct world_node *node, uint16_t conn_idx)
+{
+        int i;
+
+        for (i = 0; i < WORLD_MAX_LINKS; i++) {
+                struct world_link *link = &world.links[i];
+
+                if (!link->used) {
+                        continue;
+                }
+                if ((link->master == node && link->master_idx == conn_idx) ||
+                        (link->slave == node && link->slave_idx == conn_idx)) {
+                        return link;
+                }
+        }
+
+        return NULL;
+}
+
+/* Time of the next connection event of a link after now */
+static uint32_t next_conn_event(const struct world_link *link)
+{
+        uint32_t since = world.now - link->anchor;
+
+        return world.now + link->interval_ms - since % link->interval_ms;
+}
+
+static void queue_msg(struct world_msg *msg)
+{
+        struct world_msg **p = &world.msgs;
+
+        // in time order, first come first served on the same time
+        while (*p && (int32_t)((*p)->at - msg->at) <= 0) {
+                p = &(*p)->next;
+        }
+        msg->next = *p;
+        *p = msg;
+}
+
+static struct world_msg *msg_alloc(uint8_t kind, struct world_link *link, struct world_node *to)
+{
+        struct world_msg *msg = calloc(1, sizeof(*msg));
+
+        if (!msg) {
+                fail("calloc", "message");
+        }
+        msg->kind = kind;
+        msg->link = link;
+        msg->to = to;
+        msg->at = next_conn_event(link);
+
+        return msg;
+}
+
+static void send_pdu(struct world_link *link, const struct world_node *from, const struct host_pdu *pdu)
+{
+        struct world_node *to = (from == link->master) ? link->slave : link->master;
+        struct world_msg *msg;
+
+        if (world.filter && world.filter(from, to, pdu)) {
+                world.stats.pdus_dropped++;
+                return;
+        }
+        msg = msg_alloc(MSG_PDU, link, to);
+        msg->pdu = *pdu;
+        queue_msg(msg);
+}
+
+static void radio_disconnect(void *ctx, uint16_t conn_idx, uint8_t reason)
+{
+        struct world_node *node = ctx;
+        struct world_link *link = link_by_idx(node, conn_idx);
+        struct world_msg *msg;
+
+        if (!link) {
+                return;
+        }
+        msg = msg_alloc(MSG_LINK_DOWN, link, node);
+        msg->reason = BLE_HCI_ERROR_CON_TERM_BY_LOCAL_HOST;
+        msg->peer_reason = reason;
+        queue_msg(msg);
+}
+
+static void radio_send(void *ctx, uint16_t conn_idx, const struct host_pdu *pdu)
+{
+        struct world_node *node = ctx;
+        struct world_link *link = link_by_idx(node, conn_idx);
+
+        if (link) {
+                send_pdu(link, node, pdu);
+        }
+}
+
+/*
+ * Nodes
+ */
+static struct world_node *node_new(const char *name, const bd_address_t *addr)
+{
+        struct world_node *node;
+
+        if (world.num_nodes == WORLD_MAX_NODES) {
+                fail("too many nodes", name);
+        }
+        node = calloc(1, sizeof(*node));
+        if (!node) {
+                fail("calloc", name);
+        }
+        node->id = world.num_nodes;
+        snprintf(node->name, sizeof(node->name), "%s", name);
+        node->addr = *addr;
+        world.nodes[world.num_nodes++] = node;
+
+        return node;
+}
+
+void world_set_image(const char *image)
+{
+        snprintf(world.image, sizeof(world.image), "%s", image);
+}
+
+struct world_node *world_add_node(const char *name, const bd_address_t *addr,
+        const struct host_hih6130 *sensor)
+{
+        struct world_node *node = node_new(name, addr);
+
+        node->lib = load_image(node->id);
+        bind_image(node);
+
+        node->radio.ctx = node;
+        node->radio.adv = radio_adv;
+        node->radio.scan = radio_scan;
+        node->radio.connect = radio_connect;
+        node->radio.connect_cancel = radio_connect_cancel;
+        node->radio.disconnect = radio_disconnect;
+        node->radio.send = radio_send;
+
+        node->api.set_address(addr);
+        node->api.set_world(&node->radio);
+        node->api.set_hih6130(sensor);
+        node->api.boot(node->api.main);
+        // a node added later starts on the world clock
+        node->api.run_until(world.now);
+
+        return node;
+}
+
+struct world_node *world_add_phone(const char *name, const bd_address_t *addr)
+{
+        struct world_node *phone = node_new(name, addr);
+
+        phone->phone = true;
+        phone->phone_mtu = 247;
+
+        return phone;
+}
+
+void world_set_range(const struct world_node *a, const struct world_node *b, bool in_range)
+{
+        world.far[a->id][b->id] = !in_range;
+        world.far[b->id][a->id] = !in_range;
+}
+
+static bool in_range(const struct world_node *a, const struct world_node *b)
+{
+        return !world.far[a->id][b->id];
+}
+
+void world_set_adv_interval(uint32_t ms)
+{
+        world.adv_interval_ms = ms ? ms : 1;
+}
+
+void world_set_filter(bool (*filter)(const struct world_node *from, const struct world_node *to,
+        const struct host_pdu *pdu))
+{
+        world.filter = filter;
+}
+
+void world_set_link_hook(void (*hook)(const struct world_link *link, bool up))
+{
+        world.link_hook = hook;
+}
+
+void world_set_loss(uint8_t pct)
+{
+        world.loss_pct = pct;
+}
+
+uint32_t world_now(void)
+{
+        return world.now;
+}
+
+const struct world_stats *world_get_stats(void)
+{
+        return &world.stats;
+}
+
+/*
+ * Links
+ */
+struct world_link *world_find_link(const struct world_node *a, const struct world_node *b)
+{
+        int i;
+
+        for (i = 0; i < WORLD_MAX_LINKS; i++) {
+                struct world_link *link = &world.links[i];
+
+                if (link->used && ((link->master == a && link->slave == b) ||
+                        (link->master == b && link->slave == a))) {
+                        return link;
+                }
+        }
+
+        return NULL;
+}
+
+int world_node_links(const struct world_node *node)
+{
+        int i, n = 0;
+
+        for (i = 0; i < WORLD_MAX_LINKS; i++) {
+                if (world.links[i].used && (world.links[i].master == node || world.links[i].slave == node)) {
+                        n++;
+                }
+        }
+
+        return n;
+}
+
+static uint32_t interval_ms(uint16_t interval)
+{
+        uint32_t ms = interval * 5 / 4;
+
+        return ms ? ms : 1;
+}
+
+static void link_establish(struct world_node *master, struct world_node *slave)
+{
+        struct world_link *link = NULL;
+        gap_conn_params_t params = master->connect_params;
+        int i;
+
+        for (i = 0; i < WORLD_MAX_LINKS && !link; i++) {
+                if (!world.links[i].used) {
+                        link = &world.links[i];
+                }
+        }
+        if (!link) {
+                fail("too many links", master->name);
+        }
+
+        memset(link, 0, sizeof(*link));
+        link->used = true;
+        link->master = master;
+        link->slave = slave;
+        link->anchor = world.now;
+        link->interval_ms = interval_ms(params.interval_min);
+        link->mtu = HOST_ATT_MTU_DEFAULT;
+        master->connecting = false;
+        master->links_up++;
+        slave->links_up++;
+        world.stats.links_up++;
+
+        // phones index their links by the link itself
+        link->master_idx = master->lib ? master->api.link_up(&slave->addr, true, &params) : link - world.links;
+        link->slave_idx = slave->lib ? slave->api.link_up(&master->addr, false, &params) : link - world.links;
+        if (master->lib) {
+                master->api.set_rssi(link->master_idx, WORLD_RSSI);
+        }
+        if (slave->lib) {
+                slave->api.set_rssi(link->slave_idx, WORLD_RSSI);
+        }
+        // advertising stops on a connection as slave; the phone side does it here
+        if (!slave->lib) {
+                slave->advertising = false;
+        }
+        if (world.link_hook) {
+                world.link_hook(link, true);
+        }
+}
+
+static void link_drop(struct world_link *link, uint8_t master_reason, uint8_t slave_reason)
+{
+        struct world_msg **p = &world.msgs;
+
+        link->used = false;
+        world.stats.links_down++;
+        if (world.link_hook) {
+                world.link_hook(link, false);
+        }
+        if (link->master->lib) {
+                link->master->api.link_down(link->master_idx, master_reason);
+        }
+        if (link->slave->lib) {
+                link->slave->api.link_down(link->slave_idx, slave_reason);
+        }
+
+        // nothing is delivered on a link which is gone
+        while (*p) {
+                if ((*p)->link == link) {
+                        struct world_msg *msg = *p;
+
+                        *p = msg->next;
+                        free(msg);
+                } else {
+                        p = &(*p)->next;
+                }
+        }
+}
+
+void world_link_loss(struct world_link *link)
+{
+        link_drop(link, BLE_HCI_ERROR_CON_TIMEOUT, BLE_HCI_ERROR_CON_TIMEOUT);
+}
+
+/*
+ * Phones
+ */
+static void phone_reply(struct world_link *link, struct world_node *phone, const struct host_pdu *req,
+        uint8_t op)
+{
+        struct host_pdu rsp;
+
+        memset(&rsp, 0, offsetof(struct host_pdu, value));
+        rsp.op = op;
+        rsp.handle = req->handle;
+
+        switch (op) {
+        case HOST_PDU_MTU_RSP:
+                rsp.param[0] = phone->phone_mtu;
+                break;
+        case HOST_PDU_CONN_PARAM_RSP:
+                rsp.status = BLE_ERROR_NOT_ACCEPTED;
+                break;
+        case HOST_PDU_CONN_UPDATE:
+                memcpy(rsp.param, req->param, sizeof(rsp.param));
+                rsp.param[1] = req->param[0];
+                break;
+        case HOST_PDU_PHY_RSP:
+                // the requester transmits on its own tx preference and receives on its rx one
+                rsp.param[0] = (req->param[0] & BLE_GAP_PHY_PREF_2M) ? BLE_GAP_PHY_2M : BLE_GAP_PHY_1M;
+                rsp.param[1] = (req->param[1] & BLE_GAP_PHY_PREF_2M) ? BLE_GAP_PHY_2M : BLE_GAP_PHY_1M;
+                break;
+        case HOST_PDU_LENGTH_RSP:
+                rsp.param[0] = req->param[0] < 251 ? req->param[0] : 251;
+                rsp.param[1] = req->param[1] < 2120 ? req->param[1] : 2120;
+                break;
+        default:
+                break;
+        }
+        send_pdu(link, phone, &rsp);
+}
+
+static void phone_recv(struct world_link *link, struct world_node *phone, const struct host_pdu *pdu)
+{
+        switch (pdu->op) {
+        case HOST_PDU_MTU_REQ:
+                link->mtu = pdu->param[0] < phone->phone_mtu ? pdu->param[0] : phone->phone_mtu;
+                phone_reply(link, phone, pdu, HOST_PDU_MTU_RSP);
+                return;
+        case HOST_PDU_CONN_PARAM_REQ:
+                if (phone->phone_reject_params) {
+                        phone_reply(link, phone, pdu, HOST_PDU_CONN_PARAM_RSP);
+                } else {
+                        phone_reply(link, phone, pdu, HOST_PDU_CONN_UPDATE);
+                }
+                return;
+        case HOST_PDU_PHY_REQ:
+                phone_reply(link, phone, pdu, HOST_PDU_PHY_RSP);
+                return;
+        case HOST_PDU_LENGTH_REQ:
+                phone_reply(link, phone, pdu, HOST_PDU_LENGTH_RSP);
+                return;
+        case HOST_PDU_NOTIFY:
+        case HOST_PDU_INDICATE:
+        {
+                struct world_notification *n = &phone->notify_log[phone->notify_count % WORLD_PHONE_NOTIFY_LOG];
+
+                n->time = world.now;
+                n->handle = pdu->handle;
+                n->indication = (pdu->op == HOST_PDU_INDICATE);
+                n->length = pdu->length;
+                memcpy(n->value, pdu->value, pdu->length);
+                phone->notify_count++;
+                if (n->indication) {
+                        phone_reply(link, phone, pdu, HOST_PDU_CONFIRM);
+                }
+                return;
+        }
+        default:
+                break;
+        }
+
+        if (phone->inbox_count == WORLD_PHONE_INBOX) {
+                fail("phone inbox full", phone->name);
+        }
+        phone->inbox[phone->inbox_count++] = *pdu;
+}
+
+/*
+ * Stepping
+ */
+static void deliver(struct world_msg *msg)
+{
+        struct world_link *link = msg->link;
+        struct world_node *to = msg->to;
+
+        if (msg->kind == MSG_LINK_DOWN) {
+                // msg->to requested it
+                if (to == link->master) {
+                        link_drop(link, msg->reason, msg->peer_reason);
+                } else {
+                        link_drop(link, msg->peer_reason, msg->reason);
+                }
+                return;
+        }
+
+        world.stats.pdus++;
+        link->pdus++;
+        link->bytes += msg->pdu.length;
+
+        // a parameter update takes effect for both sides
+        if (msg->pdu.op == HOST_PDU_CONN_UPDATE) {
+                link->interval_ms = interval_ms(msg->pdu.param[0]);
+                link->anchor = world.now;
+        }
+
+        if (to->phone) {
+                phone_recv(link, to, &msg->pdu);
+        } else {
+                to->api.recv(to == link->master ? link->master_idx : link->slave_idx, &msg->pdu);
+        }
+}
+
+/*
+ * The link layer delivers in order: what the sender of a lost PDU queued behind it
+ * waits for the retransmission
+ */
+static void hold_behind(const struct world_msg *lost)
+{
+        struct world_msg **p = &world.msgs;
+        struct world_msg *held = NULL, **tail = &held;
+
+        while (*p) {
+                struct world_msg *msg = *p;
+
+                if (msg != lost && msg->link == lost->link && msg->to == lost->to &&
+                                                        (int32_t)(msg->at - lost->at) < 0) {
+                        *p = msg->next;
+                        msg->next = NULL;
+                        *tail = msg;
+                        tail = &msg->next;
+                        continue;
+                }
+                p = &msg->next;
+        }
+
+        while (held) {
+                struct world_msg *msg = held;
+
+                held = msg->next;
+                msg->at = lost->at;
+                queue_msg(msg);
+        }
+}
+
+/*
+ * Check whether a PDU gets lost at this connection event. A lost PDU goes again at
+ * the next event, after WORLD_SUPERVISION_EVENTS lost events in a row the link is gone.
+ */
+static bool lost(struct world_msg *msg)
+{
+        struct world_link *link = msg->link;
+
+        if (!world.loss_pct || world_random() % 100 >= world.loss_pct) {
+                link->losses = 0;
+                return false;
+        }
+
+        world.stats.retransmissions++;
+        if (++link->losses >= WORLD_SUPERVISION_EVENTS) {
+                free(msg);
+                world_link_loss(link);
+                return true;
+        }
+        msg->at = next_conn_event(link);
+        queue_msg(msg);
+        hold_behind(msg);
+
+        return true;
+}
+
+static bool scan_hears(const struct world_node *scanner)
+{
+        uint32_t t = (world.now - scanner->scan_start) % scanner->scan_interval_ms;
+
+        return t < scanner->scan_window_ms;
+}
+
+static void adv_event(struct world_node *adv)
+{
+        int i;
+
+        for (i = 0; i < world.num_nodes; i++) {
+                struct world_node *node = world.nodes[i];
+
+                if (node == adv || !in_range(node, adv)) {
+                        continue;
+                }
+
+                // a pending connection request to the advertiser goes through if both have room,
+                // links taken as slave meanwhile may have used up the initiator's
+                if (node->connecting && !memcmp(node->connect_addr.addr, adv->addr.addr, sizeof(adv->addr.addr)) &&
+                        world_node_links(adv) < HOST_BLE_MAX_CONN && world_node_links(node) < HOST_BLE_MAX_CONN) {
+                        link_establish(node, adv);
+                        return;
+                }
+
+                if (!node->scanning || !node->lib || !scan_hears(node)) {
+                        continue;
+                }
+                node->api.adv_report(&adv->addr, WORLD_RSSI, false, adv->ad, adv->ad_len);
+                node->adv_reports++;
+                world.stats.adv_reports++;
+                if (node->scan_active && adv->sd_len) {
+                        node->api.adv_report(&adv->addr, WORLD_RSSI, true, adv->sd, adv->sd_len);
+                        node->adv_reports++;
+                        world.stats.adv_reports++;
+                }
+        }
+}
+
+static void run_images(void)
+{
+        int i;
+
+        for (i = 0; i < world.num_nodes; i++) {
+                if (world.nodes[i]->lib) {
+                        world.nodes[i]->api.run_until(world.now);
+                }
+        }
+}
+
+/* Handle everything due now */
+static void step(void)
+{
+        int i;
+
+        world.stats.steps++;
+        run_images();
+
+        while (world.msgs && (int32_t)(world.msgs->at - world.now) <= 0) {
+                struct world_msg *msg = world.msgs;
+
+                world.msgs = msg->next;
+                if (msg->kind == MSG_PDU && lost(msg)) {
+                        continue;
+                }
+                deliver(msg);
+                free(msg);
+        }
+
+        for (i = 0; i < world.num_nodes; i++) {
+                struct world_node *node = world.nodes[i];
+
+                if (!node->advertising || (int32_t)(node->next_adv - world.now) > 0) {
+                        continue;
+                }
+                node->next_adv = world.now + world.adv_interval_ms + world_random() % WORLD_ADV_DELAY_MS;
+                adv_event(node);
+        }
+
+        run_images();
+}
+
+/* Time at which something happens next */
+static uint32_t next_time(void)
+{
+        uint32_t next = world.now + 0x7FFFFFFF;
+        int i;
+
+        if (world.msgs) {
+                next = world.msgs->at;
+        }
+        for (i = 0; i < world.num_nodes; i++) {
+                struct world_node *node = world.nodes[i];
+
+                if (node->advertising && (int32_t)(node->next_adv - next) < 0) {
+                        next = node->next_adv;
+                }
+                if (node->lib) {
+                        uint32_t t = node->api.next_event();
+
+                        if ((int32_t)(t - next) < 0) {
+                                next = t;
+                        }
+                }
+        }
+
+        // everything due now was handled by the step
+        return (int32_t)(next - world.now) > 0 ? next : world.now + 1;
+}
+
+void world_run_until(uint32_t ms)
+{
+        for (;;) {
+                uint32_t next;
+
+                step();
+                next = next_time();
+                if ((int32_t)(next - ms) > 0) {
+                        break;
+                }
+                world.now = next;
+        }
+        if ((int32_t)(ms - world.now) > 0) {
+                world.now = ms;
+                run_images();
+        }
+}
+
+void world_run(uint32_t ms)
+{
+        world_run_until(world.now + ms);
+}
+
+/* Run until \p done returns true, at most until \p deadline */
+static bool run_while_not(bool (*done)(const void *ud), const void *ud, uint32_t deadline)
+{
+        while (!done(ud)) {
+                uint32_t next;
+
+                step();
+                if (done(ud)) {
+                        return true;
+                }
+                next = next_time();
+                if ((int32_t)(next - deadline) > 0) {
+                        world.now = deadline;
+                        run_images();
+                        return done(ud);
+                }
+                world.now = next;
+        }
+
+        return true;
+}
+
+static bool phone_connected(const void *ud)
+{
+        const struct world_node *phone = ud;
+
+        return !phone->connecting;
+}
+
+struct world_link *world_phone_connect(struct world_node *phone, struct world_node *node,
+        uint32_t timeout_ms)
+{
+        gap_conn_params_t params = {
+                .interval_min = WORLD_PHONE_INTERVAL,
+                .interval_max = WORLD_PHONE_INTERVAL,
+                .slave_latency = 0,
+                .sup_timeout = WORLD_PHONE_TIMEOUT,
+        };
+
+        phone->connecting = true;
+        phone->connect_addr = node->addr;
+        phone->connect_params = params;
+        if (!run_while_not(phone_connected, phone, world.now + timeout_ms)) {
+                phone->connecting = false;
+                return NULL;
+        }
+
+        return world_find_link(phone, node);
+}
+
+void world_phone_disconnect(struct world_node *phone, struct world_link *link)
+{
+        struct world_msg *msg = msg_alloc(MSG_LINK_DOWN, link, phone);
+
+        msg->reason = BLE_HCI_ERROR_CON_TERM_BY_LOCAL_HOST;
+        msg->peer_reason = BLE_HCI_ERROR_REMOTE_USER_TERM_CON;
+        queue_msg(msg);
+        world_run_until(msg->at);
+}
+
+struct phone_wait {
+        struct world_node *phone;
+        uint8_t op;
+};
+
+static bool phone_has(const void *ud)
+{
+        const struct phone_wait *wait = ud;
+        int i;
+
+        for (i = 0; i < wait->phone->inbox_count; i++) {
+                if (wait->phone->inbox[i].op == wait->op) {
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+/* Take the first PDU of a kind from the inbox of a phone */
+static bool phone_take(struct world_node *phone, uint8_t op, struct host_pdu *pdu)
+{
+        int i;
+
+        for (i = 0; i < phone->inbox_count; i++) {
+                if (phone->inbox[i].op == op) {
+                        *pdu = phone->inbox[i];
+                        memmove(&phone->inbox[i], &phone->inbox[i + 1],
+                                (phone->inbox_count - i - 1) * sizeof(phone->inbox[0]));
+                        phone->inbox_count--;
+                        return true;
+                }
+        }
+
+        return false;
+}
+
+/* Send a request and wait for its response */
+static bool phone_request(struct world_node *phone, struct world_link *link, const struct host_pdu *req,
+        uint8_t rsp_op, struct host_pdu *rsp)
+{
+        struct phone_wait wait = { phone, rsp_op };
+
+        send_pdu(link, phone, req);
+        if (!run_while_not(phone_has, &wait, world.now + WORLD_PHONE_RSP_TIMEOUT_MS)) {
+                return false;
+        }
+
+        return phone_take(phone, rsp_op, rsp);
+}
+
+static void pdu_init(struct host_pdu *pdu, uint8_t op)
+{
+        memset(pdu, 0, offsetof(struct host_pdu, value));
+        pdu->op = op;
+}
+
+uint16_t world_phone_exchange_mtu(struct world_node *phone, struct world_link *link)
+{
+        static struct host_pdu req, rsp;
+
+        pdu_init(&req, HOST_PDU_MTU_REQ);
+        req.param[0] = phone->phone_mtu;
+        if (!phone_request(phone, link, &req, HOST_PDU_MTU_RSP, &rsp)) {
+                return 0;
+        }
+        link->mtu = rsp.param[0] < phone->phone_mtu ? rsp.param[0] : phone->phone_mtu;
+        if (link->mtu < HOST_ATT_MTU_DEFAULT) {
+                link->mtu = HOST_ATT_MTU_DEFAULT;
+        }
+
+        return link->mtu;
+}
+
+static int hex_digit(char c)
+{
+        if (c >= '0' && c <= '9') {
+                return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+                return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+                return c - 'A' + 10;
+        }
+
+        return -1;
+}
+
+/* As ble_uuid_from_string() of the image */
+static void uuid_parse(const char *str, att_uuid_t *uuid)
+{
+        uint8_t bytes[16] = { 0 };
+        int n = 0;
+
+        memset(uuid, 0, sizeof(*uuid));
+        for (; *str && n < 32; str++) {
+                int d = hex_digit(*str);
+
+                if (d < 0) {
+                        continue;
+                }
+                bytes[n / 2] |= (n % 2) ? d : d << 4;
+                n++;
+        }
+        if (n == 4) {
+                uuid->type = ATT_UUID_16;
+                uuid->uuid16 = (bytes[0] << 8) | bytes[1];
+                return;
+        }
+        uuid->type = ATT_UUID_128;
+        for (n = 0; n < 16; n++) {
+                uuid->uuid128[n] = bytes[15 - n];
+        }
+}
+
+uint16_t world_phone_find_char(struct world_node *phone, struct world_link *link, const char *uuid)
+{
+        static struct host_pdu req, rsp;
+        uint16_t value_h = 0;
+
+        pdu_init(&req, HOST_PDU_FIND_CHAR_REQ);
+        req.handle = 1;
+        req.end_handle = 0xFFFF;
+        req.param[0] = 1;
+        uuid_parse(uuid, &req.uuid);
+        if (!phone_request(phone, link, &req, HOST_PDU_FIND_DONE, &rsp)) {
+                return 0;
+        }
+        if (phone_take(phone, HOST_PDU_FIND_CHAR_RSP, &rsp)) {
+                value_h = rsp.param[0];
+        }
+        while (phone_take(phone, HOST_PDU_FIND_CHAR_RSP, &rsp)) {
+        }
+
+        return value_h;
+}
+
+att_error_t world_phone_read(struct world_node *phone, struct world_link *link, uint16_t handle,
+        uint16_t offset, uint8_t *value, uint16_t *length)
+{
+        static struct host_pdu req, rsp;
+
+        *length = 0;
+        pdu_init(&req, HOST_PDU_READ_REQ);
+        req.handle = handle;
+        req.offset = offset;
+        if (!phone_request(phone, link, &req, HOST_PDU_READ_RSP, &rsp)) {
+                return ATT_ERROR_UNLIKELY;
+        }
+        if (rsp.status == ATT_ERROR_OK) {
+                memcpy(value, rsp.value, rsp.length);
+                *length = rsp.length;
+        }
+
+        return rsp.status;
+}
+
+att_error_t world_phone_read_long(struct world_node *phone, struct world_link *link, uint16_t handle,
+        uint8_t *value, uint16_t *length)
+{
+        uint16_t total = 0;
+
+        for (;;) {
+                uint16_t len;
+                att_error_t status = world_phone_read(phone, link, handle, total, value + total, &len);
+
+                if (status != ATT_ERROR_OK) {
+                        // a read at the end of the value ends a long read
+                        if (status == ATT_ERROR_INVALID_OFFSET && total) {
+                                break;
+                        }
+                        *length = total;
+                        return status;
+                }
+                total += len;
+                if (len < link->mtu - 1 || total >= HOST_ATT_VALUE_MAX) {
+                        break;
+                }
+        }
+        *length = total;
+
+        return ATT_ERROR_OK;
+}
+
+att_error_t world_phone_write(struct world_node *phone, struct world_link *link, uint16_t handle,
+        const void *value, uint16_t length)
+{
+        static struct host_pdu req, rsp;
+
+        pdu_init(&req, HOST_PDU_WRITE_REQ);
+        req.handle = handle;
+        req.length = length;
+        memcpy(req.value, value, length);
+        if (!phone_request(phone, link, &req, HOST_PDU_WRITE_RSP, &rsp)) {
+                return ATT_ERROR_UNLIKELY;
+        }
+
+        return rsp.status;
+}
+
+const struct world_notification *world_phone_last_notification(const struct world_node *phone,
+        uint16_t handle, uint32_t since)
+{
+        uint32_t i;
+
+        for (i = phone->notify_count; i > since && phone->notify_count - i < WORLD_PHONE_NOTIFY_LOG; i--) {
+                const struct world_notification *n = &phone->notify_log[(i - 1) % WORLD_PHONE_NOTIFY_LOG];
+
+                if (n->handle == handle) {
+                        return n;
+                }
+        }
+
+        return NULL;
+}
@@ -0,0 +1,296 @@
+/*
+ * fleet_world.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Radio world of the host tests and the fleet simulator.
+ *
+ * Every node runs its own copy of the firmware image (libnode.so, the firmware
+ * built with the SDK stand-ins of test/sdk), loaded with dlopen() so the copies do
+ * not share any state. The world advances all images in lockstep on one virtual
+ * clock and carries what they put on the air between them: advertising reports to
+ * the scanning nodes in range, connection requests to the advertisers and PDUs on
+ * the connections, delivered at the next connection event.
+ *
+ * A phone is a scripted peer without an image: the test drives it with the
+ * world_phone_xxx() calls, it answers the link procedures of the nodes itself.
+ */
+
+#ifndef TEST_FLEET_WORLD_H_
+#define TEST_FLEET_WORLD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "host_sdk.h"
+
+#define WORLD_MAX_NODES                 (64)
+#define WORLD_MAX_LINKS                 (128)
+#define WORLD_PHONE_INBOX               (64)
+#define WORLD_PHONE_NOTIFY_LOG          (64)
+#define WORLD_SUPERVISION_EVENTS        (6)
+
+/* Entry points of a firmware image */
+struct world_image {
+        void (*boot)(int (*main_fn)(void));
+        int (*main)(void);
+        void (*run_until)(OS_TICK_TIME until);
+        OS_TICK_TIME (*now)(void);
+        OS_TICK_TIME (*next_event)(void);
+        void (*set_cpu_scale)(uint32_t ns_per_tick);
+        uint32_t (*wdog_expiries)(void);
+        size_t (*heap_used)(void);
+        size_t (*heap_watermark)(void);
+        void (*heap_limit)(size_t bytes);
+        void (*heap_fail_hook)(bool (*fail)(size_t size));
+        void (*set_address)(const bd_address_t *addr);
+        void (*set_world)(const struct host_ble_world *world);
+        uint16_t (*link_up)(const bd_address_t *peer, bool master, const gap_conn_params_t *params);
+        void (*connect_failed)(uint8_t status);
+        void (*link_down)(uint16_t conn_idx, uint8_t reason);
+        void (*adv_report)(const bd_address_t *addr, int8_t rssi, bool scan_rsp, const uint8_t *data,
+                uint8_t len);
+        void (*recv)(uint16_t conn_idx, const struct host_pdu *pdu);
+        void (*pair)(uint16_t conn_idx, bool bond);
+        void (*set_rssi)(uint16_t conn_idx, int8_t rssi);
+        void (*get_stats)(struct host_ble_stats *stats);
+        void (*set_hih6130)(const struct host_hih6130 *model);
+        int (*i2c_open_count)(void);
+        uint32_t (*i2c_transfers)(void);
+};
+
+/* A notification or indication received by a phone */
+struct world_notification {
+        uint32_t time;
+        uint16_t handle;
+        bool indication;
+        uint16_t length;
+        uint8_t value[HOST_ATT_VALUE_MAX];
+};
+
+struct world_node {
+        int id;
+        char name[24];
+        bd_address_t addr;
+        /* firmware image, NULL for a phone */
+        void *lib;
+        struct world_image api;
+        struct host_ble_world radio;
+        /* advertising */
+        bool advertising;
+        uint8_t ad[BLE_ADV_DATA_LEN_MAX];
+        uint8_t ad_len;
+        uint8_t sd[BLE_SCAN_RSP_LEN_MAX];
+        uint8_t sd_len;
+        uint32_t next_adv;
+        /* scanning */
+        bool scanning;
+        bool scan_active;
+        uint32_t scan_start;
+        uint32_t scan_interval_ms;
+        uint32_t scan_window_ms;
+        /* pending connection request */
+        bool connecting;
+        bd_address_t connect_addr;
+        gap_conn_params_t connect_params;
+        /* counters */
+        uint32_t adv_reports;
+        uint32_t links_up;
+        /* phone: MTU it offers, parameter requests it refuses */
+        bool phone;
+        uint16_t phone_mtu;
+        bool phone_reject_params;
+        /* phone: responses not consumed yet, and the notifications received */
+        struct host_pdu inbox[WORLD_PHONE_INBOX];
+        int inbox_count;
+        struct world_notification notify_log[WORLD_PHONE_NOTIFY_LOG];
+        uint32_t notify_count;
+};
+
+struct world_link {
+        bool used;
+        struct world_node *master;
+        struct world_node *slave;
+        uint16_t master_idx;
+        uint16_t slave_idx;
+        uint32_t anchor;
+        uint32_t interval_ms;
+        /* ATT MTU of the connection, tracked from the exchanges */
+        uint16_t mtu;
+        uint32_t pdus;
+        uint32_t bytes;
+        /* connection events in a row without a PDU getting through */
+        uint8_t losses;
+};
+
+/* Counters of the world */
+struct world_stats {
+        uint32_t steps;
+        uint32_t pdus;
+        uint32_t pdus_dropped;
+        uint32_t retransmissions;
+        uint32_t adv_reports;
+        uint32_t links_up;
+        uint32_t links_down;
+};
+
+/**
+ * \brief Set up the world
+ *
+ * \param [in] image: path of the firmware image every node loads a copy of
+ * \param [in] seed: seed of the advertising jitter
+ */
+void world_init(const char *image, uint32_t seed);
+
+/**
+ * \brief Firmware image of the nodes added from now on
+ */
+void world_set_image(const char *image);
+
+/**
+ * \brief Add a node running the firmware image, booted right away
+ *
+ * \param [in] name: name in the reports
+ * \param [in] addr: public address of the node
+ * \param [in] sensor: HIH6130 model of the node
+ */
+struct world_node *world_add_node(const char *name, const bd_address_t *addr,
+        const struct host_hih6130 *sensor);
+
+/**
+ * \brief Add a phone
+ */
+struct world_node *world_add_phone(const char *name, const bd_address_t *addr);
+
+/**
+ * \brief Put two nodes in or out of radio range of each other, all nodes are in range by default
+ */
+void world_set_range(const struct world_node *a, const struct world_node *b, bool in_range);
+
+/**
+ * \brief Interval of the advertising events, 100 ms by default
+ */
+void world_set_adv_interval(uint32_t ms);
+
+/**
+ * \brief Drop PDUs, \p filter returns true for each PDU to drop
+ */
+void world_set_filter(bool (*filter)(const struct world_node *from, const struct world_node *to,
+        const struct host_pdu *pdu));
+
+/**
+ * \brief Call \p hook on every link which comes up or goes down
+ */
+void world_set_link_hook(void (*hook)(const struct world_link *link, bool up));
+
+/**
+ * \brief Lose PDUs on the air
+ *
+ * The link layer retransmits a lost PDU at the next connection event; after
+ * WORLD_SUPERVISION_EVENTS events in a row without getting through the link is lost.
+ *
+ * \param [in] pct: chance of a PDU to get lost, per connection event
+ */
+void world_set_loss(uint8_t pct);
+
+/**
+ * \brief Run the world up to a time, in ms
+ */
+void world_run_until(uint32_t ms);
+
+/**
+ * \brief Run the world for a time, in ms
+ */
+void world_run(uint32_t ms);
+
+/**
+ * \brief Current time of the world, in ms
+ */
+uint32_t world_now(void);
+
+/**
+ * \brief Counters of the world
+ */
+const struct world_stats *world_get_stats(void);
+
+/**
+ * \brief Symbol of the firmware image of a node, NULL for a phone or if not found
+ */
+void *world_node_sym(const struct world_node *node, const char *name);
+
+/**
+ * \brief Link between two nodes, NULL if not connected
+ */
+struct world_link *world_find_link(const struct world_node *a, const struct world_node *b);
+
+/**
+ * \brief Number of links of a node
+ */
+int world_node_links(const struct world_node *node);
+
+/**
+ * \brief Break a link, as a supervision timeout on both sides
+ */
+void world_link_loss(struct world_link *link);
+
+/**
+ * \brief Connect a phone to a node
+ *
+ * \return the link, NULL if the node did not advertise within \p timeout_ms
+ */
+struct world_link *world_phone_connect(struct world_node *phone, struct world_node *node,
+        uint32_t timeout_ms);
+
+/**
+ * \brief Disconnect a phone
+ */
+void world_phone_disconnect(struct world_node *phone, struct world_link *link);
+
+/**
+ * \brief Exchange the MTU of a phone connection
+ *
+ * \return the MTU of the connection, 0 on a timeout
+ */
+uint16_t world_phone_exchange_mtu(struct world_node *phone, struct world_link *link);
+
+/**
+ * \brief Find a characteristic on the node a phone is connected to
+ *
+ * \return value handle of the characteristic, 0 if not found
+ */
+uint16_t world_phone_find_char(struct world_node *phone, struct world_link *link, const char *uuid);
+
+/**
+ * \brief Read an attribute with a single read request
+ *
+ * \param [out] value: at least HOST_ATT_VALUE_MAX bytes
+ *
+ * \return ATT status, ATT_ERROR_UNLIKELY on a timeout
+ */
+att_error_t world_phone_read(struct world_node *phone, struct world_link *link, uint16_t handle,
+        uint16_t offset, uint8_t *value, uint16_t *length);
+
+/**
+ * \brief Read a whole attribute value with a long read
+ */
+att_error_t world_phone_read_long(struct world_node *phone, struct world_link *link, uint16_t handle,
+        uint8_t *value, uint16_t *length);
+
+/**
+ * \brief Write an attribute with a write request
+ *
+ * \return ATT status, ATT_ERROR_UNLIKELY on a timeout
+ */
+att_error_t world_phone_write(struct world_node *phone, struct world_link *link, uint16_t handle,
+        const void *value, uint16_t length);
+
+/**
+ * \brief Latest notification or indication of a handle since \p since notifications
+ *
+ * \return the notification, NULL if none
+ */
+const struct world_notification *world_phone_last_notification(const struct world_node *phone,
+        uint16_t handle, uint32_t since);
+
+#endif /* TEST_FLEET_WORLD_H_ */
@@ -0,0 +1,449 @@
+/*
+ * host_tests.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host tests of the SDK independent modules, built and run by the makefile in
+ * this directory. Every failed check prints its expression, the exit status is
+ * non-zero if any check failed. The conversion kernels and calibration tables
+ * have tests of their own in conv_tests.c.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "ble_adv_parser.h"
+#include "node_aggregate.h"
+#include "sensor_filter.h"
+#include "sensor_record.h"
+#include "sensor_rules.h"
+#include "sensor_snapshot.h"
+#include "time_sync.h"
+
+/* Defined by the firmware tasks, the tests use their own instances */
+struct sensor_snapshot_buf sensor_snapshots;
+struct sensor_rules alarm_rules;
+
+static int checks;
+static int failures;
+
+#define CHECK(expr)                                                                     \
+        do {                                                                            \
+                checks++;                                                               \
+                if (!(expr)) {                                                          \
+                        failures++;                                                     \
+                        printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+                }                                                                       \
+        } while (0)
+
+static void test_record(void)
+{
+        struct sensor_record rec = {
+                .temperature = 0xFE0C,
+                .humidity = 4567,
+                .water = 890,
+                .sequence = 0xBEEF,
+                .battery = SENSOR_BATTERY_UNKNOWN,
+        };
+        struct sensor_record out;
+        uint8_t buf[SENSOR_RECORD_LEN];
+
+        sensor_record_pack(&rec, buf);
+        memset(&out, 0, sizeof(out));
+        sensor_record_unpack(buf, &out);
+
+        CHECK(out.temperature == rec.temperature);
+        CHECK(out.humidity == rec.humidity);
+        CHECK(out.water == rec.water);
+        CHECK(out.sequence == rec.sequence);
+        CHECK(out.battery == rec.battery);
+}
+
+static void test_adv_parser(void)
+{
+        static const uint8_t uuid[ADV_UUID128_LEN] = {
+                0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08,
+                0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0x10,
+        };
+        struct sensor_record rec = {
+                .temperature = 2150,
+                .humidity = 4800,
+                .water = 120,
+                .sequence = 7,
+                .battery = 88,
+        };
+        struct adv_report_info info;
+        uint8_t data[31];
+        uint8_t n = 0;
+
+        data[n++] = 2;
+        data[n++] = ADV_AD_TYPE_FLAGS;
+        data[n++] = 0x06;
+        data[n++] = 1 + ADV_UUID128_LEN;
+        data[n++] = ADV_AD_TYPE_UUID128_LIST;
+        memcpy(&data[n], uuid, ADV_UUID128_LEN);
+        n += ADV_UUID128_LEN;
+
+        CHECK(adv_parse_report(data, n, uuid, &info));
+        CHECK(info.uuid_match);
+        CHECK(!info.has_record);
+        CHECK(adv_has_uuid128(data, n, uuid));
+
+        // the broadcasting node's record, in the scan response
+        n = 0;
+        data[n++] = 1 + BLUETANIST_MFR_RECORD_LEN;
+        data[n++] = ADV_AD_TYPE_MANUFACTURER_DATA;
+        adv_encode_sensor_record(&rec, &data[n]);
+        n += BLUETANIST_MFR_RECORD_LEN;
+
+        CHECK(adv_parse_report(data, n, uuid, &info));
+        CHECK(!info.uuid_match);
+        CHECK(info.has_record);
+        CHECK(info.record.temperature == rec.temperature);
+        CHECK(info.record.sequence == rec.sequence);
+        CHECK(info.record.battery == rec.battery);
+
+        // a structure running past the end of the data
+        data[0] = 30;
+        CHECK(!adv_parse_report(data, n, uuid, &info));
+}
+
+static void test_aggregate(void)
+{
+        struct aggregate_entry entry = {
+                .addr = { 0x11, 0x22, 0x33, 0x44, 0x55, 0x66 },
+                .sequence = 300,
+                .age = 12,
+                .rssi = -67,
+                .valid = AGGREGATE_VALID_TEMPERATURE | AGGREGATE_VALID_HUMIDITY | AGGREGATE_VALID_SEQUENCE,
+                .battery = SENSOR_BATTERY_UNKNOWN,
+                .flags = AGGREGATE_FLAG_CONNECTED,
+                .hops = 1,
+                .temperature = (uint16_t) -250,
+                .humidity = 5100,
+        };
+        struct aggregate_entry out, next;
+        uint8_t buf[AGGREGATE_HDR_LEN + 2 * AGGREGATE_ENTRY_LEN];
+        uint8_t delta[AGGREGATE_DELTA_ENTRY_MAX_LEN];
+        uint16_t generation;
+        uint32_t timestamp;
+        uint8_t count, len_abs, len_rel;
+
+        aggregate_encode_header(buf, 2, 0x1234, 0xA0B0C0D0);
+        aggregate_encode_entry(&buf[AGGREGATE_HDR_LEN], &entry);
+        aggregate_encode_entry(&buf[AGGREGATE_HDR_LEN + AGGREGATE_ENTRY_LEN], &entry);
+
+        CHECK(aggregate_decode_header(buf, sizeof(buf), &count, &generation, &timestamp));
+        CHECK(count == 2);
+        CHECK(generation == 0x1234);
+        CHECK(timestamp == 0xA0B0C0D0);
+        // truncated frame
+        CHECK(!aggregate_decode_header(buf, sizeof(buf) - 1, &count, &generation, &timestamp));
+
+        aggregate_decode_entry(&buf[AGGREGATE_HDR_LEN + AGGREGATE_ENTRY_LEN], &out);
+        CHECK(memcmp(out.addr, entry.addr, sizeof(entry.addr)) == 0);
+        CHECK(out.sequence == entry.sequence);
+        CHECK(out.age == entry.age);
+        CHECK(out.rssi == entry.rssi);
+        CHECK(out.valid == entry.valid);
+        CHECK(out.battery == entry.battery);
+        CHECK(out.flags == entry.flags);
+        CHECK(out.hops == entry.hops);
+        CHECK(out.temperature == entry.temperature);
+        CHECK(out.humidity == entry.humidity);
+
+        aggregate_encode_delta_header(buf, 1, 0x1235, 0x1234, 1000);
+        CHECK(buf[0] == AGGREGATE_DELTA_VERSION);
+        CHECK(buf[0] & 0x80);
+
+        // a small change relative to the previous entry encodes shorter than absolute values
+        next = entry;
+        next.sequence++;
+        next.temperature += 3;
+        len_abs = aggregate_encode_delta_entry(delta, &next, NULL);
+        len_rel = aggregate_encode_delta_entry(delta, &next, &entry);
+        CHECK(len_abs <= AGGREGATE_DELTA_ENTRY_MAX_LEN);
+        CHECK(len_rel < len_abs);
+        CHECK(delta[6] & AGGREGATE_FLAG_DELTA);
+}
+
+/*
+ * Frames at the attribute value limit: AGGREGATE_MAX_ENTRIES entries fit in
+ * AGGREGATE_MAX_LEN bytes, one more does not and is not decoded
+ */
+static void test_aggregate_limit(void)
+{
+        static uint8_t buf[AGGREGATE_HDR_LEN + (AGGREGATE_MAX_ENTRIES + 1) * AGGREGATE_ENTRY_LEN];
+        struct aggregate_entry entry = {
+                .valid = AGGREGATE_VALID_TEMPERATURE,
+                .flags = AGGREGATE_FLAG_RELAYED,
+        };
+        struct aggregate_entry out;
+        uint16_t generation;
+        uint32_t timestamp;
+        uint8_t count;
+        int i;
+
+        CHECK(AGGREGATE_MAX_ENTRIES == 24);
+        CHECK(AGGREGATE_HDR_LEN + AGGREGATE_MAX_ENTRIES * AGGREGATE_ENTRY_LEN <= AGGREGATE_MAX_LEN);
+        CHECK(AGGREGATE_HDR_LEN + (AGGREGATE_MAX_ENTRIES + 1) * AGGREGATE_ENTRY_LEN > AGGREGATE_MAX_LEN);
+        // the worst delta frame of a full list does not fit, it goes as a full frame
+        CHECK(AGGREGATE_DELTA_HDR_LEN + AGGREGATE_MAX_ENTRIES * AGGREGATE_DELTA_ENTRY_MAX_LEN > AGGREGATE_MAX_LEN);
+
+        for (i = 0; i <= AGGREGATE_MAX_ENTRIES; i++) {
+                entry.addr[0] = i;
+                entry.temperature = 2000 + i;
+                aggregate_encode_entry(&buf[AGGREGATE_HDR_LEN + i * AGGREGATE_ENTRY_LEN], &entry);
+        }
+
+        aggregate_encode_header(buf, AGGREGATE_MAX_ENTRIES - 1, 7, 0);
+        CHECK(aggregate_decode_header(buf, AGGREGATE_MAX_LEN, &count, &generation, &timestamp));
+        CHECK(count == AGGREGATE_MAX_ENTRIES - 1);
+
+        aggregate_encode_header(buf, AGGREGATE_MAX_ENTRIES, 8, 0);
+        CHECK(aggregate_decode_header(buf, AGGREGATE_MAX_LEN, &count, &generation, &timestamp));
+        CHECK(count == AGGREGATE_MAX_ENTRIES);
+        aggregate_decode_entry(&buf[AGGREGATE_HDR_LEN + (count - 1) * AGGREGATE_ENTRY_LEN], &out);
+        CHECK(out.addr[0] == AGGREGATE_MAX_ENTRIES - 1);
+        CHECK(out.temperature == 2000 + AGGREGATE_MAX_ENTRIES - 1);
+
+        // one entry too many, even with the bytes for it
+        aggregate_encode_header(buf, AGGREGATE_MAX_ENTRIES + 1, 9, 0);
+        CHECK(!aggregate_decode_header(buf, sizeof(buf), &count, &generation, &timestamp));
+}
+
+static void test_filter(void)
+{
+        struct sensor_filter_config cfg = {
+                .ema_shift = 2,
+                .median = true,
+                .outlier_limit = 500,
+                .max_rejects = 2,
+                .change_delta = 10,
+        };
+        struct sensor_filter f;
+        int i;
+
+        sensor_filter_reset(&f);
+        CHECK(sensor_filter_update(&f, &cfg, 2000));
+        CHECK(sensor_filter_value(&f) == 2000);
+
+        // noise below the change delta is not reported
+        CHECK(!sensor_filter_update(&f, &cfg, 2004));
+        CHECK(!sensor_filter_update(&f, &cfg, 1997));
+
+        // a single spike is rejected
+        CHECK(!sensor_filter_update(&f, &cfg, 9000));
+        CHECK(sensor_filter_value(&f) < 2010);
+        CHECK(!sensor_filter_update(&f, &cfg, 2001));
+
+        // a sustained step is accepted after max_rejects samples
+        CHECK(!sensor_filter_update(&f, &cfg, 3000));
+        CHECK(!sensor_filter_update(&f, &cfg, 3000));
+        CHECK(sensor_filter_update(&f, &cfg, 3000));
+        CHECK(sensor_filter_value(&f) == 3000);
+
+        // the EMA converges on a constant input
+        for (i = 0; i < 50; i++) {
+                sensor_filter_update(&f, &cfg, 3200);
+        }
+        CHECK(sensor_filter_value(&f) == 3200);
+}
+
+/*
+ * Replay a trace of traces/: comment lines start with '#', the "filter:" one holds
+ * the configuration of the channel. Each line is an oversampled sample, the filter
+ * output after it and whether a change was reported; a sample without an input is
+ * a period without a valid reading, which leaves the filter alone.
+ */
+static void test_filter_trace(const char *path)
+{
+        struct sensor_filter_config cfg;
+        struct sensor_filter f;
+        char line[128];
+        int ema_shift, median;
+        int input, output, changed;
+        int samples = 0, bad = 0;
+        bool configured = false;
+        bool reported;
+        FILE *fp;
+
+        fp = fopen(path, "r");
+        CHECK(fp != NULL);
+        if (fp == NULL) {
+                return;
+        }
+
+        memset(&cfg, 0, sizeof(cfg));
+        sensor_filter_reset(&f);
+
+        while (fgets(line, sizeof(line), fp)) {
+                if (line[0] == '#') {
+                        if (sscanf(line, "# filter: ema_shift=%d median=%d outlier_limit=%d max_rejects=%hhu "
+                                        "change_delta=%d", &ema_shift, &median, &cfg.outlier_limit,
+                                        &cfg.max_rejects, &cfg.change_delta) == 5) {
+                                cfg.ema_shift = ema_shift;
+                                cfg.median = median;
+                                configured = true;
+                        }
+                        continue;
+                }
+
+                if (line[0] == ',') {
+                        if (sscanf(line, ",%d,%d", &output, &changed) != 2) {
+                                break;
+                        }
+                        reported = false;
+                } else {
+                        if (sscanf(line, "%d,%d,%d", &input, &output, &changed) != 3) {
+                                break;
+                        }
+                        reported = sensor_filter_update(&f, &cfg, input);
+                }
+
+                samples++;
+                if (sensor_filter_value(&f) != output || reported != (changed != 0)) {
+                        if (bad++ == 0) {
+                                printf("%s: sample %d: output %ld changed %d, expected %d %d\n", path, samples,
+                                        (long)sensor_filter_value(&f), reported, output, changed);
+                        }
+                }
+        }
+        CHECK(feof(fp));
+        fclose(fp);
+
+        CHECK(configured);
+        CHECK(samples > 0);
+        CHECK(bad == 0);
+}
+
+static void test_snapshot(void)
+{
+        struct sensor_snapshot_buf *buf = &sensor_snapshots;
+        struct sensor_snapshot *w;
+        const struct sensor_snapshot *r;
+
+        memset(buf, 0, sizeof(*buf));
+
+        w = sensor_snapshot_begin(buf);
+        w->record.temperature = 2100;
+        w->record.humidity = 0x1234;
+        w->timestamp = 1;
+        sensor_snapshot_publish(buf, w);
+
+        r = sensor_snapshot_acquire(buf);
+        CHECK(r == w);
+        CHECK(r->value[SENSOR_CH_HUMIDITY][0] == 0x34);
+        CHECK(r->value[SENSOR_CH_HUMIDITY][1] == 0x12);
+
+        // the writer never fills the pinned or the published buffer
+        w = sensor_snapshot_begin(buf);
+        CHECK(w != r);
+        w->timestamp = 2;
+        sensor_snapshot_publish(buf, w);
+        w = sensor_snapshot_begin(buf);
+        CHECK(w != r);
+        CHECK(w->timestamp != 2);
+        CHECK(r->timestamp == 1);
+        sensor_snapshot_release(buf);
+
+        r = sensor_snapshot_acquire(buf);
+        CHECK(r->timestamp == 2);
+        sensor_snapshot_release(buf);
+}
+
+static void test_time_sync(void)
+{
+        struct time_sync ts;
+        uint32_t local, fleet, delay;
+        int i;
+
+        time_sync_reset(&ts);
+        CHECK(time_sync_now(&ts, 1234) == 1234);
+
+        time_sync_update(&ts, 1000, 500000);
+        CHECK(time_sync_now(&ts, 1000) == 500000);
+        CHECK(time_sync_now(&ts, 2000) == 501000);
+
+        // local clock 200 ppm slow: the drift estimate converges within the EMA
+        for (i = 1; i <= 20; i++) {
+                local = 1000 + i * TIME_SYNC_MIN_DRIFT_MS;
+                fleet = 500000 + i * (TIME_SYNC_MIN_DRIFT_MS + TIME_SYNC_MIN_DRIFT_MS / 5000);
+                time_sync_update(&ts, local, fleet);
+        }
+        CHECK(ts.drift_ppm >= 190 && ts.drift_ppm <= 200);
+        CHECK(ts.last_error >= -2 && ts.last_error <= 2);
+
+        // a jump of the master clock is not taken as drift
+        time_sync_update(&ts, local + TIME_SYNC_MIN_DRIFT_MS, fleet + 10 * TIME_SYNC_MIN_DRIFT_MS);
+        CHECK(ts.drift_ppm >= 190 && ts.drift_ppm <= 200);
+
+        time_sync_reset(&ts);
+        delay = time_sync_epoch_delay(&ts, 9000, 10000, 0);
+        CHECK(delay == 11000);
+        delay = time_sync_epoch_delay(&ts, 5000, 10000, 0);
+        CHECK(delay == 5000);
+        delay = time_sync_epoch_delay(&ts, 5000, 10000, 2000);
+        CHECK(delay == 7000);
+}
+
+static void test_rules(void)
+{
+        struct sensor_rules *rules = &alarm_rules;
+        int32_t value[SENSOR_CH_COUNT] = { 2000, 5000, 0 };
+        uint8_t cfg[1 + 2 * SENSOR_RULE_LEN] = {
+                0,
+                SENSOR_CH_TEMPERATURE, SENSOR_RULE_MAX, 0xC4, 0x09, 0x64, 0x00,   /* > 25.00, hyst 1.00 */
+                SENSOR_CH_HUMIDITY, SENSOR_RULE_RATE, 0xE8, 0x03, 0x00, 0x00,     /* > 10.00 per minute */
+        };
+        uint8_t out[sizeof(cfg)];
+        uint8_t bad[1 + SENSOR_RULE_LEN] = { 0, SENSOR_CH_COUNT, SENSOR_RULE_MIN, 0, 0, 0, 0 };
+
+        memset(rules, 0, sizeof(*rules));
+        CHECK(sensor_rules_compile(rules, cfg, sizeof(cfg)));
+        CHECK(rules->count == 2);
+        CHECK(sensor_rules_encode(rules, out, sizeof(out)) == sizeof(cfg));
+        CHECK(memcmp(out, cfg, sizeof(cfg)) == 0);
+
+        // malformed writes leave the table unchanged
+        CHECK(!sensor_rules_compile(rules, bad, sizeof(bad)));
+        CHECK(!sensor_rules_compile(rules, cfg, sizeof(cfg) - 1));
+        CHECK(rules->count == 2);
+
+        CHECK(sensor_rules_eval(rules, value, 0) == 0);
+        value[SENSOR_CH_TEMPERATURE] = 2501;
+        CHECK(sensor_rules_eval(rules, value, 60000) == (1 << 0));
+        // inside the hysteresis the rule stays active
+        value[SENSOR_CH_TEMPERATURE] = 2450;
+        CHECK(sensor_rules_eval(rules, value, 120000) == 0);
+        value[SENSOR_CH_TEMPERATURE] = 2400;
+        CHECK(sensor_rules_eval(rules, value, 180000) == (1 << 0));
+        CHECK(rules->active == 0);
+
+        // 20.00 in 30 s is 40.00 per minute
+        value[SENSOR_CH_HUMIDITY] = 7000;
+        CHECK(sensor_rules_eval(rules, value, 210000) == (1 << 1));
+        CHECK(rules->active == (1 << 1));
+        CHECK(rules->changed == ((1 << 0) | (1 << 1)));
+}
+
+int main(void)
+{
+        test_record();
+        test_adv_parser();
+        test_aggregate();
+        test_aggregate_limit();
+        test_filter();
+        test_filter_trace("traces/spike.csv");
+        test_filter_trace("traces/dropout.csv");
+        test_snapshot();
+        test_time_sync();
+        test_rules();
+
+        printf("%d checks, %d failed\n", checks, failures);
+
+        return failures ? 1 : 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * ad_i2c.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK I2C adapter, implemented by host_i2c.c. The bus has a
+ * model of the HIH6130 sensor on it (host_sdk.h).
+ */
+
+#ifndef TEST_SDK_AD_I2C_H_
+#define TEST_SDK_AD_I2C_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hw_gpio.h"
+#include "hw_i2c.h"
+
+typedef enum {
+        AD_IO_CONF_OFF = 0,
+        AD_IO_CONF_ON = 1,
+} AD_IO_CONF_STATE;
+
+typedef struct {
+        HW_GPIO_MODE mode;
+        HW_GPIO_FUNC function;
+        bool high;
+} ad_io_conf_t;
+
+typedef struct {
+        HW_GPIO_PORT port;
+        HW_GPIO_PIN pin;
+        ad_io_conf_t on;
+        ad_io_conf_t off;
+} ad_pin_conf_t;
+
+typedef struct {
+        ad_pin_conf_t scl;
+        ad_pin_conf_t sda;
+        HW_GPIO_POWER voltage_level;
+} ad_i2c_io_conf_t;
+
+typedef struct {
+        uint8_t clk_cfg;
+        i2c_config i2c;
+} ad_i2c_driver_conf_t;
+
+typedef struct {
+        HW_I2C_ID id;
+        const ad_i2c_io_conf_t *io;
+        const ad_i2c_driver_conf_t *drv;
+} ad_i2c_controller_conf_t;
+
+typedef void *ad_i2c_handle_t;
+
+#define I2C_DEFAULT_CLK_CFG             .clk_cfg = 0
+
+ad_i2c_handle_t ad_i2c_open(const ad_i2c_controller_conf_t *conf);
+int ad_i2c_close(ad_i2c_handle_t handle, bool force);
+int ad_i2c_write(ad_i2c_handle_t handle, const uint8_t *wbuf, size_t wlen, uint8_t condition_flags);
+int ad_i2c_read(ad_i2c_handle_t handle, uint8_t *rbuf, size_t rlen, uint8_t condition_flags);
+int ad_i2c_io_config(HW_I2C_ID id, const ad_i2c_io_conf_t *io_config, AD_IO_CONF_STATE state);
+
+#endif /* TEST_SDK_AD_I2C_H_ */
@@ -0,0 +1,72 @@
+/*
+ * ble_bufops.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK little endian buffer helpers.
+ */
+
+#ifndef TEST_SDK_BLE_BUFOPS_H_
+#define TEST_SDK_BLE_BUFOPS_H_
+
+#include <stdint.h>
+
+static inline uint16_t get_u16(const uint8_t *buffer)
+{
+        return buffer[0] | (buffer[1] << 8);
+}
+
+static inline uint32_t get_u32(const uint8_t *buffer)
+{
+        return buffer[0] | (buffer[1] << 8) | (buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+static inline void put_u16(uint8_t *buffer, uint16_t value)
+{
+        buffer[0] = value;
+        buffer[1] = value >> 8;
+}
+
+static inline void put_u32(uint8_t *buffer, uint32_t value)
+{
+        buffer[0] = value;
+        buffer[1] = value >> 8;
+        buffer[2] = value >> 16;
+        buffer[3] = value >> 24;
+}
+
+static inline uint16_t get_u16_inc(const uint8_t **buffer)
+{
+        uint16_t value = get_u16(*buffer);
+
+        *buffer += 2;
+        return value;
+}
+
+static inline uint32_t get_u32_inc(const uint8_t **buffer)
+{
+        uint32_t value = get_u32(*buffer);
+
+        *buffer += 4;
+        return value;
+}
+
+static inline void put_u8_inc(uint8_t **buffer, uint8_t value)
+{
+        *(*buffer)++ = value;
+}
+
+static inline void put_u16_inc(uint8_t **buffer, uint16_t value)
+{
+        put_u16(*buffer, value);
+        *buffer += 2;
+}
+
+static inline void put_u32_inc(uint8_t **buffer, uint32_t value)
+{
+        put_u32(*buffer, value);
+        *buffer += 4;
+}
+
+#endif /* TEST_SDK_BLE_BUFOPS_H_ */
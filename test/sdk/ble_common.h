@@ -0,0 +1,91 @@
+/*
+ * ble_common.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK BLE common definitions, implemented by host_ble.c.
+ */
+
+#ifndef TEST_SDK_BLE_COMMON_H_
+#define TEST_SDK_BLE_COMMON_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+        BLE_STATUS_OK = 0x00,
+        BLE_ERROR_FAILED = 0x01,
+        BLE_ERROR_ALREADY_DONE = 0x02,
+        BLE_ERROR_IN_PROGRESS = 0x03,
+        BLE_ERROR_INVALID_PARAM = 0x04,
+        BLE_ERROR_NOT_ALLOWED = 0x05,
+        BLE_ERROR_NOT_CONNECTED = 0x06,
+        BLE_ERROR_NOT_SUPPORTED = 0x07,
+        BLE_ERROR_NOT_ACCEPTED = 0x08,
+        BLE_ERROR_BUSY = 0x09,
+        BLE_ERROR_TIMEOUT = 0x0A,
+        BLE_ERROR_NOT_SUPPORTED_BY_PEER = 0x0B,
+        BLE_ERROR_CANCELED = 0x0C,
+        BLE_ERROR_ENC_KEY_MISSING = 0x0D,
+        BLE_ERROR_INS_RESOURCES = 0x0E,
+        BLE_ERROR_NOT_FOUND = 0x0F,
+} ble_error_t;
+
+/* HCI error codes */
+#define BLE_HCI_ERROR_NO_ERROR                  (0x00)
+#define BLE_HCI_ERROR_CON_TIMEOUT               (0x08)
+#define BLE_HCI_ERROR_REMOTE_USER_TERM_CON      (0x13)
+#define BLE_HCI_ERROR_CON_TERM_BY_LOCAL_HOST    (0x16)
+#define BLE_HCI_ERROR_UNACCEPTABLE_CONN_INT     (0x3B)
+#define BLE_HCI_ERROR_CONN_FAILED_TO_BE_EST     (0x3E)
+
+#define BLE_CONN_IDX_INVALID            (0xFFFF)
+
+/* Task notification bit of the application for new BLE events */
+#define BLE_APP_NOTIFY_MASK             (1 << 0)
+
+typedef enum {
+        BLE_EVT_CAT_COMMON,
+        BLE_EVT_CAT_GAP,
+        BLE_EVT_CAT_GATTS,
+        BLE_EVT_CAT_GATTC,
+        BLE_EVT_CAT_L2CAP,
+} ble_evt_cat_t;
+
+#define BLE_EVT_CAT_FIRST(cat)          ((cat) << 8)
+
+typedef struct {
+        uint16_t evt_code;
+        uint16_t length;
+} ble_evt_hdr_t;
+
+typedef enum {
+        PUBLIC_ADDRESS = 0x00,
+        PRIVATE_ADDRESS = 0x01,
+} addr_type_t;
+
+#define BD_ADDR_LEN                     (6)
+
+typedef struct {
+        addr_type_t addr_type;
+        uint8_t addr[BD_ADDR_LEN];
+} bd_address_t;
+
+typedef bd_address_t own_address_t;
+
+ble_error_t ble_register_app(void);
+ble_error_t ble_enable(void);
+ble_evt_hdr_t *ble_get_event(bool wait);
+bool ble_has_event(void);
+
+/*
+ * Event loop of the tuning image: test/Makefile builds libnode_tune.so with
+ * CFG_BLE_EVT_BATCH and CFG_BLE_EVT_BUDGET_MS on these, ble_replay -t sets them
+ */
+extern uint16_t host_ble_evt_batch;
+extern uint32_t host_ble_evt_budget_ms;
+void ble_handle_event_default(ble_evt_hdr_t *hdr);
+const char *ble_address_to_string(const bd_address_t *address);
+
+#endif /* TEST_SDK_BLE_COMMON_H_ */
@@ -0,0 +1,283 @@
+/*
+ * ble_gap.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK GAP API, implemented by host_ble.c.
+ */
+
+#ifndef TEST_SDK_BLE_GAP_H_
+#define TEST_SDK_BLE_GAP_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ble_common.h"
+#include "ble_att.h"
+
+#define BLE_ADV_DATA_LEN_MAX            (31)
+#define BLE_SCAN_RSP_LEN_MAX            (31)
+#define BLE_GAP_DEVNAME_LEN_MAX         (64)
+
+#define BLE_ADV_INTERVAL_FROM_MS(ms)    ((ms) * 1000 / 625)
+#define BLE_SCAN_INTERVAL_FROM_MS(ms)   ((ms) * 1000 / 625)
+#define BLE_SCAN_WINDOW_FROM_MS(ms)     ((ms) * 1000 / 625)
+#define BLE_CONN_INTERVAL_FROM_MS(ms)   ((ms) * 100 / 125)
+#define BLE_CONN_INTERVAL_TO_MS(val)    ((val) * 125 / 100)
+#define BLE_SUPERVISION_TMO_FROM_MS(ms) ((ms) / 10)
+
+enum ble_evt_gap {
+        BLE_EVT_GAP_CONNECTED = BLE_EVT_CAT_FIRST(BLE_EVT_CAT_GAP),
+        BLE_EVT_GAP_ADV_REPORT,
+        BLE_EVT_GAP_DISCONNECTED,
+        BLE_EVT_GAP_DISCONNECT_FAILED,
+        BLE_EVT_GAP_ADV_COMPLETED,
+        BLE_EVT_GAP_SCAN_COMPLETED,
+        BLE_EVT_GAP_CONN_PARAM_UPDATE_REQ,
+        BLE_EVT_GAP_CONN_PARAM_UPDATED,
+        BLE_EVT_GAP_PAIR_REQ,
+        BLE_EVT_GAP_PAIR_COMPLETED,
+        BLE_EVT_GAP_SECURITY_REQUEST,
+        BLE_EVT_GAP_PASSKEY_NOTIFY,
+        BLE_EVT_GAP_PASSKEY_REQUEST,
+        BLE_EVT_GAP_SEC_LEVEL_CHANGED,
+        BLE_EVT_GAP_ADDRESS_RESOLVED,
+        BLE_EVT_GAP_SET_SEC_LEVEL_FAILED,
+        BLE_EVT_GAP_CONN_PARAM_UPDATE_COMPLETED,
+        BLE_EVT_GAP_DATA_LENGTH_CHANGED,
+        BLE_EVT_GAP_DATA_LENGTH_SET_FAILED,
+        BLE_EVT_GAP_CONNECTION_COMPLETED,
+        BLE_EVT_GAP_NUMERIC_REQUEST,
+        BLE_EVT_GAP_ADDRESS_RESOLUTION_FAILED,
+        BLE_EVT_GAP_LTK_MISSING,
+        BLE_EVT_GAP_AIR_OP_BDADDR,
+        BLE_EVT_GAP_PHY_SET_COMPLETED,
+        BLE_EVT_GAP_PHY_CHANGED,
+};
+
+typedef enum {
+        GAP_NO_ROLE = 0x00,
+        GAP_OBSERVER_ROLE = 0x01,
+        GAP_BROADCASTER_ROLE = 0x02,
+        GAP_CENTRAL_ROLE = 0x04,
+        GAP_PERIPHERAL_ROLE = 0x08,
+} gap_role_t;
+
+typedef enum {
+        GAP_CONN_MODE_NON_CONN,
+        GAP_CONN_MODE_UNDIRECTED,
+        GAP_CONN_MODE_DIRECTED,
+        GAP_CONN_MODE_DIRECTED_LDC,
+} gap_conn_mode_t;
+
+typedef enum {
+        GAP_SCAN_ACTIVE,
+        GAP_SCAN_PASSIVE,
+} gap_scan_type_t;
+
+typedef enum {
+        GAP_SCAN_GEN_DISC_MODE,
+        GAP_SCAN_LIM_DISC_MODE,
+        GAP_SCAN_OBSERVER_MODE,
+} gap_scan_mode_t;
+
+typedef enum {
+        GAP_DATA_TYPE_FLAGS = 0x01,
+        GAP_DATA_TYPE_UUID16_LIST_INC = 0x02,
+        GAP_DATA_TYPE_UUID16_LIST = 0x03,
+        GAP_DATA_TYPE_UUID128_LIST_INC = 0x06,
+        GAP_DATA_TYPE_UUID128_LIST = 0x07,
+        GAP_DATA_TYPE_SHORT_LOCAL_NAME = 0x08,
+        GAP_DATA_TYPE_LOCAL_NAME = 0x09,
+        GAP_DATA_TYPE_TX_POWER_LEVEL = 0x0A,
+        GAP_DATA_TYPE_MANUFACTURER_SPEC = 0xFF,
+} gap_data_type_t;
+
+/* Types of advertising reports */
+typedef enum {
+        GAP_ADV_IND,
+        GAP_ADV_DIRECT_IND,
+        GAP_ADV_SCAN_IND,
+        GAP_ADV_NONCONN_IND,
+        GAP_SCAN_RSP,
+} gap_adv_type_t;
+
+typedef enum {
+        BLE_GAP_PHY_1M = 1,
+        BLE_GAP_PHY_2M = 2,
+        BLE_GAP_PHY_CODED = 3,
+} ble_gap_phy_t;
+
+typedef enum {
+        BLE_GAP_PHY_PREF_AUTO = 0x00,
+        BLE_GAP_PHY_PREF_1M = 0x01,
+        BLE_GAP_PHY_PREF_2M = 0x02,
+        BLE_GAP_PHY_PREF_CODED = 0x04,
+} ble_gap_phy_pref_t;
+
+typedef struct {
+        uint8_t len;
+        uint8_t type;
+        const uint8_t *data;
+} gap_adv_ad_struct_t;
+
+#define GAP_ADV_AD_STRUCT_BYTES(_type, ...)                                             \
+        {                                                                               \
+                .len = sizeof((uint8_t[]) { __VA_ARGS__ }),                             \
+                .type = (_type),                                                        \
+                .data = (const uint8_t[]) { __VA_ARGS__ },                              \
+        }
+
+#define GAP_ADV_AD_STRUCT_DECLARE(_type, _len, _data)                                   \
+        &(gap_adv_ad_struct_t) {                                                        \
+                .len = (_len),                                                          \
+                .type = (_type),                                                        \
+                .data = (const uint8_t *)(_data),                                       \
+        }
+
+typedef struct {
+        uint16_t interval_min;
+        uint16_t interval_max;
+        uint16_t slave_latency;
+        uint16_t sup_timeout;
+} gap_conn_params_t;
+
+typedef struct {
+        bd_address_t address;
+        uint16_t conn_idx;
+        bool connected;
+        bool bonded;
+        bool paired;
+        bool mitm;
+        bool secure;
+} gap_device_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        bd_address_t own_addr;
+        bd_address_t peer_address;
+        gap_conn_params_t conn_params;
+} ble_evt_gap_connected_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        bd_address_t address;
+        uint8_t reason;
+} ble_evt_gap_disconnected_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint8_t adv_type;
+        uint8_t status;
+} ble_evt_gap_adv_completed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint8_t type;
+        bd_address_t address;
+        int8_t rssi;
+        uint8_t length;
+        uint8_t data[BLE_ADV_DATA_LEN_MAX];
+} ble_evt_gap_adv_report_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint8_t scan_type;
+        uint8_t status;
+} ble_evt_gap_scan_completed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        gap_conn_params_t conn_params;
+} ble_evt_gap_conn_param_update_req_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        gap_conn_params_t conn_params;
+} ble_evt_gap_conn_param_updated_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint8_t status;
+} ble_evt_gap_conn_param_update_completed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        bool bond;
+} ble_evt_gap_pair_req_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint8_t status;
+        bool bond;
+        bool mitm;
+} ble_evt_gap_pair_completed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint16_t max_tx_length;
+        uint16_t max_tx_time;
+        uint16_t max_rx_length;
+        uint16_t max_rx_time;
+} ble_evt_gap_data_length_changed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint8_t status;
+} ble_evt_gap_data_length_set_failed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint8_t status;
+} ble_evt_gap_connection_completed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint8_t status;
+} ble_evt_gap_phy_set_completed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        ble_gap_phy_t tx_phy;
+        ble_gap_phy_t rx_phy;
+} ble_evt_gap_phy_changed_t;
+
+ble_error_t ble_gap_address_get(own_address_t *address);
+ble_error_t ble_gap_role_set(gap_role_t role);
+ble_error_t ble_gap_device_name_set(const char *name, att_perm_t perm);
+ble_error_t ble_gap_mtu_size_get(uint16_t *mtu_size);
+ble_error_t ble_gap_mtu_size_set(uint16_t mtu_size);
+ble_error_t ble_gap_adv_ad_struct_set(size_t ad_len, const gap_adv_ad_struct_t *ad, size_t sd_len,
+        const gap_adv_ad_struct_t *sd);
+ble_error_t ble_gap_adv_start(gap_conn_mode_t adv_type);
+ble_error_t ble_gap_adv_stop(void);
+ble_error_t ble_gap_scan_start(gap_scan_type_t type, gap_scan_mode_t mode, uint16_t interval,
+        uint16_t window, bool filt_wlist, bool filt_dupl);
+ble_error_t ble_gap_scan_stop(void);
+ble_error_t ble_gap_connect(const bd_address_t *peer_addr, const gap_conn_params_t *conn_params);
+ble_error_t ble_gap_connect_cancel(void);
+ble_error_t ble_gap_disconnect(uint16_t conn_idx, uint8_t reason);
+ble_error_t ble_gap_get_connected(uint8_t *length, uint16_t **conn_idx);
+ble_error_t ble_gap_get_device_by_conn_idx(uint16_t conn_idx, gap_device_t *gap_device);
+ble_error_t ble_gap_conn_rssi_get(uint16_t conn_idx, int8_t *conn_rssi);
+ble_error_t ble_gap_conn_param_update(uint16_t conn_idx, const gap_conn_params_t *conn_params);
+ble_error_t ble_gap_conn_param_update_reply(uint16_t conn_idx, bool accept);
+ble_error_t ble_gap_pair_reply(uint16_t conn_idx, bool accept, bool bond);
+ble_error_t ble_gap_data_length_set(uint16_t conn_idx, uint16_t tx_length, uint16_t tx_time);
+ble_error_t ble_gap_phy_set(uint16_t conn_idx, ble_gap_phy_pref_t tx_phy_pref,
+        ble_gap_phy_pref_t rx_phy_pref);
+
+#endif /* TEST_SDK_BLE_GAP_H_ */
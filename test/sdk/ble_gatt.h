@@ -0,0 +1,41 @@
+/*
+ * ble_gatt.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK GATT definitions.
+ */
+
+#ifndef TEST_SDK_BLE_GATT_H_
+#define TEST_SDK_BLE_GATT_H_
+
+typedef enum {
+        GATT_SERVICE_PRIMARY,
+        GATT_SERVICE_SECONDARY,
+} gatt_service_t;
+
+typedef enum {
+        GATT_EVENT_NOTIFICATION,
+        GATT_EVENT_INDICATION,
+} gatt_event_t;
+
+typedef enum {
+        GATT_PROP_NONE = 0,
+        GATT_PROP_BROADCAST = 0x01,
+        GATT_PROP_READ = 0x02,
+        GATT_PROP_WRITE_NO_RESP = 0x04,
+        GATT_PROP_WRITE = 0x08,
+        GATT_PROP_NOTIFY = 0x10,
+        GATT_PROP_INDICATE = 0x20,
+        GATT_PROP_WRITE_SIGNED = 0x40,
+        GATT_PROP_EXTENDED = 0x80,
+} gatt_prop_t;
+
+typedef enum {
+        GATT_CCC_NONE = 0x0000,
+        GATT_CCC_NOTIFICATIONS = 0x0001,
+        GATT_CCC_INDICATIONS = 0x0002,
+} gatt_ccc_t;
+
+#endif /* TEST_SDK_BLE_GATT_H_ */
@@ -0,0 +1,111 @@
+/*
+ * ble_gattc.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK GATT client API, implemented by host_ble.c.
+ */
+
+#ifndef TEST_SDK_BLE_GATTC_H_
+#define TEST_SDK_BLE_GATTC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble_common.h"
+#include "ble_att.h"
+#include "ble_gatt.h"
+
+enum ble_evt_gattc {
+        BLE_EVT_GATTC_BROWSE_SVC = BLE_EVT_CAT_FIRST(BLE_EVT_CAT_GATTC),
+        BLE_EVT_GATTC_BROWSE_COMPLETED,
+        BLE_EVT_GATTC_DISCOVER_SVC,
+        BLE_EVT_GATTC_DISCOVER_INCLUDE,
+        BLE_EVT_GATTC_DISCOVER_CHAR,
+        BLE_EVT_GATTC_DISCOVER_DESC,
+        BLE_EVT_GATTC_DISCOVER_COMPLETED,
+        BLE_EVT_GATTC_READ_COMPLETED,
+        BLE_EVT_GATTC_WRITE_COMPLETED,
+        BLE_EVT_GATTC_NOTIFICATION,
+        BLE_EVT_GATTC_INDICATION,
+        BLE_EVT_GATTC_MTU_CHANGED,
+};
+
+typedef enum {
+        GATTC_DISCOVERY_TYPE_SVC = 0x01,
+        GATTC_DISCOVERY_TYPE_INCLUDED = 0x02,
+        GATTC_DISCOVERY_TYPE_CHARACTERISTICS = 0x03,
+        GATTC_DISCOVERY_TYPE_DESCRIPTORS = 0x04,
+} gattc_discovery_type_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        att_uuid_t uuid;
+        uint16_t start_h;
+        uint16_t end_h;
+} ble_evt_gattc_discover_svc_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        att_uuid_t uuid;
+        uint16_t handle;
+        uint16_t value_handle;
+        uint8_t properties;
+} ble_evt_gattc_discover_char_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        gattc_discovery_type_t type;
+        uint8_t status;
+} ble_evt_gattc_discover_completed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint16_t handle;
+        att_error_t status;
+        uint16_t offset;
+        uint16_t length;
+        uint8_t value[];
+} ble_evt_gattc_read_completed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint16_t handle;
+        att_error_t status;
+        uint16_t operation;
+} ble_evt_gattc_write_completed_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint16_t handle;
+        uint16_t length;
+        uint8_t value[];
+} ble_evt_gattc_notification_t;
+
+typedef ble_evt_gattc_notification_t ble_evt_gattc_indication_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint16_t mtu;
+} ble_evt_gattc_mtu_changed_t;
+
+ble_error_t ble_gattc_get_mtu(uint16_t conn_idx, uint16_t *mtu);
+ble_error_t ble_gattc_exchange_mtu(uint16_t conn_idx);
+ble_error_t ble_gattc_discover_svc(uint16_t conn_idx, const att_uuid_t *uuid);
+ble_error_t ble_gattc_discover_char(uint16_t conn_idx, uint16_t start_h, uint16_t end_h,
+        const att_uuid_t *uuid);
+ble_error_t ble_gattc_read(uint16_t conn_idx, uint16_t handle, uint16_t offset);
+ble_error_t ble_gattc_write(uint16_t conn_idx, uint16_t handle, uint16_t offset, uint16_t length,
+        const uint8_t *value);
+ble_error_t ble_gattc_write_no_resp(uint16_t conn_idx, uint16_t handle, bool signed_write,
+        uint16_t length, const uint8_t *value);
+
+#endif /* TEST_SDK_BLE_GATTC_H_ */
@@ -0,0 +1,78 @@
+/*
+ * ble_gatts.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK GATT server API, implemented by host_ble.c.
+ */
+
+#ifndef TEST_SDK_BLE_GATTS_H_
+#define TEST_SDK_BLE_GATTS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble_common.h"
+#include "ble_att.h"
+#include "ble_gatt.h"
+
+enum ble_evt_gatts {
+        BLE_EVT_GATTS_READ_REQ = BLE_EVT_CAT_FIRST(BLE_EVT_CAT_GATTS),
+        BLE_EVT_GATTS_WRITE_REQ,
+        BLE_EVT_GATTS_PREPARE_WRITE_REQ,
+        BLE_EVT_GATTS_EVENT_SENT,
+};
+
+/* Read requests of the attribute go to the application */
+#define GATTS_FLAG_CHAR_READ_REQ        (0x01)
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint16_t handle;
+        uint16_t offset;
+} ble_evt_gatts_read_req_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint16_t handle;
+        uint16_t offset;
+        uint16_t length;
+        uint8_t value[];
+} ble_evt_gatts_write_req_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint16_t handle;
+        uint16_t offset;
+        uint16_t length;
+} ble_evt_gatts_prepare_write_req_t;
+
+typedef struct {
+        ble_evt_hdr_t hdr;
+        uint16_t conn_idx;
+        uint16_t handle;
+        gatt_event_t type;
+        bool status;
+} ble_evt_gatts_event_sent_t;
+
+uint16_t ble_gatts_get_num_attr(uint16_t include, uint16_t characteristics, uint16_t descriptors);
+ble_error_t ble_gatts_add_service(const att_uuid_t *uuid, const gatt_service_t type, uint16_t num_attrs);
+ble_error_t ble_gatts_add_characteristic(const att_uuid_t *uuid, gatt_prop_t prop, att_perm_t perm,
+        uint16_t max_len, uint8_t flags, uint16_t *h_offset, uint16_t *h_val_offset);
+ble_error_t ble_gatts_add_descriptor(const att_uuid_t *uuid, att_perm_t perm, uint16_t max_len,
+        uint8_t flags, uint16_t *h_offset);
+ble_error_t ble_gatts_register_service(uint16_t *handle, ...);
+ble_error_t ble_gatts_set_value(uint16_t handle, uint16_t length, const void *value);
+ble_error_t ble_gatts_read_cfm(uint16_t conn_idx, uint16_t handle, att_error_t status, uint16_t length,
+        const void *value);
+ble_error_t ble_gatts_write_cfm(uint16_t conn_idx, uint16_t handle, att_error_t status);
+ble_error_t ble_gatts_prepare_write_cfm(uint16_t conn_idx, uint16_t handle, uint16_t length,
+        att_error_t status);
+ble_error_t ble_gatts_send_event(uint16_t conn_idx, uint16_t handle, gatt_event_t type, uint16_t length,
+        const void *value);
+
+#endif /* TEST_SDK_BLE_GATTS_H_ */
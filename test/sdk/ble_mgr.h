@@ -0,0 +1,15 @@
+/*
+ * ble_mgr.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK BLE manager, implemented by host_ble.c.
+ */
+
+#ifndef TEST_SDK_BLE_MGR_H_
+#define TEST_SDK_BLE_MGR_H_
+
+void ble_mgr_init(void);
+
+#endif /* TEST_SDK_BLE_MGR_H_ */
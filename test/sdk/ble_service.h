@@ -0,0 +1,45 @@
+/*
+ * ble_service.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK BLE service framework, implemented by host_ble.c.
+ */
+
+#ifndef TEST_SDK_BLE_SERVICE_H_
+#define TEST_SDK_BLE_SERVICE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble_gap.h"
+#include "ble_gatts.h"
+
+typedef struct ble_service ble_service_t;
+
+typedef void (*ble_service_connected_evt_t)(ble_service_t *svc, const ble_evt_gap_connected_t *evt);
+typedef void (*ble_service_disconnected_evt_t)(ble_service_t *svc, const ble_evt_gap_disconnected_t *evt);
+typedef void (*ble_service_read_req_t)(ble_service_t *svc, const ble_evt_gatts_read_req_t *evt);
+typedef void (*ble_service_write_req_t)(ble_service_t *svc, const ble_evt_gatts_write_req_t *evt);
+typedef void (*ble_service_prepare_write_req_t)(ble_service_t *svc,
+        const ble_evt_gatts_prepare_write_req_t *evt);
+typedef void (*ble_service_event_sent_t)(ble_service_t *svc, const ble_evt_gatts_event_sent_t *evt);
+typedef void (*ble_service_cleanup_t)(ble_service_t *svc);
+
+struct ble_service {
+        uint16_t start_h;
+        uint16_t end_h;
+        ble_service_connected_evt_t connected_evt;
+        ble_service_disconnected_evt_t disconnected_evt;
+        ble_service_read_req_t read_req;
+        ble_service_write_req_t write_req;
+        ble_service_prepare_write_req_t prepare_write_req;
+        ble_service_event_sent_t event_sent;
+        ble_service_cleanup_t cleanup;
+};
+
+void ble_service_add(ble_service_t *svc);
+bool ble_service_handle_event(const ble_evt_hdr_t *evt);
+
+#endif /* TEST_SDK_BLE_SERVICE_H_ */
@@ -0,0 +1,27 @@
+/*
+ * ble_storage.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK BLE storage, implemented by host_ble.c. Values are kept
+ * per peer; values of a peer which is not bonded are dropped when it disconnects.
+ */
+
+#ifndef TEST_SDK_BLE_STORAGE_H_
+#define TEST_SDK_BLE_STORAGE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble_common.h"
+
+typedef uint32_t ble_storage_key_t;
+
+ble_error_t ble_storage_put_u32(uint16_t conn_idx, ble_storage_key_t key, uint32_t value, bool persistent);
+ble_error_t ble_storage_get_u16(uint16_t conn_idx, ble_storage_key_t key, uint16_t *value);
+ble_error_t ble_storage_get_u32(uint16_t conn_idx, ble_storage_key_t key, uint32_t *value);
+ble_error_t ble_storage_remove(uint16_t conn_idx, ble_storage_key_t key);
+ble_error_t ble_storage_remove_all(ble_storage_key_t key);
+
+#endif /* TEST_SDK_BLE_STORAGE_H_ */
@@ -0,0 +1,27 @@
+/*
+ * ble_uuid.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK UUID helpers, implemented by host_ble.c.
+ */
+
+#ifndef TEST_SDK_BLE_UUID_H_
+#define TEST_SDK_BLE_UUID_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "ble_att.h"
+
+#define UUID_GATT_PRIMARY_SERVICE               (0x2800)
+#define UUID_GATT_CHARACTERISTIC                (0x2803)
+#define UUID_GATT_CHAR_USER_DESCRIPTION         (0x2901)
+#define UUID_GATT_CLIENT_CHAR_CONFIGURATION     (0x2902)
+
+void ble_uuid_from_string(const char *str, att_uuid_t *uuid);
+void ble_uuid_create16(uint16_t uuid16, att_uuid_t *uuid);
+bool ble_uuid_equal(const att_uuid_t *uuid1, const att_uuid_t *uuid2);
+
+#endif /* TEST_SDK_BLE_UUID_H_ */
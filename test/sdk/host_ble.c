@@ -0,0 +1,2113 @@
+/*
+ * host_ble.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the BLE manager: the event queue of the application, GAP, the
+ * GATT client and server with their attribute database, the service framework and
+ * the BLE storage.
+ *
+ * Events are allocated from the heap of the image and queued to the application
+ * task as the BLE manager does; advertising reports are dropped when the queue is
+ * nearly full, other events are never dropped. Everything which goes over the air
+ * is handed to the world (host_ble_world) as a PDU, the world delivers the PDUs
+ * of the peer with host_ble_recv(). GATT client requests of a connection are
+ * serialized, the next one is sent once the previous one completed, as ATT does.
+ *
+ * In replay mode (ble_replay.c) the events of the stand-in are dropped, the
+ * application only gets the events of a trace, injected with host_ble_inject().
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "osal.h"
+#include "ble_common.h"
+#include "ble_gap.h"
+#include "ble_gattc.h"
+#include "ble_gatts.h"
+#include "ble_mgr.h"
+#include "ble_service.h"
+#include "ble_storage.h"
+#include "ble_uuid.h"
+#include "host_sdk.h"
+
+#define HOST_BLE_MAX_ATTRS              (96)
+#define HOST_BLE_MAX_SERVICES           (8)
+#define HOST_BLE_MAX_STORAGE            (64)
+#define HOST_BLE_CLIENT_OPS             (16)
+#define HOST_BLE_INDICATIONS            (8)
+
+/* Duration of a general or limited discovery scan */
+#define HOST_BLE_DISCOVERY_MS           (10240)
+
+/* Link layer payload and time a device supports */
+#define HOST_BLE_MAX_OCTETS             (251)
+#define HOST_BLE_MAX_TIME               (2120)
+
+enum attr_kind {
+        ATTR_SERVICE,
+        ATTR_CHAR_DECL,
+        ATTR_VALUE,
+        ATTR_DESC,
+};
+
+struct attr {
+        uint8_t kind;
+        att_uuid_t uuid;
+        uint8_t props;                  /* characteristic declarations */
+        uint16_t end_h;                 /* service declarations */
+        att_perm_t perm;
+        uint8_t flags;
+        uint16_t max_len;
+        uint16_t length;
+        uint8_t *value;
+};
+
+struct client_op {
+        struct host_pdu pdu;
+};
+
+struct conn {
+        bool used;
+        bool master;
+        bd_address_t peer;
+        gap_conn_params_t params;
+        uint16_t mtu;
+        bool paired;
+        bool bonded;
+        int8_t rssi;
+        /* GATT client requests, the first one is on the air when busy */
+        struct client_op ops[HOST_BLE_CLIENT_OPS];
+        uint8_t op_head;
+        uint8_t op_count;
+        bool op_busy;
+        /* GATT server requests waiting for the application */
+        bool read_pending;
+        uint16_t read_handle;
+        uint16_t read_offset;
+        bool write_pending;
+        bool write_cmd;
+        uint16_t write_handle;
+        /* indications, the first one waits for its confirmation when busy */
+        struct host_pdu ind[HOST_BLE_INDICATIONS];
+        uint8_t ind_head;
+        uint8_t ind_count;
+        bool ind_busy;
+        /* link procedures */
+        bool update_pending;
+        gap_conn_params_t update_req;
+        bool phy_pending;
+        bool length_pending;
+};
+
+struct storage_entry {
+        bool used;
+        bd_address_t peer;
+        ble_storage_key_t key;
+        uint32_t value;
+};
+
+__RETAINED static struct {
+        bd_address_t addr;
+        const struct host_ble_world *world;
+        OS_QUEUE evt_queue;
+        OS_TASK app_task;
+        uint16_t gap_mtu;
+        char name[BLE_GAP_DEVNAME_LEN_MAX + 1];
+        /* GAP */
+        bool advertising;
+        uint8_t ad[BLE_ADV_DATA_LEN_MAX];
+        uint8_t ad_len;
+        uint8_t sd[BLE_SCAN_RSP_LEN_MAX];
+        uint8_t sd_len;
+        bool scanning;
+        bool scan_active;
+        uint16_t scan_interval;
+        uint16_t scan_window;
+        OS_TIMER scan_timer;
+        bool connecting;
+        struct conn conns[HOST_BLE_MAX_CONN];
+        /* GATT server */
+        struct attr attrs[HOST_BLE_MAX_ATTRS + 1];      /* by handle, 0 is not used */
+        uint16_t num_attrs;                             /* last handle in use */
+        uint16_t svc_start;                             /* service being added */
+        uint16_t svc_next;                              /* next offset in it */
+        ble_service_t *services[HOST_BLE_MAX_SERVICES];
+        int num_services;
+        struct storage_entry storage[HOST_BLE_MAX_STORAGE];
+        /* events the stack holds back while the queue is full, oldest first */
+        ble_evt_hdr_t *held[HOST_BLE_EVT_HELD_MAX];
+        /* replay: only injected events are queued */
+        bool replay;
+        bool injecting;
+        uint16_t held_head;
+        uint16_t held_count;
+        struct host_ble_stats stats;
+} ble = {
+        .gap_mtu = HOST_GAP_MTU_DEFAULT,
+};
+
+/* Event loop of the tuning image (ble_common.h), the firmware defaults until set */
+uint16_t host_ble_evt_batch = 8;
+uint32_t host_ble_evt_budget_ms = 2;
+
+/*
+ * Event queue
+ */
+static void *evt_alloc(uint16_t evt_code, size_t size)
+{
+        ble_evt_hdr_t *hdr = OS_MALLOC(size);
+
+        if (hdr) {
+                memset(hdr, 0, size);
+                hdr->evt_code = evt_code;
+                hdr->length = size - sizeof(*hdr);
+        }
+
+        return hdr;
+}
+
+/*
+ * The manager blocks on a full queue and the stack behind it waits: events are not
+ * lost, they are delivered once the application fetched others
+ */
+static void evt_queue(void *evt)
+{
+        OS_UBASE_TYPE waiting;
+
+        OS_ASSERT(evt != NULL);
+        if (ble.replay && !ble.injecting) {
+                OS_FREE(evt);
+                return;
+        }
+        if (ble.held_count || OS_QUEUE_PUT(ble.evt_queue, &evt, OS_QUEUE_NO_WAIT) != OS_QUEUE_OK) {
+                if (ble.held_count == HOST_BLE_EVT_HELD_MAX) {
+                        host_os_assert("BLE stack out of event buffers", __FILE__, __LINE__);
+                }
+                ble.held[(ble.held_head + ble.held_count) % HOST_BLE_EVT_HELD_MAX] = evt;
+                ble.held_count++;
+                if (ble.held_count > ble.stats.max_held) {
+                        ble.stats.max_held = ble.held_count;
+                }
+        }
+
+        ble.stats.events++;
+        waiting = OS_QUEUE_MESSAGES_WAITING(ble.evt_queue);
+        if (waiting > ble.stats.max_queued) {
+                ble.stats.max_queued = waiting;
+        }
+        if (ble.app_task) {
+                OS_TASK_NOTIFY(ble.app_task, BLE_APP_NOTIFY_MASK, eSetBits);
+        }
+}
+
+void ble_mgr_init(void)
+{
+        OS_QUEUE_CREATE(ble.evt_queue, sizeof(ble_evt_hdr_t *), HOST_BLE_EVT_QUEUE_LEN);
+        OS_ASSERT(ble.evt_queue);
+
+        memset(ble.conns, 0, sizeof(ble.conns));
+}
+
+ble_error_t ble_register_app(void)
+{
+        ble.app_task = OS_GET_CURRENT_TASK();
+
+        // events queued before the registration
+        if (OS_QUEUE_MESSAGES_WAITING(ble.evt_queue)) {
+                OS_TASK_NOTIFY(ble.app_task, BLE_APP_NOTIFY_MASK, eSetBits);
+        }
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_enable(void)
+{
+        return BLE_STATUS_OK;
+}
+
+ble_evt_hdr_t *ble_get_event(bool wait)
+{
+        ble_evt_hdr_t *hdr;
+
+        if (OS_QUEUE_GET(ble.evt_queue, &hdr, wait ? OS_QUEUE_FOREVER : OS_QUEUE_NO_WAIT) != OS_QUEUE_OK) {
+                return NULL;
+        }
+
+        // the slot taken lets the oldest held event in
+        if (ble.held_count) {
+                OS_QUEUE_PUT(ble.evt_queue, &ble.held[ble.held_head], OS_QUEUE_NO_WAIT);
+                ble.held_head = (ble.held_head + 1) % HOST_BLE_EVT_HELD_MAX;
+                ble.held_count--;
+        }
+
+        return hdr;
+}
+
+bool ble_has_event(void)
+{
+        return OS_QUEUE_MESSAGES_WAITING(ble.evt_queue) > 0;
+}
+
+const char *ble_address_to_string(const bd_address_t *address)
+{
+        static char buf[sizeof("00:00:00:00:00:00")];
+
+        snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", address->addr[5], address->addr[4],
+                address->addr[3], address->addr[2], address->addr[1], address->addr[0]);
+
+        return buf;
+}
+
+/*
+ * Connections
+ */
+static struct conn *conn_get(uint16_t conn_idx)
+{
+        if (conn_idx >= HOST_BLE_MAX_CONN || !ble.conns[conn_idx].used) {
+                return NULL;
+        }
+
+        return &ble.conns[conn_idx];
+}
+
+static void send_pdu(uint16_t conn_idx, const struct host_pdu *pdu)
+{
+        ble.stats.pdus_tx++;
+        if (ble.world && ble.world->send) {
+                ble.world->send(ble.world->ctx, conn_idx, pdu);
+        }
+}
+
+static void pdu_init(struct host_pdu *pdu, uint8_t op)
+{
+        memset(pdu, 0, offsetof(struct host_pdu, value));
+        pdu->op = op;
+}
+
+/*
+ * GAP
+ */
+ble_error_t ble_gap_address_get(own_address_t *address)
+{
+        memcpy(address, &ble.addr, sizeof(*address));
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_role_set(gap_role_t role)
+{
+        (void)role;
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_device_name_set(const char *name, att_perm_t perm)
+{
+        (void)perm;
+
+        if (strlen(name) > BLE_GAP_DEVNAME_LEN_MAX) {
+                return BLE_ERROR_INVALID_PARAM;
+        }
+        strcpy(ble.name, name);
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_mtu_size_get(uint16_t *mtu_size)
+{
+        *mtu_size = ble.gap_mtu;
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_mtu_size_set(uint16_t mtu_size)
+{
+        if (mtu_size < HOST_ATT_MTU_DEFAULT || mtu_size > HOST_ATT_MTU_MAX) {
+                return BLE_ERROR_INVALID_PARAM;
+        }
+        ble.gap_mtu = mtu_size;
+
+        return BLE_STATUS_OK;
+}
+
+static uint8_t ad_serialize(uint8_t *buf, size_t buf_len, size_t count, const gap_adv_ad_struct_t *ad)
+{
+        size_t len = 0;
+        size_t i;
+
+        for (i = 0; i < count; i++) {
+                if (len + 2 + ad[i].len > buf_len) {
+                        return 0xFF;
+                }
+                buf[len++] = ad[i].len + 1;
+                buf[len++] = ad[i].type;
+                memcpy(buf + len, ad[i].data, ad[i].len);
+                len += ad[i].len;
+        }
+
+        return len;
+}
+
+static void report_adv(void)
+{
+        if (ble.world && ble.world->adv) {
+                ble.world->adv(ble.world->ctx, ble.advertising, ble.ad, ble.ad_len, ble.sd, ble.sd_len);
+        }
+}
+
+ble_error_t ble_gap_adv_ad_struct_set(size_t ad_len, const gap_adv_ad_struct_t *ad, size_t sd_len,
+        const gap_adv_ad_struct_t *sd)
+{
+        uint8_t ad_buf[BLE_ADV_DATA_LEN_MAX];
+        uint8_t sd_buf[BLE_SCAN_RSP_LEN_MAX];
+        uint8_t ad_bytes = ad_serialize(ad_buf, sizeof(ad_buf), ad_len, ad);
+        uint8_t sd_bytes = ad_serialize(sd_buf, sizeof(sd_buf), sd_len, sd);
+
+        if (ad_bytes == 0xFF || sd_bytes == 0xFF) {
+                return BLE_ERROR_INVALID_PARAM;
+        }
+        memcpy(ble.ad, ad_buf, ad_bytes);
+        ble.ad_len = ad_bytes;
+        memcpy(ble.sd, sd_buf, sd_bytes);
+        ble.sd_len = sd_bytes;
+
+        if (ble.advertising) {
+                report_adv();
+        }
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_adv_start(gap_conn_mode_t adv_type)
+{
+        (void)adv_type;
+
+        if (ble.advertising) {
+                return BLE_ERROR_IN_PROGRESS;
+        }
+        ble.advertising = true;
+        report_adv();
+
+        return BLE_STATUS_OK;
+}
+
+static void queue_adv_completed(uint8_t status)
+{
+        ble_evt_gap_adv_completed_t *evt = evt_alloc(BLE_EVT_GAP_ADV_COMPLETED, sizeof(*evt));
+
+        evt->adv_type = GAP_CONN_MODE_UNDIRECTED;
+        evt->status = status;
+        evt_queue(evt);
+}
+
+ble_error_t ble_gap_adv_stop(void)
+{
+        if (!ble.advertising) {
+                return BLE_ERROR_NOT_ALLOWED;
+        }
+        ble.advertising = false;
+        report_adv();
+        queue_adv_completed(BLE_ERROR_CANCELED);
+
+        return BLE_STATUS_OK;
+}
+
+static void scan_done(uint8_t status)
+{
+        ble_evt_gap_scan_completed_t *evt;
+
+        ble.scanning = false;
+        OS_TIMER_STOP(ble.scan_timer, OS_TIMER_FOREVER);
+        if (ble.world && ble.world->scan) {
+                ble.world->scan(ble.world->ctx, false, ble.scan_active, ble.scan_interval, ble.scan_window);
+        }
+
+        evt = evt_alloc(BLE_EVT_GAP_SCAN_COMPLETED, sizeof(*evt));
+        evt->scan_type = ble.scan_active ? GAP_SCAN_ACTIVE : GAP_SCAN_PASSIVE;
+        evt->status = status;
+        evt_queue(evt);
+}
+
+static void scan_timer_cb(OS_TIMER timer)
+{
+        (void)timer;
+
+        if (ble.scanning) {
+                scan_done(BLE_STATUS_OK);
+        }
+}
+
+ble_error_t ble_gap_scan_start(gap_scan_type_t type, gap_scan_mode_t mode, uint16_t interval,
+        uint16_t window, bool filt_wlist, bool filt_dupl)
+{
+        (void)filt_wlist;
+        (void)filt_dupl;
+
+        if (ble.scanning) {
+                return BLE_ERROR_IN_PROGRESS;
+        }
+        if (!ble.scan_timer) {
+                ble.scan_timer = OS_TIMER_CREATE("ble_scan", OS_MS_2_TICKS(HOST_BLE_DISCOVERY_MS),
+                        OS_TIMER_ONCE, NULL, scan_timer_cb);
+                OS_ASSERT(ble.scan_timer);
+        }
+
+        ble.scanning = true;
+        ble.scan_active = (type == GAP_SCAN_ACTIVE);
+        ble.scan_interval = interval;
+        ble.scan_window = window;
+        // discovery scans end by themselves, observer scans run until stopped
+        if (mode != GAP_SCAN_OBSERVER_MODE) {
+                OS_TIMER_START(ble.scan_timer, OS_TIMER_FOREVER);
+        }
+        if (ble.world && ble.world->scan) {
+                ble.world->scan(ble.world->ctx, true, ble.scan_active, interval, window);
+        }
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_scan_stop(void)
+{
+        if (!ble.scanning) {
+                return BLE_ERROR_NOT_ALLOWED;
+        }
+        scan_done(BLE_ERROR_CANCELED);
+
+        return BLE_STATUS_OK;
+}
+
+static int free_conn_idx(void)
+{
+        int i;
+
+        for (i = 0; i < HOST_BLE_MAX_CONN; i++) {
+                if (!ble.conns[i].used) {
+                        return i;
+                }
+        }
+
+        return -1;
+}
+
+ble_error_t ble_gap_connect(const bd_address_t *peer_addr, const gap_conn_params_t *conn_params)
+{
+        if (ble.connecting) {
+                return BLE_ERROR_BUSY;
+        }
+        if (free_conn_idx() < 0) {
+                return BLE_ERROR_INS_RESOURCES;
+        }
+        ble.connecting = true;
+        if (ble.world && ble.world->connect) {
+                ble.world->connect(ble.world->ctx, peer_addr, conn_params);
+        }
+
+        return BLE_STATUS_OK;
+}
+
+static void queue_connection_completed(uint8_t status)
+{
+        ble_evt_gap_connection_completed_t *evt = evt_alloc(BLE_EVT_GAP_CONNECTION_COMPLETED, sizeof(*evt));
+
+        evt->status = status;
+        evt_queue(evt);
+}
+
+ble_error_t ble_gap_connect_cancel(void)
+{
+        if (!ble.connecting) {
+                return BLE_ERROR_NOT_ALLOWED;
+        }
+        ble.connecting = false;
+        if (ble.world && ble.world->connect_cancel) {
+                ble.world->connect_cancel(ble.world->ctx);
+        }
+        queue_connection_completed(BLE_ERROR_CANCELED);
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_disconnect(uint16_t conn_idx, uint8_t reason)
+{
+        if (!conn_get(conn_idx)) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if (ble.world && ble.world->disconnect) {
+                ble.world->disconnect(ble.world->ctx, conn_idx, reason);
+        }
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_get_connected(uint8_t *length, uint16_t **conn_idx)
+{
+        uint8_t count = 0;
+        int i;
+
+        *conn_idx = OS_MALLOC(HOST_BLE_MAX_CONN * sizeof(uint16_t));
+        if (*conn_idx == NULL) {
+                *length = 0;
+                return BLE_ERROR_INS_RESOURCES;
+        }
+        for (i = 0; i < HOST_BLE_MAX_CONN; i++) {
+                if (ble.conns[i].used) {
+                        (*conn_idx)[count++] = i;
+                }
+        }
+        *length = count;
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_get_device_by_conn_idx(uint16_t conn_idx, gap_device_t *gap_device)
+{
+        struct conn *conn = conn_get(conn_idx);
+
+        if (!conn) {
+                return BLE_ERROR_NOT_FOUND;
+        }
+        memset(gap_device, 0, sizeof(*gap_device));
+        memcpy(&gap_device->address, &conn->peer, sizeof(gap_device->address));
+        gap_device->conn_idx = conn_idx;
+        gap_device->connected = true;
+        gap_device->bonded = conn->bonded;
+        gap_device->paired = conn->paired;
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_conn_rssi_get(uint16_t conn_idx, int8_t *conn_rssi)
+{
+        struct conn *conn = conn_get(conn_idx);
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        *conn_rssi = conn->rssi;
+
+        return BLE_STATUS_OK;
+}
+
+static void params_from_pdu(gap_conn_params_t *params, const struct host_pdu *pdu)
+{
+        params->interval_min = pdu->param[0];
+        params->interval_max = pdu->param[1];
+        params->slave_latency = pdu->param[2];
+        params->sup_timeout = pdu->param[3];
+}
+
+static void params_to_pdu(struct host_pdu *pdu, const gap_conn_params_t *params)
+{
+        pdu->param[0] = params->interval_min;
+        pdu->param[1] = params->interval_max;
+        pdu->param[2] = params->slave_latency;
+        pdu->param[3] = params->sup_timeout;
+}
+
+static void queue_params_updated(uint16_t conn_idx, const gap_conn_params_t *params)
+{
+        ble_evt_gap_conn_param_updated_t *evt = evt_alloc(BLE_EVT_GAP_CONN_PARAM_UPDATED, sizeof(*evt));
+
+        evt->conn_idx = conn_idx;
+        evt->conn_params = *params;
+        evt_queue(evt);
+}
+
+static void queue_update_completed(uint16_t conn_idx, uint8_t status)
+{
+        ble_evt_gap_conn_param_update_completed_t *evt =
+                evt_alloc(BLE_EVT_GAP_CONN_PARAM_UPDATE_COMPLETED, sizeof(*evt));
+
+        evt->conn_idx = conn_idx;
+        evt->status = status;
+        evt_queue(evt);
+}
+
+/* The master applies parameters, the controller picks the lowest interval of the range */
+static void apply_params(uint16_t conn_idx, struct conn *conn, const gap_conn_params_t *params)
+{
+        struct host_pdu pdu;
+
+        conn->params = *params;
+        conn->params.interval_max = params->interval_min;
+
+        pdu_init(&pdu, HOST_PDU_CONN_UPDATE);
+        params_to_pdu(&pdu, &conn->params);
+        send_pdu(conn_idx, &pdu);
+        queue_params_updated(conn_idx, &conn->params);
+}
+
+ble_error_t ble_gap_conn_param_update(uint16_t conn_idx, const gap_conn_params_t *conn_params)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu pdu;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if (conn->update_pending) {
+                return BLE_ERROR_BUSY;
+        }
+
+        if (conn->master) {
+                apply_params(conn_idx, conn, conn_params);
+                queue_update_completed(conn_idx, BLE_STATUS_OK);
+                return BLE_STATUS_OK;
+        }
+
+        // the slave asks the master, which answers with an update or a rejection
+        conn->update_pending = true;
+        pdu_init(&pdu, HOST_PDU_CONN_PARAM_REQ);
+        params_to_pdu(&pdu, conn_params);
+        send_pdu(conn_idx, &pdu);
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_conn_param_update_reply(uint16_t conn_idx, bool accept)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu pdu;
+
+        if (!conn || !conn->master) {
+                return BLE_ERROR_NOT_ALLOWED;
+        }
+
+        if (accept) {
+                apply_params(conn_idx, conn, &conn->update_req);
+        } else {
+                pdu_init(&pdu, HOST_PDU_CONN_PARAM_RSP);
+                pdu.status = BLE_ERROR_NOT_ACCEPTED;
+                send_pdu(conn_idx, &pdu);
+        }
+
+        return BLE_STATUS_OK;
+}
+
+static void queue_pair_completed(uint16_t conn_idx, uint8_t status, bool bond)
+{
+        ble_evt_gap_pair_completed_t *evt = evt_alloc(BLE_EVT_GAP_PAIR_COMPLETED, sizeof(*evt));
+
+        evt->conn_idx = conn_idx;
+        evt->status = status;
+        evt->bond = bond;
+        evt_queue(evt);
+}
+
+ble_error_t ble_gap_pair_reply(uint16_t conn_idx, bool accept, bool bond)
+{
+        struct conn *conn = conn_get(conn_idx);
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if (!accept) {
+                queue_pair_completed(conn_idx, BLE_ERROR_NOT_ACCEPTED, false);
+                return BLE_STATUS_OK;
+        }
+        conn->paired = true;
+        conn->bonded = bond;
+        queue_pair_completed(conn_idx, BLE_STATUS_OK, bond);
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_data_length_set(uint16_t conn_idx, uint16_t tx_length, uint16_t tx_time)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu pdu;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if (conn->length_pending) {
+                return BLE_ERROR_BUSY;
+        }
+        conn->length_pending = true;
+        pdu_init(&pdu, HOST_PDU_LENGTH_REQ);
+        pdu.param[0] = tx_length;
+        pdu.param[1] = tx_time;
+        send_pdu(conn_idx, &pdu);
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gap_phy_set(uint16_t conn_idx, ble_gap_phy_pref_t tx_phy_pref,
+        ble_gap_phy_pref_t rx_phy_pref)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu pdu;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if (conn->phy_pending) {
+                return BLE_ERROR_BUSY;
+        }
+        conn->phy_pending = true;
+        pdu_init(&pdu, HOST_PDU_PHY_REQ);
+        pdu.param[0] = tx_phy_pref;
+        pdu.param[1] = rx_phy_pref;
+        send_pdu(conn_idx, &pdu);
+
+        return BLE_STATUS_OK;
+}
+
+/*
+ * GATT client
+ */
+ble_error_t ble_gattc_get_mtu(uint16_t conn_idx, uint16_t *mtu)
+{
+        struct conn *conn = conn_get(conn_idx);
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        *mtu = conn->mtu;
+
+        return BLE_STATUS_OK;
+}
+
+static void client_next(uint16_t conn_idx, struct conn *conn)
+{
+        if (conn->op_busy || !conn->op_count) {
+                return;
+        }
+        conn->op_busy = true;
+        send_pdu(conn_idx, &conn->ops[conn->op_head].pdu);
+}
+
+static struct host_pdu *client_op(struct conn *conn, uint8_t op)
+{
+        struct host_pdu *pdu;
+
+        if (conn->op_count == HOST_BLE_CLIENT_OPS) {
+                return NULL;
+        }
+        pdu = &conn->ops[(conn->op_head + conn->op_count) % HOST_BLE_CLIENT_OPS].pdu;
+        pdu_init(pdu, op);
+
+        return pdu;
+}
+
+static ble_error_t client_submit(uint16_t conn_idx, struct conn *conn)
+{
+        conn->op_count++;
+        client_next(conn_idx, conn);
+
+        return BLE_STATUS_OK;
+}
+
+/* The request on the air, NULL if none */
+static const struct host_pdu *client_current(struct conn *conn)
+{
+        return conn->op_busy ? &conn->ops[conn->op_head].pdu : NULL;
+}
+
+static void client_done(uint16_t conn_idx, struct conn *conn)
+{
+        conn->op_busy = false;
+        conn->op_head = (conn->op_head + 1) % HOST_BLE_CLIENT_OPS;
+        conn->op_count--;
+        client_next(conn_idx, conn);
+}
+
+ble_error_t ble_gattc_exchange_mtu(uint16_t conn_idx)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu *pdu;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if ((pdu = client_op(conn, HOST_PDU_MTU_REQ)) == NULL) {
+                return BLE_ERROR_INS_RESOURCES;
+        }
+        pdu->param[0] = ble.gap_mtu;
+
+        return client_submit(conn_idx, conn);
+}
+
+ble_error_t ble_gattc_discover_svc(uint16_t conn_idx, const att_uuid_t *uuid)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu *pdu;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if ((pdu = client_op(conn, HOST_PDU_FIND_SVC_REQ)) == NULL) {
+                return BLE_ERROR_INS_RESOURCES;
+        }
+        if (uuid) {
+                pdu->uuid = *uuid;
+                pdu->param[0] = 1;
+        }
+
+        return client_submit(conn_idx, conn);
+}
+
+ble_error_t ble_gattc_discover_char(uint16_t conn_idx, uint16_t start_h, uint16_t end_h,
+        const att_uuid_t *uuid)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu *pdu;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if ((pdu = client_op(conn, HOST_PDU_FIND_CHAR_REQ)) == NULL) {
+                return BLE_ERROR_INS_RESOURCES;
+        }
+        pdu->handle = start_h;
+        pdu->end_handle = end_h;
+        if (uuid) {
+                pdu->uuid = *uuid;
+                pdu->param[0] = 1;
+        }
+
+        return client_submit(conn_idx, conn);
+}
+
+ble_error_t ble_gattc_read(uint16_t conn_idx, uint16_t handle, uint16_t offset)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu *pdu;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if ((pdu = client_op(conn, HOST_PDU_READ_REQ)) == NULL) {
+                return BLE_ERROR_INS_RESOURCES;
+        }
+        pdu->handle = handle;
+        pdu->offset = offset;
+
+        return client_submit(conn_idx, conn);
+}
+
+ble_error_t ble_gattc_write(uint16_t conn_idx, uint16_t handle, uint16_t offset, uint16_t length,
+        const uint8_t *value)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu *pdu;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if (length > HOST_ATT_VALUE_MAX) {
+                return BLE_ERROR_INVALID_PARAM;
+        }
+        if ((pdu = client_op(conn, HOST_PDU_WRITE_REQ)) == NULL) {
+                return BLE_ERROR_INS_RESOURCES;
+        }
+        pdu->handle = handle;
+        pdu->offset = offset;
+        pdu->length = length;
+        memcpy(pdu->value, value, length);
+
+        return client_submit(conn_idx, conn);
+}
+
+ble_error_t ble_gattc_write_no_resp(uint16_t conn_idx, uint16_t handle, bool signed_write,
+        uint16_t length, const uint8_t *value)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu pdu;
+
+        (void)signed_write;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if (length > conn->mtu - 3) {
+                return BLE_ERROR_INVALID_PARAM;
+        }
+        pdu_init(&pdu, HOST_PDU_WRITE_CMD);
+        pdu.handle = handle;
+        pdu.length = length;
+        memcpy(pdu.value, value, length);
+        send_pdu(conn_idx, &pdu);
+
+        return BLE_STATUS_OK;
+}
+
+static void queue_mtu_changed(uint16_t conn_idx, uint16_t mtu)
+{
+        ble_evt_gattc_mtu_changed_t *evt = evt_alloc(BLE_EVT_GATTC_MTU_CHANGED, sizeof(*evt));
+
+        evt->conn_idx = conn_idx;
+        evt->mtu = mtu;
+        evt_queue(evt);
+}
+
+/* Handle a response to a GATT client request of the device */
+static void client_response(uint16_t conn_idx, struct conn *conn, const struct host_pdu *pdu)
+{
+        const struct host_pdu *req = client_current(conn);
+
+        if (!req) {
+                return;
+        }
+
+        switch (pdu->op) {
+        case HOST_PDU_MTU_RSP:
+        {
+                uint16_t mtu = pdu->param[0] < ble.gap_mtu ? pdu->param[0] : ble.gap_mtu;
+
+                conn->mtu = mtu < HOST_ATT_MTU_DEFAULT ? HOST_ATT_MTU_DEFAULT : mtu;
+                queue_mtu_changed(conn_idx, conn->mtu);
+                client_done(conn_idx, conn);
+                break;
+        }
+        case HOST_PDU_FIND_SVC_RSP:
+        {
+                ble_evt_gattc_discover_svc_t *evt = evt_alloc(BLE_EVT_GATTC_DISCOVER_SVC, sizeof(*evt));
+
+                evt->conn_idx = conn_idx;
+                evt->uuid = pdu->uuid;
+                evt->start_h = pdu->handle;
+                evt->end_h = pdu->end_handle;
+                evt_queue(evt);
+                break;
+        }
+        case HOST_PDU_FIND_CHAR_RSP:
+        {
+                ble_evt_gattc_discover_char_t *evt = evt_alloc(BLE_EVT_GATTC_DISCOVER_CHAR, sizeof(*evt));
+
+                evt->conn_idx = conn_idx;
+                evt->uuid = pdu->uuid;
+                evt->handle = pdu->handle;
+                evt->value_handle = pdu->param[0];
+                evt->properties = pdu->props;
+                evt_queue(evt);
+                break;
+        }
+        case HOST_PDU_FIND_DONE:
+        {
+                ble_evt_gattc_discover_completed_t *evt =
+                        evt_alloc(BLE_EVT_GATTC_DISCOVER_COMPLETED, sizeof(*evt));
+
+                evt->conn_idx = conn_idx;
+                evt->type = (req->op == HOST_PDU_FIND_SVC_REQ) ? GATTC_DISCOVERY_TYPE_SVC :
+                                                                GATTC_DISCOVERY_TYPE_CHARACTERISTICS;
+                evt->status = pdu->status;
+                evt_queue(evt);
+                client_done(conn_idx, conn);
+                break;
+        }
+        case HOST_PDU_READ_RSP:
+        {
+                ble_evt_gattc_read_completed_t *evt =
+                        evt_alloc(BLE_EVT_GATTC_READ_COMPLETED, sizeof(*evt) + pdu->length);
+
+                evt->conn_idx = conn_idx;
+                evt->handle = req->handle;
+                evt->status = pdu->status;
+                evt->offset = req->offset;
+                evt->length = pdu->length;
+                memcpy(evt->value, pdu->value, pdu->length);
+                evt_queue(evt);
+                client_done(conn_idx, conn);
+                break;
+        }
+        case HOST_PDU_WRITE_RSP:
+        {
+                ble_evt_gattc_write_completed_t *evt = evt_alloc(BLE_EVT_GATTC_WRITE_COMPLETED, sizeof(*evt));
+
+                evt->conn_idx = conn_idx;
+                evt->handle = req->handle;
+                evt->status = pdu->status;
+                evt->operation = GATTC_DISCOVERY_TYPE_SVC;
+                evt_queue(evt);
+                client_done(conn_idx, conn);
+                break;
+        }
+        default:
+                break;
+        }
+}
+
+/*
+ * GATT server database
+ */
+uint16_t ble_gatts_get_num_attr(uint16_t include, uint16_t characteristics, uint16_t descriptors)
+{
+        return include + 2 * characteristics + descriptors;
+}
+
+static struct attr *attr_add(uint16_t *h_offset)
+{
+        uint16_t handle = ble.svc_start + ble.svc_next;
+
+        OS_ASSERT(ble.svc_start && handle <= HOST_BLE_MAX_ATTRS);
+        if (h_offset) {
+                *h_offset = ble.svc_next;
+        }
+        ble.svc_next++;
+        if (handle > ble.num_attrs) {
+                ble.num_attrs = handle;
+        }
+
+        return &ble.attrs[handle];
+}
+
+ble_error_t ble_gatts_add_service(const att_uuid_t *uuid, const gatt_service_t type, uint16_t num_attrs)
+{
+        struct attr *attr;
+
+        (void)type;
+
+        if (ble.num_attrs + 1 + num_attrs > HOST_BLE_MAX_ATTRS) {
+                return BLE_ERROR_INS_RESOURCES;
+        }
+        ble.svc_start = ble.num_attrs + 1;
+        ble.svc_next = 0;
+
+        attr = attr_add(NULL);
+        attr->kind = ATTR_SERVICE;
+        attr->uuid = *uuid;
+        attr->perm = ATT_PERM_READ;
+        attr->end_h = ble.svc_start + num_attrs;
+
+        return BLE_STATUS_OK;
+}
+
+static void attr_value_init(struct attr *attr, uint16_t max_len)
+{
+        attr->max_len = max_len;
+        attr->length = 0;
+        attr->value = max_len ? calloc(1, max_len) : NULL;
+}
+
+ble_error_t ble_gatts_add_characteristic(const att_uuid_t *uuid, gatt_prop_t prop, att_perm_t perm,
+        uint16_t max_len, uint8_t flags, uint16_t *h_offset, uint16_t *h_val_offset)
+{
+        struct attr *decl = attr_add(h_offset);
+        struct attr *value = attr_add(h_val_offset);
+
+        decl->kind = ATTR_CHAR_DECL;
+        decl->uuid = *uuid;
+        decl->props = prop;
+        decl->perm = ATT_PERM_READ;
+
+        value->kind = ATTR_VALUE;
+        value->uuid = *uuid;
+        value->perm = perm;
+        value->flags = flags;
+        attr_value_init(value, max_len);
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_add_descriptor(const att_uuid_t *uuid, att_perm_t perm, uint16_t max_len,
+        uint8_t flags, uint16_t *h_offset)
+{
+        struct attr *desc = attr_add(h_offset);
+
+        desc->kind = ATTR_DESC;
+        desc->uuid = *uuid;
+        desc->perm = perm;
+        desc->flags = flags;
+        attr_value_init(desc, max_len);
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_register_service(uint16_t *handle, ...)
+{
+        uint16_t *h_offset;
+        va_list ap;
+
+        *handle = ble.svc_start;
+
+        va_start(ap, handle);
+        while ((h_offset = va_arg(ap, uint16_t *)) != NULL) {
+                *h_offset += ble.svc_start;
+        }
+        va_end(ap);
+
+        ble.svc_start = 0;
+
+        return BLE_STATUS_OK;
+}
+
+static struct attr *attr_get(uint16_t handle)
+{
+        if (handle == 0 || handle > ble.num_attrs) {
+                return NULL;
+        }
+
+        return &ble.attrs[handle];
+}
+
+ble_error_t ble_gatts_set_value(uint16_t handle, uint16_t length, const void *value)
+{
+        struct attr *attr = attr_get(handle);
+
+        if (!attr || (attr->kind != ATTR_VALUE && attr->kind != ATTR_DESC)) {
+                return BLE_ERROR_INVALID_PARAM;
+        }
+        if (length > attr->max_len) {
+                return BLE_ERROR_INVALID_PARAM;
+        }
+        memcpy(attr->value, value, length);
+        attr->length = length;
+
+        return BLE_STATUS_OK;
+}
+
+/*
+ * GATT server
+ */
+static void send_read_rsp(uint16_t conn_idx, struct conn *conn, uint16_t handle, uint16_t offset,
+        att_error_t status, uint16_t length, const void *value)
+{
+        struct host_pdu pdu;
+        uint16_t max = conn->mtu - 1;
+
+        pdu_init(&pdu, HOST_PDU_READ_RSP);
+        pdu.status = status;
+        pdu.handle = handle;
+        pdu.offset = offset;
+        if (status == ATT_ERROR_OK) {
+                if (length > max) {
+                        length = max;
+                }
+                if (length > HOST_ATT_VALUE_MAX - offset) {
+                        length = HOST_ATT_VALUE_MAX - offset;
+                }
+                pdu.length = length;
+                memcpy(pdu.value, value, length);
+        }
+        send_pdu(conn_idx, &pdu);
+}
+
+static void send_write_rsp(uint16_t conn_idx, uint16_t handle, att_error_t status)
+{
+        struct host_pdu pdu;
+
+        pdu_init(&pdu, HOST_PDU_WRITE_RSP);
+        pdu.status = status;
+        pdu.handle = handle;
+        send_pdu(conn_idx, &pdu);
+}
+
+ble_error_t ble_gatts_read_cfm(uint16_t conn_idx, uint16_t handle, att_error_t status, uint16_t length,
+        const void *value)
+{
+        struct conn *conn = conn_get(conn_idx);
+
+        (void)handle;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if (!conn->read_pending) {
+                return BLE_ERROR_NOT_ALLOWED;
+        }
+        conn->read_pending = false;
+        send_read_rsp(conn_idx, conn, conn->read_handle, conn->read_offset, status, length, value);
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_write_cfm(uint16_t conn_idx, uint16_t handle, att_error_t status)
+{
+        struct conn *conn = conn_get(conn_idx);
+
+        (void)handle;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        if (!conn->write_pending) {
+                return BLE_ERROR_NOT_ALLOWED;
+        }
+        conn->write_pending = false;
+        // write commands are not answered
+        if (!conn->write_cmd) {
+                send_write_rsp(conn_idx, conn->write_handle, status);
+        }
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_gatts_prepare_write_cfm(uint16_t conn_idx, uint16_t handle, uint16_t length,
+        att_error_t status)
+{
+        (void)handle;
+        (void)length;
+        (void)status;
+
+        // prepared writes are not sent by the world
+        return conn_get(conn_idx) ? BLE_STATUS_OK : BLE_ERROR_NOT_CONNECTED;
+}
+
+static void queue_event_sent(uint16_t conn_idx, uint16_t handle, gatt_event_t type, bool status)
+{
+        ble_evt_gatts_event_sent_t *evt = evt_alloc(BLE_EVT_GATTS_EVENT_SENT, sizeof(*evt));
+
+        evt->conn_idx = conn_idx;
+        evt->handle = handle;
+        evt->type = type;
+        evt->status = status;
+        evt_queue(evt);
+}
+
+static void indication_next(uint16_t conn_idx, struct conn *conn)
+{
+        if (conn->ind_busy || !conn->ind_count) {
+                return;
+        }
+        conn->ind_busy = true;
+        send_pdu(conn_idx, &conn->ind[conn->ind_head]);
+}
+
+ble_error_t ble_gatts_send_event(uint16_t conn_idx, uint16_t handle, gatt_event_t type, uint16_t length,
+        const void *value)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct host_pdu *pdu;
+        struct host_pdu notify;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_CONNECTED;
+        }
+        // a notification or an indication carries at most MTU - 3 bytes
+        if (length > conn->mtu - 3) {
+                length = conn->mtu - 3;
+        }
+
+        if (type == GATT_EVENT_NOTIFICATION) {
+                pdu_init(&notify, HOST_PDU_NOTIFY);
+                notify.handle = handle;
+                notify.length = length;
+                memcpy(notify.value, value, length);
+                send_pdu(conn_idx, &notify);
+                queue_event_sent(conn_idx, handle, type, true);
+                return BLE_STATUS_OK;
+        }
+
+        if (conn->ind_count == HOST_BLE_INDICATIONS) {
+                return BLE_ERROR_INS_RESOURCES;
+        }
+        pdu = &conn->ind[(conn->ind_head + conn->ind_count++) % HOST_BLE_INDICATIONS];
+        pdu_init(pdu, HOST_PDU_INDICATE);
+        pdu->handle = handle;
+        pdu->length = length;
+        memcpy(pdu->value, value, length);
+        indication_next(conn_idx, conn);
+
+        return BLE_STATUS_OK;
+}
+
+static bool uuid_filter(const struct host_pdu *pdu, const att_uuid_t *uuid)
+{
+        return !pdu->param[0] || ble_uuid_equal(&pdu->uuid, uuid);
+}
+
+static void serve_find_svc(uint16_t conn_idx, const struct host_pdu *req)
+{
+        struct host_pdu pdu;
+        uint16_t h;
+
+        for (h = 1; h <= ble.num_attrs; h++) {
+                const struct attr *attr = &ble.attrs[h];
+
+                if (attr->kind != ATTR_SERVICE || !uuid_filter(req, &attr->uuid)) {
+                        continue;
+                }
+                pdu_init(&pdu, HOST_PDU_FIND_SVC_RSP);
+                pdu.uuid = attr->uuid;
+                pdu.handle = h;
+                pdu.end_handle = attr->end_h;
+                send_pdu(conn_idx, &pdu);
+        }
+        pdu_init(&pdu, HOST_PDU_FIND_DONE);
+        send_pdu(conn_idx, &pdu);
+}
+
+static void serve_find_char(uint16_t conn_idx, const struct host_pdu *req)
+{
+        struct host_pdu pdu;
+        uint16_t h;
+
+        for (h = req->handle; h && h <= req->end_handle && h <= ble.num_attrs; h++) {
+                const struct attr *attr = &ble.attrs[h];
+
+                if (attr->kind != ATTR_CHAR_DECL || !uuid_filter(req, &attr->uuid)) {
+                        continue;
+                }
+                pdu_init(&pdu, HOST_PDU_FIND_CHAR_RSP);
+                pdu.uuid = attr->uuid;
+                pdu.handle = h;
+                pdu.param[0] = h + 1;
+                pdu.props = attr->props;
+                send_pdu(conn_idx, &pdu);
+        }
+        pdu_init(&pdu, HOST_PDU_FIND_DONE);
+        send_pdu(conn_idx, &pdu);
+}
+
+static bool is_ccc(const struct attr *attr)
+{
+        return attr->kind == ATTR_DESC && attr->uuid.type == ATT_UUID_16 &&
+                attr->uuid.uuid16 == UUID_GATT_CLIENT_CHAR_CONFIGURATION;
+}
+
+static void serve_read(uint16_t conn_idx, struct conn *conn, const struct host_pdu *req)
+{
+        struct attr *attr = attr_get(req->handle);
+        ble_evt_gatts_read_req_t *evt;
+
+        if (!attr || (attr->kind != ATTR_VALUE && attr->kind != ATTR_DESC)) {
+                send_read_rsp(conn_idx, conn, req->handle, req->offset, ATT_ERROR_INVALID_HANDLE, 0, NULL);
+                return;
+        }
+        if (!(attr->perm & ATT_PERM_READ)) {
+                send_read_rsp(conn_idx, conn, req->handle, req->offset, ATT_ERROR_READ_NOT_PERMITTED, 0, NULL);
+                return;
+        }
+
+        // the application serves values flagged so and the client configurations
+        if ((attr->flags & GATTS_FLAG_CHAR_READ_REQ) || is_ccc(attr)) {
+                OS_ASSERT(!conn->read_pending);
+                conn->read_pending = true;
+                conn->read_handle = req->handle;
+                conn->read_offset = req->offset;
+
+                evt = evt_alloc(BLE_EVT_GATTS_READ_REQ, sizeof(*evt));
+                evt->conn_idx = conn_idx;
+                evt->handle = req->handle;
+                evt->offset = req->offset;
+                evt_queue(evt);
+                return;
+        }
+
+        if (req->offset > attr->length) {
+                send_read_rsp(conn_idx, conn, req->handle, req->offset, ATT_ERROR_INVALID_OFFSET, 0, NULL);
+                return;
+        }
+        send_read_rsp(conn_idx, conn, req->handle, req->offset, ATT_ERROR_OK, attr->length - req->offset,
+                attr->value + req->offset);
+}
+
+static void serve_write(uint16_t conn_idx, struct conn *conn, const struct host_pdu *req)
+{
+        bool cmd = (req->op == HOST_PDU_WRITE_CMD);
+        struct attr *attr = attr_get(req->handle);
+        ble_evt_gatts_write_req_t *evt;
+        att_error_t status = ATT_ERROR_OK;
+
+        if (!attr || (attr->kind != ATTR_VALUE && attr->kind != ATTR_DESC)) {
+                status = ATT_ERROR_INVALID_HANDLE;
+        } else if (!(attr->perm & ATT_PERM_WRITE)) {
+                status = ATT_ERROR_WRITE_NOT_PERMITTED;
+        } else if (req->offset + req->length > attr->max_len) {
+                status = ATT_ERROR_INVALID_VALUE_LENGTH;
+        }
+        if (status != ATT_ERROR_OK) {
+                if (!cmd) {
+                        send_write_rsp(conn_idx, req->handle, status);
+                }
+                return;
+        }
+
+        OS_ASSERT(!conn->write_pending);
+        conn->write_pending = true;
+        conn->write_cmd = cmd;
+        conn->write_handle = req->handle;
+
+        evt = evt_alloc(BLE_EVT_GATTS_WRITE_REQ, sizeof(*evt) + req->length);
+        evt->conn_idx = conn_idx;
+        evt->handle = req->handle;
+        evt->offset = req->offset;
+        evt->length = req->length;
+        memcpy(evt->value, req->value, req->length);
+        evt_queue(evt);
+}
+
+static void serve_mtu(uint16_t conn_idx, struct conn *conn, const struct host_pdu *req)
+{
+        struct host_pdu pdu;
+        uint16_t mtu = req->param[0] < ble.gap_mtu ? req->param[0] : ble.gap_mtu;
+
+        conn->mtu = mtu < HOST_ATT_MTU_DEFAULT ? HOST_ATT_MTU_DEFAULT : mtu;
+
+        pdu_init(&pdu, HOST_PDU_MTU_RSP);
+        pdu.param[0] = ble.gap_mtu;
+        send_pdu(conn_idx, &pdu);
+        queue_mtu_changed(conn_idx, conn->mtu);
+}
+
+/*
+ * Link procedures answered by the peer
+ */
+static ble_gap_phy_t phy_from_pref(uint16_t pref)
+{
+        return (pref & BLE_GAP_PHY_PREF_2M) ? BLE_GAP_PHY_2M : BLE_GAP_PHY_1M;
+}
+
+static void queue_phy_changed(uint16_t conn_idx, ble_gap_phy_t tx_phy, ble_gap_phy_t rx_phy)
+{
+        ble_evt_gap_phy_changed_t *evt = evt_alloc(BLE_EVT_GAP_PHY_CHANGED, sizeof(*evt));
+
+        evt->conn_idx = conn_idx;
+        evt->tx_phy = tx_phy;
+        evt->rx_phy = rx_phy;
+        evt_queue(evt);
+}
+
+static void queue_length_changed(uint16_t conn_idx, uint16_t octets, uint16_t time)
+{
+        ble_evt_gap_data_length_changed_t *evt = evt_alloc(BLE_EVT_GAP_DATA_LENGTH_CHANGED, sizeof(*evt));
+
+        evt->conn_idx = conn_idx;
+        evt->max_tx_length = octets;
+        evt->max_tx_time = time;
+        evt->max_rx_length = octets;
+        evt->max_rx_time = time;
+        evt_queue(evt);
+}
+
+static void link_procedure(uint16_t conn_idx, struct conn *conn, const struct host_pdu *req)
+{
+        struct host_pdu pdu;
+
+        switch (req->op) {
+        case HOST_PDU_CONN_PARAM_REQ:
+        {
+                ble_evt_gap_conn_param_update_req_t *evt =
+                        evt_alloc(BLE_EVT_GAP_CONN_PARAM_UPDATE_REQ, sizeof(*evt));
+
+                params_from_pdu(&conn->update_req, req);
+                evt->conn_idx = conn_idx;
+                evt->conn_params = conn->update_req;
+                evt_queue(evt);
+                break;
+        }
+        case HOST_PDU_CONN_PARAM_RSP:
+                if (conn->update_pending) {
+                        conn->update_pending = false;
+                        queue_update_completed(conn_idx, req->status);
+                }
+                break;
+        case HOST_PDU_CONN_UPDATE:
+                params_from_pdu(&conn->params, req);
+                queue_params_updated(conn_idx, &conn->params);
+                if (conn->update_pending) {
+                        conn->update_pending = false;
+                        queue_update_completed(conn_idx, BLE_STATUS_OK);
+                }
+                break;
+        case HOST_PDU_PHY_REQ:
+        {
+                ble_gap_phy_t tx = phy_from_pref(req->param[1]);
+                ble_gap_phy_t rx = phy_from_pref(req->param[0]);
+
+                pdu_init(&pdu, HOST_PDU_PHY_RSP);
+                pdu.param[0] = rx;
+                pdu.param[1] = tx;
+                send_pdu(conn_idx, &pdu);
+                queue_phy_changed(conn_idx, tx, rx);
+                break;
+        }
+        case HOST_PDU_PHY_RSP:
+        {
+                ble_evt_gap_phy_set_completed_t *evt;
+
+                if (!conn->phy_pending) {
+                        break;
+                }
+                conn->phy_pending = false;
+                evt = evt_alloc(BLE_EVT_GAP_PHY_SET_COMPLETED, sizeof(*evt));
+                evt->conn_idx = conn_idx;
+                evt->status = req->status;
+                evt_queue(evt);
+                if (req->status == BLE_STATUS_OK) {
+                        queue_phy_changed(conn_idx, req->param[0], req->param[1]);
+                }
+                break;
+        }
+        case HOST_PDU_LENGTH_REQ:
+        {
+                uint16_t octets = req->param[0] < HOST_BLE_MAX_OCTETS ? req->param[0] : HOST_BLE_MAX_OCTETS;
+                uint16_t time = req->param[1] < HOST_BLE_MAX_TIME ? req->param[1] : HOST_BLE_MAX_TIME;
+
+                pdu_init(&pdu, HOST_PDU_LENGTH_RSP);
+                pdu.param[0] = octets;
+                pdu.param[1] = time;
+                send_pdu(conn_idx, &pdu);
+                queue_length_changed(conn_idx, octets, time);
+                break;
+        }
+        case HOST_PDU_LENGTH_RSP:
+                if (!conn->length_pending) {
+                        break;
+                }
+                conn->length_pending = false;
+                if (req->status == BLE_STATUS_OK) {
+                        queue_length_changed(conn_idx, req->param[0], req->param[1]);
+                } else {
+                        ble_evt_gap_data_length_set_failed_t *evt =
+                                evt_alloc(BLE_EVT_GAP_DATA_LENGTH_SET_FAILED, sizeof(*evt));
+
+                        evt->conn_idx = conn_idx;
+                        evt->status = req->status;
+                        evt_queue(evt);
+                }
+                break;
+        default:
+                break;
+        }
+}
+
+/*
+ * Default handler
+ */
+void ble_handle_event_default(ble_evt_hdr_t *hdr)
+{
+        switch (hdr->evt_code) {
+        case BLE_EVT_GATTS_READ_REQ:
+        {
+                ble_evt_gatts_read_req_t *evt = (ble_evt_gatts_read_req_t *) hdr;
+
+                ble_gatts_read_cfm(evt->conn_idx, evt->handle, ATT_ERROR_READ_NOT_PERMITTED, 0, NULL);
+                break;
+        }
+        case BLE_EVT_GATTS_WRITE_REQ:
+        {
+                ble_evt_gatts_write_req_t *evt = (ble_evt_gatts_write_req_t *) hdr;
+
+                ble_gatts_write_cfm(evt->conn_idx, evt->handle, ATT_ERROR_WRITE_NOT_PERMITTED);
+                break;
+        }
+        case BLE_EVT_GATTS_PREPARE_WRITE_REQ:
+        {
+                ble_evt_gatts_prepare_write_req_t *evt = (ble_evt_gatts_prepare_write_req_t *) hdr;
+
+                ble_gatts_prepare_write_cfm(evt->conn_idx, evt->handle, 0, ATT_ERROR_REQUEST_NOT_SUPPORTED);
+                break;
+        }
+        case BLE_EVT_GAP_CONN_PARAM_UPDATE_REQ:
+        {
+                ble_evt_gap_conn_param_update_req_t *evt = (ble_evt_gap_conn_param_update_req_t *) hdr;
+
+                ble_gap_conn_param_update_reply(evt->conn_idx, true);
+                break;
+        }
+        case BLE_EVT_GAP_PAIR_REQ:
+        {
+                ble_evt_gap_pair_req_t *evt = (ble_evt_gap_pair_req_t *) hdr;
+
+                ble_gap_pair_reply(evt->conn_idx, false, false);
+                break;
+        }
+        default:
+                break;
+        }
+}
+
+/*
+ * Service framework
+ */
+void ble_service_add(ble_service_t *svc)
+{
+        OS_ASSERT(ble.num_services < HOST_BLE_MAX_SERVICES);
+        ble.services[ble.num_services++] = svc;
+}
+
+static ble_service_t *service_by_handle(uint16_t handle)
+{
+        int i;
+
+        for (i = 0; i < ble.num_services; i++) {
+                if (handle >= ble.services[i]->start_h && handle <= ble.services[i]->end_h) {
+                        return ble.services[i];
+                }
+        }
+
+        return NULL;
+}
+
+bool ble_service_handle_event(const ble_evt_hdr_t *evt)
+{
+        ble_service_t *svc;
+        int i;
+
+        switch (evt->evt_code) {
+        case BLE_EVT_GAP_CONNECTED:
+                for (i = 0; i < ble.num_services; i++) {
+                        if (ble.services[i]->connected_evt) {
+                                ble.services[i]->connected_evt(ble.services[i],
+                                        (const ble_evt_gap_connected_t *) evt);
+                        }
+                }
+                return false;
+        case BLE_EVT_GAP_DISCONNECTED:
+                for (i = 0; i < ble.num_services; i++) {
+                        if (ble.services[i]->disconnected_evt) {
+                                ble.services[i]->disconnected_evt(ble.services[i],
+                                        (const ble_evt_gap_disconnected_t *) evt);
+                        }
+                }
+                return false;
+        case BLE_EVT_GATTS_READ_REQ:
+        {
+                const ble_evt_gatts_read_req_t *info = (const ble_evt_gatts_read_req_t *) evt;
+
+                svc = service_by_handle(info->handle);
+                if (svc && svc->read_req) {
+                        svc->read_req(svc, info);
+                        return true;
+                }
+                return false;
+        }
+        case BLE_EVT_GATTS_WRITE_REQ:
+        {
+                const ble_evt_gatts_write_req_t *info = (const ble_evt_gatts_write_req_t *) evt;
+
+                svc = service_by_handle(info->handle);
+                if (svc && svc->write_req) {
+                        svc->write_req(svc, info);
+                        return true;
+                }
+                return false;
+        }
+        case BLE_EVT_GATTS_PREPARE_WRITE_REQ:
+        {
+                const ble_evt_gatts_prepare_write_req_t *info = (const ble_evt_gatts_prepare_write_req_t *) evt;
+
+                svc = service_by_handle(info->handle);
+                if (svc && svc->prepare_write_req) {
+                        svc->prepare_write_req(svc, info);
+                        return true;
+                }
+                return false;
+        }
+        case BLE_EVT_GATTS_EVENT_SENT:
+        {
+                const ble_evt_gatts_event_sent_t *info = (const ble_evt_gatts_event_sent_t *) evt;
+
+                svc = service_by_handle(info->handle);
+                if (svc && svc->event_sent) {
+                        svc->event_sent(svc, info);
+                        return true;
+                }
+                return false;
+        }
+        default:
+                return false;
+        }
+}
+
+/*
+ * Storage
+ */
+static struct storage_entry *storage_find(const bd_address_t *peer, ble_storage_key_t key)
+{
+        int i;
+
+        for (i = 0; i < HOST_BLE_MAX_STORAGE; i++) {
+                struct storage_entry *e = &ble.storage[i];
+
+                if (e->used && e->key == key && !memcmp(e->peer.addr, peer->addr, sizeof(peer->addr))) {
+                        return e;
+                }
+        }
+
+        return NULL;
+}
+
+ble_error_t ble_storage_put_u32(uint16_t conn_idx, ble_storage_key_t key, uint32_t value, bool persistent)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct storage_entry *e;
+        int i;
+
+        (void)persistent;
+
+        if (!conn) {
+                return BLE_ERROR_NOT_FOUND;
+        }
+        e = storage_find(&conn->peer, key);
+        for (i = 0; !e && i < HOST_BLE_MAX_STORAGE; i++) {
+                if (!ble.storage[i].used) {
+                        e = &ble.storage[i];
+                        e->used = true;
+                        e->peer = conn->peer;
+                        e->key = key;
+                }
+        }
+        if (!e) {
+                return BLE_ERROR_INS_RESOURCES;
+        }
+        e->value = value;
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_storage_get_u32(uint16_t conn_idx, ble_storage_key_t key, uint32_t *value)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct storage_entry *e;
+
+        if (!conn || (e = storage_find(&conn->peer, key)) == NULL) {
+                return BLE_ERROR_NOT_FOUND;
+        }
+        *value = e->value;
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_storage_get_u16(uint16_t conn_idx, ble_storage_key_t key, uint16_t *value)
+{
+        uint32_t v;
+        ble_error_t status = ble_storage_get_u32(conn_idx, key, &v);
+
+        if (status == BLE_STATUS_OK) {
+                *value = (uint16_t)v;
+        }
+
+        return status;
+}
+
+ble_error_t ble_storage_remove(uint16_t conn_idx, ble_storage_key_t key)
+{
+        struct conn *conn = conn_get(conn_idx);
+        struct storage_entry *e;
+
+        if (!conn || (e = storage_find(&conn->peer, key)) == NULL) {
+                return BLE_ERROR_NOT_FOUND;
+        }
+        e->used = false;
+
+        return BLE_STATUS_OK;
+}
+
+ble_error_t ble_storage_remove_all(ble_storage_key_t key)
+{
+        int i;
+
+        for (i = 0; i < HOST_BLE_MAX_STORAGE; i++) {
+                if (ble.storage[i].used && ble.storage[i].key == key) {
+                        ble.storage[i].used = false;
+                }
+        }
+
+        return BLE_STATUS_OK;
+}
+
+static void storage_drop_peer(const bd_address_t *peer)
+{
+        int i;
+
+        for (i = 0; i < HOST_BLE_MAX_STORAGE; i++) {
+                if (ble.storage[i].used && !memcmp(ble.storage[i].peer.addr, peer->addr, sizeof(peer->addr))) {
+                        ble.storage[i].used = false;
+                }
+        }
+}
+
+/*
+ * UUIDs
+ */
+static int hex_digit(char c)
+{
+        if (c >= '0' && c <= '9') {
+                return c - '0';
+        }
+        if (c >= 'a' && c <= 'f') {
+                return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F') {
+                return c - 'A' + 10;
+        }
+
+        return -1;
+}
+
+void ble_uuid_from_string(const char *str, att_uuid_t *uuid)
+{
+        uint8_t bytes[16];
+        int n = 0;
+
+        memset(uuid, 0, sizeof(*uuid));
+        for (; *str && n < 32; str++) {
+                int d = hex_digit(*str);
+
+                if (d < 0) {
+                        continue;
+                }
+                if (n % 2 == 0) {
+                        bytes[n / 2] = d << 4;
+                } else {
+                        bytes[n / 2] |= d;
+                }
+                n++;
+        }
+
+        if (n == 4) {
+                ble_uuid_create16((bytes[0] << 8) | bytes[1], uuid);
+                return;
+        }
+
+        // 128-bit UUIDs are little-endian, the string is big-endian
+        uuid->type = ATT_UUID_128;
+        for (n = 0; n < 16; n++) {
+                uuid->uuid128[n] = bytes[15 - n];
+        }
+}
+
+void ble_uuid_create16(uint16_t uuid16, att_uuid_t *uuid)
+{
+        memset(uuid, 0, sizeof(*uuid));
+        uuid->type = ATT_UUID_16;
+        uuid->uuid16 = uuid16;
+}
+
+bool ble_uuid_equal(const att_uuid_t *uuid1, const att_uuid_t *uuid2)
+{
+        if (uuid1->type != uuid2->type) {
+                return false;
+        }
+        if (uuid1->type == ATT_UUID_16) {
+                return uuid1->uuid16 == uuid2->uuid16;
+        }
+
+        return !memcmp(uuid1->uuid128, uuid2->uuid128, sizeof(uuid1->uuid128));
+}
+
+/*
+ * World
+ */
+void host_ble_set_address(const bd_address_t *addr)
+{
+        memcpy(&ble.addr, addr, sizeof(ble.addr));
+}
+
+void host_ble_set_world(const struct host_ble_world *world)
+{
+        ble.world = world;
+}
+
+uint16_t host_ble_link_up(const bd_address_t *peer, bool master, const gap_conn_params_t *params)
+{
+        ble_evt_gap_connected_t *evt;
+        struct conn *conn;
+        int idx = free_conn_idx();
+
+        OS_ASSERT(idx >= 0);
+        conn = &ble.conns[idx];
+        memset(conn, 0, sizeof(*conn));
+        conn->used = true;
+        conn->master = master;
+        conn->peer = *peer;
+        conn->params = *params;
+        conn->params.interval_max = params->interval_min;
+        conn->mtu = HOST_ATT_MTU_DEFAULT;
+        conn->rssi = -60;
+
+        evt = evt_alloc(BLE_EVT_GAP_CONNECTED, sizeof(*evt));
+        evt->conn_idx = idx;
+        memcpy(&evt->own_addr, &ble.addr, sizeof(evt->own_addr));
+        evt->peer_address = *peer;
+        evt->conn_params = conn->params;
+        evt_queue(evt);
+
+        if (master) {
+                ble.connecting = false;
+                queue_connection_completed(BLE_STATUS_OK);
+        } else {
+                // advertising stops on a connection as slave
+                ble.advertising = false;
+                report_adv();
+                queue_adv_completed(BLE_STATUS_OK);
+        }
+
+        return idx;
+}
+
+void host_ble_connect_failed(uint8_t status)
+{
+        if (!ble.connecting) {
+                return;
+        }
+        ble.connecting = false;
+        queue_connection_completed(status);
+}
+
+void host_ble_link_down(uint16_t conn_idx, uint8_t reason)
+{
+        ble_evt_gap_disconnected_t *evt;
+        struct conn *conn = conn_get(conn_idx);
+
+        if (!conn) {
+                return;
+        }
+
+        evt = evt_alloc(BLE_EVT_GAP_DISCONNECTED, sizeof(*evt));
+        evt->conn_idx = conn_idx;
+        evt->address = conn->peer;
+        evt->reason = reason;
+        evt_queue(evt);
+
+        // only bonded peers keep their stored values
+        if (!conn->bonded) {
+                storage_drop_peer(&conn->peer);
+        }
+        conn->used = false;
+}
+
+void host_ble_adv_report(const bd_address_t *addr, int8_t rssi, bool scan_rsp, const uint8_t *data,
+        uint8_t len)
+{
+        ble_evt_gap_adv_report_t *evt;
+
+        if (!ble.scanning) {
+                return;
+        }
+        // reports are dropped before the queue runs out for the other events
+        if (ble.held_count || OS_QUEUE_SPACES_AVAILABLE(ble.evt_queue) <= HOST_BLE_EVT_RESERVED) {
+                ble.stats.adv_dropped++;
+                return;
+        }
+        evt = evt_alloc(BLE_EVT_GAP_ADV_REPORT, sizeof(*evt));
+        if (!evt) {
+                ble.stats.adv_dropped++;
+                return;
+        }
+        evt->type = scan_rsp ? GAP_SCAN_RSP : GAP_ADV_IND;
+        evt->address = *addr;
+        evt->rssi = rssi;
+        evt->length = len < sizeof(evt->data) ? len : sizeof(evt->data);
+        memcpy(evt->data, data, evt->length);
+        evt_queue(evt);
+}
+
+void host_ble_recv(uint16_t conn_idx, const struct host_pdu *pdu)
+{
+        struct conn *conn = conn_get(conn_idx);
+
+        if (!conn) {
+                return;
+        }
+        ble.stats.pdus_rx++;
+
+        switch (pdu->op) {
+        case HOST_PDU_MTU_REQ:
+                serve_mtu(conn_idx, conn, pdu);
+                break;
+        case HOST_PDU_FIND_SVC_REQ:
+                serve_find_svc(conn_idx, pdu);
+                break;
+        case HOST_PDU_FIND_CHAR_REQ:
+                serve_find_char(conn_idx, pdu);
+                break;
+        case HOST_PDU_READ_REQ:
+                serve_read(conn_idx, conn, pdu);
+                break;
+        case HOST_PDU_WRITE_REQ:
+        case HOST_PDU_WRITE_CMD:
+                serve_write(conn_idx, conn, pdu);
+                break;
+        case HOST_PDU_MTU_RSP:
+        case HOST_PDU_FIND_SVC_RSP:
+        case HOST_PDU_FIND_CHAR_RSP:
+        case HOST_PDU_FIND_DONE:
+        case HOST_PDU_READ_RSP:
+        case HOST_PDU_WRITE_RSP:
+                client_response(conn_idx, conn, pdu);
+                break;
+        case HOST_PDU_NOTIFY:
+        case HOST_PDU_INDICATE:
+        {
+                bool indication = (pdu->op == HOST_PDU_INDICATE);
+                ble_evt_gattc_notification_t *evt = evt_alloc(indication ? BLE_EVT_GATTC_INDICATION :
+                                                        BLE_EVT_GATTC_NOTIFICATION, sizeof(*evt) + pdu->length);
+                struct host_pdu confirm;
+
+                evt->conn_idx = conn_idx;
+                evt->handle = pdu->handle;
+                evt->length = pdu->length;
+                memcpy(evt->value, pdu->value, pdu->length);
+                evt_queue(evt);
+
+                // the stack confirms indications itself
+                if (indication) {
+                        pdu_init(&confirm, HOST_PDU_CONFIRM);
+                        confirm.handle = pdu->handle;
+                        send_pdu(conn_idx, &confirm);
+                }
+                break;
+        }
+        case HOST_PDU_CONFIRM:
+                if (conn->ind_busy) {
+                        uint16_t handle = conn->ind[conn->ind_head].handle;
+
+                        conn->ind_busy = false;
+                        conn->ind_head = (conn->ind_head + 1) % HOST_BLE_INDICATIONS;
+                        conn->ind_count--;
+                        queue_event_sent(conn_idx, handle, GATT_EVENT_INDICATION, true);
+                        indication_next(conn_idx, conn);
+                }
+                break;
+        default:
+                link_procedure(conn_idx, conn, pdu);
+                break;
+        }
+}
+
+void host_ble_pair(uint16_t conn_idx, bool bond)
+{
+        ble_evt_gap_pair_req_t *evt;
+
+        if (!conn_get(conn_idx)) {
+                return;
+        }
+        evt = evt_alloc(BLE_EVT_GAP_PAIR_REQ, sizeof(*evt));
+        evt->conn_idx = conn_idx;
+        evt->bond = bond;
+        evt_queue(evt);
+}
+
+void host_ble_set_rssi(uint16_t conn_idx, int8_t rssi)
+{
+        struct conn *conn = conn_get(conn_idx);
+
+        if (conn) {
+                conn->rssi = rssi;
+        }
+}
+
+void host_ble_replay(bool on)
+{
+        ble.replay = on;
+}
+
+bool host_ble_inject(uint16_t evt_code, uint16_t length, const uint8_t *data, uint16_t data_len)
+{
+        ble_evt_hdr_t *hdr = evt_alloc(evt_code, sizeof(*hdr) + length);
+
+        if (!hdr) {
+                return false;
+        }
+        memcpy(hdr + 1, data, data_len < length ? data_len : length);
+
+        ble.injecting = true;
+        evt_queue(hdr);
+        ble.injecting = false;
+
+        return true;
+}
+
+void host_ble_get_stats(struct host_ble_stats *stats)
+{
+        *stats = ble.stats;
+}
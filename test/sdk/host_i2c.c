@@ -0,0 +1,118 @@
+/*
+ * host_i2c.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the I2C adapter with a HIH6130 on the bus.
+ *
+ * A controller is owned from ad_i2c_open() to ad_i2c_close(); as on the target,
+ * opening it again before closing it waits for the owner to close it, here for
+ * ever. Any write to the HIH6130 is a measurement request, a 4 byte read returns
+ * the status, humidity and temperature of the model.
+ */
+
+#include <string.h>
+
+#include "osal.h"
+#include "ad_i2c.h"
+#include "peripheral_setup.h"
+#include "host_sdk.h"
+
+__RETAINED static struct {
+        const ad_i2c_controller_conf_t *owner;
+        int open_count;
+        uint32_t transfers;
+        struct host_hih6130 hih6130;
+} bus;
+
+ad_i2c_handle_t ad_i2c_open(const ad_i2c_controller_conf_t *conf)
+{
+        /* the controller is taken and never given back: the caller waits for ever */
+        while (bus.owner) {
+                OS_DELAY_MS(60000);
+        }
+        bus.owner = conf;
+        bus.open_count++;
+
+        return (ad_i2c_handle_t)conf;
+}
+
+int ad_i2c_close(ad_i2c_handle_t handle, bool force)
+{
+        (void)force;
+
+        OS_ASSERT(handle == bus.owner);
+        bus.owner = NULL;
+        bus.open_count--;
+
+        return 0;
+}
+
+static bool addressed(ad_i2c_handle_t handle)
+{
+        const ad_i2c_controller_conf_t *conf = handle;
+
+        bus.transfers++;
+
+        return conf->drv->i2c.address == HIH6130_I2C_ADDRESS && !bus.hih6130.nack;
+}
+
+int ad_i2c_write(ad_i2c_handle_t handle, const uint8_t *wbuf, size_t wlen, uint8_t condition_flags)
+{
+        (void)wbuf;
+        (void)wlen;
+        (void)condition_flags;
+
+        OS_ASSERT(handle == bus.owner);
+        if (!addressed(handle)) {
+                return HW_I2C_ABORT_7B_ADDR_NO_ACK;
+        }
+
+        return HW_I2C_ABORT_NONE;
+}
+
+int ad_i2c_read(ad_i2c_handle_t handle, uint8_t *rbuf, size_t rlen, uint8_t condition_flags)
+{
+        uint8_t data[4];
+
+        (void)condition_flags;
+
+        OS_ASSERT(handle == bus.owner);
+        if (!addressed(handle)) {
+                return HW_I2C_ABORT_7B_ADDR_NO_ACK;
+        }
+
+        data[0] = (bus.hih6130.status << 6) | ((bus.hih6130.raw_humidity >> 8) & 0x3F);
+        data[1] = bus.hih6130.raw_humidity & 0xFF;
+        data[2] = (bus.hih6130.raw_temperature >> 6) & 0xFF;
+        data[3] = (bus.hih6130.raw_temperature << 2) & 0xFF;
+        memset(rbuf, 0xFF, rlen);
+        memcpy(rbuf, data, rlen < sizeof(data) ? rlen : sizeof(data));
+
+        return HW_I2C_ABORT_NONE;
+}
+
+int ad_i2c_io_config(HW_I2C_ID id, const ad_i2c_io_conf_t *io_config, AD_IO_CONF_STATE state)
+{
+        (void)id;
+        (void)io_config;
+        (void)state;
+
+        return 0;
+}
+
+void host_i2c_set_hih6130(const struct host_hih6130 *model)
+{
+        bus.hih6130 = *model;
+}
+
+int host_i2c_open_count(void)
+{
+        return bus.open_count;
+}
+
+uint32_t host_i2c_transfers(void)
+{
+        return bus.transfers;
+}
@@ -0,0 +1,1086 @@
+/*
+ * host_os.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the kernel, the heap, the watchdog and the system services the
+ * firmware calls at start-up.
+ *
+ * Every task runs on its own thread, but only the thread holding the baton runs:
+ * the kernel (the thread calling host_os_run_until()) hands it to the highest
+ * priority ready task and waits until the task gives it back by blocking. A task
+ * readying a task of higher priority gives the baton back right away, as it would
+ * be preempted. Kernel state is only touched by the thread holding the baton, the
+ * mutex only orders the hand-overs.
+ */
+
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "osal.h"
+#include "sdk_list.h"
+#include "sys_watchdog.h"
+#include "sys_clock_mgr.h"
+#include "sys_power_mgr.h"
+#include "hw_sys.h"
+#include "sdk_defs.h"
+#include "host_sdk.h"
+
+#define HOST_OS_MAX_TASKS               (8)
+#define HOST_OS_MAX_WDOG                (8)
+#define HOST_OS_THREAD_STACK            (512 * 1024)
+
+/* Heap block header and kernel object sizes charged to the heap, as on the target */
+#define HOST_HEAP_BLOCK_HDR             (8)
+#define HOST_HEAP_TCB_SIZE              (96)
+#define HOST_HEAP_TIMER_SIZE            (48)
+#define HOST_HEAP_QUEUE_SIZE            (80)
+
+enum task_state {
+        TASK_READY,
+        TASK_RUNNING,
+        TASK_BLOCKED,
+        TASK_DELETED,
+};
+
+enum task_wait {
+        WAIT_NONE,
+        WAIT_DELAY,
+        WAIT_NOTIFY,
+        WAIT_QUEUE_DATA,
+        WAIT_QUEUE_SPACE,
+};
+
+struct host_task {
+        const char *name;
+        OS_TASK_FUNCTION fn;
+        void *arg;
+        OS_UBASE_TYPE prio;
+        uint32_t stack_size;
+        pthread_t thread;
+        pthread_cond_t cond;
+        enum task_state state;
+        enum task_wait wait;
+        bool timed;                     /* the wait ends at wake */
+        bool timed_out;
+        OS_TICK_TIME wake;
+        uint64_t ready_seq;             /* first come first served among equal priorities */
+        uint32_t notify_value;
+        bool notify_pending;
+        struct host_queue *queue;       /* queue waited on */
+        void *tcb;                      /* TCB and stack charged to the heap */
+        struct timespec cpu_start;
+};
+
+struct host_timer {
+        struct host_timer *next;
+        const char *name;
+        OS_TICK_TIME period;
+        bool reload;
+        bool active;
+        OS_TICK_TIME expiry;
+        uint64_t seq;                   /* order of timers expiring on the same tick */
+        void *id;
+        OS_TIMER_CALLBACK cb;
+};
+
+struct host_queue {
+        size_t item_size;
+        size_t max_items;
+        size_t head;
+        size_t count;
+        uint8_t *items;
+};
+
+struct wdog_id {
+        bool used;
+        bool suspended;
+        bool notified;
+};
+
+struct heap_block {
+        size_t size;
+        size_t pad;                     /* keeps the payload aligned as malloc() does */
+};
+
+__RETAINED static struct {
+        pthread_mutex_t lock;
+        pthread_cond_t ctrl_cond;
+        struct host_task *current;      /* task holding the baton, NULL: the kernel */
+        struct host_task tasks[HOST_OS_MAX_TASKS];
+        int num_tasks;
+        struct host_timer *timers;
+        OS_TICK_TIME now;
+        uint64_t seq;
+        jmp_buf boot;
+        /* time charged for CPU use */
+        uint32_t ns_per_tick;
+        uint64_t cpu_ns;
+        /* heap */
+        size_t heap_limit;
+        size_t heap_used;
+        size_t heap_min_free;
+        bool (*heap_fail)(size_t size);
+        /* watchdog */
+        struct wdog_id wdog[HOST_OS_MAX_WDOG];
+        OS_TICK_TIME wdog_check;
+        uint32_t wdog_expiries;
+} kernel = {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .ctrl_cond = PTHREAD_COND_INITIALIZER,
+        .heap_limit = configTOTAL_HEAP_SIZE,
+        .heap_min_free = configTOTAL_HEAP_SIZE,
+        .wdog_check = HOST_WDOG_PERIOD_MS,
+};
+
+static bool heap_charge(size_t size);
+static void heap_release(size_t size);
+
+/* Defined by main.c */
+void vApplicationIdleHook(void);
+
+void host_os_assert(const char *expr, const char *file, int line)
+{
+        fprintf(stderr, "%s:%d: assertion failed: %s (tick %u)\n", file, line, expr,
+                (unsigned)kernel.now);
+        abort();
+}
+
+static uint64_t elapsed_ns(const struct timespec *from)
+{
+        struct timespec ts;
+
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return (uint64_t)(ts.tv_sec - from->tv_sec) * 1000000000ull + ts.tv_nsec - from->tv_nsec;
+}
+
+/*
+ * Baton passing
+ */
+static void switch_to(struct host_task *task)
+{
+        pthread_mutex_lock(&kernel.lock);
+        task->state = TASK_RUNNING;
+        kernel.current = task;
+        pthread_cond_signal(&task->cond);
+        while (kernel.current != NULL) {
+                pthread_cond_wait(&kernel.ctrl_cond, &kernel.lock);
+        }
+        pthread_mutex_unlock(&kernel.lock);
+
+        /* charge the CPU time the task used */
+        if (kernel.ns_per_tick) {
+                kernel.now += kernel.cpu_ns / kernel.ns_per_tick;
+                kernel.cpu_ns %= kernel.ns_per_tick;
+        }
+}
+
+static void wait_baton(struct host_task *self)
+{
+        while (kernel.current != self) {
+                pthread_cond_wait(&self->cond, &kernel.lock);
+        }
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &self->cpu_start);
+}
+
+static void switch_out(struct host_task *self)
+{
+        if (kernel.ns_per_tick) {
+                kernel.cpu_ns += elapsed_ns(&self->cpu_start);
+        }
+
+        pthread_mutex_lock(&kernel.lock);
+        kernel.current = NULL;
+        pthread_cond_signal(&kernel.ctrl_cond);
+        if (self->state == TASK_DELETED) {
+                pthread_mutex_unlock(&kernel.lock);
+                pthread_exit(NULL);
+        }
+        wait_baton(self);
+        pthread_mutex_unlock(&kernel.lock);
+}
+
+static void *task_thread(void *arg)
+{
+        struct host_task *self = arg;
+
+        pthread_mutex_lock(&kernel.lock);
+        wait_baton(self);
+        pthread_mutex_unlock(&kernel.lock);
+
+        self->fn(self->arg);
+
+        /* returning from a task function is not allowed on FreeRTOS */
+        host_os_assert("task function returned", __FILE__, __LINE__);
+        return NULL;
+}
+
+static void make_ready(struct host_task *task)
+{
+        task->state = TASK_READY;
+        task->wait = WAIT_NONE;
+        task->timed = false;
+        task->ready_seq = ++kernel.seq;
+}
+
+static struct host_task *running_task(void)
+{
+        return kernel.current;
+}
+
+/* Give the baton to a task readied by the running one if it has higher priority */
+static void preempt(struct host_task *readied)
+{
+        struct host_task *self = running_task();
+
+        if (self && readied->prio > self->prio) {
+                make_ready(self);
+                switch_out(self);
+        }
+}
+
+static void block(struct host_task *self, enum task_wait wait, OS_TICK_TIME timeout)
+{
+        self->state = TASK_BLOCKED;
+        self->wait = wait;
+        self->timed_out = false;
+        self->timed = (timeout != OS_TASK_NOTIFY_FOREVER);
+        if (self->timed) {
+                self->wake = host_os_tick_count() + timeout;
+        }
+        switch_out(self);
+}
+
+static struct host_task *pick_ready(void)
+{
+        struct host_task *best = NULL;
+        int i;
+
+        for (i = 0; i < kernel.num_tasks; i++) {
+                struct host_task *task = &kernel.tasks[i];
+
+                if (task->state != TASK_READY) {
+                        continue;
+                }
+                if (!best || task->prio > best->prio ||
+                        (task->prio == best->prio && task->ready_seq < best->ready_seq)) {
+                        best = task;
+                }
+        }
+
+        return best;
+}
+
+/*
+ * Tasks
+ */
+OS_BASE_TYPE host_os_task_create(const char *name, OS_TASK_FUNCTION fn, void *arg, uint32_t stack_size,
+        OS_UBASE_TYPE prio, OS_TASK *handle)
+{
+        struct host_task *task;
+        pthread_attr_t attr;
+        void *tcb;
+
+        *handle = NULL;
+        if (kernel.num_tasks >= HOST_OS_MAX_TASKS) {
+                return OS_FAIL;
+        }
+
+        /* the TCB and the stack come from the heap */
+        tcb = host_os_malloc(HOST_HEAP_TCB_SIZE + stack_size);
+        if (!tcb) {
+                return OS_FAIL;
+        }
+
+        task = &kernel.tasks[kernel.num_tasks++];
+        memset(task, 0, sizeof(*task));
+        task->name = name;
+        task->fn = fn;
+        task->arg = arg;
+        task->prio = prio;
+        task->stack_size = stack_size;
+        task->tcb = tcb;
+        pthread_cond_init(&task->cond, NULL);
+        make_ready(task);
+
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr, HOST_OS_THREAD_STACK);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&task->thread, &attr, task_thread, task) != 0) {
+                host_os_assert("pthread_create", __FILE__, __LINE__);
+        }
+        pthread_attr_destroy(&attr);
+
+        *handle = task;
+        preempt(task);
+
+        return OS_TASK_CREATE_SUCCESS;
+}
+
+void host_os_task_delete(OS_TASK task)
+{
+        host_os_free(task->tcb);
+        task->tcb = NULL;
+        task->state = TASK_DELETED;
+
+        if (task == running_task()) {
+                switch_out(task);
+        }
+}
+
+OS_TASK host_os_current_task(void)
+{
+        return running_task();
+}
+
+const char *host_os_task_name(OS_TASK task)
+{
+        return task ? task->name : "";
+}
+
+OS_BASE_TYPE host_os_task_notify(OS_TASK task, uint32_t value, OS_NOTIFY_ACTION action)
+{
+        OS_BASE_TYPE ret = OS_OK;
+
+        switch (action) {
+        case eSetBits:
+                task->notify_value |= value;
+                break;
+        case eIncrement:
+                task->notify_value++;
+                break;
+        case eSetValueWithOverwrite:
+                task->notify_value = value;
+                break;
+        case eSetValueWithoutOverwrite:
+                if (task->notify_pending) {
+                        ret = OS_FAIL;
+                } else {
+                        task->notify_value = value;
+                }
+                break;
+        case eNoAction:
+        default:
+                break;
+        }
+        task->notify_pending = true;
+
+        if (task->state == TASK_BLOCKED && task->wait == WAIT_NOTIFY) {
+                make_ready(task);
+                preempt(task);
+        }
+
+        return ret;
+}
+
+OS_BASE_TYPE host_os_task_notify_wait(uint32_t clear_entry, uint32_t clear_exit, uint32_t *value,
+        OS_TICK_TIME timeout)
+{
+        struct host_task *self = running_task();
+
+        OS_ASSERT(self != NULL);
+
+        if (!self->notify_pending) {
+                self->notify_value &= ~clear_entry;
+                if (timeout != 0) {
+                        block(self, WAIT_NOTIFY, timeout);
+                }
+        }
+
+        if (value) {
+                *value = self->notify_value;
+        }
+        if (!self->notify_pending) {
+                return OS_FAIL;
+        }
+        self->notify_pending = false;
+        self->notify_value &= ~clear_exit;
+
+        return OS_OK;
+}
+
+void host_os_delay(OS_TICK_TIME ticks)
+{
+        struct host_task *self = running_task();
+
+        OS_ASSERT(self != NULL);
+
+        if (ticks == 0) {
+                make_ready(self);
+                switch_out(self);
+                return;
+        }
+        block(self, WAIT_DELAY, ticks);
+}
+
+OS_TICK_TIME host_os_tick_count(void)
+{
+        struct host_task *self = running_task();
+        uint64_t ns = kernel.cpu_ns;
+
+        if (kernel.ns_per_tick && self) {
+                ns += elapsed_ns(&self->cpu_start);
+        }
+
+        return kernel.now + (kernel.ns_per_tick ? ns / kernel.ns_per_tick : 0);
+}
+
+/*
+ * Timers
+ */
+OS_TIMER host_os_timer_create(const char *name, OS_TICK_TIME period, bool reload, void *id,
+        OS_TIMER_CALLBACK cb)
+{
+        struct host_timer *timer;
+
+        if (!heap_charge(HOST_HEAP_TIMER_SIZE)) {
+                return NULL;
+        }
+        timer = calloc(1, sizeof(*timer));
+        timer->name = name;
+        timer->period = period;
+        timer->reload = reload;
+        timer->id = id;
+        timer->cb = cb;
+        timer->next = kernel.timers;
+        kernel.timers = timer;
+
+        return timer;
+}
+
+OS_BASE_TYPE host_os_timer_start(OS_TIMER timer)
+{
+        timer->active = true;
+        timer->expiry = host_os_tick_count() + timer->period;
+        timer->seq = ++kernel.seq;
+
+        return OS_TIMER_SUCCESS;
+}
+
+OS_BASE_TYPE host_os_timer_stop(OS_TIMER timer)
+{
+        timer->active = false;
+
+        return OS_TIMER_SUCCESS;
+}
+
+OS_BASE_TYPE host_os_timer_change_period(OS_TIMER timer, OS_TICK_TIME period)
+{
+        timer->period = period;
+
+        return host_os_timer_start(timer);
+}
+
+OS_BASE_TYPE host_os_timer_delete(OS_TIMER timer)
+{
+        struct host_timer **p;
+
+        for (p = &kernel.timers; *p; p = &(*p)->next) {
+                if (*p == timer) {
+                        *p = timer->next;
+                        free(timer);
+                        heap_release(HOST_HEAP_TIMER_SIZE);
+                        break;
+                }
+        }
+
+        return OS_TIMER_SUCCESS;
+}
+
+bool host_os_timer_is_active(OS_TIMER timer)
+{
+        return timer->active;
+}
+
+void *host_os_timer_id(OS_TIMER timer)
+{
+        return timer->id;
+}
+
+static struct host_timer *next_timer(void)
+{
+        struct host_timer *timer, *first = NULL;
+
+        for (timer = kernel.timers; timer; timer = timer->next) {
+                if (!timer->active) {
+                        continue;
+                }
+                if (!first || (int32_t)(timer->expiry - first->expiry) < 0 ||
+                        (timer->expiry == first->expiry && timer->seq < first->seq)) {
+                        first = timer;
+                }
+        }
+
+        return first;
+}
+
+static bool expire_timers(void)
+{
+        struct host_timer *timer;
+        bool expired = false;
+
+        while ((timer = next_timer()) != NULL && (int32_t)(timer->expiry - kernel.now) <= 0) {
+                if (timer->reload && timer->period) {
+                        timer->expiry += timer->period;
+                        timer->seq = ++kernel.seq;
+                } else {
+                        timer->active = false;
+                }
+                timer->cb(timer);
+                expired = true;
+        }
+
+        return expired;
+}
+
+/*
+ * Queues
+ */
+OS_QUEUE host_os_queue_create(size_t item_size, size_t max_items)
+{
+        struct host_queue *queue;
+
+        if (!heap_charge(HOST_HEAP_QUEUE_SIZE + item_size * max_items)) {
+                return NULL;
+        }
+        queue = calloc(1, sizeof(*queue));
+        queue->item_size = item_size;
+        queue->max_items = max_items;
+        queue->items = calloc(max_items, item_size);
+
+        return queue;
+}
+
+/* Ready the task of highest priority waiting on the queue */
+static void wake_queue_waiter(struct host_queue *queue, enum task_wait wait)
+{
+        struct host_task *best = NULL;
+        int i;
+
+        for (i = 0; i < kernel.num_tasks; i++) {
+                struct host_task *task = &kernel.tasks[i];
+
+                if (task->state == TASK_BLOCKED && task->wait == wait && task->queue == queue &&
+                        (!best || task->prio > best->prio)) {
+                        best = task;
+                }
+        }
+
+        if (best) {
+                best->queue = NULL;
+                make_ready(best);
+                preempt(best);
+        }
+}
+
+OS_BASE_TYPE host_os_queue_put(OS_QUEUE queue, const void *item, OS_TICK_TIME timeout)
+{
+        struct host_task *self = running_task();
+
+        while (queue->count == queue->max_items) {
+                if (timeout == 0 || !self) {
+                        return OS_QUEUE_FULL;
+                }
+                self->queue = queue;
+                block(self, WAIT_QUEUE_SPACE, timeout);
+                if (self->timed_out) {
+                        return OS_QUEUE_FULL;
+                }
+        }
+
+        memcpy(queue->items + ((queue->head + queue->count) % queue->max_items) * queue->item_size,
+                item, queue->item_size);
+        queue->count++;
+        wake_queue_waiter(queue, WAIT_QUEUE_DATA);
+
+        return OS_QUEUE_OK;
+}
+
+OS_BASE_TYPE host_os_queue_get(OS_QUEUE queue, void *item, OS_TICK_TIME timeout)
+{
+        struct host_task *self = running_task();
+
+        while (queue->count == 0) {
+                if (timeout == 0 || !self) {
+                        return OS_QUEUE_EMPTY;
+                }
+                self->queue = queue;
+                block(self, WAIT_QUEUE_DATA, timeout);
+                if (self->timed_out) {
+                        return OS_QUEUE_EMPTY;
+                }
+        }
+
+        memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->max_items;
+        queue->count--;
+        wake_queue_waiter(queue, WAIT_QUEUE_SPACE);
+
+        return OS_QUEUE_OK;
+}
+
+OS_UBASE_TYPE host_os_queue_waiting(OS_QUEUE queue)
+{
+        return queue->count;
+}
+
+OS_UBASE_TYPE host_os_queue_space(OS_QUEUE queue)
+{
+        return queue->max_items - queue->count;
+}
+
+/*
+ * Heap
+ */
+static bool heap_charge(size_t size)
+{
+        size_t charged = (size + HOST_HEAP_BLOCK_HDR + 7) & ~(size_t)7;
+
+        if (kernel.heap_fail && kernel.heap_fail(size)) {
+                return false;
+        }
+        if (kernel.heap_used + charged > kernel.heap_limit) {
+                return false;
+        }
+        kernel.heap_used += charged;
+        if (kernel.heap_limit - kernel.heap_used < kernel.heap_min_free) {
+                kernel.heap_min_free = kernel.heap_limit - kernel.heap_used;
+        }
+
+        return true;
+}
+
+static void heap_release(size_t size)
+{
+        kernel.heap_used -= (size + HOST_HEAP_BLOCK_HDR + 7) & ~(size_t)7;
+}
+
+void *host_os_malloc(size_t size)
+{
+        struct heap_block *block;
+
+        if (!heap_charge(size)) {
+                return NULL;
+        }
+        block = malloc(sizeof(*block) + size);
+        block->size = size;
+
+        return block + 1;
+}
+
+void host_os_free(void *ptr)
+{
+        struct heap_block *block;
+
+        if (!ptr) {
+                return;
+        }
+        block = (struct heap_block *)ptr - 1;
+        heap_release(block->size);
+        free(block);
+}
+
+size_t host_os_free_heap(void)
+{
+        return kernel.heap_limit - kernel.heap_used;
+}
+
+size_t host_os_heap_watermark(void)
+{
+        return kernel.heap_min_free;
+}
+
+void host_os_heap_limit(size_t bytes)
+{
+        kernel.heap_limit = bytes;
+        kernel.heap_min_free = bytes > kernel.heap_used ? bytes - kernel.heap_used : 0;
+}
+
+void host_os_heap_fail_hook(bool (*fail)(size_t size))
+{
+        kernel.heap_fail = fail;
+}
+
+size_t host_os_heap_used(void)
+{
+        return kernel.heap_used;
+}
+
+/*
+ * Watchdog
+ */
+void sys_watchdog_init(void)
+{
+}
+
+int8_t sys_watchdog_register(bool notify_trigger)
+{
+        int8_t id;
+
+        (void)notify_trigger;
+
+        for (id = 0; id < HOST_OS_MAX_WDOG; id++) {
+                if (!kernel.wdog[id].used) {
+                        kernel.wdog[id].used = true;
+                        kernel.wdog[id].notified = true;
+                        return id;
+                }
+        }
+
+        return -1;
+}
+
+void sys_watchdog_unregister(int8_t id)
+{
+        kernel.wdog[id].used = false;
+}
+
+void sys_watchdog_configure_idle_id(int8_t id)
+{
+        (void)id;
+}
+
+void sys_watchdog_notify(int8_t id)
+{
+        kernel.wdog[id].notified = true;
+}
+
+void sys_watchdog_suspend(int8_t id)
+{
+        kernel.wdog[id].suspended = true;
+}
+
+void sys_watchdog_resume(int8_t id)
+{
+        kernel.wdog[id].suspended = false;
+        kernel.wdog[id].notified = true;
+}
+
+void sys_watchdog_notify_and_resume(int8_t id)
+{
+        sys_watchdog_resume(id);
+}
+
+static void check_watchdog(void)
+{
+        int id;
+
+        while ((int32_t)(kernel.now - kernel.wdog_check) >= 0) {
+                for (id = 0; id < HOST_OS_MAX_WDOG; id++) {
+                        struct wdog_id *w = &kernel.wdog[id];
+
+                        if (!w->used || w->suspended) {
+                                continue;
+                        }
+                        if (!w->notified) {
+                                fprintf(stderr, "watchdog: id %d not notified (tick %u)\n", id,
+                                        (unsigned)kernel.now);
+                                kernel.wdog_expiries++;
+                        }
+                        w->notified = false;
+                }
+                kernel.wdog_check += HOST_WDOG_PERIOD_MS;
+        }
+}
+
+uint32_t host_os_wdog_expiries(void)
+{
+        return kernel.wdog_expiries;
+}
+
+/*
+ * Scheduler
+ */
+void host_os_boot(int (*main_fn)(void))
+{
+        if (setjmp(kernel.boot) == 0) {
+                main_fn();
+        }
+}
+
+void vTaskStartScheduler(void)
+{
+        longjmp(kernel.boot, 1);
+}
+
+/* Wake up the tasks whose wait timed out */
+static void wake_timed_out(void)
+{
+        int i;
+
+        for (i = 0; i < kernel.num_tasks; i++) {
+                struct host_task *task = &kernel.tasks[i];
+
+                if (task->state == TASK_BLOCKED && task->timed &&
+                        (int32_t)(task->wake - kernel.now) <= 0) {
+                        bool timed_out = (task->wait != WAIT_DELAY);
+
+                        task->queue = NULL;
+                        make_ready(task);
+                        task->timed_out = timed_out;
+                }
+        }
+}
+
+OS_TICK_TIME host_os_next_event(void)
+{
+        struct host_timer *timer;
+        OS_TICK_TIME next = kernel.wdog_check;
+        int i;
+
+        if (pick_ready()) {
+                return kernel.now;
+        }
+
+        timer = next_timer();
+        if (timer && (int32_t)(timer->expiry - next) < 0) {
+                next = timer->expiry;
+        }
+        for (i = 0; i < kernel.num_tasks; i++) {
+                struct host_task *task = &kernel.tasks[i];
+
+                if (task->state == TASK_BLOCKED && task->timed && (int32_t)(task->wake - next) < 0) {
+                        next = task->wake;
+                }
+        }
+
+        return (int32_t)(next - kernel.now) < 0 ? kernel.now : next;
+}
+
+void host_os_run_until(OS_TICK_TIME until)
+{
+        for (;;) {
+                struct host_task *task;
+                OS_TICK_TIME next;
+
+                expire_timers();
+                wake_timed_out();
+                check_watchdog();
+
+                task = pick_ready();
+                if (task) {
+                        switch_to(task);
+                        continue;
+                }
+
+                /* nothing ready, the idle task runs */
+                vApplicationIdleHook();
+
+                next = host_os_next_event();
+                if ((int32_t)(next - until) > 0) {
+                        if ((int32_t)(until - kernel.now) > 0) {
+                                kernel.now = until;
+                        }
+                        break;
+                }
+                kernel.now = next;
+        }
+}
+
+OS_TICK_TIME host_os_now(void)
+{
+        return kernel.now;
+}
+
+void host_os_set_cpu_scale(uint32_t ns_per_tick)
+{
+        kernel.ns_per_tick = ns_per_tick;
+        kernel.cpu_ns = 0;
+}
+
+/*
+ * Lists, as sdk_list.c
+ */
+void list_add(void **head, void *elem)
+{
+        struct list_elem *e = elem;
+
+        e->next = *head;
+        *head = e;
+}
+
+void list_append(void **head, void *elem)
+{
+        struct list_elem *e = elem;
+
+        e->next = NULL;
+        while (*head) {
+                head = (void **)&((struct list_elem *)*head)->next;
+        }
+        *head = e;
+}
+
+void *list_pop_back(void **head)
+{
+        struct list_elem **p = (struct list_elem **)head;
+        struct list_elem *e;
+
+        if (!*p) {
+                return NULL;
+        }
+        while ((*p)->next) {
+                p = &(*p)->next;
+        }
+        e = *p;
+        *p = NULL;
+
+        return e;
+}
+
+void *list_find(void *head, list_elem_match_t match, const void *ud)
+{
+        struct list_elem *e;
+
+        for (e = head; e; e = e->next) {
+                if (match(e, ud)) {
+                        return e;
+                }
+        }
+
+        return NULL;
+}
+
+void *list_unlink(void **head, list_elem_match_t match, const void *ud)
+{
+        struct list_elem **p;
+
+        for (p = (struct list_elem **)head; *p; p = &(*p)->next) {
+                if (match(*p, ud)) {
+                        struct list_elem *e = *p;
+
+                        *p = e->next;
+                        return e;
+                }
+        }
+
+        return NULL;
+}
+
+void list_remove(void **head, list_elem_match_t match, const void *ud)
+{
+        OS_FREE(list_unlink(head, match, ud));
+}
+
+void list_foreach(void *head, list_elem_cb_t cb, const void *ud)
+{
+        struct list_elem *e, *next;
+
+        for (e = head; e; e = next) {
+                next = e->next;
+                cb(e, ud);
+        }
+}
+
+void list_free(void **head, list_elem_cb_t cb, const void *ud)
+{
+        struct list_elem *e = *head;
+
+        while (e) {
+                struct list_elem *next = e->next;
+
+                if (cb) {
+                        cb(e, ud);
+                }
+                OS_FREE(e);
+                e = next;
+        }
+        *head = NULL;
+}
+
+int list_size(void *head)
+{
+        struct list_elem *e;
+        int n = 0;
+
+        for (e = head; e; e = e->next) {
+                n++;
+        }
+
+        return n;
+}
+
+/*
+ * System services called at start-up
+ */
+void cm_sys_clk_init(sys_clk_t clk)
+{
+        (void)clk;
+}
+
+void cm_apb_set_clock_divider(apb_div_t div)
+{
+        (void)div;
+}
+
+void cm_ahb_set_clock_divider(ahb_div_t div)
+{
+        (void)div;
+}
+
+void cm_lp_clk_init(void)
+{
+}
+
+cm_sys_clk_set_status_t cm_sys_clk_set(sys_clk_t clk)
+{
+        (void)clk;
+        return cm_sysclk_success;
+}
+
+bool cm_cpu_clk_set(cpu_clk_t clk)
+{
+        (void)clk;
+        return true;
+}
+
+uint32_t cm_cpu_clk_get_fromISR(void)
+{
+        return HOST_CPU_CLK_MHZ;
+}
+
+void pm_system_init(periph_init_cb init)
+{
+        if (init) {
+                init();
+        }
+}
+
+void pm_set_wakeup_mode(bool wait_for_xtal)
+{
+        (void)wait_for_xtal;
+}
+
+void pm_sleep_mode_set(sleep_mode_t mode)
+{
+        (void)mode;
+}
+
+void pm_set_sys_wakeup_mode(sys_wakeup_mode_t mode)
+{
+        (void)mode;
+}
+
+void hw_sys_pd_com_enable(void)
+{
+}
+
+void hw_sys_pd_com_disable(void)
+{
+}
+
+/* Cycle counter, counts the CPU time of the thread at HOST_CPU_CLK_MHZ */
+struct host_dwt *host_dwt(void)
+{
+        static __thread struct host_dwt dwt;
+        struct timespec ts;
+
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        dwt.CYCCNT = (uint32_t)(((uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec) *
+                HOST_CPU_CLK_MHZ / 1000);
+
+        return &dwt;
+}
@@ -0,0 +1,302 @@
+/*
+ * host_sdk.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Control interface of the host stand-ins of the SDK, used by the test programs
+ * to boot a firmware image, advance its time and play the radio around it.
+ *
+ * One firmware image runs on one kernel (host_os.c): the caller boots it, then
+ * advances it with host_os_run_until(), from its own thread, while no task of it
+ * runs. Everything else of this interface is called in between, the firmware
+ * calls back into the world from its tasks (host_ble_world).
+ */
+
+#ifndef TEST_SDK_HOST_SDK_H_
+#define TEST_SDK_HOST_SDK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "osal.h"
+#include "ble_gap.h"
+#include "ble_att.h"
+
+/* No event pending */
+#define HOST_OS_NEVER                   (0xFFFFFFFF)
+
+/* Period in which every registered task has to notify the watchdog */
+#define HOST_WDOG_PERIOD_MS             (2600)
+
+/*
+ * Kernel (host_os.c)
+ */
+
+/**
+ * \brief Run main() of the image up to vTaskStartScheduler()
+ *
+ * \param [in] main_fn: main() of the firmware, built as host_main()
+ */
+void host_os_boot(int (*main_fn)(void));
+
+/**
+ * \brief Run the tasks and timers up to a tick
+ *
+ * Runs every task which is ready, expires timers and wakes up waiting tasks until
+ * nothing is left to do at or before \p until. Time stops at \p until, or after
+ * it when CPU time is charged (host_os_set_cpu_scale()).
+ */
+void host_os_run_until(OS_TICK_TIME until);
+
+/**
+ * \brief Current tick of the kernel
+ */
+OS_TICK_TIME host_os_now(void);
+
+/**
+ * \brief Tick at which something happens next, HOST_OS_NEVER if nothing is pending
+ */
+OS_TICK_TIME host_os_next_event(void);
+
+/**
+ * \brief Charge the CPU time the tasks use to the virtual time
+ *
+ * \param [in] ns_per_tick: thread CPU time taking one tick, 0 to stop time while
+ *                          tasks run (default)
+ */
+void host_os_set_cpu_scale(uint32_t ns_per_tick);
+
+/**
+ * \brief Limit the heap, OS_MALLOC() fails past it
+ *
+ * The limit defaults to configTOTAL_HEAP_SIZE. Task stacks and kernel objects
+ * are charged as FreeRTOS allocates them from the same heap.
+ */
+void host_os_heap_limit(size_t bytes);
+
+/**
+ * \brief Make allocations fail
+ *
+ * \param [in] fail: called with the size of each allocation, returns true to fail it;
+ *                   NULL to stop
+ */
+void host_os_heap_fail_hook(bool (*fail)(size_t size));
+
+/**
+ * \brief Bytes allocated, block headers included
+ */
+size_t host_os_heap_used(void);
+
+/**
+ * \brief Number of watchdog periods in which a registered task did not notify
+ */
+uint32_t host_os_wdog_expiries(void);
+
+/*
+ * BLE (host_ble.c)
+ */
+
+/* Maximum number of connections */
+#define HOST_BLE_MAX_CONN               (8)
+
+/* Events the application has not fetched yet, advertising reports are dropped past
+ * HOST_BLE_EVT_QUEUE_LEN - HOST_BLE_EVT_RESERVED */
+#define HOST_BLE_EVT_QUEUE_LEN          (32)
+#define HOST_BLE_EVT_RESERVED           (8)
+/* Events the stack holds back while the queue is full, it runs out of buffers past them */
+#define HOST_BLE_EVT_HELD_MAX           (256)
+
+/* ATT MTU of a connection before an exchange, and the MTU a device offers by default */
+#define HOST_ATT_MTU_DEFAULT            (23)
+#define HOST_GAP_MTU_DEFAULT            (65)
+#define HOST_ATT_MTU_MAX                (512)
+
+/* Largest attribute value */
+#define HOST_ATT_VALUE_MAX              (512)
+
+/*
+ * Protocol data units between two devices
+ *
+ * A PDU stands for one ATT PDU, or one link layer or L2CAP procedure message.
+ */
+enum host_pdu_op {
+        HOST_PDU_MTU_REQ,               /* param[0]: client MTU */
+        HOST_PDU_MTU_RSP,               /* param[0]: server MTU */
+        HOST_PDU_FIND_SVC_REQ,          /* uuid, if param[0] is non-zero */
+        HOST_PDU_FIND_SVC_RSP,          /* uuid, handle, end_handle */
+        HOST_PDU_FIND_CHAR_REQ,         /* handle, end_handle; uuid, if param[0] is non-zero */
+        HOST_PDU_FIND_CHAR_RSP,         /* uuid, handle of the declaration, param[0]: value handle, props */
+        HOST_PDU_FIND_DONE,             /* end of a discovery */
+        HOST_PDU_READ_REQ,              /* handle, offset */
+        HOST_PDU_READ_RSP,              /* status, handle, offset, value */
+        HOST_PDU_WRITE_REQ,             /* handle, offset, value */
+        HOST_PDU_WRITE_CMD,             /* handle, value */
+        HOST_PDU_WRITE_RSP,             /* status, handle */
+        HOST_PDU_NOTIFY,                /* handle, value */
+        HOST_PDU_INDICATE,              /* handle, value */
+        HOST_PDU_CONFIRM,               /* handle */
+        HOST_PDU_CONN_PARAM_REQ,        /* param[]: connection parameters, slave to master */
+        HOST_PDU_CONN_PARAM_RSP,        /* status, master refused the request */
+        HOST_PDU_CONN_UPDATE,           /* param[]: connection parameters in use from now on */
+        HOST_PDU_PHY_REQ,               /* param[0], param[1]: tx, rx PHY preferences */
+        HOST_PDU_PHY_RSP,               /* status, param[0], param[1]: tx, rx PHY */
+        HOST_PDU_LENGTH_REQ,            /* param[0], param[1]: tx octets, time */
+        HOST_PDU_LENGTH_RSP,            /* status, param[0], param[1]: tx octets, time */
+};
+
+struct host_pdu {
+        uint8_t op;
+        uint8_t status;
+        uint16_t handle;
+        uint16_t end_handle;
+        uint16_t offset;
+        uint16_t param[4];
+        att_uuid_t uuid;
+        uint8_t props;
+        uint16_t length;
+        uint8_t value[HOST_ATT_VALUE_MAX];
+};
+
+/*
+ * Radio around the device, called from the tasks of the firmware. The calls only
+ * record what the firmware asked for, the world answers later with the entry
+ * points below.
+ */
+struct host_ble_world {
+        void *ctx;
+        /* advertising started or stopped, with the advertising and scan response data */
+        void (*adv)(void *ctx, bool on, const uint8_t *ad, uint8_t ad_len, const uint8_t *sd,
+                uint8_t sd_len);
+        /* scanning started or stopped, interval and window in 0.625 ms units */
+        void (*scan)(void *ctx, bool on, bool active, uint16_t interval, uint16_t window);
+        /* connection to a peer requested, and canceled */
+        void (*connect)(void *ctx, const bd_address_t *peer, const gap_conn_params_t *params);
+        void (*connect_cancel)(void *ctx);
+        /* disconnection requested */
+        void (*disconnect)(void *ctx, uint16_t conn_idx, uint8_t reason);
+        /* PDU sent on a connection */
+        void (*send)(void *ctx, uint16_t conn_idx, const struct host_pdu *pdu);
+};
+
+/* Counters of the BLE stand-in */
+struct host_ble_stats {
+        uint32_t events;                /* events queued to the application */
+        uint32_t adv_dropped;           /* advertising reports dropped on a full queue */
+        uint32_t max_queued;            /* event queue high-water mark */
+        uint32_t max_held;              /* events held back by the stack, high-water mark */
+        uint32_t pdus_tx;
+        uint32_t pdus_rx;
+};
+
+/**
+ * \brief Set the public address of the device, before booting it
+ */
+void host_ble_set_address(const bd_address_t *addr);
+
+/**
+ * \brief Connect the device to the world
+ */
+void host_ble_set_world(const struct host_ble_world *world);
+
+/**
+ * \brief A connection was established
+ *
+ * \param [in] peer: address of the peer
+ * \param [in] master: the device is the master of the connection (it requested it)
+ * \param [in] params: connection parameters
+ *
+ * \return index of the connection on the device
+ */
+uint16_t host_ble_link_up(const bd_address_t *peer, bool master, const gap_conn_params_t *params);
+
+/**
+ * \brief The pending connection request did not succeed
+ *
+ * \param [in] status: status of the connection completed event
+ */
+void host_ble_connect_failed(uint8_t status);
+
+/**
+ * \brief A connection was lost or terminated
+ */
+void host_ble_link_down(uint16_t conn_idx, uint8_t reason);
+
+/**
+ * \brief The scanning device received an advertising report
+ *
+ * \param [in] addr: address of the advertiser
+ * \param [in] rssi: signal strength
+ * \param [in] scan_rsp: the report is a scan response
+ * \param [in] data: advertising or scan response data
+ * \param [in] len: data length
+ */
+void host_ble_adv_report(const bd_address_t *addr, int8_t rssi, bool scan_rsp, const uint8_t *data,
+        uint8_t len);
+
+/**
+ * \brief A PDU arrived on a connection
+ */
+void host_ble_recv(uint16_t conn_idx, const struct host_pdu *pdu);
+
+/**
+ * \brief The peer paired, and bonded when \p bond is set
+ */
+void host_ble_pair(uint16_t conn_idx, bool bond);
+
+/**
+ * \brief Signal strength of a connection, -60 dBm if not set
+ */
+void host_ble_set_rssi(uint16_t conn_idx, int8_t rssi);
+
+/**
+ * \brief Replay mode: the events of the stand-in are dropped, only injected ones are queued
+ */
+void host_ble_replay(bool on);
+
+/**
+ * \brief Queue an event to the application, as the BLE manager does
+ *
+ * \param [in] evt_code: event code
+ * \param [in] length: length of the event after its header
+ * \param [in] data: first bytes of the event after its header, the rest is zero
+ * \param [in] data_len: number of bytes in \p data
+ *
+ * \return false if the event could not be allocated
+ */
+bool host_ble_inject(uint16_t evt_code, uint16_t length, const uint8_t *data, uint16_t data_len);
+
+/**
+ * \brief Counters of the BLE stand-in
+ */
+void host_ble_get_stats(struct host_ble_stats *stats);
+
+/*
+ * I2C (host_i2c.c)
+ */
+
+/* Model of the HIH6130 humidity and temperature sensor */
+struct host_hih6130 {
+        uint16_t raw_humidity;          /* 14 bits */
+        uint16_t raw_temperature;       /* 14 bits */
+        uint8_t status;                 /* 2 bits, 1: stale data */
+        bool nack;                      /* the sensor does not answer */
+};
+
+/**
+ * \brief Set the HIH6130 model, read by every measurement from then on
+ */
+void host_i2c_set_hih6130(const struct host_hih6130 *model);
+
+/**
+ * \brief Number of ad_i2c_open() without their ad_i2c_close()
+ */
+int host_i2c_open_count(void);
+
+/**
+ * \brief Number of I2C transfers, successful or not
+ */
+uint32_t host_i2c_transfers(void);
+
+#endif /* TEST_SDK_HOST_SDK_H_ */
@@ -0,0 +1,43 @@
+/*
+ * hw_gpio.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK GPIO low level driver definitions.
+ */
+
+#ifndef TEST_SDK_HW_GPIO_H_
+#define TEST_SDK_HW_GPIO_H_
+
+typedef enum {
+        HW_GPIO_PORT_0 = 0,
+        HW_GPIO_PORT_1 = 1,
+} HW_GPIO_PORT;
+
+typedef enum {
+        HW_GPIO_PIN_0 = 0,
+        HW_GPIO_PIN_30 = 30,
+        HW_GPIO_PIN_31 = 31,
+} HW_GPIO_PIN;
+
+typedef enum {
+        HW_GPIO_MODE_INPUT = 0,
+        HW_GPIO_MODE_INPUT_PULLUP = 0x100,
+        HW_GPIO_MODE_INPUT_PULLDOWN = 0x200,
+        HW_GPIO_MODE_OUTPUT = 0x300,
+        HW_GPIO_MODE_OUTPUT_OPEN_DRAIN = 0x700,
+} HW_GPIO_MODE;
+
+typedef enum {
+        HW_GPIO_FUNC_GPIO = 0,
+        HW_GPIO_FUNC_I2C_SCL = 17,
+        HW_GPIO_FUNC_I2C_SDA = 18,
+} HW_GPIO_FUNC;
+
+typedef enum {
+        HW_GPIO_POWER_V33 = 0,
+        HW_GPIO_POWER_VDD1V8P = 1,
+} HW_GPIO_POWER;
+
+#endif /* TEST_SDK_HW_GPIO_H_ */
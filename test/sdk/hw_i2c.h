@@ -0,0 +1,60 @@
+/*
+ * hw_i2c.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK I2C low level driver definitions.
+ */
+
+#ifndef TEST_SDK_HW_I2C_H_
+#define TEST_SDK_HW_I2C_H_
+
+#include <stdint.h>
+
+typedef enum {
+        HW_I2C1 = 0,
+        HW_I2C2 = 1,
+} HW_I2C_ID;
+
+typedef enum {
+        HW_I2C_SPEED_STANDARD = 1,
+        HW_I2C_SPEED_FAST = 2,
+        HW_I2C_SPEED_HIGH = 3,
+} HW_I2C_SPEED;
+
+typedef enum {
+        HW_I2C_MODE_MASTER,
+        HW_I2C_MODE_SLAVE,
+} HW_I2C_MODE;
+
+typedef enum {
+        HW_I2C_ADDRESSING_7B,
+        HW_I2C_ADDRESSING_10B,
+} HW_I2C_ADDRESSING;
+
+typedef enum {
+        HW_I2C_ABORT_NONE = 0,
+        HW_I2C_ABORT_7B_ADDR_NO_ACK = 1,
+        HW_I2C_ABORT_10B_ADDR1_NO_ACK = 2,
+        HW_I2C_ABORT_10B_ADDR2_NO_ACK = 3,
+        HW_I2C_ABORT_TX_DATA_NO_ACK = 4,
+        HW_I2C_ABORT_GENERAL_CALL_NO_ACK = 5,
+        HW_I2C_ABORT_ARBITRATION_LOST = 13,
+        HW_I2C_ABORT_SW_ERROR = 0xFF,
+} HW_I2C_ABORT_SOURCE;
+
+/* Transfer flags */
+#define HW_I2C_F_NONE                   (0x00000000)
+#define HW_I2C_F_WAIT_FOR_STOP          (0x00000001)
+#define HW_I2C_F_ADD_STOP               (0x00000002)
+#define HW_I2C_F_ADD_RESTART            (0x00000004)
+
+typedef struct {
+        HW_I2C_SPEED speed;
+        HW_I2C_MODE mode;
+        HW_I2C_ADDRESSING addr_mode;
+        uint16_t address;
+} i2c_config;
+
+#endif /* TEST_SDK_HW_I2C_H_ */
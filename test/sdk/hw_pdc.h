@@ -0,0 +1,13 @@
+/*
+ * hw_pdc.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK header, nothing of it is used on the host.
+ */
+
+#ifndef TEST_SDK_HW_PDC_H_
+#define TEST_SDK_HW_PDC_H_
+
+#endif /* TEST_SDK_HW_PDC_H_ */
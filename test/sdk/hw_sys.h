@@ -0,0 +1,16 @@
+/*
+ * hw_sys.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK system low level driver, implemented by host_os.c.
+ */
+
+#ifndef TEST_SDK_HW_SYS_H_
+#define TEST_SDK_HW_SYS_H_
+
+void hw_sys_pd_com_enable(void);
+void hw_sys_pd_com_disable(void);
+
+#endif /* TEST_SDK_HW_SYS_H_ */
@@ -0,0 +1,13 @@
+/*
+ * hw_wkup.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK header, nothing of it is used on the host.
+ */
+
+#ifndef TEST_SDK_HW_WKUP_H_
+#define TEST_SDK_HW_WKUP_H_
+
+#endif /* TEST_SDK_HW_WKUP_H_ */
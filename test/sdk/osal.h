@@ -0,0 +1,188 @@
+/*
+ * osal.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK OS abstraction, implemented by host_os.c.
+ *
+ * Every task is a thread, but only one of them runs at a time: the kernel hands
+ * the CPU to the highest priority ready task (first come first served among equal
+ * priorities) and gets it back when the task blocks. Time is virtual, in 1 ms
+ * ticks, and only advances when no task is ready; timers expire in kernel
+ * context between task runs, as the timer task of FreeRTOS does.
+ */
+
+#ifndef TEST_SDK_OSAL_H_
+#define TEST_SDK_OSAL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define __RETAINED
+#define __RETAINED_RW
+#define __RETAINED_CODE
+#define INITIALISED_PRIVILEGED_DATA
+#define PRIVILEGED_DATA
+
+#define configTICK_RATE_HZ              (1000)
+#define configTOTAL_HEAP_SIZE           (22972)
+#define configMINIMAL_STACK_SIZE        (100)
+
+/* Heap statistics of the kernel are not available, see mem_stats.c */
+#define tskKERNEL_VERSION_MAJOR         (10)
+#define tskKERNEL_VERSION_MINOR         (1)
+#define tskKERNEL_VERSION_BUILD         (1)
+#define INCLUDE_uxTaskGetStackHighWaterMark     (0)
+
+typedef struct host_task *OS_TASK;
+typedef struct host_timer *OS_TIMER;
+typedef struct host_queue *OS_QUEUE;
+typedef uint32_t OS_TICK_TIME;
+typedef long OS_BASE_TYPE;
+typedef unsigned long OS_UBASE_TYPE;
+typedef void (*OS_TASK_FUNCTION)(void *);
+typedef void (*OS_TIMER_CALLBACK)(OS_TIMER);
+
+typedef enum {
+        eNoAction = 0,
+        eSetBits,
+        eIncrement,
+        eSetValueWithOverwrite,
+        eSetValueWithoutOverwrite,
+} OS_NOTIFY_ACTION;
+
+#define OS_OK                           (1)
+#define OS_FAIL                         (0)
+#define OS_TASK_CREATE_SUCCESS          OS_OK
+#define OS_TASK_NOTIFY_SUCCESS          OS_OK
+#define OS_TIMER_SUCCESS                OS_OK
+#define OS_TIMER_FAIL                   OS_FAIL
+#define OS_QUEUE_OK                     OS_OK
+#define OS_QUEUE_FULL                   OS_FAIL
+#define OS_QUEUE_EMPTY                  OS_FAIL
+
+#define OS_TASK_PRIORITY_LOWEST         (0)
+#define OS_TASK_PRIORITY_NORMAL         (1)
+#define OS_TASK_PRIORITY_HIGHEST        (6)
+
+#define OS_STACK_WORD_SIZE              (4)
+
+#define OS_TIMER_FOREVER                (0xFFFFFFFF)
+#define OS_TIMER_ONCE                   (0)
+#define OS_TIMER_RELOAD                 (1)
+
+#define OS_TASK_NOTIFY_NO_WAIT          (0)
+#define OS_TASK_NOTIFY_FOREVER          (0xFFFFFFFF)
+#define OS_TASK_NOTIFY_NONE             (0)
+#define OS_TASK_NOTIFY_ALL_BITS         (0xFFFFFFFF)
+
+#define OS_QUEUE_NO_WAIT                (0)
+#define OS_QUEUE_FOREVER                (0xFFFFFFFF)
+
+#define OS_MS_2_TICKS(ms)               ((OS_TICK_TIME)(ms))
+#define OS_TICKS_2_MS(ticks)            ((uint32_t)(ticks))
+#define OS_TIME_TO_TICKS(ms)            OS_MS_2_TICKS(ms)
+
+/*
+ * Kernel, see host_os.c
+ */
+OS_BASE_TYPE host_os_task_create(const char *name, OS_TASK_FUNCTION fn, void *arg, uint32_t stack_size,
+        OS_UBASE_TYPE prio, OS_TASK *task);
+void host_os_task_delete(OS_TASK task);
+OS_TASK host_os_current_task(void);
+const char *host_os_task_name(OS_TASK task);
+OS_BASE_TYPE host_os_task_notify(OS_TASK task, uint32_t value, OS_NOTIFY_ACTION action);
+OS_BASE_TYPE host_os_task_notify_wait(uint32_t clear_entry, uint32_t clear_exit, uint32_t *value,
+        OS_TICK_TIME timeout);
+void host_os_delay(OS_TICK_TIME ticks);
+OS_TICK_TIME host_os_tick_count(void);
+
+OS_TIMER host_os_timer_create(const char *name, OS_TICK_TIME period, bool reload, void *id,
+        OS_TIMER_CALLBACK cb);
+OS_BASE_TYPE host_os_timer_start(OS_TIMER timer);
+OS_BASE_TYPE host_os_timer_stop(OS_TIMER timer);
+OS_BASE_TYPE host_os_timer_change_period(OS_TIMER timer, OS_TICK_TIME period);
+OS_BASE_TYPE host_os_timer_delete(OS_TIMER timer);
+bool host_os_timer_is_active(OS_TIMER timer);
+void *host_os_timer_id(OS_TIMER timer);
+
+OS_QUEUE host_os_queue_create(size_t item_size, size_t max_items);
+OS_BASE_TYPE host_os_queue_put(OS_QUEUE queue, const void *item, OS_TICK_TIME timeout);
+OS_BASE_TYPE host_os_queue_get(OS_QUEUE queue, void *item, OS_TICK_TIME timeout);
+OS_UBASE_TYPE host_os_queue_waiting(OS_QUEUE queue);
+OS_UBASE_TYPE host_os_queue_space(OS_QUEUE queue);
+
+void *host_os_malloc(size_t size);
+void host_os_free(void *ptr);
+size_t host_os_free_heap(void);
+size_t host_os_heap_watermark(void);
+
+void host_os_assert(const char *expr, const char *file, int line);
+void vTaskStartScheduler(void);
+
+/*
+ * Tasks
+ */
+#define OS_TASK_CREATE(name, fn, arg, stack, prio, task)                                \
+        host_os_task_create((name), (fn), (arg), (stack), (prio), &(task))
+#define OS_TASK_DELETE(task)            host_os_task_delete(task)
+#define OS_GET_CURRENT_TASK()           host_os_current_task()
+#define OS_TASK_NOTIFY(task, value, action)             host_os_task_notify((task), (value), (action))
+#define OS_TASK_NOTIFY_FROM_ISR(task, value, action)    host_os_task_notify((task), (value), (action))
+#define OS_TASK_NOTIFY_WAIT(clear_entry, clear_exit, value, timeout)                    \
+        host_os_task_notify_wait((clear_entry), (clear_exit), (value), (timeout))
+#define OS_DELAY(ticks)                 host_os_delay(ticks)
+#define OS_DELAY_MS(ms)                 host_os_delay(OS_MS_2_TICKS(ms))
+#define OS_GET_TICK_COUNT()             host_os_tick_count()
+#define pcTaskGetName(task)             host_os_task_name(task)
+
+/*
+ * Timers
+ */
+#define OS_TIMER_CREATE(name, period, reload, id, cb)                                   \
+        host_os_timer_create((name), (period), (reload), (void *)(id), (cb))
+#define OS_TIMER_START(timer, timeout)  host_os_timer_start(timer)
+#define OS_TIMER_RESET(timer, timeout)  host_os_timer_start(timer)
+#define OS_TIMER_STOP(timer, timeout)   host_os_timer_stop(timer)
+#define OS_TIMER_CHANGE_PERIOD(timer, period, timeout)  host_os_timer_change_period((timer), (period))
+#define OS_TIMER_DELETE(timer, timeout) host_os_timer_delete(timer)
+#define OS_TIMER_IS_ACTIVE(timer)       host_os_timer_is_active(timer)
+#define OS_TIMER_GET_TIMER_ID(timer)    host_os_timer_id(timer)
+
+/*
+ * Queues
+ */
+#define OS_QUEUE_CREATE(queue, item_size, max_items)                                    \
+        ((queue) = host_os_queue_create((item_size), (max_items)))
+#define OS_QUEUE_PUT(queue, item, timeout)      host_os_queue_put((queue), (item), (timeout))
+#define OS_QUEUE_GET(queue, item, timeout)      host_os_queue_get((queue), (item), (timeout))
+#define OS_QUEUE_MESSAGES_WAITING(queue)        host_os_queue_waiting(queue)
+#define OS_QUEUE_SPACES_AVAILABLE(queue)        host_os_queue_space(queue)
+
+/*
+ * Heap
+ */
+#define OS_MALLOC(size)                 host_os_malloc(size)
+#define OS_FREE(ptr)                    host_os_free(ptr)
+#define OS_GET_FREE_HEAP_SIZE()         host_os_free_heap()
+#define OS_GET_HEAP_WATERMARK()         host_os_heap_watermark()
+
+/*
+ * Only one task runs at a time and tasks are never preempted in the middle of
+ * their code, critical sections have nothing to protect
+ */
+#define OS_ENTER_CRITICAL_SECTION()     do { } while (0)
+#define OS_LEAVE_CRITICAL_SECTION()     do { } while (0)
+#define taskENTER_CRITICAL()            do { } while (0)
+#define taskEXIT_CRITICAL()             do { } while (0)
+
+#define OS_ASSERT(expr)                 ((expr) ? (void)0 : host_os_assert(#expr, __FILE__, __LINE__))
+#define ASSERT_ERROR(expr)              OS_ASSERT(expr)
+#define ASSERT_WARNING(expr)            OS_ASSERT(expr)
+
+#define ARRAY_LENGTH(array)             (sizeof(array) / sizeof((array)[0]))
+
+#endif /* TEST_SDK_OSAL_H_ */
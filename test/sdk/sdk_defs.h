@@ -0,0 +1,32 @@
+/*
+ * sdk_defs.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK definitions: the cycle counter of the Cortex-M debug
+ * unit counts the CPU time of the calling thread (host_os.c).
+ */
+
+#ifndef TEST_SDK_SDK_DEFS_H_
+#define TEST_SDK_SDK_DEFS_H_
+
+#include <stdint.h>
+
+struct host_dwt {
+        uint32_t CTRL;
+        uint32_t CYCCNT;
+};
+
+struct host_core_debug {
+        uint32_t DEMCR;
+};
+
+struct host_dwt *host_dwt(void);
+
+#define DWT                             (host_dwt())
+#define CoreDebug                       (&(struct host_core_debug){ 0 })
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+#endif /* TEST_SDK_SDK_DEFS_H_ */
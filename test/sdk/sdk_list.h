@@ -0,0 +1,32 @@
+/*
+ * sdk_list.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK singly linked list, implemented by host_os.c.
+ */
+
+#ifndef TEST_SDK_SDK_LIST_H_
+#define TEST_SDK_SDK_LIST_H_
+
+#include <stdbool.h>
+
+struct list_elem {
+        struct list_elem *next;
+};
+
+typedef void (*list_elem_cb_t)(const void *elem, const void *ud);
+typedef bool (*list_elem_match_t)(const void *elem, const void *ud);
+
+void list_add(void **head, void *elem);
+void list_append(void **head, void *elem);
+void *list_pop_back(void **head);
+void *list_find(void *head, list_elem_match_t match, const void *ud);
+void *list_unlink(void **head, list_elem_match_t match, const void *ud);
+void list_remove(void **head, list_elem_match_t match, const void *ud);
+void list_foreach(void *head, list_elem_cb_t cb, const void *ud);
+void list_free(void **head, list_elem_cb_t cb, const void *ud);
+int list_size(void *head);
+
+#endif /* TEST_SDK_SDK_LIST_H_ */
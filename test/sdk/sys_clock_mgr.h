@@ -0,0 +1,55 @@
+/*
+ * sys_clock_mgr.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK clock manager, implemented by host_os.c.
+ */
+
+#ifndef TEST_SDK_SYS_CLOCK_MGR_H_
+#define TEST_SDK_SYS_CLOCK_MGR_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* CPU clock of the target, the cycle counter (sdk_defs.h) runs at it */
+#define HOST_CPU_CLK_MHZ                (32)
+
+typedef enum {
+        sysclk_RC32 = 0,
+        sysclk_XTAL32M = 1,
+        sysclk_PLL96 = 2,
+} sys_clk_t;
+
+typedef sys_clk_t cpu_clk_t;
+
+typedef enum {
+        ahb_div1 = 0,
+        ahb_div2,
+        ahb_div4,
+        ahb_div8,
+} ahb_div_t;
+
+typedef enum {
+        apb_div1 = 0,
+        apb_div2,
+        apb_div4,
+        apb_div8,
+} apb_div_t;
+
+typedef enum {
+        cm_sysclk_success,
+        cm_sysclk_higher_prio_used,
+        cm_sysclk_div1_clk_in_use,
+} cm_sys_clk_set_status_t;
+
+void cm_sys_clk_init(sys_clk_t clk);
+void cm_apb_set_clock_divider(apb_div_t div);
+void cm_ahb_set_clock_divider(ahb_div_t div);
+void cm_lp_clk_init(void);
+cm_sys_clk_set_status_t cm_sys_clk_set(sys_clk_t clk);
+bool cm_cpu_clk_set(cpu_clk_t clk);
+uint32_t cm_cpu_clk_get_fromISR(void);
+
+#endif /* TEST_SDK_SYS_CLOCK_MGR_H_ */
@@ -0,0 +1,35 @@
+/*
+ * sys_power_mgr.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK power manager, implemented by host_os.c.
+ */
+
+#ifndef TEST_SDK_SYS_POWER_MGR_H_
+#define TEST_SDK_SYS_POWER_MGR_H_
+
+#include <stdbool.h>
+
+typedef enum {
+        pm_mode_active = 0,
+        pm_mode_idle,
+        pm_mode_extended_sleep,
+        pm_mode_deep_sleep,
+        pm_mode_hibernation,
+} sleep_mode_t;
+
+typedef enum {
+        pm_sys_wakeup_mode_normal,
+        pm_sys_wakeup_mode_fast,
+} sys_wakeup_mode_t;
+
+typedef void (*periph_init_cb)(void);
+
+void pm_system_init(periph_init_cb init);
+void pm_set_wakeup_mode(bool wait_for_xtal);
+void pm_sleep_mode_set(sleep_mode_t mode);
+void pm_set_sys_wakeup_mode(sys_wakeup_mode_t mode);
+
+#endif /* TEST_SDK_SYS_POWER_MGR_H_ */
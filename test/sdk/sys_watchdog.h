@@ -0,0 +1,26 @@
+/*
+ * sys_watchdog.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Host stand-in of the SDK watchdog service, implemented by host_os.c: every
+ * registered task which is not suspended has to notify within HOST_WDOG_PERIOD_MS.
+ */
+
+#ifndef TEST_SDK_SYS_WATCHDOG_H_
+#define TEST_SDK_SYS_WATCHDOG_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+void sys_watchdog_init(void);
+int8_t sys_watchdog_register(bool notify_trigger);
+void sys_watchdog_unregister(int8_t id);
+void sys_watchdog_configure_idle_id(int8_t id);
+void sys_watchdog_notify(int8_t id);
+void sys_watchdog_suspend(int8_t id);
+void sys_watchdog_resume(int8_t id);
+void sys_watchdog_notify_and_resume(int8_t id);
+
+#endif /* TEST_SDK_SYS_WATCHDOG_H_ */
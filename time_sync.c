@@ -0,0 +1,99 @@
+/*
+ * time_sync.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ *
+ * Fleet clock: offset and drift of the local clock against the clock of the
+ * root master. Every sync re-anchors the offset; the drift is estimated over
+ * intervals of at least TIME_SYNC_MIN_DRIFT_MS so the latency of the sync
+ * write (up to a connection interval) averages out, and smoothed by an EMA.
+ *
+ * Times are ms in 32 bits, differences are taken modulo 2^32 so a wrap of
+ * either clock is handled; an epoch is stretched once when the fleet clock wraps.
+ */
+
+#include <string.h>
+
+#include "time_sync.h"
+
+/*
+ * delta * ppm / 10^6
+ */
+static int32_t scale_ppm(uint32_t delta, int32_t ppm)
+{
+        return (int32_t)(((int64_t)delta * ppm) / 1000000);
+}
+
+void time_sync_reset(struct time_sync *ts)
+{
+        memset(ts, 0, sizeof(*ts));
+}
+
+uint32_t time_sync_now(const struct time_sync *ts, uint32_t local_ms)
+{
+        uint32_t elapsed;
+
+        if (!ts->synced) {
+                return local_ms;
+        }
+
+        elapsed = local_ms - ts->local_ref;
+
+        return ts->fleet_ref + elapsed + scale_ppm(elapsed, ts->drift_ppm);
+}
+
+void time_sync_update(struct time_sync *ts, uint32_t local_ms, uint32_t fleet_ms)
+{
+        uint32_t elapsed;
+        int32_t measured;
+
+        if (!ts->synced) {
+                ts->synced = true;
+                ts->drift_local_ref = local_ms;
+                ts->drift_fleet_ref = fleet_ms;
+                goto anchor;
+        }
+
+        ts->last_error = (int32_t)(fleet_ms - time_sync_now(ts, local_ms));
+
+        /*
+         * Drift over the interval since the last drift reference: the difference
+         * between the fleet and the local time elapsed, relative to the local time
+         */
+        elapsed = local_ms - ts->drift_local_ref;
+        if (elapsed < TIME_SYNC_MIN_DRIFT_MS) {
+                goto anchor;
+        }
+        measured = (int32_t)(((int64_t)(int32_t)((fleet_ms - ts->drift_fleet_ref) - elapsed) * 1000000) / elapsed);
+        ts->drift_local_ref = local_ms;
+        ts->drift_fleet_ref = fleet_ms;
+
+        // a master restart or a jump of its clock, not drift
+        if (measured > TIME_SYNC_MAX_DRIFT_PPM || measured < -TIME_SYNC_MAX_DRIFT_PPM) {
+                goto anchor;
+        }
+        ts->drift_ppm += (measured - ts->drift_ppm) / (1 << TIME_SYNC_DRIFT_SHIFT);
+
+anchor:
+        ts->local_ref = local_ms;
+        ts->fleet_ref = fleet_ms;
+}
+
+uint32_t time_sync_epoch_delay(const struct time_sync *ts, uint32_t local_ms, uint32_t period_ms,
+                                                                                uint32_t offset_ms)
+{
+        uint32_t fleet = time_sync_now(ts, local_ms) - offset_ms;
+        uint32_t delay = period_ms - fleet % period_ms;
+
+        if (delay < period_ms / 4) {
+                delay += period_ms;
+        }
+
+        // fleet ms to local ms
+        if (ts->synced) {
+                delay -= scale_ppm(delay, ts->drift_ppm);
+        }
+
+        return delay ? delay : 1;
+}
@@ -0,0 +1,76 @@
+/*
+ * time_sync.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: ssuser
+ */
+
+#ifndef TIME_SYNC_H_
+#define TIME_SYNC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Limit of the estimated drift between the fleet clock and the local clock, ppm.
+ * Covers an uncalibrated RC low power clock; larger estimates are treated as noise.
+ */
+#define TIME_SYNC_MAX_DRIFT_PPM         (500)
+
+/*
+ * Minimum local time over which the drift is estimated; a sync latency of 30 ms
+ * is 100 ppm of noise over 5 minutes. Syncs in between only re-anchor the clock.
+ */
+#define TIME_SYNC_MIN_DRIFT_MS          (300000)
+
+/* Drift estimate EMA weight 1 / 2^TIME_SYNC_DRIFT_SHIFT */
+#define TIME_SYNC_DRIFT_SHIFT           (2)
+
+/*
+ * Fleet clock state, all times in ms.
+ *
+ * The fleet time is the clock of the root master, distributed down the tree of
+ * masters. Between syncs it is extrapolated from the local clock, corrected by
+ * the estimated drift of the local clock.
+ */
+struct time_sync {
+        bool synced;
+        uint32_t local_ref;             /* local time of the last sync */
+        uint32_t fleet_ref;             /* fleet time received with the last sync */
+        uint32_t drift_local_ref;       /* local and fleet time at the start of the drift interval */
+        uint32_t drift_fleet_ref;
+        int32_t drift_ppm;              /* fleet clock rate relative to the local clock */
+        int32_t last_error;             /* prediction error at the last sync */
+};
+
+/**
+ * \brief Reset the fleet clock, the fleet time follows the local clock until synced
+ */
+void time_sync_reset(struct time_sync *ts);
+
+/**
+ * \brief Sync the fleet clock
+ *
+ * \param [in] local_ms: local time at which \p fleet_ms was received
+ * \param [in] fleet_ms: fleet time sent by the master
+ */
+void time_sync_update(struct time_sync *ts, uint32_t local_ms, uint32_t fleet_ms);
+
+/**
+ * \brief Fleet time at local time \p local_ms
+ */
+uint32_t time_sync_now(const struct time_sync *ts, uint32_t local_ms);
+
+/**
+ * \brief Local time until the next epoch of the fleet clock
+ *
+ * Epochs are the multiples of \p period_ms of the fleet time, shifted by \p offset_ms.
+ * An epoch closer than a quarter period is skipped, so waking up slightly early
+ * does not run the same epoch twice.
+ *
+ * \return delay in ms of the local clock, 1 .. 1.25 * \p period_ms
+ */
+uint32_t time_sync_epoch_delay(const struct time_sync *ts, uint32_t local_ms, uint32_t period_ms,
+                                                                                uint32_t offset_ms);
+
+#endif /* TIME_SYNC_H_ */
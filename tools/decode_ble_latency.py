@@ -0,0 +1,96 @@
+#!/usr/bin/env python3
+#
+# decode_ble_latency.py
+#
+# Decodes the BLE event latency statistics read from the diagnostics service
+# (DIAG_ATTR_LATENCY, see ble_latency.h). Concatenate the values of consecutive
+# reads until an empty value is returned and pass them as a binary file or as a
+# hex string.
+#
+# Usage: tools/decode_ble_latency.py <dump.bin>
+#        tools/decode_ble_latency.py --hex <hex string>
+#
+
+import struct
+import sys
+
+HDR_FMT = '<2sBBIBBBx'
+
+
+def bucket_range_us(b, shift, cycles_per_us):
+    lo = 0 if b == 0 else (1 << (b - 1)) << shift
+    hi = (1 << b) << shift
+    return lo / cycles_per_us, hi / cycles_per_us
+
+
+def percentile(buckets, count, p, shift, cycles_per_us):
+    # upper bound of the bucket holding the p-th percentile
+    target = count * p / 100.0
+    acc = 0
+    for b, n in enumerate(buckets):
+        acc += n
+        if acc >= target:
+            return bucket_range_us(b, shift, cycles_per_us)[1]
+    return float('inf')
+
+
+def decode(data):
+    magic, version, num_codes, clk_hz, shift, num_buckets, num_depth = \
+        struct.unpack_from(HDR_FMT, data, 0)
+    if magic != b'BL' or version not in (1, 2):
+        sys.exit('not a BLE latency dump (magic %r, version %d)' % (magic, version))
+
+    cycles_per_us = clk_hz / 1e6
+    pos = struct.calcsize(HDR_FMT)
+
+    print('CPU clock %d MHz, %d event codes' % (clk_hz // 1000000, num_codes))
+    print('%-6s %8s %10s %10s %10s' % ('code', 'count', 'p50 us', 'p99 us', 'max us'))
+
+    for _ in range(num_codes):
+        code, count, max_cycles = struct.unpack_from('<HII', data, pos)
+        pos += 10
+        buckets = struct.unpack_from('<%dH' % num_buckets, data, pos)
+        pos += 2 * num_buckets
+
+        name = 'other' if code == 0xFFFF else '%04x' % code
+        print('%-6s %8d %10.1f %10.1f %10.1f' % (
+            name, count,
+            percentile(buckets, sum(buckets), 50, shift, cycles_per_us),
+            percentile(buckets, sum(buckets), 99, shift, cycles_per_us),
+            max_cycles / cycles_per_us))
+
+    depth_max, = struct.unpack_from('<H', data, pos)
+    pos += 2
+    depth = struct.unpack_from('<%dH' % num_depth, data, pos)
+
+    print('\nevents drained per burst (max %d):' % depth_max)
+    for b, n in enumerate(depth):
+        lo, hi = 1 << b, (1 << (b + 1)) - 1
+        label = '%d+' % lo if b == num_depth - 1 else ('%d' % lo if lo == hi else '%d-%d' % (lo, hi))
+        print('  %-8s %d' % (label, n))
+    pos += 2 * num_depth
+
+    if version < 2:
+        return
+
+    wakeups, events, busy, max_events, limited, peak_rate = struct.unpack_from('<IIIHII', data, pos)
+    busy_s = (busy << shift) / clk_hz
+    print('\nevent loop: %d events in %d wakeups (%.1f per wakeup, max %d)' % (
+        events, wakeups, events / wakeups if wakeups else 0, max_events))
+    print('  busy %.3f s, %.0f events/s sustained' % (busy_s, events / busy_s if busy_s else 0))
+    print('  %d wakeups limited by batch size or time budget, peak %d events/s' % (limited, peak_rate))
+
+
+def main():
+    if len(sys.argv) == 3 and sys.argv[1] == '--hex':
+        data = bytes.fromhex(sys.argv[2])
+    elif len(sys.argv) == 2:
+        with open(sys.argv[1], 'rb') as f:
+            data = f.read()
+    else:
+        sys.exit('usage: decode_ble_latency.py <dump.bin> | --hex <hex string>')
+    decode(data)
+
+
+if __name__ == '__main__':
+    main()
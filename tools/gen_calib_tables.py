@@ -0,0 +1,101 @@
+#!/usr/bin/env python3
+#
+# gen_calib_tables.py
+#
+# Generates sensor_calib_tables.h: piecewise-linear calibration tables with
+# uniformly spaced breakpoints for calib_apply() (see sensor_conversion.h).
+#
+# Each table is described by its input domain and a list of measured
+# calibration points (converted value, reference value). The points are
+# interpolated linearly onto the uniform breakpoint grid and rounded.
+#
+# Usage: tools/gen_calib_tables.py > sensor_calib_tables.h
+#
+
+import math
+import sys
+
+TABLES = [
+    {
+        # HIH6130 relative humidity, 0.01 %RH. Identity until the sensor is calibrated.
+        'name': 'calib_hih_humidity',
+        'x_min': 0, 'x_max': 10000, 'shift': 10,
+        'points': [(0, 0), (10000, 10000)],
+    },
+    {
+        # HIH6130 ambient temperature, 0.01 degC. Identity until the sensor is calibrated.
+        'name': 'calib_hih_temperature',
+        'x_min': -4000, 'x_max': 12501, 'shift': 10,
+        'points': [(-4000, -4000), (12501, 12501)],
+    },
+    {
+        # Soil moisture (water), 14-bit raw to 0.01 %. Replace with the probe's
+        # measured curve; the default maps the raw range linearly.
+        'name': 'calib_water',
+        'x_min': 0, 'x_max': 16383, 'shift': 11,
+        'points': [(0, 0), (16383, 10000)],
+    },
+]
+
+
+def interpolate(points, x):
+    points = sorted(points)
+    if x <= points[0][0]:
+        (x0, y0), (x1, y1) = points[0], points[1]
+    elif x >= points[-1][0]:
+        (x0, y0), (x1, y1) = points[-2], points[-1]
+    else:
+        for (x0, y0), (x1, y1) in zip(points, points[1:]):
+            if x0 <= x <= x1:
+                break
+    return y0 + (y1 - y0) * (x - x0) / (x1 - x0)
+
+
+def generate(table):
+    step = 1 << table['shift']
+    num = math.ceil((table['x_max'] - table['x_min']) / step) + 1
+    if num > 255:
+        raise ValueError('%s: too many breakpoints' % table['name'])
+
+    y = [int(round(interpolate(table['points'], table['x_min'] + k * step))) for k in range(num)]
+    for v in y:
+        if not -32768 <= v <= 32767:
+            raise ValueError('%s: value out of int16 range' % table['name'])
+
+    lines = ['static const int16_t %s_y[%d] = {' % (table['name'], num)]
+    for i in range(0, num, 8):
+        lines.append('        ' + ', '.join('%6d' % v for v in y[i:i + 8]) + ',')
+    lines.append('};')
+    lines.append('')
+    lines.append('static const struct calib_table %s = {' % table['name'])
+    lines.append('        .x0     = %d,' % table['x_min'])
+    lines.append('        .shift  = %d,' % table['shift'])
+    lines.append('        .num    = %d,' % num)
+    lines.append('        .y      = %s_y,' % table['name'])
+    lines.append('};')
+    lines.append('')
+    return lines
+
+
+def main():
+    out = [
+        '/*',
+        ' * sensor_calib_tables.h',
+        ' *',
+        ' * Generated by tools/gen_calib_tables.py, do not edit.',
+        ' */',
+        '',
+        '#ifndef SENSOR_CALIB_TABLES_H_',
+        '#define SENSOR_CALIB_TABLES_H_',
+        '',
+        '#include "sensor_conversion.h"',
+        '',
+    ]
+    for table in TABLES:
+        out += generate(table)
+    out.append('#endif /* SENSOR_CALIB_TABLES_H_ */')
+    sys.stdout.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    main()